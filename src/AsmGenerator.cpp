@@ -0,0 +1,290 @@
+#include "AsmGenerator.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+
+namespace {
+constexpr int kMaxCachedListings = 32;
+
+// 只有这些段里的内容对阅读生成代码有用，调试信息、异常表等整段跳过。
+bool isNoiseSection(const QString &name) {
+    return name.startsWith(QLatin1String(".debug")) || name.startsWith(QLatin1String(".note"))
+           || name.startsWith(QLatin1String("__DWARF")) || name.startsWith(QLatin1String(".comment"))
+           || name.startsWith(QLatin1String(".eh_frame")) || name.startsWith(QLatin1String(".gcc_except_table"))
+           || name.startsWith(QLatin1String(".llvm_addrsig"));
+}
+
+bool isDataDirective(const QString &directive) {
+    static const QSet<QString> kData{".string", ".ascii", ".asciz", ".byte", ".short", ".value",
+                                     ".long",   ".quad",  ".zero",  ".word", ".hword", ".xword"};
+    return kData.contains(directive);
+}
+
+QString stripComment(const QString &line) {
+    int end = line.size();
+    const int hash = line.indexOf(QLatin1String(" #"));
+    if (hash >= 0) {
+        end = hash;
+    }
+    const int slashes = line.indexOf(QLatin1String(" //"));
+    if (slashes >= 0 && slashes < end) {
+        end = slashes;
+    }
+    return line.left(end).trimmed();
+}
+
+QString normalizeIndent(const QString &line) {
+    int i = 0;
+    while (i < line.size() && (line.at(i) == ' ' || line.at(i) == '\t')) {
+        ++i;
+    }
+    QString body = line.mid(i);
+    body.replace('\t', QLatin1Char(' '));
+    return QStringLiteral("        ") + body;
+}
+}
+
+AsmGenerator::AsmGenerator(QObject *parent) : QObject(parent) {
+    connect(&pipeline_, &ToolPipeline::finished, this, &AsmGenerator::finish);
+}
+
+bool AsmGenerator::isRunning() const {
+    return pipeline_.isRunning();
+}
+
+void AsmGenerator::invalidate() {
+    cache_.clear();
+}
+
+QString AsmGenerator::cacheKey(const Request &request) const {
+    const QFileInfo source(request.source);
+    const QFileInfo object(request.object);
+    QStringList parts{request.source,
+                      QString::number(source.lastModified().toMSecsSinceEpoch()),
+                      QString::number(source.size()),
+                      request.compiler,
+                      request.flags.join('\n'),
+                      request.object,
+                      request.object.isEmpty() ? QString() : QString::number(object.lastModified().toMSecsSinceEpoch()),
+                      request.verbose ? "v" : "",
+                      request.intelSyntax ? "i" : ""};
+    return QString::fromLatin1(QCryptographicHash::hash(parts.join('\n').toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+void AsmGenerator::generate(const Request &request) {
+    const QString key = cacheKey(request);
+    const auto cached = cache_.constFind(key);
+    if (cached != cache_.constEnd()) {
+        pipeline_.cancel(); // 还没完成的旧请求不再覆盖这次的结果
+        AsmListing listing = cached.value();
+        listing.cached = true;
+        emit finished(listing);
+        return;
+    }
+
+    request_ = request;
+    key_ = key;
+    timer_.start();
+
+    const QString objdump = request.object.isEmpty() ? QString() : ToolPipeline::findTool({"objdump", "llvm-objdump"});
+    if (!objdump.isEmpty()) {
+        // 目标文件就是增量编译的产物，反汇编它比重新编译快得多，看到的也正是最终参与链接的代码
+        QStringList args{"-d", "-l", "-C", "-r", "--no-show-raw-insn"};
+        if (request.intelSyntax) {
+            args << "-M" << "intel";
+        }
+        args << request.object;
+        disassembling_ = true;
+        pipeline_.start(objdump, args, request.workingDirectory);
+        return;
+    }
+
+    QStringList args = request.flags;
+    // -g1 只生成行号表，足够把汇编对应回源码，不影响代码生成
+    args << "-S" << "-g1" << "-o" << "-";
+    if (request.verbose) {
+        args << "-fverbose-asm";
+    }
+    if (request.intelSyntax) {
+        args << "-masm=intel";
+    }
+    args << request.source;
+    disassembling_ = false;
+    // -S 的输出整段交给 c++filt 还原名字
+    pipeline_.start(request.compiler, args, request.workingDirectory, [](const QByteArray &output) { return output; });
+}
+
+void AsmGenerator::finish(const QByteArray &output, const QString &error) {
+    const bool fromObjdump = disassembling_;
+    AsmListing listing;
+    if (error.isEmpty()) {
+        const QString text = QString::fromLocal8Bit(output);
+        listing = fromObjdump ? parseObjdumpOutput(text) : parseCompilerOutput(text);
+    }
+    listing.sourcePath = request_.source;
+    listing.origin = fromObjdump ? QStringLiteral("objdump") : QStringLiteral("-S");
+    listing.elapsedMs = timer_.elapsed();
+    listing.error = error;
+    if (error.isEmpty()) {
+        if (cache_.size() >= kMaxCachedListings) {
+            cache_.clear();
+        }
+        cache_.insert(key_, listing);
+    }
+    emit finished(listing);
+}
+
+bool AsmGenerator::isMainFile(const QString &path) const {
+    if (path.isEmpty()) {
+        return false;
+    }
+    const QString absolute = QDir::isAbsolutePath(path) ? path : QDir(request_.workingDirectory).absoluteFilePath(path);
+    if (QDir::cleanPath(absolute) == QDir::cleanPath(request_.source)) {
+        return true;
+    }
+    // 编译器记录的路径可能经过符号链接或 -ffile-prefix-map 改写，退一步按文件名比较
+    return !QDir::isAbsolutePath(path) && QFileInfo(path).fileName() == QFileInfo(request_.source).fileName();
+}
+
+AsmListing AsmGenerator::parseCompilerOutput(const QString &text) const {
+    static const QRegularExpression fileRe(QStringLiteral("^\\s*\\.file\\s+(\\d+)\\s+\"([^\"]*)\"(?:\\s+\"([^\"]*)\")?"));
+    static const QRegularExpression locRe(QStringLiteral("^\\s*\\.loc\\s+(\\d+)\\s+(\\d+)"));
+    static const QRegularExpression typeRe(QStringLiteral("^\\s*\\.type\\s+(.+?)\\s*,\\s*[@%]function"));
+    static const QRegularExpression sectionRe(QStringLiteral("^\\s*\\.section\\s+([^,\\s]+)"));
+    // 跳转目标（gcc 的 .L3、clang 的 .LBB0_2）和常量（.LC0）保留，其余 .L 标签都是调试信息用的
+    static const QRegularExpression localLabelRe(QStringLiteral("^\\.(L\\d+|LC\\d+|LBB\\d+_\\d+|LCPI\\d+_\\d+)$"));
+
+    AsmListing listing;
+    QHash<int, bool> mainFiles;
+    QSet<QString> functionNames;
+    bool sawTypeDirectives = false;
+    bool skipping = false;
+    int currentLine = 0;
+    const QStringList lines = text.split('\n');
+
+    // .type 在标签前面出现，先扫一遍收集函数名
+    for (const QString &line : lines) {
+        const QRegularExpressionMatch type = typeRe.match(line);
+        if (type.hasMatch()) {
+            functionNames.insert(type.captured(1));
+            sawTypeDirectives = true;
+        }
+    }
+
+    for (const QString &raw : lines) {
+        const QString trimmed = raw.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        int directiveEnd = 0;
+        while (directiveEnd < trimmed.size() && !trimmed.at(directiveEnd).isSpace()) {
+            ++directiveEnd;
+        }
+        const QString directive = trimmed.left(directiveEnd);
+        if (directive == QLatin1String(".section")) {
+            const QRegularExpressionMatch section = sectionRe.match(trimmed);
+            skipping = section.hasMatch() && isNoiseSection(section.captured(1));
+            continue;
+        }
+        if (directive == QLatin1String(".text") || directive == QLatin1String(".data")
+            || directive == QLatin1String(".bss")) {
+            skipping = false;
+            continue;
+        }
+        if (directive == QLatin1String(".file")) {
+            const QRegularExpressionMatch file = fileRe.match(trimmed);
+            if (file.hasMatch()) {
+                const QString path = file.captured(3).isEmpty() ? file.captured(2)
+                                                                : QDir(file.captured(2)).filePath(file.captured(3));
+                mainFiles.insert(file.captured(1).toInt(), isMainFile(path));
+            }
+            continue;
+        }
+        if (directive == QLatin1String(".loc")) {
+            const QRegularExpressionMatch loc = locRe.match(trimmed);
+            if (loc.hasMatch()) {
+                currentLine = mainFiles.value(loc.captured(1).toInt()) ? loc.captured(2).toInt() : 0;
+            }
+            continue;
+        }
+        if (skipping) {
+            continue;
+        }
+
+        const bool indented = raw.at(0) == ' ' || raw.at(0) == '\t';
+        const QString label = stripComment(trimmed); // clang 在标签后面写 "# @main"
+        if (!indented && label.endsWith(':')) {
+            const QString name = label.left(label.size() - 1);
+            if (name.startsWith('.')) {
+                if (localLabelRe.match(name).hasMatch()) {
+                    listing.lines << label;
+                    listing.sourceLines << 0;
+                }
+                continue;
+            }
+            if (!sawTypeDirectives || functionNames.contains(name)) {
+                listing.functions.append(qMakePair(name, static_cast<int>(listing.lines.size())));
+                currentLine = 0;
+            }
+            listing.lines << label;
+            listing.sourceLines << 0;
+            continue;
+        }
+        if (trimmed.startsWith('#') || trimmed.startsWith(QLatin1String("//")) || trimmed.startsWith(';')) {
+            // -fverbose-asm 的整行注释里是对应的源码，普通模式下都是编译器自己的说明
+            if (request_.verbose && currentLine > 0) {
+                listing.lines << normalizeIndent(raw);
+                listing.sourceLines << currentLine;
+            }
+            continue;
+        }
+        if (trimmed.startsWith('.') && !isDataDirective(directive)) {
+            continue;
+        }
+        listing.lines << normalizeIndent(raw);
+        listing.sourceLines << currentLine;
+    }
+    return listing;
+}
+
+AsmListing AsmGenerator::parseObjdumpOutput(const QString &text) const {
+    // objdump -dl 的格式：
+    //   0000000000000000 <main>:
+    //   main():
+    //   /path/a.cpp:5
+    //      0:	push   rbp
+    //   			1: R_X86_64_PLT32	foo()-0x4
+    static const QRegularExpression functionRe(QStringLiteral("^[0-9a-fA-F]+ <(.+)>:$"));
+    static const QRegularExpression locationRe(QStringLiteral("^(\\S.*):(\\d+)(?: \\(discriminator \\d+\\))?$"));
+    static const QRegularExpression instructionRe(QStringLiteral("^\\s+[0-9a-fA-F]+:\\s"));
+
+    AsmListing listing;
+    int currentLine = 0;
+    for (const QString &line : text.split('\n')) {
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+        const QRegularExpressionMatch function = functionRe.match(line);
+        if (function.hasMatch()) {
+            listing.functions.append(qMakePair(function.captured(1), static_cast<int>(listing.lines.size())));
+            listing.lines << function.captured(1) + QLatin1Char(':');
+            listing.sourceLines << 0;
+            currentLine = 0;
+            continue;
+        }
+        const QRegularExpressionMatch location = locationRe.match(line);
+        if (location.hasMatch()) {
+            currentLine = isMainFile(location.captured(1)) ? location.captured(2).toInt() : 0;
+            continue;
+        }
+        if (instructionRe.match(line).hasMatch()) {
+            listing.lines << normalizeIndent(line);
+            listing.sourceLines << currentLine;
+        }
+    }
+    return listing;
+}
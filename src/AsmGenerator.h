@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ToolPipeline.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+// 一个翻译单元的汇编清单：已去掉调试信息、CFI 等伪指令，每行记录对应的源码行。
+struct AsmListing {
+    QString sourcePath;
+    QStringList lines;
+    QVector<int> sourceLines;             // 与 lines 一一对应，源码行号从 1 开始，0 表示不对应
+    QList<QPair<QString, int>> functions; // 函数名 -> 所在汇编行
+    QString origin;                       // "objdump" 或 "-S"
+    qint64 elapsedMs = 0;
+    bool cached = false;
+    QString error;
+};
+
+// 生成汇编：增量编译留下的目标文件仍是最新时直接 objdump -dl，否则单独用 -S 编译这一个翻译单元。
+// 新请求会取消还没完成的旧请求；结果按源文件、参数和 mtime 缓存，切换标签页不必重新编译。
+class AsmGenerator : public QObject {
+    Q_OBJECT
+
+public:
+    struct Request {
+        QString source;
+        QString compiler;
+        QStringList flags;
+        QString workingDirectory;
+        QString object; // 最新的目标文件，为空表示需要 -S 编译
+        bool verbose = false;
+        bool intelSyntax = false;
+    };
+
+    explicit AsmGenerator(QObject *parent = nullptr);
+
+    void generate(const Request &request);
+    void invalidate();
+    bool isRunning() const;
+
+signals:
+    void finished(const AsmListing &listing);
+
+private:
+    void finish(const QByteArray &output, const QString &error);
+    QString cacheKey(const Request &request) const;
+    AsmListing parseCompilerOutput(const QString &text) const;
+    AsmListing parseObjdumpOutput(const QString &text) const;
+    bool isMainFile(const QString &path) const;
+
+    ToolPipeline pipeline_;
+    bool disassembling_ = false; // 当前请求走的是 objdump 而不是 -S
+    Request request_;
+    QString key_;
+    QElapsedTimer timer_;
+    QHash<QString, AsmListing> cache_;
+};
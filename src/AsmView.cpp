@@ -0,0 +1,194 @@
+#include "AsmView.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSettings>
+#include <QTextBlock>
+#include <QVBoxLayout>
+
+namespace {
+const QColor kLinkedLineColor(255, 200, 0, 90);
+}
+
+AsmView::AsmView(AsmGenerator *generator, QWidget *parent) : QWidget(parent), generator_(generator) {
+    QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+    functionCombo_ = new QComboBox(this);
+    functionCombo_->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    functionCombo_->setMinimumContentsLength(20);
+    verboseCheck_ = new QCheckBox(tr("详细注释"), this);
+    verboseCheck_->setToolTip(tr("-fverbose-asm：在汇编里注明变量名和对应的源码"));
+    verboseCheck_->setChecked(settings.value("asm/verbose", false).toBool());
+    intelCheck_ = new QCheckBox(tr("Intel 语法"), this);
+    intelCheck_->setChecked(settings.value("asm/intel", false).toBool());
+    refreshButton_ = new QPushButton(tr("刷新"), this);
+    statusLabel_ = new QLabel(tr("打开一个源文件后显示它的汇编。"), this);
+    statusLabel_->setWordWrap(true);
+
+    text_ = new QPlainTextEdit(this);
+    text_->setReadOnly(true);
+    text_->setLineWrapMode(QPlainTextEdit::NoWrap);
+    QFont font;
+    font.setFamily("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setPointSize(10);
+    text_->setFont(font);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(functionCombo_, 1);
+    bar->addWidget(verboseCheck_);
+    bar->addWidget(intelCheck_);
+    bar->addWidget(refreshButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(statusLabel_);
+    layout->addWidget(text_);
+
+    auto optionsChanged = [this]() {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("asm/verbose", verboseCheck_->isChecked());
+        settings.setValue("asm/intel", intelCheck_->isChecked());
+        emit refreshRequested();
+    };
+    connect(verboseCheck_, &QCheckBox::toggled, this, optionsChanged);
+    connect(intelCheck_, &QCheckBox::toggled, this, optionsChanged);
+    connect(refreshButton_, &QPushButton::clicked, this, [this]() {
+        generator_->invalidate();
+        emit refreshRequested();
+    });
+    connect(generator_, &AsmGenerator::finished, this, &AsmView::showListing);
+    connect(functionCombo_, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+        const QTextBlock block = text_->document()->findBlockByNumber(functionCombo_->itemData(index).toInt());
+        if (!block.isValid()) {
+            return;
+        }
+        syncing_ = true;
+        // 先跳到末尾再回来，让函数第一行停在视图顶部
+        text_->moveCursor(QTextCursor::End);
+        text_->setTextCursor(QTextCursor(block));
+        syncing_ = false;
+    });
+    connect(text_, &QPlainTextEdit::cursorPositionChanged, this, [this]() {
+        if (syncing_) {
+            return;
+        }
+        const int asmLine = text_->textCursor().blockNumber();
+        syncFunctionCombo(asmLine);
+        const int line = listing_.sourceLines.value(asmLine);
+        if (line > 0) {
+            highlightSourceLine(line, false);
+            emit sourceLineSelected(line);
+        }
+    });
+}
+
+bool AsmView::verboseAsm() const {
+    return verboseCheck_->isChecked();
+}
+
+bool AsmView::intelSyntax() const {
+    return intelCheck_->isChecked();
+}
+
+QString AsmView::sourcePath() const {
+    return listing_.sourcePath;
+}
+
+void AsmView::setStatus(const QString &text) {
+    statusLabel_->setText(text);
+}
+
+void AsmView::setCurrentSourceLine(int line) {
+    if (line == highlightedLine_) {
+        return;
+    }
+    highlightSourceLine(line, true);
+}
+
+void AsmView::showListing(const AsmListing &listing) {
+    const bool sameSource = listing.sourcePath == listing_.sourcePath;
+    listing_ = listing;
+    const QString fileName = QFileInfo(listing.sourcePath).fileName();
+    if (!listing.error.isEmpty()) {
+        listing_.lines.clear();
+        listing_.sourceLines.clear();
+        listing_.functions.clear();
+        functionCombo_->clear();
+        text_->setPlainText(listing.error);
+        statusLabel_->setText(tr("%1：生成汇编失败").arg(fileName));
+        return;
+    }
+
+    const int scroll = text_->verticalScrollBar()->value();
+    syncing_ = true;
+    text_->setPlainText(listing.lines.join('\n'));
+    syncing_ = false;
+    functionCombo_->clear();
+    for (const auto &function : listing.functions) {
+        functionCombo_->addItem(function.first, function.second);
+    }
+
+    const QString origin = listing.origin == QLatin1String("objdump") ? tr("反汇编增量编译的目标文件")
+                                                                     : tr("-S 单独编译");
+    statusLabel_->setText(tr("%1：%2，%3 行汇编，%4 个函数，%5")
+                              .arg(fileName, origin)
+                              .arg(listing.lines.size())
+                              .arg(listing.functions.size())
+                              .arg(listing.cached ? tr("来自缓存") : tr("用时 %1 ms").arg(listing.elapsedMs)));
+
+    // 同一个文件重新生成（保存后）时保持原来的高亮和位置
+    const int line = sameSource ? highlightedLine_ : 0;
+    highlightedLine_ = 0;
+    if (line > 0) {
+        highlightSourceLine(line, true);
+    } else if (sameSource) {
+        text_->verticalScrollBar()->setValue(scroll);
+    }
+}
+
+void AsmView::highlightSourceLine(int line, bool scroll) {
+    highlightedLine_ = line;
+    QList<QTextEdit::ExtraSelection> selections;
+    QTextBlock first;
+    for (int i = 0; i < listing_.sourceLines.size(); ++i) {
+        if (listing_.sourceLines.at(i) != line) {
+            continue;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(text_->document()->findBlockByNumber(i));
+        selection.format.setBackground(kLinkedLineColor);
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selections.append(selection);
+        if (!first.isValid()) {
+            first = selection.cursor.block();
+        }
+    }
+    text_->setExtraSelections(selections);
+    if (scroll && first.isValid()) {
+        syncing_ = true;
+        text_->setTextCursor(QTextCursor(first));
+        text_->centerCursor();
+        syncing_ = false;
+        syncFunctionCombo(first.blockNumber());
+    }
+}
+
+void AsmView::syncFunctionCombo(int asmLine) {
+    int index = -1;
+    for (int i = 0; i < listing_.functions.size(); ++i) {
+        if (listing_.functions.at(i).second > asmLine) {
+            break;
+        }
+        index = i;
+    }
+    functionCombo_->setCurrentIndex(index);
+}
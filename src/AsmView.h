@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QWidget>
+
+#include "AsmGenerator.h"
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+
+// 汇编面板：显示 AsmGenerator 的结果，和编辑器双向联动——
+// 编辑器光标所在行对应的汇编行高亮并滚动到可见，点汇编行时发出对应的源码行。
+class AsmView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit AsmView(AsmGenerator *generator, QWidget *parent = nullptr);
+
+    bool verboseAsm() const;
+    bool intelSyntax() const;
+    QString sourcePath() const;
+    void setStatus(const QString &text);
+    void setCurrentSourceLine(int line); // 从 1 开始
+
+signals:
+    void sourceLineSelected(int line);
+    void refreshRequested();
+
+private:
+    void showListing(const AsmListing &listing);
+    void highlightSourceLine(int line, bool scroll);
+    void syncFunctionCombo(int asmLine);
+
+    AsmGenerator *generator_;
+    AsmListing listing_;
+    QLabel *statusLabel_;
+    QComboBox *functionCombo_;
+    QCheckBox *verboseCheck_;
+    QCheckBox *intelCheck_;
+    QPushButton *refreshButton_;
+    QPlainTextEdit *text_;
+    int highlightedLine_ = 0;
+    bool syncing_ = false;
+};
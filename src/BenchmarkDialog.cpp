@@ -0,0 +1,251 @@
+#include "BenchmarkDialog.h"
+
+#include <QCheckBox>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSettings>
+#include <QSpinBox>
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+// 与上次相比慢了超过这个比例就标红
+constexpr double kRegressionThreshold = 0.05;
+
+void addStatsRow(QTreeWidget *tree, const QString &name, const BenchmarkRunner::Stats &stats, double scale, int precision) {
+    auto *item = new QTreeWidgetItem(tree);
+    item->setText(0, name);
+    const double values[] = {stats.mean, stats.median, stats.stddev, stats.min, stats.max};
+    for (int i = 0; i < 5; ++i) {
+        item->setText(i + 1, QString::number(values[i] / scale, 'f', precision));
+        item->setTextAlignment(i + 1, Qt::AlignRight | Qt::AlignVCenter);
+    }
+}
+}
+
+BenchmarkDialog::BenchmarkDialog(BenchmarkRunner *runner, QWidget *parent) : QDialog(parent), runner_(runner) {
+    setWindowTitle(tr("基准测试"));
+    resize(860, 560);
+
+    QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+    iterationsSpin_ = new QSpinBox(this);
+    iterationsSpin_->setRange(1, 1000);
+    iterationsSpin_->setValue(settings.value("benchmark/iterations", 10).toInt());
+    warmupSpin_ = new QSpinBox(this);
+    warmupSpin_->setRange(0, 100);
+    warmupSpin_->setValue(settings.value("benchmark/warmup", 2).toInt());
+    perfCheck_ = new QCheckBox(tr("用 perf stat 采集硬件计数器（需要安装 perf）"), this);
+    perfCheck_->setChecked(settings.value("benchmark/usePerf", true).toBool());
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("测量次数："), iterationsSpin_);
+    form->addRow(tr("预热次数："), warmupSpin_);
+    form->addRow(QString(), perfCheck_);
+
+    btnRun_ = new QPushButton(tr("编译 Release 并运行"), this);
+    btnStop_ = new QPushButton(tr("停止"), this);
+    btnStop_->setEnabled(false);
+    auto *btnClose = new QPushButton(tr("关闭"), this);
+    statusLabel_ = new QLabel(tr("每次运行都会记录墙钟时间、CPU 时间和峰值内存；程序使用 Google Benchmark 时自动解析其 JSON 输出。"), this);
+    statusLabel_->setWordWrap(true);
+    progressBar_ = new QProgressBar(this);
+    progressBar_->hide();
+
+    summaryTree_ = new QTreeWidget(this);
+    summaryTree_->setHeaderLabels({tr("指标"), tr("均值"), tr("中位数"), tr("标准差"), tr("最小"), tr("最大")});
+    summaryTree_->setRootIsDecorated(false);
+    gbenchTree_ = new QTreeWidget(this);
+    gbenchTree_->setHeaderLabels({tr("基准项"), tr("均值(ns)"), tr("中位数(ns)"), tr("标准差(ns)"), tr("最小(ns)"), tr("最大(ns)")});
+    gbenchTree_->setRootIsDecorated(false);
+    gbenchTree_->setSortingEnabled(true);
+    historyTree_ = new QTreeWidget(this);
+    historyTree_->setHeaderLabels({tr("时间"), tr("程序"), tr("次数"), tr("墙钟中位数(ms)"), tr("标准差(ms)"),
+                                   tr("用户态(ms)"), tr("峰值内存(MB)"), tr("较上次")});
+    historyTree_->setRootIsDecorated(false);
+
+    auto *tabs = new QTabWidget(this);
+    tabs->addTab(summaryTree_, tr("本次结果"));
+    tabs->addTab(gbenchTree_, tr("Google Benchmark"));
+    tabs->addTab(historyTree_, tr("历史"));
+
+    auto *btnLayout = new QHBoxLayout();
+    btnLayout->addWidget(btnRun_);
+    btnLayout->addWidget(btnStop_);
+    btnLayout->addStretch();
+    btnLayout->addWidget(btnClose);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(btnLayout);
+    layout->addWidget(statusLabel_);
+    layout->addWidget(progressBar_);
+    layout->addWidget(tabs);
+
+    connect(btnRun_, &QPushButton::clicked, this, [this]() {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("benchmark/iterations", iterationsSpin_->value());
+        settings.setValue("benchmark/warmup", warmupSpin_->value());
+        settings.setValue("benchmark/usePerf", perfCheck_->isChecked());
+        emit runRequested();
+    });
+    connect(btnStop_, &QPushButton::clicked, runner_, &BenchmarkRunner::cancel);
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::close);
+    connect(runner_, &BenchmarkRunner::progress, this, [this](int done, int total, BenchmarkRunner::Stage stage) {
+        btnRun_->setEnabled(false);
+        btnStop_->setEnabled(true);
+        progressBar_->setRange(0, total);
+        progressBar_->setValue(done);
+        progressBar_->show();
+        const int measured = warmupSpin_->value() + iterationsSpin_->value();
+        if (stage == BenchmarkRunner::Warmup) {
+            setStatus(tr("预热第 %1 次...").arg(done + 1));
+        } else if (stage == BenchmarkRunner::Timing) {
+            setStatus(tr("测量第 %1/%2 次...").arg(done - warmupSpin_->value() + 1).arg(iterationsSpin_->value()));
+        } else {
+            setStatus(tr("用 perf 采集计数器，第 %1/%2 次...").arg(done - measured + 1).arg(total - measured));
+        }
+    });
+    connect(runner_, &BenchmarkRunner::finished, this, [this](const BenchmarkRunner::Result &result) {
+        btnRun_->setEnabled(true);
+        btnStop_->setEnabled(false);
+        progressBar_->hide();
+        BenchmarkRunner::saveHistory(result, metricsDir_);
+        showResult(result);
+        populateHistory();
+    });
+}
+
+int BenchmarkDialog::iterations() const {
+    return iterationsSpin_->value();
+}
+
+int BenchmarkDialog::warmup() const {
+    return warmupSpin_->value();
+}
+
+bool BenchmarkDialog::usePerf() const {
+    return perfCheck_->isChecked();
+}
+
+void BenchmarkDialog::setMetricsDirectory(const QString &dir) {
+    metricsDir_ = dir;
+    populateHistory();
+}
+
+void BenchmarkDialog::setStatus(const QString &text) {
+    statusLabel_->setText(text);
+}
+
+void BenchmarkDialog::showResult(const BenchmarkRunner::Result &result) {
+    summaryTree_->clear();
+    gbenchTree_->clear();
+
+    QVector<double> wall;
+    QVector<double> user;
+    QVector<double> sys;
+    QVector<double> rss;
+    QVector<double> ipc;
+    QMap<QString, QVector<double>> counters;
+    QMap<QString, QVector<double>> benchmarks;
+    int failedRuns = 0;
+    for (const BenchmarkRunner::Sample &sample : result.samples) {
+        wall << sample.wallUs;
+        user << sample.userUs;
+        sys << sample.sysUs;
+        rss << sample.maxRssKb;
+        if (sample.exitCode != 0) {
+            ++failedRuns;
+        }
+        for (auto it = sample.counters.cbegin(); it != sample.counters.cend(); ++it) {
+            counters[it.key()] << it.value();
+        }
+        if (sample.counters.value("cycles") > 0 && sample.counters.contains("instructions")) {
+            ipc << sample.counters.value("instructions") / sample.counters.value("cycles");
+        }
+        for (auto it = sample.benchmarks.cbegin(); it != sample.benchmarks.cend(); ++it) {
+            benchmarks[it.key()] << it.value();
+        }
+    }
+
+    if (!result.samples.isEmpty()) {
+        addStatsRow(summaryTree_, tr("墙钟时间(ms)"), BenchmarkRunner::summarize(wall), 1000.0, 3);
+        addStatsRow(summaryTree_, tr("用户态 CPU(ms)"), BenchmarkRunner::summarize(user), 1000.0, 3);
+        addStatsRow(summaryTree_, tr("内核态 CPU(ms)"), BenchmarkRunner::summarize(sys), 1000.0, 3);
+        addStatsRow(summaryTree_, tr("峰值内存(MB)"), BenchmarkRunner::summarize(rss), 1024.0, 2);
+        for (auto it = counters.cbegin(); it != counters.cend(); ++it) {
+            addStatsRow(summaryTree_, it.key(), BenchmarkRunner::summarize(it.value()), 1.0, 0);
+        }
+        if (!ipc.isEmpty()) {
+            addStatsRow(summaryTree_, tr("IPC"), BenchmarkRunner::summarize(ipc), 1.0, 3);
+        }
+    }
+    summaryTree_->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+
+    for (auto it = benchmarks.cbegin(); it != benchmarks.cend(); ++it) {
+        addStatsRow(gbenchTree_, it.key(), BenchmarkRunner::summarize(it.value()), 1.0, 1);
+    }
+    gbenchTree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    QString status;
+    if (!result.error.isEmpty()) {
+        status = result.error;
+    } else if (result.cancelled) {
+        status = tr("已停止，完成 %1 次测量。").arg(result.samples.size());
+    } else {
+        status = tr("完成 %1 次测量（预热 %2 次）。").arg(result.samples.size()).arg(result.options.warmup);
+    }
+    if (failedRuns > 0) {
+        status += tr(" 其中 %1 次退出码非 0，结果可能无效。").arg(failedRuns);
+    }
+    if (result.options.usePerf && !result.perfUsed) {
+        status += tr(" 未找到 perf，没有硬件计数器。");
+    } else if (result.perfUsed && counters.isEmpty() && !result.samples.isEmpty()) {
+        status += tr(" perf 没有返回计数器（可能受 perf_event_paranoid 限制）。");
+    }
+    setStatus(status);
+}
+
+void BenchmarkDialog::populateHistory() {
+    historyTree_->clear();
+    const QList<BenchmarkRunner::HistoryEntry> history = BenchmarkRunner::loadHistory(metricsDir_);
+    for (int i = history.size() - 1; i >= 0; --i) {
+        const BenchmarkRunner::HistoryEntry &entry = history.at(i);
+        auto *item = new QTreeWidgetItem(historyTree_);
+        item->setText(0, QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString("yyyy-MM-dd HH:mm:ss"));
+        item->setText(1, QFileInfo(entry.program).fileName());
+        item->setToolTip(1, entry.program);
+        item->setText(2, QString::number(entry.iterations));
+        item->setText(3, QString::number(entry.wallUs.median / 1000.0, 'f', 3));
+        item->setText(4, QString::number(entry.wallUs.stddev / 1000.0, 'f', 3));
+        item->setText(5, QString::number(entry.userUs / 1000.0, 'f', 3));
+        item->setText(6, QString::number(entry.maxRssKb / 1024.0, 'f', 2));
+
+        // 和同一程序、同一模式的上一次比较中位数
+        for (int j = i - 1; j >= 0; --j) {
+            const BenchmarkRunner::HistoryEntry &previous = history.at(j);
+            if (previous.program != entry.program || previous.profile != entry.profile) {
+                continue;
+            }
+            if (previous.wallUs.median > 0) {
+                const double change = (entry.wallUs.median - previous.wallUs.median) / previous.wallUs.median;
+                item->setText(7, QStringLiteral("%1%2%").arg(change > 0 ? "+" : "").arg(change * 100, 0, 'f', 1));
+                if (change > kRegressionThreshold) {
+                    item->setForeground(7, Qt::red);
+                } else if (change < -kRegressionThreshold) {
+                    item->setForeground(7, Qt::darkGreen);
+                }
+            }
+            break;
+        }
+        for (int column = 2; column < 8; ++column) {
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QDialog>
+
+#include "BenchmarkRunner.h"
+
+class QCheckBox;
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QSpinBox;
+class QTreeWidget;
+
+// 基准测试面板：设置运行次数，发起“编译 Release 并运行”，显示统计结果和历史对比。
+class BenchmarkDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    BenchmarkDialog(BenchmarkRunner *runner, QWidget *parent = nullptr);
+
+    int iterations() const;
+    int warmup() const;
+    bool usePerf() const;
+    void setMetricsDirectory(const QString &dir);
+    void setStatus(const QString &text);
+
+signals:
+    void runRequested();
+
+private:
+    void showResult(const BenchmarkRunner::Result &result);
+    void populateHistory();
+
+    BenchmarkRunner *runner_;
+    QString metricsDir_;
+    QSpinBox *iterationsSpin_;
+    QSpinBox *warmupSpin_;
+    QCheckBox *perfCheck_;
+    QPushButton *btnRun_;
+    QPushButton *btnStop_;
+    QLabel *statusLabel_;
+    QProgressBar *progressBar_;
+    QTreeWidget *summaryTree_;
+    QTreeWidget *gbenchTree_;
+    QTreeWidget *historyTree_;
+};
@@ -0,0 +1,481 @@
+#include "BenchmarkRunner.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr int kMaxHistory = 200;
+constexpr qint64 kMaxParsedOutput = 16 * 1024 * 1024;
+constexpr int kPerfPasses = 3; // 计时之外单独在 perf 下跑的次数，只用来取硬件计数器
+const QString kPerfEvents = QStringLiteral("cycles,instructions,cache-references,cache-misses,branch-misses");
+
+QString historyPath(const QString &metricsDir) {
+    return QDir(metricsDir).filePath("benchmarks.json");
+}
+
+// perf stat -x, 的输出：值,单位,事件名,...；不支持的事件值为 <not supported>，直接跳过。
+QMap<QString, double> parsePerfCsv(const QString &path) {
+    QMap<QString, double> counters;
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        return counters;
+    }
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split(',');
+        if (fields.size() < 3) {
+            continue;
+        }
+        bool ok = false;
+        const double value = fields.at(0).toDouble(&ok);
+        if (!ok) {
+            continue;
+        }
+        QString event = fields.at(2);
+        event = event.section(':', 0, 0); // cycles:u -> cycles
+        counters.insert(event, value);
+    }
+    return counters;
+}
+
+double toNanoseconds(double value, const QString &unit) {
+    if (unit == "us") {
+        return value * 1e3;
+    }
+    if (unit == "ms") {
+        return value * 1e6;
+    }
+    if (unit == "s") {
+        return value * 1e9;
+    }
+    return value;
+}
+
+// Google Benchmark 的 --benchmark_format=json 输出；程序在 JSON 前打印了别的内容也能识别。
+QMap<QString, double> parseGoogleBenchmark(const QString &path) {
+    QMap<QString, double> result;
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return result;
+    }
+    const QByteArray data = file.read(kMaxParsedOutput);
+    const int start = data.indexOf('{');
+    if (start < 0) {
+        return result;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(data.mid(start)).object();
+    QMap<QString, int> counts;
+    for (const auto &value : root.value("benchmarks").toArray()) {
+        const QJsonObject b = value.toObject();
+        if (b.value("run_type").toString() == "aggregate") {
+            continue; // 有 --benchmark_repetitions 时的 mean/median 汇总行，自己再算
+        }
+        const QString name = b.value("run_name").toString(b.value("name").toString());
+        if (name.isEmpty()) {
+            continue;
+        }
+        result[name] += toNanoseconds(b.value("real_time").toDouble(), b.value("time_unit").toString("ns"));
+        counts[name] += 1;
+    }
+    for (auto it = result.begin(); it != result.end(); ++it) {
+        it.value() /= qMax(1, counts.value(it.key()));
+    }
+    return result;
+}
+
+bool looksLikeGoogleBenchmark(const QString &program) {
+    QFile file(program);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    // 链接了 Google Benchmark 的程序里一定有这个命令行参数名。分块读，块之间保留一段重叠，
+    // 不把整个（可能几百 MB 的带调试信息的）可执行文件读进内存
+    const QByteArray needle("benchmark_format");
+    constexpr qint64 kChunk = 1024 * 1024;
+    QByteArray tail;
+    while (!file.atEnd()) {
+        const QByteArray window = tail + file.read(kChunk);
+        if (window.contains(needle)) {
+            return true;
+        }
+        tail = window.right(needle.size() - 1);
+    }
+    return false;
+}
+
+QJsonObject statsToJson(const BenchmarkRunner::Stats &stats) {
+    QJsonObject o;
+    o.insert("mean", stats.mean);
+    o.insert("median", stats.median);
+    o.insert("stddev", stats.stddev);
+    o.insert("min", stats.min);
+    o.insert("max", stats.max);
+    return o;
+}
+
+BenchmarkRunner::Stats statsFromJson(const QJsonObject &o) {
+    BenchmarkRunner::Stats stats;
+    stats.mean = o.value("mean").toDouble();
+    stats.median = o.value("median").toDouble();
+    stats.stddev = o.value("stddev").toDouble();
+    stats.min = o.value("min").toDouble();
+    stats.max = o.value("max").toDouble();
+    return stats;
+}
+
+QJsonObject mapToJson(const QMap<QString, double> &map) {
+    QJsonObject o;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        o.insert(it.key(), it.value());
+    }
+    return o;
+}
+
+QMap<QString, double> mapFromJson(const QJsonObject &o) {
+    QMap<QString, double> map;
+    for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+        map.insert(it.key(), it.value().toDouble());
+    }
+    return map;
+}
+}
+
+BenchmarkRunner::BenchmarkRunner(QObject *parent) : QObject(parent) {}
+
+BenchmarkRunner::~BenchmarkRunner() {
+    if (thread_) {
+        cancel();
+        thread_->wait();
+        delete thread_;
+    }
+}
+
+bool BenchmarkRunner::start(const Options &options) {
+    if (thread_ || options.program.isEmpty()) {
+        return false;
+    }
+    cancelled_ = false;
+    thread_ = QThread::create([this, options]() {
+        const Result result = execute(options);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            thread_->wait();
+            thread_->deleteLater();
+            thread_ = nullptr;
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    thread_->start();
+    return true;
+}
+
+void BenchmarkRunner::cancel() {
+    cancelled_ = true;
+#ifdef Q_OS_UNIX
+    const qint64 pid = childPid_.load();
+    if (pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGKILL) != 0) {
+        ::kill(static_cast<pid_t>(pid), SIGKILL); // 子进程还没来得及 setpgid
+    }
+#endif
+}
+
+bool BenchmarkRunner::isRunning() const {
+    return thread_ != nullptr;
+}
+
+BenchmarkRunner::Result BenchmarkRunner::execute(const Options &options) {
+    Result result;
+    result.options = options;
+    result.timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        result.error = tr("无法创建临时目录。");
+        return result;
+    }
+    const QString stdoutPath = tempDir.filePath("stdout.txt");
+    const QString perfPath = tempDir.filePath("perf.csv");
+
+    QStringList args = options.args;
+    const bool gbench = looksLikeGoogleBenchmark(options.program);
+    if (gbench && !args.join(' ').contains("benchmark_format")) {
+        args << QStringLiteral("--benchmark_format=json");
+    }
+    const QString perf = options.usePerf ? QStandardPaths::findExecutable("perf") : QString();
+    result.perfUsed = !perf.isEmpty();
+
+    // 计时的运行直接启动程序，perf 的开销不计入墙钟时间和峰值内存；计数器另外跑几次 perf 取得
+    const int perfPasses = result.perfUsed ? qMin(kPerfPasses, options.iterations) : 0;
+    const int measured = options.warmup + options.iterations;
+    const int total = measured + perfPasses;
+    for (int i = 0; i < total; ++i) {
+        const bool warmup = i < options.warmup;
+        const bool perfPass = i >= measured;
+        const Stage stage = warmup ? Warmup : perfPass ? Counters : Timing;
+        QMetaObject::invokeMethod(this, [this, i, total, stage]() { emit progress(i, total, stage); },
+                                  Qt::QueuedConnection);
+        QStringList command = QStringList{options.program} + args;
+        if (perfPass) {
+            command = QStringList{perf, "stat", "-x,", "-o", perfPath, "-e", kPerfEvents, "--"} + command;
+        }
+        bool ok = false;
+        Sample sample = runOnce(command, options.workingDirectory, stdoutPath, &ok);
+        if (cancelled_) {
+            result.cancelled = true;
+            break;
+        }
+        if (!ok) {
+            result.error = tr("无法启动：%1").arg(command.first());
+            break;
+        }
+        if (warmup) {
+            continue;
+        }
+        if (perfPass) {
+            // 计数器挂到前几个计时样本上，汇总时按出现次数取均值
+            result.samples[i - measured].counters = parsePerfCsv(perfPath);
+            continue;
+        }
+        if (gbench) {
+            sample.benchmarks = parseGoogleBenchmark(stdoutPath);
+        }
+        result.samples.append(sample);
+    }
+    return result;
+}
+
+BenchmarkRunner::Sample BenchmarkRunner::runOnce(const QStringList &command, const QString &workingDirectory,
+                                                 const QString &stdoutPath, bool *ok) {
+    Sample sample;
+    *ok = false;
+#ifdef Q_OS_UNIX
+    // 自己 fork/exec 再用 wait4 回收，rusage 里就是这一个子进程（含它等待过的后代）的 CPU 时间和峰值内存。
+    QList<QByteArray> storage;
+    for (const QString &arg : command) {
+        storage << QFile::encodeName(arg);
+    }
+    QVector<char *> argv;
+    for (QByteArray &arg : storage) {
+        argv << arg.data();
+    }
+    argv << nullptr;
+    const QByteArray workDir = QFile::encodeName(workingDirectory);
+    const int outFd = ::open(QFile::encodeName(stdoutPath).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    const int nullFd = ::open("/dev/null", O_RDWR | O_CLOEXEC);
+    if (outFd < 0 || nullFd < 0) {
+        if (outFd >= 0) {
+            ::close(outFd);
+        }
+        if (nullFd >= 0) {
+            ::close(nullFd);
+        }
+        return sample;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::setpgid(0, 0);
+        if (!workDir.isEmpty()) {
+            ::chdir(workDir.constData());
+        }
+        ::dup2(nullFd, STDIN_FILENO);
+        ::dup2(outFd, STDOUT_FILENO);
+        ::dup2(nullFd, STDERR_FILENO);
+        ::execvp(argv.at(0), argv.data());
+        ::_exit(127);
+    }
+    ::close(outFd);
+    ::close(nullFd);
+    if (pid < 0) {
+        return sample;
+    }
+    childPid_ = pid;
+    int status = 0;
+    struct rusage usage {};
+    while (::wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    sample.wallUs = timer.nsecsElapsed() / 1000;
+    childPid_ = 0;
+
+    sample.userUs = static_cast<qint64>(usage.ru_utime.tv_sec) * 1000000 + usage.ru_utime.tv_usec;
+    sample.sysUs = static_cast<qint64>(usage.ru_stime.tv_sec) * 1000000 + usage.ru_stime.tv_usec;
+#ifdef Q_OS_MACOS
+    sample.maxRssKb = usage.ru_maxrss / 1024; // macOS 上单位是字节
+#else
+    sample.maxRssKb = usage.ru_maxrss;
+#endif
+    sample.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    *ok = sample.exitCode != 127;
+#else
+    // 没有 wait4 的平台只能量墙钟时间
+    QProcess process;
+    process.setWorkingDirectory(workingDirectory);
+    process.setStandardOutputFile(stdoutPath);
+    process.setStandardErrorFile(QProcess::nullDevice());
+    QElapsedTimer timer;
+    timer.start();
+    process.start(command.first(), command.mid(1));
+    if (!process.waitForStarted()) {
+        return sample;
+    }
+    process.waitForFinished(-1);
+    sample.wallUs = timer.nsecsElapsed() / 1000;
+    sample.exitCode = process.exitCode();
+    *ok = true;
+#endif
+    return sample;
+}
+
+BenchmarkRunner::Stats BenchmarkRunner::summarize(QVector<double> values) {
+    Stats stats;
+    if (values.isEmpty()) {
+        return stats;
+    }
+    std::sort(values.begin(), values.end());
+    const int n = values.size();
+    double sum = 0;
+    for (double v : values) {
+        sum += v;
+    }
+    stats.mean = sum / n;
+    stats.median = n % 2 ? values.at(n / 2) : (values.at(n / 2 - 1) + values.at(n / 2)) / 2;
+    stats.min = values.first();
+    stats.max = values.last();
+    if (n > 1) {
+        double squares = 0;
+        for (double v : values) {
+            squares += (v - stats.mean) * (v - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (n - 1));
+    }
+    return stats;
+}
+
+BenchmarkRunner::HistoryEntry BenchmarkRunner::summarizeResult(const Result &result) {
+    HistoryEntry entry;
+    entry.timestamp = result.timestamp;
+    entry.program = result.options.program;
+    entry.profile = result.options.profile;
+    entry.iterations = result.samples.size();
+
+    QVector<double> wall;
+    double user = 0;
+    double sys = 0;
+    QMap<QString, QVector<double>> counters;
+    QMap<QString, QVector<double>> benchmarks;
+    for (const Sample &sample : result.samples) {
+        wall << sample.wallUs;
+        user += sample.userUs;
+        sys += sample.sysUs;
+        entry.maxRssKb = qMax(entry.maxRssKb, sample.maxRssKb);
+        for (auto it = sample.counters.cbegin(); it != sample.counters.cend(); ++it) {
+            counters[it.key()] << it.value();
+        }
+        for (auto it = sample.benchmarks.cbegin(); it != sample.benchmarks.cend(); ++it) {
+            benchmarks[it.key()] << it.value();
+        }
+    }
+    entry.wallUs = summarize(wall);
+    if (!result.samples.isEmpty()) {
+        entry.userUs = user / result.samples.size();
+        entry.sysUs = sys / result.samples.size();
+    }
+    for (auto it = counters.cbegin(); it != counters.cend(); ++it) {
+        entry.counters.insert(it.key(), summarize(it.value()).mean);
+    }
+    for (auto it = benchmarks.cbegin(); it != benchmarks.cend(); ++it) {
+        entry.benchmarks.insert(it.key(), summarize(it.value()).median);
+    }
+    return entry;
+}
+
+bool BenchmarkRunner::saveHistory(const Result &result, const QString &metricsDir) {
+    if (metricsDir.isEmpty() || result.samples.isEmpty()) {
+        return false;
+    }
+    const QString path = historyPath(metricsDir);
+    QJsonArray runs;
+    QFile existing(path);
+    if (existing.open(QFile::ReadOnly)) {
+        runs = QJsonDocument::fromJson(existing.readAll()).object().value("runs").toArray();
+        existing.close();
+    }
+
+    const HistoryEntry entry = summarizeResult(result);
+    QJsonObject run;
+    run.insert("timestamp", static_cast<double>(entry.timestamp));
+    run.insert("program", entry.program);
+    run.insert("profile", entry.profile);
+    run.insert("iterations", entry.iterations);
+    run.insert("wallUs", statsToJson(entry.wallUs));
+    run.insert("userUs", entry.userUs);
+    run.insert("sysUs", entry.sysUs);
+    run.insert("maxRssKb", static_cast<double>(entry.maxRssKb));
+    run.insert("counters", mapToJson(entry.counters));
+    run.insert("benchmarks", mapToJson(entry.benchmarks));
+    runs.append(run);
+    while (runs.size() > kMaxHistory) {
+        runs.removeFirst();
+    }
+
+    QDir().mkpath(metricsDir);
+    QJsonObject root;
+    root.insert("runs", runs);
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QList<BenchmarkRunner::HistoryEntry> BenchmarkRunner::loadHistory(const QString &metricsDir) {
+    QList<HistoryEntry> result;
+    QFile file(historyPath(metricsDir));
+    if (metricsDir.isEmpty() || !file.open(QFile::ReadOnly)) {
+        return result;
+    }
+    const QJsonArray runs = QJsonDocument::fromJson(file.readAll()).object().value("runs").toArray();
+    for (const auto &value : runs) {
+        const QJsonObject r = value.toObject();
+        HistoryEntry entry;
+        entry.timestamp = static_cast<qint64>(r.value("timestamp").toDouble());
+        entry.program = r.value("program").toString();
+        entry.profile = r.value("profile").toString();
+        entry.iterations = r.value("iterations").toInt();
+        entry.wallUs = statsFromJson(r.value("wallUs").toObject());
+        entry.userUs = r.value("userUs").toDouble();
+        entry.sysUs = r.value("sysUs").toDouble();
+        entry.maxRssKb = static_cast<qint64>(r.value("maxRssKb").toDouble());
+        entry.counters = mapFromJson(r.value("counters").toObject());
+        entry.benchmarks = mapFromJson(r.value("benchmarks").toObject());
+        result.append(entry);
+    }
+    return result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+
+class QThread;
+
+// 把编译产物重复运行多次做基准测试：先预热若干次，再正式测量。
+// 每次测量记录墙钟时间、用户态/内核态 CPU 时间和峰值内存（wait4 的 rusage），
+// 装有 perf 时另外在 perf stat 下跑几次取硬件计数器（计时的那几次不经过 perf）；程序输出 Google Benchmark JSON 时按基准项汇总。
+// 子进程在后台线程里同步启动和等待，界面线程不受影响。历史保存在 build/metrics/benchmarks.json。
+class BenchmarkRunner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString program;
+        QStringList args;
+        QString workingDirectory;
+        QString profile;
+        int iterations = 10;
+        int warmup = 2;
+        bool usePerf = true;
+    };
+
+    enum Stage { Warmup, Timing, Counters };
+
+    struct Sample {
+        qint64 wallUs = 0;
+        qint64 userUs = 0;
+        qint64 sysUs = 0;
+        qint64 maxRssKb = 0;
+        int exitCode = 0;
+        QMap<QString, double> counters;  // perf 事件名 -> 计数
+        QMap<QString, double> benchmarks; // Google Benchmark 名称 -> real_time（纳秒）
+    };
+
+    struct Stats {
+        double mean = 0;
+        double median = 0;
+        double stddev = 0;
+        double min = 0;
+        double max = 0;
+    };
+
+    struct Result {
+        Options options;
+        qint64 timestamp = 0;
+        QList<Sample> samples;
+        bool perfUsed = false;
+        bool cancelled = false;
+        QString error;
+    };
+
+    struct HistoryEntry {
+        qint64 timestamp = 0;
+        QString program;
+        QString profile;
+        int iterations = 0;
+        Stats wallUs;
+        double userUs = 0;
+        double sysUs = 0;
+        qint64 maxRssKb = 0;
+        QMap<QString, double> counters;   // 均值
+        QMap<QString, double> benchmarks; // 中位数
+    };
+
+    explicit BenchmarkRunner(QObject *parent = nullptr);
+    ~BenchmarkRunner() override;
+
+    bool start(const Options &options);
+    void cancel();
+    bool isRunning() const;
+
+    static Stats summarize(QVector<double> values);
+    static HistoryEntry summarizeResult(const Result &result);
+    static bool saveHistory(const Result &result, const QString &metricsDir);
+    static QList<HistoryEntry> loadHistory(const QString &metricsDir);
+
+signals:
+    void progress(int done, int total, BenchmarkRunner::Stage stage);
+    void finished(const BenchmarkRunner::Result &result);
+
+private:
+    Result execute(const Options &options);
+    Sample runOnce(const QStringList &command, const QString &workingDirectory, const QString &stdoutPath, bool *ok);
+
+    QThread *thread_ = nullptr;
+    std::atomic<qint64> childPid_{0};
+    std::atomic<bool> cancelled_{false};
+};
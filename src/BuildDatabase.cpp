@@ -0,0 +1,324 @@
+#include "BuildDatabase.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+qint64 fileMtime(const QFileInfo &info) {
+    return info.lastModified().toMSecsSinceEpoch();
+}
+}
+
+bool BuildDatabase::load(const QString &path) {
+    path_ = path;
+    units_.clear();
+    files_.clear();
+    linkHash_.clear();
+    isolated_.clear();
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != 1) {
+        return false;
+    }
+
+    linkHash_ = root.value("link").toString();
+
+    const QJsonObject filesObj = root.value("files").toObject();
+    for (auto it = filesObj.begin(); it != filesObj.end(); ++it) {
+        const QJsonObject f = it.value().toObject();
+        FileState state;
+        state.mtime = static_cast<qint64>(f.value("mtime").toDouble());
+        state.hash = QByteArray::fromHex(f.value("hash").toString().toLatin1());
+        files_.insert(it.key(), state);
+    }
+
+    const QJsonObject unitsObj = root.value("units").toObject();
+    for (auto it = unitsObj.begin(); it != unitsObj.end(); ++it) {
+        const QJsonObject u = it.value().toObject();
+        Unit unit;
+        unit.object = u.value("object").toString();
+        unit.flagsHash = u.value("flags").toString();
+        const QJsonObject depsObj = u.value("deps").toObject();
+        for (auto d = depsObj.begin(); d != depsObj.end(); ++d) {
+            unit.deps.insert(d.key(), QByteArray::fromHex(d.value().toString().toLatin1()));
+        }
+        units_.insert(it.key(), unit);
+    }
+
+    for (const auto &value : root.value("isolated").toArray()) {
+        isolated_.insert(value.toString());
+    }
+    return true;
+}
+
+bool BuildDatabase::save() const {
+    if (path_.isEmpty()) {
+        return false;
+    }
+    QDir().mkpath(QFileInfo(path_).absolutePath());
+
+    QJsonObject root;
+    root.insert("version", 1);
+    root.insert("link", linkHash_);
+
+    QJsonObject filesObj;
+    for (auto it = files_.cbegin(); it != files_.cend(); ++it) {
+        QJsonObject f;
+        f.insert("mtime", static_cast<double>(it.value().mtime));
+        f.insert("hash", QString::fromLatin1(it.value().hash.toHex()));
+        filesObj.insert(it.key(), f);
+    }
+    root.insert("files", filesObj);
+
+    QJsonObject unitsObj;
+    for (auto it = units_.cbegin(); it != units_.cend(); ++it) {
+        QJsonObject u;
+        u.insert("object", it.value().object);
+        u.insert("flags", it.value().flagsHash);
+        QJsonObject depsObj;
+        for (auto d = it.value().deps.cbegin(); d != it.value().deps.cend(); ++d) {
+            depsObj.insert(d.key(), QString::fromLatin1(d.value().toHex()));
+        }
+        u.insert("deps", depsObj);
+        unitsObj.insert(it.key(), u);
+    }
+    root.insert("units", unitsObj);
+
+    QJsonArray isolatedArr;
+    for (const QString &src : isolated_) {
+        isolatedArr.append(src);
+    }
+    root.insert("isolated", isolatedArr);
+
+    QSaveFile file(path_);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void BuildDatabase::clear() {
+    units_.clear();
+    files_.clear();
+    linkHash_.clear();
+    isolated_.clear();
+}
+
+QString BuildDatabase::path() const {
+    return path_;
+}
+
+bool BuildDatabase::isStale(const QString &source, const QString &object, const QString &flagsHash) {
+    auto it = units_.constFind(source);
+    if (it == units_.cend()) {
+        return true;
+    }
+    const Unit &unit = it.value();
+    if (unit.object != object || unit.flagsHash != flagsHash || !QFileInfo::exists(object)) {
+        return true;
+    }
+    if (unit.deps.isEmpty()) {
+        return true;
+    }
+    for (auto d = unit.deps.cbegin(); d != unit.deps.cend(); ++d) {
+        const QByteArray hash = currentHash(d.key());
+        if (hash.isEmpty() || hash != d.value()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QHash<QString, QByteArray> BuildDatabase::snapshotInputs(const QString &source, const QStringList &extraDeps) {
+    QStringList inputs = units_.value(source).deps.keys();
+    inputs.append(source);
+    inputs.append(extraDeps);
+    QHash<QString, QByteArray> snapshot;
+    for (const QString &input : inputs) {
+        const QByteArray hash = currentHash(input);
+        if (!hash.isEmpty()) {
+            snapshot.insert(input, hash);
+        }
+    }
+    return snapshot;
+}
+
+bool BuildDatabase::recordCompiled(const QString &source, const QString &object, const QString &flagsHash,
+                                   const QString &depFile, const QString &workingDir,
+                                   const QStringList &extraDeps, const QHash<QString, QByteArray> &launchHashes,
+                                   qint64 launchedMs) {
+    Unit unit;
+    unit.object = object;
+    unit.flagsHash = flagsHash;
+
+    QStringList deps = parseDepFile(depFile, workingDir);
+    if (!deps.contains(source)) {
+        deps.prepend(source);
+    }
+    for (const QString &extra : extraDeps) {
+        if (!deps.contains(extra)) {
+            deps.append(extra);
+        }
+    }
+    for (const QString &dep : deps) {
+        auto snap = launchHashes.constFind(dep);
+        if (snap != launchHashes.cend()) {
+            unit.deps.insert(dep, snap.value());
+            continue;
+        }
+        // 启动时还不知道的依赖：编译过程中被改过就无法确定编进去的是哪个版本
+        const QFileInfo info(dep);
+        if (info.exists() && fileMtime(info) >= launchedMs) {
+            units_.remove(source);
+            return false;
+        }
+        const QByteArray hash = currentHash(dep);
+        if (!hash.isEmpty()) {
+            unit.deps.insert(dep, hash);
+        }
+    }
+    units_.insert(source, unit);
+    return true;
+}
+
+void BuildDatabase::removeUnit(const QString &source) {
+    units_.remove(source);
+}
+
+QStringList BuildDatabase::dependencies(const QString &source) const {
+    return units_.value(source).deps.keys();
+}
+
+QStringList BuildDatabase::changedDependencies(const QString &source) {
+    QStringList changed;
+    auto it = units_.constFind(source);
+    if (it == units_.cend()) {
+        return changed;
+    }
+    for (auto d = it.value().deps.cbegin(); d != it.value().deps.cend(); ++d) {
+        const QByteArray hash = currentHash(d.key());
+        if (hash.isEmpty() || hash != d.value()) {
+            changed.append(d.key());
+        }
+    }
+    return changed;
+}
+
+QSet<QString> BuildDatabase::isolatedSources() const {
+    return isolated_;
+}
+
+void BuildDatabase::setIsolatedSources(const QSet<QString> &sources) {
+    isolated_ = sources;
+}
+
+QString BuildDatabase::linkHash() const {
+    return linkHash_;
+}
+
+void BuildDatabase::setLinkHash(const QString &hash) {
+    linkHash_ = hash;
+}
+
+QString BuildDatabase::hashArguments(const QString &program, const QStringList &args) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(program.toUtf8());
+    for (const QString &arg : args) {
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(arg.toUtf8());
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QStringList BuildDatabase::parseDepFile(const QString &depFile, const QString &workingDir) {
+    QFile file(depFile);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    QString text = QString::fromLocal8Bit(file.readAll());
+    text.replace(QStringLiteral("\\\r\n"), QStringLiteral(" "));
+    text.replace(QStringLiteral("\\\n"), QStringLiteral(" "));
+
+    // 目标名本身可能带盘符（C:\...），因此找第一个后面跟空白的冒号。
+    int colon = -1;
+    for (int i = 0; i + 1 < text.size(); ++i) {
+        if (text.at(i) == ':' && text.at(i + 1).isSpace()) {
+            colon = i;
+            break;
+        }
+    }
+    if (colon < 0) {
+        return {};
+    }
+
+    const QDir base(workingDir.isEmpty() ? QDir::currentPath() : workingDir);
+    QStringList deps;
+    QString current;
+    const QString body = text.mid(colon + 1);
+    for (int i = 0; i < body.size(); ++i) {
+        const QChar c = body.at(i);
+        if (c == '\\' && i + 1 < body.size() && body.at(i + 1) == ' ') {
+            current += ' ';
+            ++i;
+        } else if (c == '$' && i + 1 < body.size() && body.at(i + 1) == '$') {
+            current += '$';
+            ++i;
+        } else if (c.isSpace()) {
+            if (!current.isEmpty()) {
+                deps.append(QDir::cleanPath(base.absoluteFilePath(current)));
+                current.clear();
+            }
+            if (c == '\n') {
+                // -MP 生成的空规则从第二行开始，只取第一条规则。
+                break;
+            }
+        } else {
+            current += c;
+        }
+    }
+    if (!current.isEmpty()) {
+        deps.append(QDir::cleanPath(base.absoluteFilePath(current)));
+    }
+    deps.removeDuplicates();
+    return deps;
+}
+
+QByteArray BuildDatabase::currentHash(const QString &filePath) {
+    const QFileInfo info(filePath);
+    if (!info.exists()) {
+        return {};
+    }
+    const qint64 mtime = fileMtime(info);
+    auto it = files_.find(filePath);
+    if (it != files_.end() && it.value().mtime == mtime && !it.value().hash.isEmpty()) {
+        return it.value().hash;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    FileState state;
+    state.mtime = mtime;
+    state.hash = hash.result();
+    files_.insert(filePath, state);
+    return state.hash;
+}
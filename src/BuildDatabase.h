@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// 增量编译状态：记录每个翻译单元的目标文件、编译参数指纹以及 -MMD 生成的头文件依赖，
+// 依赖文件按 mtime + 内容哈希判断是否变化（仅 touch 不会触发重编译）。
+class BuildDatabase {
+public:
+    BuildDatabase() = default;
+
+    bool load(const QString &path);
+    bool save() const;
+    void clear();
+    QString path() const;
+
+    bool isStale(const QString &source, const QString &object, const QString &flagsHash);
+    // 编译开始前调用：记下源文件、extraDeps 和上次已知头文件此刻的哈希
+    QHash<QString, QByteArray> snapshotInputs(const QString &source, const QStringList &extraDeps = {});
+    // 依赖哈希取自启动时的快照，编译期间被改过的文件下次仍会判为过期；
+    // 新发现的依赖若在 launchedMs 之后被修改则不记录这个单元，返回 false
+    bool recordCompiled(const QString &source, const QString &object, const QString &flagsHash,
+                        const QString &depFile, const QString &workingDir, const QStringList &extraDeps,
+                        const QHash<QString, QByteArray> &launchHashes, qint64 launchedMs);
+    void removeUnit(const QString &source);
+    QStringList dependencies(const QString &source) const;
+    QStringList changedDependencies(const QString &source);
+
+    // Unity 构建中因改动而被拆出来单独编译的源文件。
+    QSet<QString> isolatedSources() const;
+    void setIsolatedSources(const QSet<QString> &sources);
+
+    QString linkHash() const;
+    void setLinkHash(const QString &hash);
+
+    static QString hashArguments(const QString &program, const QStringList &args);
+    static QStringList parseDepFile(const QString &depFile, const QString &workingDir);
+
+private:
+    struct FileState {
+        qint64 mtime = 0;
+        QByteArray hash;
+    };
+
+    struct Unit {
+        QString object;
+        QString flagsHash;
+        QHash<QString, QByteArray> deps;
+    };
+
+    QByteArray currentHash(const QString &filePath);
+
+    QString path_;
+    QString linkHash_;
+    QHash<QString, Unit> units_;
+    QHash<QString, FileState> files_;
+    QSet<QString> isolated_;
+};
@@ -1,9 +1,91 @@
 #include "BuildManager.h"
 
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTextStream>
 #include <QDir>
+#include <QThread>
+
+namespace {
+// 源文件相对工程根目录的路径后面加 .o（保留原扩展名，同一目录下的 foo.cpp 和 foo.cc 不会撞到同一个目标文件）；
+// 根目录之外的源文件放到 _ext/ 下，按绝对路径展开，避免 ../ 逃出构建目录。
+QString objectRelPath(const QDir &root, const QString &absSource) {
+    QString rel = root.relativeFilePath(absSource);
+    if (rel.startsWith(QLatin1String("../")) || QFileInfo(rel).isAbsolute()) {
+        QString flat = QDir::cleanPath(absSource);
+        flat.replace(':', '_');
+        while (flat.startsWith('/')) {
+            flat.remove(0, 1);
+        }
+        rel = QStringLiteral("_ext/") + flat;
+    }
+    const QFileInfo info(rel);
+    const QString dir = info.path() == QLatin1String(".") ? QString() : info.path() + '/';
+    return dir + info.fileName() + QStringLiteral(".o");
+}
+
+void splitLinkFlags(const QStringList &extraFlags, QStringList *flags, QStringList *libs) {
+    for (const QString &flag : extraFlags) {
+        (flag.startsWith("-l") ? libs : flags)->append(flag);
+    }
+}
+
+QString makeEscape(QString path) {
+    path.replace('$', QLatin1String("$$"));
+    path.replace(' ', QLatin1String("\\ "));
+    return path;
+}
+
+// build 行里的路径要转义 $、空格和冒号；变量值里只需转义 $。
+QString ninjaEscapePath(QString path) {
+    path.replace('$', QLatin1String("$$"));
+    path.replace(' ', QLatin1String("$ "));
+    path.replace(':', QLatin1String("$:"));
+    return path;
+}
+
+QString ninjaEscapeValue(QString value) {
+    return value.replace('$', QLatin1String("$$"));
+}
+
+bool isClang(const QString &compiler) {
+    return QFileInfo(compiler).fileName().contains("clang");
+}
+
+// gcc 没有 thin LTO，-flto=auto 按 make jobserver/CPU 核心数并行做 LTRANS，效果最接近。
+QString ltoFlag(const QString &compiler) {
+    return isClang(compiler) ? QStringLiteral("-flto=thin") : QStringLiteral("-flto=auto");
+}
+
+QStringList codegenFlags(const QString &compiler, bool splitDwarf, bool thinLto) {
+    QStringList flags;
+    if (splitDwarf) {
+        flags << QStringLiteral("-gsplit-dwarf");
+    }
+    if (thinLto) {
+        flags << ltoFlag(compiler);
+    }
+    return flags;
+}
+
+// LTO 目标文件里是中间表示，普通 ar 建不出符号索引，要用带插件的 gcc-ar / llvm-ar。
+QString archiverTool(const QString &compiler, bool thinLto) {
+    if (thinLto) {
+        const QString tool = QStandardPaths::findExecutable(isClang(compiler) ? QStringLiteral("llvm-ar")
+                                                                               : QStringLiteral("gcc-ar"));
+        if (!tool.isEmpty()) {
+            return QFileInfo(tool).fileName();
+        }
+    }
+    return QStringLiteral("ar");
+}
+}
 
 BuildManager::BuildManager(QObject *parent) : QObject(parent) {
     process_.setProcessChannelMode(QProcess::MergedChannels);
@@ -11,16 +93,48 @@ BuildManager::BuildManager(QObject *parent) : QObject(parent) {
     connect(&process_, &QProcess::readyReadStandardError, this, &BuildManager::handleReadyRead);
     connect(&process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &BuildManager::handleFinished);
+
+    // 编译器进程往往只活几百毫秒，100ms 采样一次 VmHWM 足以拿到峰值（VmHWM 本身就是历史最大值）。
+    rssTimer_.setInterval(100);
+    connect(&rssTimer_, &QTimer::timeout, this, &BuildManager::sampleMemory);
 }
 
-void BuildManager::compile(const BuildConfig &config) {
-    if (process_.state() != QProcess::NotRunning) {
-        process_.kill();
-        process_.waitForFinished(1000);
+BuildManager::~BuildManager() {
+    // QProcess 析构时会结束并回收检测进程，之后再删它的临时目录
+    if (linkerProbe_) {
+        linkerProbe_->disconnect(this);
+        delete linkerProbe_;
+    }
+    delete linkerProbeDir_;
+    for (QThread *thread : cacheThreads_) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void BuildManager::compile(const BuildConfig &requested) {
+    if (isBuilding()) {
+        // 不打断正在进行的编译（打断只会浪费已完成的工作），只记下最新的一次请求，
+        // 当前编译结束后再增量编译一次；连续多次请求合并为一次。
+        const bool merged = buildQueued_;
+        queuedConfig_ = requested;
+        buildQueued_ = true;
+        emit outputReady(merged ? tr("已合并到排队中的编译请求。\n") : tr("编译进行中，结束后将重新编译。\n"));
+        return;
     }
 
+    BuildConfig config = requested;
+    abortJobs();
+    seenDiagnostics_.clear();
+    processBuffer_.clear();
+    ninjaBuild_ = false;
+    metrics_.begin(config.profileName);
+    metricsDirectory_ = config.buildDirectory.isEmpty() ? QString() : QDir(config.buildDirectory).filePath("metrics");
+    buildClock_.start();
+
     if (config.sources.isEmpty()) {
-        emit outputReady(tr("没有需要编译的源文件。"));
+        emit outputReady(tr("没有需要编译的源文件。\n"));
+        emit buildFinished(-1, QProcess::NormalExit);
         return;
     }
 
@@ -29,59 +143,31 @@ void BuildManager::compile(const BuildConfig &config) {
         QFileInfo info(src);
         if (!info.exists()) {
             emit outputReady(tr("源文件不存在：%1\n").arg(src));
+            emit buildFinished(-1, QProcess::NormalExit);
             return;
         }
         absSources.append(info.absoluteFilePath());
     }
 
-    const bool isStaticLib = config.outputPath.endsWith(".a");
-    if (isStaticLib) {
-        QStringList objPaths;
-        for (const QString &absSrc : absSources) {
-            QFileInfo info(absSrc);
-            const QString objPath = info.absolutePath() + QDir::separator() + info.completeBaseName() + ".o";
-            objPaths.append(objPath);
-
-            QStringList args;
-            args << ("-std=" + config.cxxStandard) << "-Wall";
-            for (const QString &inc : config.includeDirs) {
-                args << ("-I" + QFileInfo(inc).absoluteFilePath());
-            }
-            args << config.extraFlags;
-            args << "-c" << absSrc << "-o" << objPath;
-
-            emit outputReady(tr("%1 %2\n").arg(config.compiler, args.join(' ')));
-            QProcess proc;
-            proc.setProcessChannelMode(QProcess::MergedChannels);
-            proc.setWorkingDirectory(config.workingDirectory.isEmpty() ? info.absolutePath() : config.workingDirectory);
-            proc.start(config.compiler, args);
-            proc.waitForFinished(-1);
-            const QString out = QString::fromLocal8Bit(proc.readAllStandardOutput());
-            if (!out.isEmpty()) {
-                emit outputReady(out);
-            }
-            if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
-                emit buildFinished(proc.exitCode(), proc.exitStatus());
-                return;
-            }
-        }
-
-        lastBinaryPath_ = config.outputPath;
-        QStringList arArgs = {"rcs", lastBinaryPath_};
-        arArgs += objPaths;
-        emit outputReady(tr("ar %1\n").arg(arArgs.join(' ')));
-        QProcess arProc;
-        arProc.setProcessChannelMode(QProcess::MergedChannels);
-        arProc.setWorkingDirectory(config.workingDirectory);
-        arProc.start("ar", arArgs);
-        arProc.waitForFinished(-1);
-        const QString arOut = QString::fromLocal8Bit(arProc.readAllStandardOutput());
-        if (!arOut.isEmpty()) {
-            emit outputReady(arOut);
-        }
-        emit buildFinished(arProc.exitCode(), arProc.exitStatus());
+    bool linkerPending = false;
+    config.linker = resolveLinker(requested, &linkerPending);
+    buildNeedsProbe_ = linkerPending;
+    const bool delegating = config.delegateToNinja && config.perUnitBuild && !config.unityBuild
+                            && !config.buildDirectory.isEmpty() && !config.workingDirectory.isEmpty();
+    if (linkerPending && (!config.perUnitBuild || delegating)) {
+        // ninja 和单进程编译开始前就要定下链接参数，等检测结果出来再开始
+        deferredConfig_ = requested;
+        deferredStart_ = true;
+        emit outputReady(tr("正在检测链接器 %1...\n").arg(requested.linker));
         return;
     }
+    if (config.splitDwarf && config.useCompileCache) {
+        // 缓存只保存 .o，拆出去的 .dwo 取不回来，调试信息会缺失。
+        config.useCompileCache = false;
+        emit outputReady(tr("已启用 -gsplit-dwarf，本次编译不使用编译缓存。\n"));
+    }
+
+    openDatabase(config);
 
     lastBinaryPath_ = config.outputPath;
     if (lastBinaryPath_.isEmpty()) {
@@ -89,12 +175,123 @@ void BuildManager::compile(const BuildConfig &config) {
         lastBinaryPath_ = first.absolutePath() + QDir::separator() + first.completeBaseName();
     }
 
-    QStringList args;
-    args << ("-std=" + config.cxxStandard) << "-Wall";
-    for (const QString &inc : config.includeDirs) {
-        args << ("-I" + QFileInfo(inc).absoluteFilePath());
+    // ninja 自己维护依赖和并行，unity 批次由内置流水线生成，两者不混用。
+    if (delegating && startNinja(config)) {
+        return;
     }
-    args << config.extraFlags;
+
+    // 静态库总是走并行任务流水线：逐个翻译单元编译，最后由 ar 打包。
+    const bool isStaticLib = lastBinaryPath_.endsWith(".a");
+    if (config.perUnitBuild || isStaticLib) {
+        activeConfig_ = config;
+        archiving_ = isStaticLib;
+        if (activeConfig_.workingDirectory.isEmpty()) {
+            activeConfig_.workingDirectory = QFileInfo(absSources.first()).absolutePath();
+        }
+        const QStringList baseFlags = compileFlags(config);
+        QStringList flags = baseFlags;
+        QString pchFile;
+        bool pchStale = false;
+        if (!config.pchHeader.isEmpty() && !config.buildDirectory.isEmpty()) {
+            if (QFileInfo::exists(config.pchHeader)) {
+                const QString wrapper = pchWrapperPath(QDir(profileBuildDir(config)).filePath("pch"), config.pchHeader);
+                writePchWrapper(wrapper, config.pchHeader);
+                pchFile = wrapper + ".gch";
+
+                CompileJob pchJob;
+                pchJob.source = wrapper;
+                pchJob.object = pchFile;
+                pchJob.depFile = depFilePathFor(pchFile);
+                pchJob.flagsHash = BuildDatabase::hashArguments(config.compiler, baseFlags);
+                pchJob.args = baseFlags;
+                if (config.incremental) {
+                    pchJob.args << "-MMD" << "-MF" << pchJob.depFile;
+                }
+                pchJob.args << "-x" << "c++-header" << wrapper << "-o" << pchFile;
+                pchJob.label = tr("预编译头 %1").arg(QFileInfo(config.pchHeader).fileName());
+                pchJob.pch = true;
+                pchStale = !config.incremental || database_.isStale(wrapper, pchFile, pchJob.flagsHash);
+                if (pchStale) {
+                    pendingJobs_.append(pchJob);
+                }
+                // gcc 和 clang 遇到 -include x 时都会优先使用同目录下的 x.gch。
+                flags << "-Winvalid-pch" << "-include" << wrapper;
+            } else {
+                emit outputReady(tr("预编译头不存在，已忽略：%1\n").arg(config.pchHeader));
+            }
+        }
+        const QString flagsHash = BuildDatabase::hashArguments(config.compiler, flags);
+        cache_.resetStats();
+        cacheKeyBase_.clear();
+        if (config.useCompileCache) {
+            cacheKeyBase_ = cache_.compilerIdentity(config.compiler) + '\n' + config.cxxStandard + '\n'
+                            + flags.join('\n') + '\n';
+        }
+        QStringList units = absSources;
+        QHash<QString, QString> unitLabels;
+        if (config.unityBuild && absSources.size() > 1) {
+            units = prepareUnityUnits(config, absSources, &unitLabels);
+        }
+        int staleUnits = 0;
+        for (const QString &absSrc : units) {
+            CompileJob job;
+            job.source = absSrc;
+            job.object = objectPathFor(activeConfig_, absSrc);
+            job.depFile = depFilePathFor(job.object);
+            job.flagsHash = flagsHash;
+            if (!pchFile.isEmpty()) {
+                job.extraDeps << pchFile;
+            }
+            job.args = flags;
+            if (config.incremental) {
+                job.args << "-MMD" << "-MF" << job.depFile;
+            }
+            if (config.useCompileCache) {
+                job.preprocessArgs = flags;
+                if (config.incremental) {
+                    job.preprocessArgs << "-MMD" << "-MF" << job.depFile << "-MT" << job.object;
+                }
+                job.preprocessArgs << "-E" << absSrc;
+                job.preprocessing = true;
+            }
+            // -ftime-trace 不计入 flagsHash：开关它不应触发全量重编译。
+            if (config.timeTrace && isClang(config.compiler)) {
+                job.args << "-ftime-trace";
+                job.timeTrace = true;
+            }
+            job.args << "-c" << absSrc << "-o" << job.object;
+            job.label = unitLabels.value(absSrc, QFileInfo(absSrc).fileName());
+            linkObjects_.append(job.object);
+            // 预编译头要重建时，用到它的翻译单元一律重编译（依赖里只有旧的 .gch）。
+            if (config.incremental && !pchStale && !database_.isStale(absSrc, job.object, flagsHash)) {
+                continue;
+            }
+            // 编译器和缓存都不会替我们创建 -o 的父目录。
+            QDir().mkpath(QFileInfo(job.object).absolutePath());
+            pendingJobs_.append(job);
+            ++staleUnits;
+        }
+        totalJobs_ = pendingJobs_.size();
+        finishedJobs_ = 0;
+        progressTotal_ = totalJobs_ + 1; // 最后的链接/打包也算一步
+        maxJobs_ = config.jobs > 0 ? config.jobs : qMax(1, QThread::idealThreadCount());
+        linkPending_ = true;
+        if (staleUnits < units.size()) {
+            emit outputReady(tr("%1 个编译单元已是最新，需要编译 %2 个（%3 个并行任务）\n")
+                                 .arg(units.size() - staleUnits)
+                                 .arg(staleUnits)
+                                 .arg(maxJobs_));
+        } else {
+            emit outputReady(tr("并行编译 %1 个编译单元（%2 个任务）\n").arg(staleUnits).arg(maxJobs_));
+        }
+        emit buildStarted();
+        emit buildProgress(0, progressTotal_);
+        startNextJobs();
+        return;
+    }
+
+    QStringList args = compileFlags(config);
+    args << linkFlags(config);
     args << absSources;
     args << "-o" << lastBinaryPath_;
 
@@ -107,114 +304,1229 @@ void BuildManager::compile(const BuildConfig &config) {
     } else {
         process_.setWorkingDirectory(QFileInfo(absSources.first()).absolutePath());
     }
+    processParser_ = DiagnosticParser(process_.workingDirectory());
+    emit buildStarted();
+    beginProcessMetrics(QFileInfo(absSources.first()).fileName(), absSources.first(), QStringLiteral("compile"));
     process_.start();
 }
 
 void BuildManager::runLastBinary(const QStringList &args, const QString &workingDirectory) {
     if (lastBinaryPath_.isEmpty()) {
-        emit outputReady(tr("尚未编译过任何文件。"));
+        emit outputReady(tr("尚未编译过任何文件。\n"));
         return;
     }
 
     QFileInfo binInfo(lastBinaryPath_);
     if (!binInfo.exists()) {
-        emit outputReady(tr("可执行文件不存在，请先编译。"));
+        emit outputReady(tr("可执行文件不存在，请先编译。\n"));
         return;
     }
 
-    auto *runProcess = new QProcess(this);
-    runProcess->setProcessChannelMode(QProcess::MergedChannels);
-    runProcess->setProgram(lastBinaryPath_);
-    runProcess->setArguments(args);
-    runProcess->setWorkingDirectory(workingDirectory.isEmpty() ? binInfo.absolutePath() : workingDirectory);
-
-    connect(runProcess, &QProcess::readyReadStandardOutput, this, [this, runProcess]() {
-        emit outputReady(QString::fromLocal8Bit(runProcess->readAllStandardOutput()));
-    });
-    connect(runProcess, &QProcess::readyReadStandardError, this, [this, runProcess]() {
-        emit outputReady(QString::fromLocal8Bit(runProcess->readAllStandardError()));
-    });
-    connect(runProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            runProcess, &QObject::deleteLater);
-
-    emit outputReady(tr("执行：%1 %2\n").arg(lastBinaryPath_, args.join(' ')));
-    runProcess->start();
+    if (runSession_.isRunning()) {
+        emit outputReady(tr("程序仍在运行，请先停止。\n"));
+        return;
+    }
+    // 输出不经过 outputReady：量可能很大，由 RunSession 限速收集，运行控制台按需显示
+    runSession_.start(lastBinaryPath_, args, workingDirectory.isEmpty() ? binInfo.absolutePath() : workingDirectory);
 }
 
 bool BuildManager::generateMakefile(const BuildConfig &config, const QString &makefilePath) {
     if (config.sources.isEmpty() || makefilePath.isEmpty()) {
         return false;
     }
+    const QDir root(QFileInfo(makefilePath).absolutePath());
+    BuildConfig resolved = config;
+    // 生成器只用已有的检测结果，不启动、也不替换检测：正在进行的检测可能有编译在等
+    resolved.linker = resolveLinker(config);
+    if (!config.linker.isEmpty() && resolved.linker.isEmpty()) {
+        emit outputReady(tr("链接器 %1 尚未检测通过，这次生成的 Makefile 使用默认链接器，编译一次后可重新生成。\n")
+                             .arg(config.linker));
+    }
+    if (!writeIfChanged(makefilePath, makefileContent(resolved, root))) {
+        return false;
+    }
+    emit outputReady(tr("已写入 Makefile：%1\n").arg(makefilePath));
+    return true;
+}
 
-    QFile makefile(makefilePath);
-    if (!makefile.open(QFile::WriteOnly | QFile::Text)) {
+bool BuildManager::generateNinjaFile(const BuildConfig &config, const QString &ninjaPath) {
+    if (config.sources.isEmpty() || ninjaPath.isEmpty()) {
         return false;
     }
+    const QDir root(QFileInfo(ninjaPath).absolutePath());
+    BuildConfig resolved = config;
+    // 生成器只用已有的检测结果，不启动、也不替换检测：正在进行的检测可能有编译在等
+    resolved.linker = resolveLinker(config);
+    if (!config.linker.isEmpty() && resolved.linker.isEmpty()) {
+        emit outputReady(tr("链接器 %1 尚未检测通过，这次生成的 build.ninja 使用默认链接器，编译一次后可重新生成。\n")
+                             .arg(config.linker));
+    }
+    if (!writeIfChanged(ninjaPath, ninjaContent(resolved, root, root.filePath("build/ninja")))) {
+        return false;
+    }
+    emit outputReady(tr("已写入 build.ninja：%1\n").arg(ninjaPath));
+    return true;
+}
+
+QList<BuildManager::GeneratorProfile> BuildManager::generatorProfiles(const BuildConfig &config) const {
+    if (!config.profiles.isEmpty()) {
+        return config.profiles;
+    }
+    GeneratorProfile single;
+    single.name = config.profileName.isEmpty() ? QStringLiteral("default") : config.profileName;
+    single.extraFlags = config.extraFlags;
+    single.outputPath = config.outputPath;
+    single.splitDwarf = config.splitDwarf;
+    single.thinLto = config.thinLto;
+    return {single};
+}
+
+QString BuildManager::generatorPchWrapper(const BuildConfig &config, const QString &generatorDir,
+                                          const QString &profile) const {
+    // 生成器用相对路径的参数编译，不能与 IDE 内部构建共用同一个 .gch；
+    // 包装头也不放进 make clean 会删除的模式目录。
+    const QString wrapper = pchWrapperPath(QDir(generatorDir).filePath(QStringLiteral("pch/") + profile), config.pchHeader);
+    writePchWrapper(wrapper, config.pchHeader);
+    return wrapper;
+}
 
-    QFileInfo makeInfo(makefilePath);
-    const QString rootDir = makeInfo.absolutePath();
-    QDir root(rootDir);
+QByteArray BuildManager::makefileContent(const BuildConfig &config, const QDir &root) const {
+    const QList<GeneratorProfile> profiles = generatorProfiles(config);
+    const bool usePch = !config.pchHeader.isEmpty() && QFileInfo::exists(config.pchHeader);
+    const QString generatorDir = root.filePath("build/make");
+    const QString defaultTarget = QFileInfo(config.sources.first()).completeBaseName();
 
-    QStringList srcRel;
-    QStringList objRel;
+    QStringList names;
+    for (const GeneratorProfile &profile : profiles) {
+        names << profile.name;
+    }
+    const QString activeProfile = names.contains(config.profileName) ? config.profileName : names.first();
+
+    QString text;
+    QTextStream out(&text);
+    out << "# 由 RusticCppIDE 生成。make -j 并行构建，make PROFILE=<模式> 切换编译模式（" << names.join('/') << "）。\n";
+    out << "CXX := " << config.compiler << "\n";
+    out << "PROFILE ?= " << activeProfile << "\n";
+    out << "BUILD_DIR := build/make/$(PROFILE)\n";
+    out << "COMMON_FLAGS := -std=" << config.cxxStandard << " -Wall";
+    for (const QString &inc : config.includeDirs) {
+        out << " -I" << makeEscape(root.relativeFilePath(QFileInfo(inc).absoluteFilePath()));
+    }
+    out << "\n";
+    out << "LINKER_FLAGS :=" << (config.linker.isEmpty() ? QString() : " -fuse-ld=" + config.linker) << "\n\n";
+
+    for (int i = 0; i < profiles.size(); ++i) {
+        const GeneratorProfile &profile = profiles.at(i);
+        QStringList flags;
+        QStringList libs;
+        splitLinkFlags(profile.extraFlags, &flags, &libs);
+        flags << codegenFlags(config.compiler, profile.splitDwarf, profile.thinLto);
+        const QString target = profile.outputPath.isEmpty() ? defaultTarget
+                                                            : root.relativeFilePath(QFileInfo(profile.outputPath).absoluteFilePath());
+        out << (i == 0 ? "ifeq" : "else ifeq") << " ($(PROFILE)," << profile.name << ")\n";
+        out << "PROFILE_FLAGS :=" << (flags.isEmpty() ? QString() : ' ' + flags.join(' ')) << "\n";
+        out << "LDLIBS :=" << (libs.isEmpty() ? QString() : ' ' + libs.join(' ')) << "\n";
+        out << "TARGET := " << makeEscape(target) << "\n";
+        out << "AR := " << archiverTool(config.compiler, profile.thinLto) << "\n";
+        if (usePch) {
+            const QString wrapper = generatorPchWrapper(config, generatorDir, profile.name);
+            out << "PCH_HEADER := " << makeEscape(root.relativeFilePath(wrapper)) << "\n";
+        }
+    }
+    out << "else\n$(error 未知的 PROFILE：$(PROFILE)，可选：" << names.join(' ') << ")\nendif\n\n";
+
+    out << "CXXFLAGS := $(COMMON_FLAGS) $(PROFILE_FLAGS)\n";
+    out << "LDFLAGS := $(PROFILE_FLAGS) $(LINKER_FLAGS)\n";
+    if (usePch) {
+        out << "PCH := $(PCH_HEADER).gch\n";
+        out << "PCH_FLAGS := -Winvalid-pch -include $(PCH_HEADER)\n";
+    }
+
+    // 每个源文件一条显式规则：.cc/.cxx 和工程目录外的源文件不依赖 %.o: %.cpp 模式规则，
+    // 目标文件按源文件的相对路径放进 $(BUILD_DIR)/obj，同名源文件不会互相覆盖。
+    QStringList sources;
+    QStringList objects;
     for (const QString &src : config.sources) {
         const QString abs = QFileInfo(src).absoluteFilePath();
-        const QString rel = root.relativeFilePath(abs);
-        srcRel.append(rel);
-        QString obj = rel;
-        int dot = obj.lastIndexOf('.');
-        if (dot >= 0) {
-            obj = obj.left(dot) + ".o";
+        sources << makeEscape(root.relativeFilePath(abs));
+        objects << QStringLiteral("$(BUILD_DIR)/obj/") + makeEscape(objectRelPath(root, abs));
+    }
+    out << "OBJS := \\\n";
+    for (int i = 0; i < objects.size(); ++i) {
+        out << "\t" << objects.at(i) << (i + 1 < objects.size() ? " \\\n" : "\n");
+    }
+    out << "DEPS := $(OBJS:.o=.d)" << (usePch ? " $(PCH).d" : "") << "\n\n";
+
+    out << ".PHONY: all clean\n\n";
+    out << "all: $(TARGET)\n\n";
+    out << "$(TARGET): $(OBJS)\n";
+    out << "\t@mkdir -p $(@D)\n";
+    out << "ifeq ($(suffix $(TARGET)),.a)\n";
+    out << "\trm -f $@\n";
+    out << "\t$(AR) rcs $@ $(OBJS)\n";
+    out << "else\n";
+    out << "\t$(CXX) $(LDFLAGS) -o $@ $(OBJS) $(LDLIBS)\n";
+    out << "endif\n\n";
+    if (usePch) {
+        out << "$(PCH): $(PCH_HEADER) "
+            << makeEscape(root.relativeFilePath(QFileInfo(config.pchHeader).absoluteFilePath())) << "\n";
+        out << "\t$(CXX) $(CXXFLAGS) -MMD -MP -MF $@.d -x c++-header $(PCH_HEADER) -o $@\n\n";
+    }
+    for (int i = 0; i < sources.size(); ++i) {
+        out << objects.at(i) << ": " << sources.at(i) << (usePch ? " $(PCH)" : "") << "\n";
+        out << "\t@mkdir -p $(@D)\n";
+        out << "\t$(CXX) $(CXXFLAGS)" << (usePch ? " $(PCH_FLAGS)" : "") << " -MMD -MP -c $< -o $@\n\n";
+    }
+    out << "clean:\n";
+    out << "\trm -rf $(BUILD_DIR) $(TARGET)" << (usePch ? " $(PCH) $(PCH).d" : "") << "\n\n";
+    out << "-include $(DEPS)\n";
+    out.flush();
+    return text.toUtf8();
+}
+
+QByteArray BuildManager::ninjaContent(const BuildConfig &config, const QDir &root, const QString &ninjaDir) const {
+    const QList<GeneratorProfile> profiles = generatorProfiles(config);
+    const bool usePch = !config.pchHeader.isEmpty() && QFileInfo::exists(config.pchHeader);
+    const QString builddir = root.relativeFilePath(ninjaDir);
+    const QString defaultTarget = QFileInfo(config.sources.first()).completeBaseName();
+
+    QStringList names;
+    for (const GeneratorProfile &profile : profiles) {
+        names << profile.name;
+    }
+    const QString activeProfile = names.contains(config.profileName) ? config.profileName : names.first();
+
+    QString text;
+    QTextStream out(&text);
+    out << "# 由 RusticCppIDE 生成。ninja <模式> 构建指定模式（" << names.join('/') << "），不带参数构建 "
+        << activeProfile << "。\n";
+    out << "ninja_required_version = 1.3\n";
+    out << "builddir = " << ninjaEscapePath(builddir) << "\n";
+    out << "cxx = " << ninjaEscapePath(config.compiler) << "\n";
+    out << "common_flags = -std=" << config.cxxStandard << " -Wall";
+    for (const QString &inc : config.includeDirs) {
+        out << " -I" << ninjaEscapeValue(root.relativeFilePath(QFileInfo(inc).absoluteFilePath()));
+    }
+    out << "\n\n";
+
+    out << "rule cxx\n"
+           "  command = $cxx $flags -MMD -MF $out.d -c $in -o $out\n"
+           "  description = CXX $out\n"
+           "  depfile = $out.d\n"
+           "  deps = gcc\n\n";
+    out << "rule pch\n"
+           "  command = $cxx $flags -MMD -MF $out.d -x c++-header $in -o $out\n"
+           "  description = PCH $out\n"
+           "  depfile = $out.d\n"
+           "  deps = gcc\n\n";
+    out << "rule link\n"
+           "  command = $cxx $ldflags -o $out $in $libs\n"
+           "  description = LINK $out\n\n";
+    out << "rule ar\n"
+           "  command = rm -f $out && $ar rcs $out $in\n"
+           "  description = AR $out\n\n";
+
+    for (const GeneratorProfile &profile : profiles) {
+        QStringList flags;
+        QStringList libs;
+        splitLinkFlags(profile.extraFlags, &flags, &libs);
+        flags << codegenFlags(config.compiler, profile.splitDwarf, profile.thinLto);
+        const QString target = profile.outputPath.isEmpty() ? defaultTarget
+                                                            : root.relativeFilePath(QFileInfo(profile.outputPath).absoluteFilePath());
+        const QString objDir = QStringLiteral("%1/%2/obj/").arg(builddir, profile.name);
+
+        out << "# " << profile.name << "\n";
+        QString profileFlags = QStringLiteral("$common_flags");
+        for (const QString &flag : flags) {
+            profileFlags += ' ' + ninjaEscapeValue(flag);
+        }
+        QString pchFile;
+        if (usePch) {
+            const QString wrapper = root.relativeFilePath(generatorPchWrapper(config, ninjaDir, profile.name));
+            pchFile = wrapper + ".gch";
+            out << "build " << ninjaEscapePath(pchFile) << ": pch " << ninjaEscapePath(wrapper) << " | "
+                << ninjaEscapePath(root.relativeFilePath(QFileInfo(config.pchHeader).absoluteFilePath())) << "\n";
+            out << "  flags = " << profileFlags << "\n";
+            profileFlags += " -Winvalid-pch -include " + ninjaEscapeValue(wrapper);
+        }
+        QStringList objects;
+        for (const QString &src : config.sources) {
+            const QString abs = QFileInfo(src).absoluteFilePath();
+            const QString object = ninjaEscapePath(objDir + objectRelPath(root, abs));
+            objects << object;
+            out << "build " << object << ": cxx " << ninjaEscapePath(root.relativeFilePath(abs));
+            if (!pchFile.isEmpty()) {
+                out << " | " << ninjaEscapePath(pchFile);
+            }
+            out << "\n  flags = " << profileFlags << "\n";
+        }
+        const bool archive = target.endsWith(".a");
+        out << "build " << ninjaEscapePath(target) << ": " << (archive ? "ar " : "link ") << objects.join(' ') << "\n";
+        if (archive) {
+            out << "  ar = " << archiverTool(config.compiler, profile.thinLto) << "\n";
         } else {
-            obj += ".o";
+            QStringList ldflags;
+            if (!config.linker.isEmpty()) {
+                ldflags << ninjaEscapeValue("-fuse-ld=" + config.linker);
+            }
+            for (const QString &flag : flags) {
+                ldflags << ninjaEscapeValue(flag);
+            }
+            out << "  ldflags = " << ldflags.join(' ') << "\n";
+            QStringList escapedLibs;
+            for (const QString &lib : libs) {
+                escapedLibs << ninjaEscapeValue(lib);
+            }
+            out << "  libs = " << escapedLibs.join(' ') << "\n";
+        }
+        // 输出文件恰好与模式同名时不再另建 phony 目标，ninja 不允许同一路径有两条产出规则。
+        if (target != profile.name) {
+            out << "build " << ninjaEscapePath(profile.name) << ": phony " << ninjaEscapePath(target) << "\n";
         }
-        objRel.append(obj);
+        out << "\n";
     }
+    out << "default " << ninjaEscapePath(activeProfile) << "\n";
+    out.flush();
+    return text.toUtf8();
+}
 
-    QTextStream out(&makefile);
-    out << "CXX=" << config.compiler << "\n";
-    out << "CXXFLAGS=-std=" << config.cxxStandard << " -Wall";
+bool BuildManager::writeIfChanged(const QString &path, const QByteArray &content) const {
+    QFile existing(path);
+    if (existing.open(QFile::ReadOnly) && existing.readAll() == content) {
+        return true; // 内容不变时不重写，保持 mtime，make/ninja 不会因此重新生成或重编
+    }
+    existing.close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+    return file.write(content) == content.size() && file.flush();
+}
+
+bool BuildManager::startNinja(const BuildConfig &config) {
+    const QString ninja = QStandardPaths::findExecutable(QStringLiteral("ninja"));
+    if (ninja.isEmpty()) {
+        return false;
+    }
+    const QDir root(config.workingDirectory);
+    const QString ninjaDir = QDir(config.buildDirectory).filePath("ninja");
+    const QString ninjaFile = QDir(ninjaDir).filePath("build.ninja");
+    if (!writeIfChanged(ninjaFile, ninjaContent(config, root, ninjaDir))) {
+        emit outputReady(tr("无法写入 %1，改用内置构建。\n").arg(ninjaFile));
+        return false;
+    }
+
+    QStringList args;
+    args << "-f" << ninjaFile;
+    if (config.jobs > 0) {
+        args << "-j" << QString::number(config.jobs);
+    }
+    const QList<GeneratorProfile> profiles = generatorProfiles(config);
+    for (const GeneratorProfile &profile : profiles) {
+        if (profile.name == config.profileName) {
+            args << profile.name;
+            break;
+        }
+    }
+
+    ninjaBuild_ = true;
+    progressTotal_ = 0;
+    emit outputReady(tr("使用 ninja 构建：%1 %2\n").arg(ninja, args.join(' ')));
+    processParser_ = DiagnosticParser(root.absolutePath());
+    process_.setProgram(ninja);
+    process_.setArguments(args);
+    process_.setWorkingDirectory(root.absolutePath());
+    emit buildStarted();
+    beginProcessMetrics(QFileInfo(lastBinaryPath_).fileName(), lastBinaryPath_, QStringLiteral("ninja"));
+    process_.start();
+    return true;
+}
+
+QStringList BuildManager::compileFlags(const BuildConfig &config) const {
+    QStringList args;
+    args << ("-std=" + config.cxxStandard) << "-Wall" << "-fdiagnostics-parseable-fixits";
     for (const QString &inc : config.includeDirs) {
-        out << " -I" << root.relativeFilePath(QFileInfo(inc).absoluteFilePath());
+        args << ("-I" + QFileInfo(inc).absoluteFilePath());
     }
-    for (const QString &flag : config.extraFlags) {
-        out << " " << flag;
+    args << config.extraFlags;
+    args << codegenFlags(config.compiler, config.splitDwarf, config.thinLto);
+    return args;
+}
+
+QStringList BuildManager::assemblyFlags(const BuildConfig &config) const {
+    BuildConfig plain = config;
+    plain.splitDwarf = false;
+    plain.thinLto = false; // 带 -flto 时 -S 输出的是中间表示而不是机器码
+    QStringList flags = compileFlags(plain);
+    if (!config.pchHeader.isEmpty() && !config.buildDirectory.isEmpty() && QFileInfo::exists(config.pchHeader)) {
+        const QString wrapper = pchWrapperPath(QDir(profileBuildDir(config)).filePath("pch"), config.pchHeader);
+        if (QFileInfo::exists(wrapper)) {
+            flags << "-include" << wrapper;
+        }
     }
-    out << "\n";
+    return flags;
+}
 
-    QFileInfo outInfo(config.outputPath);
-    const QString targetName = outInfo.fileName().isEmpty() ? "a.out" : outInfo.fileName();
-    out << "TARGET=" << targetName << "\n";
-    out << "SRCS=" << srcRel.join(' ') << "\n";
-    out << "OBJS=" << objRel.join(' ') << "\n\n";
+QString BuildManager::upToDateObject(const BuildConfig &config, const QString &absSource) const {
+    // unity 批次和 LTO 的目标文件都不能直接对应到单个源文件的机器码
+    if (isBuilding() || !config.incremental || config.buildDirectory.isEmpty() || config.unityBuild || config.thinLto) {
+        return QString();
+    }
+    // 与 compile() 计算 flagsHash 的方式保持一致
+    QStringList flags = compileFlags(config);
+    if (!config.pchHeader.isEmpty() && QFileInfo::exists(config.pchHeader)) {
+        const QString wrapper = pchWrapperPath(QDir(profileBuildDir(config)).filePath("pch"), config.pchHeader);
+        flags << "-Winvalid-pch" << "-include" << wrapper;
+    }
+    BuildDatabase database;
+    if (!database.load(QDir(profileBuildDir(config)).filePath(".rcppide_build.json"))) {
+        return QString();
+    }
+    const QString object = objectPathFor(config, absSource);
+    if (database.isStale(absSource, object, BuildDatabase::hashArguments(config.compiler, flags))) {
+        return QString();
+    }
+    return object;
+}
 
-    out << "all: $(TARGET)\n\n";
-    out << "$(TARGET): $(OBJS)\n";
-    if (targetName.endsWith(".a")) {
-        out << "\tar rcs $@ $^\n\n";
+QStringList BuildManager::optimizationRecordFlags(const BuildConfig &config, const QString &recordPath) const {
+    QStringList flags = assemblyFlags(config);
+    if (isClang(config.compiler)) {
+        // 没有行号表时记录里没有 DebugLoc，也就对应不回源码
+        flags << "-gline-tables-only" << "-fsave-optimization-record=yaml"
+              << ("-foptimization-record-file=" + recordPath);
     } else {
-        out << "\t$(CXX) $(CXXFLAGS) -o $@ $^\n\n";
+        // gcc 12 对多个 -fopt-info-<组>=文件 只认第一个，这里一次收集所有组，分类交给解析方
+        flags << ("-fopt-info-missed-optimized=" + recordPath);
     }
-    out << "%.o: %.cpp\n";
-    out << "\t$(CXX) $(CXXFLAGS) -c $< -o $@\n\n";
-    out << "clean:\n";
-    out << "\trm -f $(TARGET) $(OBJS)\n";
+    return flags;
+}
 
-    emit outputReady(tr("已写入 Makefile：%1\n").arg(makefilePath));
+QStringList BuildManager::linkFlags(const BuildConfig &config) const {
+    QStringList args;
+    if (!config.linker.isEmpty()) {
+        args << ("-fuse-ld=" + config.linker);
+    }
+    // LTO 的真正代码生成发生在链接阶段，链接命令也要带上同样的 -flto。
+    if (config.thinLto) {
+        args << ltoFlag(config.compiler);
+    }
+    return args;
+}
+
+QString BuildManager::resolveLinker(const BuildConfig &config, bool *pending) {
+    if (pending) {
+        *pending = false;
+    }
+    if (config.linker.isEmpty()) {
+        return QString();
+    }
+    // 编译器驱动找不到链接器、或链接器不支持当前 LTO 方式时 -fuse-ld 只会在链接时报错，
+    // 所以先用一个空 main 试链接一次。结果按编译器和参数缓存，整个会话只试一次。
+    const QString key = config.compiler + '\n' + linkerProbeArgs(config).join(' ');
+    const auto cached = linkerProbes_.constFind(key);
+    if (cached != linkerProbes_.constEnd()) {
+        return cached.value() ? config.linker : QString();
+    }
+    if (pending && startLinkerProbe(config, key)) {
+        *pending = true;
+    }
+    return QString();
+}
+
+QStringList BuildManager::linkerProbeArgs(const BuildConfig &config) const {
+    QStringList probeArgs{QStringLiteral("-fuse-ld=") + config.linker};
+    if (config.thinLto) {
+        probeArgs << ltoFlag(config.compiler);
+    }
+    return probeArgs;
+}
+
+bool BuildManager::startLinkerProbe(const BuildConfig &config, const QString &key) {
+    if (linkerProbe_ && linkerProbeKey_ == key) {
+        return true;
+    }
+    if (linkerProbe_ && buildNeedsProbe_) {
+        return false; // 正在进行的检测有编译在等，不能替换
+    }
+    stopLinkerProbe();
+    auto *dir = new QTemporaryDir();
+    QFile source(dir->filePath("probe.cpp"));
+    if (!dir->isValid() || !source.open(QFile::WriteOnly)) {
+        delete dir;
+        return false;
+    }
+    source.write("int main() { return 0; }\n");
+    source.close();
+
+    linkerProbeDir_ = dir;
+    linkerProbeKey_ = key;
+    linkerProbeLinker_ = config.linker;
+    linkerProbeTimedOut_ = false;
+    linkerProbe_ = new QProcess(this);
+    linkerProbe_->setProcessChannelMode(QProcess::MergedChannels);
+    linkerProbe_->setWorkingDirectory(dir->path());
+    connect(linkerProbe_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this](int exitCode, QProcess::ExitStatus status) {
+                finishLinkerProbe(!linkerProbeTimedOut_ && status == QProcess::NormalExit && exitCode == 0);
+            });
+    connect(linkerProbe_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            finishLinkerProbe(false);
+        }
+    });
+    // 卡住的检测不拖住编译：超时按不可用处理，但不缓存，下次编译再试
+    QProcess *probe = linkerProbe_;
+    QTimer::singleShot(15000, probe, [this, probe]() {
+        if (probe == linkerProbe_) {
+            linkerProbeTimedOut_ = true;
+        }
+        probe->kill();
+    });
+    linkerProbe_->start(config.compiler, linkerProbeArgs(config) + QStringList{source.fileName(), "-o", dir->filePath("probe")});
     return true;
 }
 
+void BuildManager::finishLinkerProbe(bool ok) {
+    const QString output = QString::fromLocal8Bit(linkerProbe_->readAll());
+    const QString key = linkerProbeKey_;
+    const QString linker = linkerProbeLinker_;
+    const bool timedOut = linkerProbeTimedOut_;
+    linkerProbe_->disconnect(this);
+    linkerProbe_->deleteLater();
+    linkerProbe_ = nullptr;
+    delete linkerProbeDir_;
+    linkerProbeDir_ = nullptr;
+
+    if (timedOut) {
+        emit outputReady(tr("检测链接器 %1 超时，本次改用编译器默认的链接器。\n").arg(linker));
+    } else {
+        linkerProbes_.insert(key, ok);
+        if (ok) {
+            emit outputReady(tr("链接器 %1 可用，将通过 -fuse-ld=%1 链接。\n").arg(linker));
+        } else {
+            emit outputReady(tr("链接器 %1 不可用，改用编译器默认的链接器。\n%2").arg(linker, output));
+        }
+    }
+
+    if (!buildNeedsProbe_) {
+        return;
+    }
+    buildNeedsProbe_ = false;
+    if (deferredStart_) {
+        deferredStart_ = false;
+        BuildConfig config = deferredConfig_;
+        config.linker = ok ? linker : QString();
+        compile(config);
+    } else {
+        activeConfig_.linker = ok ? linker : QString();
+        if (awaitingLinker_) {
+            awaitingLinker_ = false;
+            startNextJobs();
+        }
+    }
+}
+
+void BuildManager::stopLinkerProbe() {
+    if (!linkerProbe_) {
+        return;
+    }
+    // 不等待进程退出；临时目录等进程结束后再删
+    QProcess *probe = linkerProbe_;
+    QTemporaryDir *dir = linkerProbeDir_;
+    linkerProbe_ = nullptr;
+    linkerProbeDir_ = nullptr;
+    probe->disconnect(this);
+    if (probe->state() == QProcess::NotRunning) {
+        probe->deleteLater();
+        delete dir;
+        return;
+    }
+    connect(probe, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), probe, [probe, dir]() {
+        delete dir;
+        probe->deleteLater();
+    });
+    probe->kill();
+}
+
+QString BuildManager::profileBuildDir(const BuildConfig &config) const {
+    const QString profile = config.profileName.isEmpty() ? QStringLiteral("default") : config.profileName;
+    return QDir(config.buildDirectory).filePath(profile);
+}
+
+QString BuildManager::objectPathFor(const BuildConfig &config, const QString &absSource) const {
+    const QFileInfo info(absSource);
+    if (config.buildDirectory.isEmpty()) {
+        return info.absoluteFilePath() + ".o";
+    }
+    // 目标文件按源文件相对工程根目录的路径镜像到 build/<模式>/obj/ 下：
+    // 各模式互不覆盖，不同目录下的同名源文件也不会冲突。unity 等生成的源文件单独放在 _gen/ 下。
+    const QDir profileDir(profileBuildDir(config));
+    const QString rel = profileDir.relativeFilePath(absSource);
+    if (!rel.startsWith(QLatin1String("../")) && !QFileInfo(rel).isAbsolute()) {
+        return profileDir.filePath(QStringLiteral("obj/_gen/") + objectRelPath(profileDir, absSource));
+    }
+    return profileDir.filePath(QStringLiteral("obj/") + objectRelPath(QDir(config.workingDirectory), absSource));
+}
+
+QString BuildManager::depFilePathFor(const QString &objectPath) const {
+    QString dep = objectPath;
+    if (dep.endsWith(".o")) {
+        dep.chop(2);
+    }
+    return dep + ".d";
+}
+
+QString BuildManager::pchWrapperPath(const QString &dir, const QString &headerPath) const {
+    const QFileInfo header(headerPath);
+    return QDir(dir).filePath(QStringLiteral("%1_pch.%2").arg(header.completeBaseName(),
+                                                             header.suffix().isEmpty() ? QStringLiteral("h") : header.suffix()));
+}
+
+bool BuildManager::writePchWrapper(const QString &wrapperPath, const QString &headerPath) const {
+    // 包装头只 include 真正的前缀头：.gch 不可用时编译器退回到文本包含，不会直接报错。
+    // 内容不变时不重写，保持 mtime，避免无谓地重建预编译头。
+    const QDir wrapperDir = QFileInfo(wrapperPath).absoluteDir();
+    const QByteArray content = QStringLiteral("#pragma once\n#include \"%1\"\n")
+                                   .arg(wrapperDir.relativeFilePath(QFileInfo(headerPath).absoluteFilePath()))
+                                   .toUtf8();
+    return writeIfChanged(wrapperPath, content);
+}
+
+QStringList BuildManager::prepareUnityUnits(const BuildConfig &config, const QStringList &sources,
+                                            QHash<QString, QString> *labels) {
+    const QDir unityDir(config.buildDirectory.isEmpty()
+                            ? QDir(QFileInfo(sources.first()).absolutePath()).filePath(QStringLiteral("unity"))
+                            : QDir(profileBuildDir(config)).filePath(QStringLiteral("unity")));
+    QDir().mkpath(unityDir.absolutePath());
+
+    // 上次单独编译的文件这次又改了才继续单独编译；一次构建里没再改动的合并回原来的批次，
+    // 否则拆出来的文件只增不减，unity 构建会慢慢退化成逐个文件编译。
+    QSet<QString> isolated;
+    QSet<QString> merged;
+    if (config.incremental) {
+        const QSet<QString> previous = database_.isolatedSources();
+        for (const QString &src : sources) {
+            if (!previous.contains(src)) {
+                continue;
+            }
+            if (database_.changedDependencies(src).contains(src)) {
+                isolated.insert(src);
+            } else {
+                merged.insert(src);
+            }
+        }
+    }
+
+    // 按完整源文件列表分槽：某个文件被拆出去时只影响它所在的那一批，后面的批次保持不变。
+    const int batchSize = qMax(2, config.unityBatchSize);
+    QStringList units;
+    for (int start = 0, index = 0; start < sources.size(); start += batchSize, ++index) {
+        const QString unityPath = unityDir.filePath(QStringLiteral("unity_%1.cpp").arg(index));
+        QStringList members;
+        for (const QString &src : sources.mid(start, batchSize)) {
+            if (!isolated.contains(src)) {
+                members.append(src);
+            }
+        }
+
+        // 上次以 unity 方式编译过、这次有源文件内容变化：把变化的文件拆出来单独编译，
+        // 之后反复修改它们时就不必再重编整个批次。
+        if (config.incremental && members.size() > 1) {
+            const QStringList changed = database_.changedDependencies(unityPath);
+            for (const QString &dep : changed) {
+                // 刚合并回来的文件相对批次上次的记录必然有变化，不能因此再拆出去
+                if (!merged.contains(dep) && members.removeOne(dep)) {
+                    isolated.insert(dep);
+                }
+            }
+        }
+
+        if (members.size() < 2) {
+            units += members;
+            continue;
+        }
+
+        QByteArray content = "// 由 RusticCppIDE 生成的 unity 编译单元，请勿手动修改。\n";
+        for (const QString &src : members) {
+            content += "#include \"" + src.toUtf8() + "\"\n";
+        }
+        if (!writeIfChanged(unityPath, content)) {
+            emit outputReady(tr("无法写入 %1，这一批改为逐个编译。\n").arg(unityPath));
+            units += members;
+            continue;
+        }
+        units.append(unityPath);
+        labels->insert(unityPath, tr("%1（%2 个文件）").arg(QFileInfo(unityPath).fileName()).arg(members.size()));
+    }
+
+    for (const QString &src : sources) {
+        if (isolated.contains(src)) {
+            units.append(src);
+        }
+    }
+    if (config.incremental) {
+        database_.setIsolatedSources(isolated);
+    }
+    if (!isolated.isEmpty()) {
+        emit outputReady(tr("Unity 构建：%1 个改动过的文件单独编译\n").arg(isolated.size()));
+    }
+    if (!merged.isEmpty()) {
+        emit outputReady(tr("Unity 构建：%1 个不再改动的文件合并回原批次\n").arg(merged.size()));
+    }
+    return units;
+}
+
+void BuildManager::openDatabase(const BuildConfig &config) {
+    if (!config.incremental || config.buildDirectory.isEmpty()) {
+        database_ = BuildDatabase();
+        return;
+    }
+    // 每次编译都重新读取，外部清理或手动删除 build/ 后状态仍然一致。
+    // 每个模式一份数据库，切换 Debug/Release 不会让对方的增量状态失效。
+    database_.load(QDir(profileBuildDir(config)).filePath(".rcppide_build.json"));
+}
+
+void BuildManager::startNextJobs() {
+    // 预编译头必须先于所有翻译单元完成。
+    while (!jobFailed_ && !pchRunning_ && !pendingJobs_.isEmpty() && runningJobs_.size() + cacheTasks_ < maxJobs_) {
+        startJob(pendingJobs_.takeFirst());
+    }
+    if (!runningJobs_.isEmpty() || cacheTasks_ > 0) {
+        return;
+    }
+    if (activeConfig_.incremental) {
+        database_.save();
+    }
+    if (activeConfig_.useCompileCache && cache_.hits() + cache_.misses() > 0) {
+        emit outputReady(tr("编译缓存：命中 %1，未命中 %2\n").arg(cache_.hits()).arg(cache_.misses()));
+        cache_.resetStats();
+    }
+    if (jobFailed_) {
+        pendingJobs_.clear();
+        linkObjects_.clear();
+        linkPending_ = false;
+        finishBuild(failedExitCode_, failedStatus_);
+        return;
+    }
+    if (pendingJobs_.isEmpty() && linkPending_) {
+        if (buildNeedsProbe_ && !archiving_) {
+            // 链接器检测还没结束，结果出来后由 finishLinkerProbe 接着链接
+            if (!awaitingLinker_) {
+                awaitingLinker_ = true;
+                emit outputReady(tr("等待链接器 %1 的检测结果...\n").arg(linkerProbeLinker_));
+            }
+            return;
+        }
+        linkPending_ = false;
+        startLink();
+    }
+}
+
+void BuildManager::startJob(CompileJob job) {
+    ++startedJobs_;
+    pchRunning_ = job.pch;
+    emit outputReady(tr("[%1/%2] 编译 %3\n").arg(startedJobs_).arg(totalJobs_).arg(job.label));
+    if (activeConfig_.incremental) {
+        // 先取时间再取哈希：快照之后的任何修改都晚于 launchedMs
+        job.launchedMs = QDateTime::currentMSecsSinceEpoch();
+        job.inputHashes = database_.snapshotInputs(job.source, job.extraDeps);
+    }
+    launchJob(job);
+}
+
+void BuildManager::launchJob(const CompileJob &job) {
+    auto *proc = new BuildProcess(this);
+    proc->setWorkingDirectory(activeConfig_.workingDirectory);
+    int lane = 0;
+    const QList<int> busyLanes = jobLanes_.values();
+    while (busyLanes.contains(lane)) {
+        ++lane;
+    }
+    runningJobs_.insert(proc, job);
+    jobBuffers_.insert(proc, QByteArray());
+    jobParsers_.insert(proc, DiagnosticParser(activeConfig_.workingDirectory));
+    jobStartMs_.insert(proc, buildClock_.elapsed());
+    jobLanes_.insert(proc, lane);
+    jobPeakRss_.insert(proc, 0);
+    if (!rssTimer_.isActive()) {
+        rssTimer_.start();
+    }
+
+    if (job.preprocessing) {
+        // 预处理结果直接流式计算哈希，不落盘；诊断信息走 stderr。
+        proc->setProcessChannelMode(QProcess::SeparateChannels);
+        auto *hash = new QCryptographicHash(QCryptographicHash::Sha256);
+        hash->addData(cacheKeyBase_.toUtf8());
+        jobHashes_.insert(proc, hash);
+        connect(proc, &QProcess::readyReadStandardOutput, this, [this, proc]() {
+            if (QCryptographicHash *h = jobHashes_.value(proc)) {
+                h->addData(proc->readAllStandardOutput());
+            }
+        });
+        connect(proc, &QProcess::readyReadStandardError, this, [this, proc]() {
+            jobBuffers_[proc] += proc->readAllStandardError();
+            flushJobOutput(proc, false);
+        });
+    } else {
+        proc->setProcessChannelMode(QProcess::MergedChannels);
+        connect(proc, &QProcess::readyReadStandardOutput, this, [this, proc]() {
+            jobBuffers_[proc] += proc->readAllStandardOutput();
+            flushJobOutput(proc, false);
+        });
+    }
+    connect(proc, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, proc](int exitCode, QProcess::ExitStatus status) {
+                handleJobFinished(proc, exitCode, status);
+            });
+    connect(proc, &QProcess::errorOccurred, this, [this, proc](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            handleJobFinished(proc, -1, QProcess::CrashExit);
+        }
+    });
+
+    proc->start(activeConfig_.compiler, job.preprocessing ? job.preprocessArgs : job.args);
+}
+
+void BuildManager::flushJobOutput(QProcess *proc, bool final) {
+    QByteArray &buffer = jobBuffers_[proc];
+    const int lastNewline = buffer.lastIndexOf('\n');
+    QByteArray complete;
+    if (final) {
+        complete = buffer;
+        buffer.clear();
+    } else if (lastNewline >= 0) {
+        complete = buffer.left(lastNewline + 1);
+        buffer.remove(0, lastNewline + 1);
+    }
+    auto parser = jobParsers_.find(proc);
+    if (parser != jobParsers_.end()) {
+        reportDiagnostics(parser.value().feed(complete));
+        if (final) {
+            reportDiagnostics(parser.value().finish());
+        }
+    }
+    if (complete.isEmpty()) {
+        return;
+    }
+
+    const QString prefix = QStringLiteral("[%1] ").arg(runningJobs_.value(proc).label);
+    QString text;
+    const QStringList lines = QString::fromLocal8Bit(complete).split('\n');
+    for (const QString &line : lines) {
+        if (!line.isEmpty() && !DiagnosticParser::isFixItLine(line)) {
+            text += prefix + line + '\n';
+        }
+    }
+    if (!text.isEmpty()) {
+        emit outputReady(text);
+    }
+}
+
+void BuildManager::handleJobFinished(QProcess *proc, int exitCode, QProcess::ExitStatus status) {
+    if (!runningJobs_.contains(proc)) {
+        return;
+    }
+    QCryptographicHash *hash = jobHashes_.take(proc);
+    if (hash) {
+        hash->addData(proc->readAllStandardOutput());
+        jobBuffers_[proc] += proc->readAllStandardError();
+    } else {
+        jobBuffers_[proc] += proc->readAllStandardOutput();
+    }
+    flushJobOutput(proc, true);
+
+    CompileJob job = runningJobs_.take(proc);
+    jobBuffers_.remove(proc);
+    jobParsers_.remove(proc);
+    proc->deleteLater();
+    if (job.pch) {
+        pchRunning_ = false;
+    }
+
+    const bool ok = status == QProcess::NormalExit && exitCode == 0;
+    BuildMetrics::Job record;
+    record.label = job.label;
+    record.source = job.source;
+    record.kind = job.pch ? QStringLiteral("pch") : (hash ? QStringLiteral("preprocess") : QStringLiteral("compile"));
+    record.startMs = jobStartMs_.take(proc);
+    record.durationMs = buildClock_.elapsed() - record.startMs;
+    record.peakRssKb = jobPeakRss_.take(proc);
+    record.lane = jobLanes_.take(proc);
+    record.exitCode = exitCode;
+    record.crashed = status != QProcess::NormalExit;
+    metrics_.addJob(record);
+    if (ok && !hash && job.timeTrace) {
+        QString trace = job.object;
+        if (trace.endsWith(".o")) {
+            trace.chop(2);
+        }
+        metrics_.addTimeTrace(trace + ".json");
+    }
+
+    if (hash) {
+        const QString key = QString::fromLatin1(hash->result().toHex());
+        delete hash;
+        if (ok) {
+            job.cacheKey = key;
+            const QString object = job.object;
+            runCacheTask([this, key, object]() { return cache_.fetch(key, object); },
+                         [this, job](bool hit) { finishCacheFetch(job, hit); });
+            return;
+        }
+    }
+
+    if (!ok) {
+        if (!jobFailed_) {
+            failedExitCode_ = exitCode == 0 ? -1 : exitCode;
+            failedStatus_ = status;
+        }
+        jobFailed_ = true;
+        if (activeConfig_.incremental) {
+            database_.removeUnit(job.source);
+        }
+        emit outputReady(tr("[%1] 编译失败\n").arg(job.label));
+    } else {
+        anyCompiled_ = true;
+        if (activeConfig_.incremental) {
+            database_.recordCompiled(job.source, job.object, job.flagsHash, job.depFile,
+                                     activeConfig_.workingDirectory, job.extraDeps, job.inputHashes,
+                                     job.launchedMs);
+        }
+        if (!job.cacheKey.isEmpty()) {
+            const QString key = job.cacheKey;
+            const QString object = job.object;
+            runCacheTask([this, key, object]() { return cache_.store(key, object); }, nullptr);
+        }
+    }
+    emit buildProgress(++finishedJobs_, progressTotal_);
+    startNextJobs();
+}
+
+void BuildManager::runCacheTask(const std::function<bool()> &task, const std::function<void(bool)> &done) {
+    const int generation = cacheGeneration_;
+    ++cacheTasks_;
+    QThread *thread = QThread::create([this, task, done, generation]() {
+        const bool ok = task();
+        QThread *self = QThread::currentThread();
+        QMetaObject::invokeMethod(this, [this, self, done, generation, ok]() {
+            self->wait();
+            cacheThreads_.remove(self);
+            self->deleteLater();
+            if (generation != cacheGeneration_) {
+                return; // 这次编译已经取消或重新开始
+            }
+            --cacheTasks_;
+            if (done) {
+                done(ok);
+            } else {
+                startNextJobs();
+            }
+        }, Qt::QueuedConnection);
+    });
+    cacheThreads_.insert(thread);
+    thread->start();
+}
+
+void BuildManager::finishCacheFetch(CompileJob job, bool hit) {
+    if (hit) {
+        anyCompiled_ = true;
+        if (activeConfig_.incremental) {
+            database_.recordCompiled(job.source, job.object, job.flagsHash, job.depFile,
+                                     activeConfig_.workingDirectory, job.extraDeps, job.inputHashes,
+                                     job.launchedMs);
+        }
+        emit outputReady(tr("[%1] 命中编译缓存\n").arg(job.label));
+        emit buildProgress(++finishedJobs_, progressTotal_);
+        startNextJobs();
+        return;
+    }
+    if (jobFailed_) {
+        startNextJobs(); // 别的单元已经失败，不再开始新的编译
+        return;
+    }
+    job.preprocessing = false;
+    launchJob(job);
+}
+
+void BuildManager::startLink() {
+    const QString program = archiving_ ? archiverTool(activeConfig_.compiler, activeConfig_.thinLto)
+                                       : activeConfig_.compiler;
+    QStringList args;
+    if (archiving_) {
+        args << "rcs" << lastBinaryPath_ << linkObjects_;
+    } else {
+        args << linkFlags(activeConfig_);
+        QStringList libs;
+        for (const QString &flag : activeConfig_.extraFlags) {
+            if (flag.startsWith("-l")) {
+                libs << flag;
+            } else {
+                args << flag;
+            }
+        }
+        args << linkObjects_ << libs;
+        args << "-o" << lastBinaryPath_;
+    }
+
+    const QString linkHash = BuildDatabase::hashArguments(program, args);
+    if (activeConfig_.incremental && !anyCompiled_ && database_.linkHash() == linkHash) {
+        const QFileInfo outInfo(lastBinaryPath_);
+        bool upToDate = outInfo.exists();
+        for (const QString &obj : linkObjects_) {
+            if (!upToDate) {
+                break;
+            }
+            upToDate = QFileInfo(obj).lastModified() <= outInfo.lastModified();
+        }
+        if (upToDate) {
+            linkObjects_.clear();
+            totalJobs_ = 0;
+            emit outputReady(tr("目标文件与链接参数均未变化，跳过链接：%1\n").arg(lastBinaryPath_));
+            emit buildProgress(progressTotal_, progressTotal_);
+            finishBuild(0, QProcess::NormalExit);
+            return;
+        }
+    }
+    pendingLinkHash_ = activeConfig_.incremental ? linkHash : QString();
+    linkObjects_.clear();
+    totalJobs_ = 0;
+
+    if (archiving_) {
+        // ar rcs 只会替换同名成员，先删掉旧库，已移出工程的目标文件才不会残留在库里。
+        QFile::remove(lastBinaryPath_);
+        emit outputReady(tr("打包：%1 %2\n").arg(program, args.join(' ')));
+    } else {
+        emit outputReady(tr("链接：%1 %2\n").arg(activeConfig_.compiler, args.join(' ')));
+    }
+    processParser_ = DiagnosticParser(activeConfig_.workingDirectory);
+    process_.setProgram(program);
+    process_.setArguments(args);
+    process_.setWorkingDirectory(activeConfig_.workingDirectory);
+    beginProcessMetrics(QFileInfo(lastBinaryPath_).fileName(), lastBinaryPath_,
+                        archiving_ ? QStringLiteral("archive") : QStringLiteral("link"));
+    process_.start();
+}
+
+void BuildManager::abortJobs() {
+    const QList<QProcess *> procs = runningJobs_.keys();
+    for (QProcess *proc : procs) {
+        // 不等待进程退出，避免卡住界面；整个进程组收到 SIGKILL 后由 finished 负责回收。
+        proc->disconnect(this);
+        static_cast<BuildProcess *>(proc)->killGroup();
+        if (proc->state() == QProcess::NotRunning) {
+            proc->deleteLater();
+        } else {
+            connect(proc, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), proc, &QObject::deleteLater);
+        }
+    }
+    runningJobs_.clear();
+    jobBuffers_.clear();
+    jobParsers_.clear();
+    jobStartMs_.clear();
+    jobLanes_.clear();
+    jobPeakRss_.clear();
+    qDeleteAll(jobHashes_);
+    jobHashes_.clear();
+    pendingJobs_.clear();
+    linkObjects_.clear();
+    pendingLinkHash_.clear();
+    linkPending_ = false;
+    ++cacheGeneration_;
+    cacheTasks_ = 0;
+    buildNeedsProbe_ = false;
+    awaitingLinker_ = false;
+    deferredStart_ = false;
+    pchRunning_ = false;
+    archiving_ = false;
+    anyCompiled_ = false;
+    totalJobs_ = 0;
+    startedJobs_ = 0;
+    finishedJobs_ = 0;
+    progressTotal_ = 0;
+    failedExitCode_ = 0;
+    failedStatus_ = QProcess::NormalExit;
+    jobFailed_ = false;
+}
+
+bool BuildManager::hasQueuedBuild() const {
+    return buildQueued_;
+}
+
+void BuildManager::cancelBuild() {
+    if (!isBuilding()) {
+        return;
+    }
+    // 已完成的翻译单元保留在数据库里，下次编译可以接着用。
+    if (activeConfig_.incremental && !runningJobs_.isEmpty()) {
+        database_.save();
+    }
+    const bool linking = process_.state() != QProcess::NotRunning;
+    buildQueued_ = false;
+    abortJobs();
+    emit outputReady(tr("编译已取消。\n"));
+    if (linking) {
+        // 先发 SIGTERM，让 ninja 有机会结束自己的子进程并写好 .ninja_log；3 秒后仍未退出再强制结束。
+        // 进程退出后由 handleFinished 发出 buildFinished。
+        process_.terminateGroup();
+        QTimer::singleShot(3000, this, [this]() {
+            if (process_.state() != QProcess::NotRunning) {
+                process_.killGroup();
+            }
+        });
+    } else {
+        finishBuild(-1, QProcess::CrashExit);
+    }
+}
+
+bool BuildManager::isBuilding() const {
+    return !runningJobs_.isEmpty() || !pendingJobs_.isEmpty() || process_.state() != QProcess::NotRunning
+           || awaitingLinker_ || deferredStart_ || cacheTasks_ > 0;
+}
+
 QString BuildManager::lastBinaryPath() const {
     return lastBinaryPath_;
 }
 
+RunSession *BuildManager::runSession() {
+    return &runSession_;
+}
+
+void BuildManager::clearCompileCache() {
+    cache_.clear();
+    emit outputReady(tr("已清空编译缓存：%1\n").arg(cache_.directory()));
+}
+
 void BuildManager::handleReadyRead() {
-    const QByteArray data = process_.readAllStandardOutput();
-    if (!data.isEmpty()) {
-        emit outputReady(QString::fromLocal8Bit(data));
+    processBuffer_ += process_.readAllStandardOutput();
+    flushProcessOutput(false);
+}
+
+void BuildManager::flushProcessOutput(bool final) {
+    QByteArray complete;
+    if (final) {
+        complete = processBuffer_;
+        processBuffer_.clear();
+    } else {
+        const int lastNewline = processBuffer_.lastIndexOf('\n');
+        if (lastNewline < 0) {
+            return;
+        }
+        complete = processBuffer_.left(lastNewline + 1);
+        processBuffer_.remove(0, lastNewline + 1);
+    }
+    reportDiagnostics(processParser_.feed(complete));
+    if (final) {
+        reportDiagnostics(processParser_.finish());
+    }
+    if (complete.isEmpty()) {
+        return;
+    }
+
+    static const QRegularExpression ninjaStatus(QStringLiteral("^\\[(\\d+)/(\\d+)\\] "));
+    QString text;
+    const QStringList lines = QString::fromLocal8Bit(complete).split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        if (DiagnosticParser::isFixItLine(lines.at(i))) {
+            continue;
+        }
+        if (ninjaBuild_) {
+            const QRegularExpressionMatch m = ninjaStatus.match(lines.at(i));
+            if (m.hasMatch()) {
+                progressTotal_ = m.captured(2).toInt();
+                emit buildProgress(m.captured(1).toInt(), progressTotal_);
+            }
+        }
+        text += lines.at(i);
+        if (i + 1 < lines.size()) {
+            text += '\n';
+        }
+    }
+    if (final && !text.isEmpty() && !text.endsWith('\n')) {
+        text += '\n'; // 进程最后一行没有换行时补上，后续提示另起一行
+    }
+    if (!text.isEmpty()) {
+        emit outputReady(text);
+    }
+}
+
+void BuildManager::reportDiagnostics(const QList<BuildDiagnostic> &diagnostics) {
+    for (const BuildDiagnostic &diag : diagnostics) {
+        // 同一个头文件里的警告会被每个包含它的翻译单元重复报告，只保留第一条。
+        const QString key = diag.key();
+        if (seenDiagnostics_.contains(key)) {
+            continue;
+        }
+        seenDiagnostics_.insert(key);
+        emit diagnosticReported(diag);
     }
 }
 
 void BuildManager::handleFinished(int exitCode, QProcess::ExitStatus status) {
+    processBuffer_ += process_.readAllStandardOutput();
+    flushProcessOutput(true);
+    if (!pendingLinkHash_.isEmpty()) {
+        const bool ok = status == QProcess::NormalExit && exitCode == 0;
+        database_.setLinkHash(ok ? pendingLinkHash_ : QString());
+        database_.save();
+        pendingLinkHash_.clear();
+    }
+    if (progressTotal_ > 0) {
+        emit buildProgress(progressTotal_, progressTotal_);
+        progressTotal_ = 0;
+    }
+    BuildMetrics::Job record = processJob_;
+    record.durationMs = buildClock_.elapsed() - record.startMs;
+    record.exitCode = exitCode;
+    record.crashed = status != QProcess::NormalExit;
+    metrics_.addJob(record);
+    finishBuild(exitCode, status);
+}
+
+void BuildManager::beginProcessMetrics(const QString &label, const QString &source, const QString &kind) {
+    processJob_ = BuildMetrics::Job();
+    processJob_.label = label;
+    processJob_.source = source;
+    processJob_.kind = kind;
+    processJob_.startMs = buildClock_.elapsed();
+    rssTimer_.start();
+}
+
+void BuildManager::sampleMemory() {
+    for (auto it = runningJobs_.cbegin(); it != runningJobs_.cend(); ++it) {
+        const qint64 pid = it.key()->processId();
+        if (pid > 0) {
+            qint64 &peak = jobPeakRss_[it.key()];
+            peak = qMax(peak, BuildMetrics::sampleTreePeakRssKb(pid));
+        }
+    }
+    if (process_.state() == QProcess::Running) {
+        processJob_.peakRssKb = qMax(processJob_.peakRssKb, BuildMetrics::sampleTreePeakRssKb(process_.processId()));
+    }
+}
+
+void BuildManager::finishBuild(int exitCode, QProcess::ExitStatus status) {
+    rssTimer_.stop();
+    metrics_.finish(buildClock_.elapsed());
+    if (!metricsDirectory_.isEmpty()) {
+        metrics_.saveHistory(metricsDirectory_);
+    }
     emit buildFinished(exitCode, status);
+    if (buildQueued_) {
+        buildQueued_ = false;
+        const BuildConfig next = queuedConfig_;
+        QTimer::singleShot(0, this, [this, next]() {
+            emit outputReady(tr("开始排队中的编译。\n"));
+            compile(next);
+        });
+    }
+}
+
+const BuildMetrics &BuildManager::lastMetrics() const {
+    return metrics_;
+}
+
+QString BuildManager::metricsDirectory() const {
+    return metricsDirectory_;
 }
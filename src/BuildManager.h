@@ -1,13 +1,41 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
 #include <QProcess>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
+
+#include <functional>
+
+#include "BuildDatabase.h"
+#include "BuildMetrics.h"
+#include "BuildProcess.h"
+#include "CompileCache.h"
+#include "DiagnosticParser.h"
+#include "RunSession.h"
+
+class QCryptographicHash;
+class QDir;
+class QTemporaryDir;
+class QThread;
 
 class BuildManager : public QObject {
     Q_OBJECT
 
 public:
     explicit BuildManager(QObject *parent = nullptr);
+    ~BuildManager() override;
+
+    // 生成 Makefile / build.ninja 时每个编译模式各自的参数。
+    struct GeneratorProfile {
+        QString name;
+        QStringList extraFlags;
+        QString outputPath;
+        bool splitDwarf = false;
+        bool thinLto = false;
+    };
 
     struct BuildConfig {
         QString compiler = QStringLiteral("g++");
@@ -17,23 +45,170 @@ public:
         QStringList extraFlags;
         QString outputPath;
         QString workingDirectory;
+        bool perUnitBuild = false; // 每个源文件单独编译为 .o 并行执行，最后单独链接
+        int jobs = 0;              // 并行任务数，0 表示按 CPU 核心数
+        bool incremental = false;  // 依据 buildDirectory 中的依赖数据库只重编译过期的翻译单元
+        bool useCompileCache = false; // 编译前先查本地目标文件缓存
+        QString buildDirectory;       // 中间产物放在 buildDirectory/<profileName>/ 下
+        QString profileName;          // 区分 Debug/Release 等模式的中间产物
+        QString pchHeader;            // 预编译的前缀头（绝对路径），为空表示不使用
+        bool unityBuild = false;      // 把多个源文件合并进 unity_N.cpp 一起编译
+        int unityBatchSize = 8;
+        bool timeTrace = false;       // clang 下附加 -ftime-trace，统计头文件解析耗时
+        bool delegateToNinja = false; // 系统装有 ninja 时生成 build.ninja 并交给它构建
+        QString linker;               // mold / lld / gold，经过试链接确认可用后才会传 -fuse-ld
+        bool splitDwarf = false;      // -gsplit-dwarf
+        bool thinLto = false;         // clang -flto=thin / gcc -flto=auto
+        QList<GeneratorProfile> profiles; // 生成器输出的全部模式，为空时只用上面的单一配置
     };
 
+    // 编译进行中再次调用时不会打断当前编译，而是排队（多次请求合并为一次），结束后自动开始。
     void compile(const BuildConfig &config);
     void runLastBinary(const QStringList &args = {}, const QString &workingDirectory = {});
     bool generateMakefile(const BuildConfig &config, const QString &makefilePath);
+    bool generateNinjaFile(const BuildConfig &config, const QString &ninjaPath);
+
+    void cancelBuild();
+    bool isBuilding() const;
+    // buildFinished 发出时为真表示还有一次排队的编译紧接着开始，这次的结果不是调用方最后要的那次
+    bool hasQueuedBuild() const;
 
     QString lastBinaryPath() const;
+    RunSession *runSession();
+    const BuildMetrics &lastMetrics() const;
+    QString metricsDirectory() const;
+    void clearCompileCache();
+
+    // 汇编视图：单个翻译单元生成汇编用的参数（去掉 LTO 和拆分调试信息，沿用预编译头），
+    // 以及增量编译留下的、参数和依赖都没变的目标文件（没有或已过期时返回空）。
+    QStringList assemblyFlags(const BuildConfig &config) const;
+    QString upToDateObject(const BuildConfig &config, const QString &absSource) const;
+
+    // 优化报告：在 assemblyFlags 的基础上让编译器把优化记录写到 recordPath，
+    // clang 为 -fsave-optimization-record 的 YAML，gcc 为 -fopt-info 的文本。
+    QStringList optimizationRecordFlags(const BuildConfig &config, const QString &recordPath) const;
 
 signals:
     void outputReady(const QString &text);
-    void buildFinished(int exitCode, QProcess::ExitStatus status);
+    void buildStarted();
+    void buildProgress(int finished, int total);
+    void diagnosticReported(const BuildDiagnostic &diagnostic);
+    void buildFinished(int exitCode, QProcess::ExitStatus status); // 每次 compile() 最终都会发出一次，没能开始时 exitCode 为 -1
 
 private slots:
     void handleReadyRead();
     void handleFinished(int exitCode, QProcess::ExitStatus status);
 
 private:
+    struct CompileJob {
+        QString source;
+        QString object;
+        QString depFile;
+        QString flagsHash;
+        QStringList args;
+        QStringList preprocessArgs;
+        QString cacheKey;
+        QStringList extraDeps;
+        QString label;
+        QHash<QString, QByteArray> inputHashes; // 启动时的输入文件哈希，见 BuildDatabase::snapshotInputs
+        qint64 launchedMs = 0;
+        bool preprocessing = false;
+        bool pch = false;
+        bool timeTrace = false;
+    };
+
+    QStringList compileFlags(const BuildConfig &config) const;
+    QStringList linkFlags(const BuildConfig &config) const;
+    // 已知的检测结果；还没检测过时返回空串，pending 不为空时还会在后台开始检测并把 *pending 置为 true
+    QString resolveLinker(const BuildConfig &config, bool *pending = nullptr);
+    QStringList linkerProbeArgs(const BuildConfig &config) const;
+    bool startLinkerProbe(const BuildConfig &config, const QString &key);
+    void finishLinkerProbe(bool ok);
+    void stopLinkerProbe();
+    QString profileBuildDir(const BuildConfig &config) const;
+    QString objectPathFor(const BuildConfig &config, const QString &absSource) const;
+    QString depFilePathFor(const QString &objectPath) const;
+    void openDatabase(const BuildConfig &config);
+    QString pchWrapperPath(const QString &dir, const QString &headerPath) const;
+    bool writePchWrapper(const QString &wrapperPath, const QString &headerPath) const;
+    QList<GeneratorProfile> generatorProfiles(const BuildConfig &config) const;
+    QString generatorPchWrapper(const BuildConfig &config, const QString &generatorDir, const QString &profile) const;
+    QByteArray makefileContent(const BuildConfig &config, const QDir &root) const;
+    QByteArray ninjaContent(const BuildConfig &config, const QDir &root, const QString &ninjaDir) const;
+    bool writeIfChanged(const QString &path, const QByteArray &content) const;
+    bool startNinja(const BuildConfig &config);
+    QStringList prepareUnityUnits(const BuildConfig &config, const QStringList &sources,
+                                  QHash<QString, QString> *labels);
+
+    void startNextJobs();
+    void startJob(CompileJob job);
+    void launchJob(const CompileJob &job);
+    void flushJobOutput(QProcess *proc, bool final);
+    void flushProcessOutput(bool final);
+    void reportDiagnostics(const QList<BuildDiagnostic> &diagnostics);
+    void handleJobFinished(QProcess *proc, int exitCode, QProcess::ExitStatus status);
+    void runCacheTask(const std::function<bool()> &task, const std::function<void(bool)> &done);
+    void finishCacheFetch(CompileJob job, bool hit);
+    void startLink();
+    void abortJobs();
+    void beginProcessMetrics(const QString &label, const QString &source, const QString &kind);
+    void sampleMemory();
+    void finishBuild(int exitCode, QProcess::ExitStatus status);
+
     QString lastBinaryPath_;
-    QProcess process_;
+    BuildProcess process_;
+    RunSession runSession_;
+
+    BuildConfig activeConfig_;
+    QList<CompileJob> pendingJobs_;
+    QHash<QProcess *, CompileJob> runningJobs_;
+    QHash<QProcess *, QByteArray> jobBuffers_;
+    QHash<QProcess *, QCryptographicHash *> jobHashes_;
+    QHash<QProcess *, DiagnosticParser> jobParsers_;
+    DiagnosticParser processParser_;
+    QByteArray processBuffer_;
+    QSet<QString> seenDiagnostics_;
+    QHash<QProcess *, qint64> jobStartMs_;
+    QHash<QProcess *, qint64> jobPeakRss_;
+    QHash<QProcess *, int> jobLanes_;
+    BuildMetrics metrics_;
+    BuildMetrics::Job processJob_;
+    QString metricsDirectory_;
+    QElapsedTimer buildClock_;
+    QTimer rssTimer_;
+    QStringList linkObjects_;
+    BuildDatabase database_;
+    CompileCache cache_;
+    QString cacheKeyBase_;
+    // 缓存读写（复制目标文件、淘汰）在后台线程里做；未完成的任务和编译任务一样占并行位置，链接前要等完
+    int cacheTasks_ = 0;
+    int cacheGeneration_ = 0; // abortJobs 时递增，丢弃被取消的那次编译的缓存结果
+    QSet<QThread *> cacheThreads_;
+    QHash<QString, bool> linkerProbes_;
+    // 链接器检测和编译任务并行，链接（或 ninja/单进程编译的启动）等它的结果
+    QProcess *linkerProbe_ = nullptr;
+    QTemporaryDir *linkerProbeDir_ = nullptr;
+    QString linkerProbeKey_;
+    QString linkerProbeLinker_;
+    bool linkerProbeTimedOut_ = false;
+    bool buildNeedsProbe_ = false; // 这次编译的链接器还在检测
+    bool awaitingLinker_ = false;  // 目标文件都好了，正等检测结果再链接
+    bool deferredStart_ = false;   // 检测结束后再用 deferredConfig_ 开始编译
+    BuildConfig deferredConfig_;
+    QString pendingLinkHash_;
+    bool linkPending_ = false;
+    bool archiving_ = false;
+    bool pchRunning_ = false;
+    bool anyCompiled_ = false;
+    int totalJobs_ = 0;
+    int startedJobs_ = 0;
+    int finishedJobs_ = 0;
+    int progressTotal_ = 0;
+    int maxJobs_ = 1;
+    int failedExitCode_ = 0;
+    QProcess::ExitStatus failedStatus_ = QProcess::NormalExit;
+    bool jobFailed_ = false;
+    bool ninjaBuild_ = false;
+    bool buildQueued_ = false;
+    BuildConfig queuedConfig_;
 };
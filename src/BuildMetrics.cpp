@@ -0,0 +1,238 @@
+#include "BuildMetrics.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+constexpr int kMaxHistory = 20;
+
+#ifdef Q_OS_LINUX
+qint64 readVmHwmKb(qint64 pid) {
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (!status.open(QFile::ReadOnly)) {
+        return 0;
+    }
+    // /proc 文件的 size 为 0，不能用 atEnd() 判断，逐行读到空为止。
+    while (true) {
+        const QByteArray line = status.readLine();
+        if (line.isEmpty()) {
+            break;
+        }
+        if (line.startsWith("VmHWM:")) {
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+    return 0;
+}
+
+QList<qint64> childPids(qint64 pid) {
+    QList<qint64> result;
+    QDir taskDir(QStringLiteral("/proc/%1/task").arg(pid));
+    const QStringList tasks = taskDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &tid : tasks) {
+        QFile children(taskDir.filePath(tid + QStringLiteral("/children")));
+        if (!children.open(QFile::ReadOnly)) {
+            continue;
+        }
+        const QList<QByteArray> parts = children.readAll().simplified().split(' ');
+        for (const QByteArray &part : parts) {
+            const qint64 child = part.toLongLong();
+            if (child > 0) {
+                result.append(child);
+            }
+        }
+    }
+    return result;
+}
+#endif
+}
+
+void BuildMetrics::begin(const QString &profile) {
+    profile_ = profile.isEmpty() ? QStringLiteral("default") : profile;
+    totalMs_ = 0;
+    jobs_.clear();
+    headers_.clear();
+}
+
+void BuildMetrics::addJob(const Job &job) {
+    jobs_.append(job);
+}
+
+void BuildMetrics::addTimeTrace(const QString &traceFile) {
+    QFile file(traceFile);
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    // clang 的 "Source" 事件是嵌套的：a.h 的耗时包含它再 include 的 b.h，这里按每个头文件各自累计。
+    for (const auto &value : root.value("traceEvents").toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event.value("name").toString() != QLatin1String("Source")) {
+            continue;
+        }
+        const QString header = event.value("args").toObject().value("detail").toString();
+        if (header.isEmpty()) {
+            continue;
+        }
+        HeaderCost &cost = headers_[QDir::cleanPath(header)];
+        cost.totalUs += static_cast<qint64>(event.value("dur").toDouble());
+        ++cost.count;
+    }
+}
+
+void BuildMetrics::finish(qint64 totalMs) {
+    totalMs_ = totalMs;
+}
+
+QString BuildMetrics::profile() const {
+    return profile_;
+}
+
+qint64 BuildMetrics::totalMs() const {
+    return totalMs_;
+}
+
+QList<BuildMetrics::Job> BuildMetrics::jobs() const {
+    return jobs_;
+}
+
+QHash<QString, BuildMetrics::HeaderCost> BuildMetrics::headers() const {
+    return headers_;
+}
+
+bool BuildMetrics::saveHistory(const QString &metricsDir) const {
+    if (metricsDir.isEmpty() || jobs_.isEmpty()) {
+        return false;
+    }
+    const QString path = historyPath(metricsDir);
+    QJsonArray builds;
+    QFile existing(path);
+    if (existing.open(QFile::ReadOnly)) {
+        builds = QJsonDocument::fromJson(existing.readAll()).object().value("builds").toArray();
+        existing.close();
+    }
+
+    QJsonObject build;
+    build.insert("timestamp", static_cast<double>(QDateTime::currentMSecsSinceEpoch()));
+    build.insert("totalMs", static_cast<double>(totalMs_));
+    QJsonArray units;
+    int failed = 0;
+    for (const Job &job : jobs_) {
+        QJsonObject u;
+        u.insert("label", job.label);
+        u.insert("source", job.source);
+        u.insert("kind", job.kind);
+        u.insert("durationMs", static_cast<double>(job.durationMs));
+        u.insert("peakRssKb", static_cast<double>(job.peakRssKb));
+        u.insert("exitCode", job.exitCode);
+        units.append(u);
+        if (job.crashed || job.exitCode != 0) {
+            ++failed;
+        }
+    }
+    build.insert("jobs", units);
+    build.insert("failed", failed);
+    QJsonObject headersObj;
+    for (auto it = headers_.cbegin(); it != headers_.cend(); ++it) {
+        QJsonObject h;
+        h.insert("us", static_cast<double>(it.value().totalUs));
+        h.insert("count", it.value().count);
+        headersObj.insert(it.key(), h);
+    }
+    build.insert("headers", headersObj);
+    builds.append(build);
+    while (builds.size() > kMaxHistory) {
+        builds.removeFirst();
+    }
+
+    QDir().mkpath(metricsDir);
+    QJsonObject root;
+    root.insert("profile", profile_);
+    root.insert("builds", builds);
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QList<BuildMetrics::Summary> BuildMetrics::loadHistory(const QString &metricsDir) const {
+    QList<Summary> result;
+    QFile file(historyPath(metricsDir));
+    if (!file.open(QFile::ReadOnly)) {
+        return result;
+    }
+    const QJsonArray builds = QJsonDocument::fromJson(file.readAll()).object().value("builds").toArray();
+    for (const auto &value : builds) {
+        const QJsonObject b = value.toObject();
+        Summary s;
+        s.timestamp = static_cast<qint64>(b.value("timestamp").toDouble());
+        s.totalMs = static_cast<qint64>(b.value("totalMs").toDouble());
+        s.jobs = b.value("jobs").toArray().size();
+        s.failed = b.value("failed").toInt();
+        result.append(s);
+    }
+    return result;
+}
+
+bool BuildMetrics::exportChromeTrace(const QString &path) const {
+    // chrome://tracing / Perfetto 的 Trace Event 格式，时间单位是微秒。
+    QJsonArray events;
+    for (const Job &job : jobs_) {
+        QJsonObject e;
+        e.insert("name", job.label);
+        e.insert("cat", job.kind);
+        e.insert("ph", "X");
+        e.insert("ts", static_cast<double>(job.startMs * 1000));
+        e.insert("dur", static_cast<double>(job.durationMs * 1000));
+        e.insert("pid", 1);
+        e.insert("tid", job.lane);
+        QJsonObject args;
+        args.insert("source", job.source);
+        args.insert("peakRssKb", static_cast<double>(job.peakRssKb));
+        args.insert("exitCode", job.exitCode);
+        e.insert("args", args);
+        events.append(e);
+    }
+    QJsonObject meta;
+    meta.insert("name", "process_name");
+    meta.insert("ph", "M");
+    meta.insert("pid", 1);
+    meta.insert("args", QJsonObject{{"name", QStringLiteral("build (%1)").arg(profile_)}});
+    events.append(meta);
+
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+qint64 BuildMetrics::sampleTreePeakRssKb(qint64 pid) {
+#ifdef Q_OS_LINUX
+    // g++/clang++ 只是驱动程序，真正吃内存的是 cc1plus 等子进程，取整棵进程树里最大的 VmHWM。
+    qint64 peak = readVmHwmKb(pid);
+    for (qint64 child : childPids(pid)) {
+        peak = qMax(peak, sampleTreePeakRssKb(child));
+    }
+    return peak;
+#else
+    Q_UNUSED(pid)
+    return 0;
+#endif
+}
+
+QString BuildMetrics::historyPath(const QString &metricsDir) const {
+    return QDir(metricsDir).filePath(profile_ + QStringLiteral(".json"));
+}
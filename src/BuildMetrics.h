@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// 一次构建的耗时统计：每个编译任务的墙钟时间、峰值内存和退出状态，
+// 以及 clang -ftime-trace 汇总出的头文件解析耗时。历史按编译模式保存在 build/metrics/ 下。
+class BuildMetrics {
+public:
+    struct Job {
+        QString label;
+        QString source;
+        QString kind;        // compile / preprocess / cache / pch / link / archive
+        qint64 startMs = 0;  // 相对构建开始
+        qint64 durationMs = 0;
+        qint64 peakRssKb = 0;
+        int exitCode = 0;
+        bool crashed = false;
+        int lane = 0;        // 并行槽位，导出时间线时作为线程号
+    };
+
+    struct HeaderCost {
+        qint64 totalUs = 0;
+        int count = 0;
+    };
+
+    struct Summary {
+        qint64 timestamp = 0; // 毫秒级 Unix 时间
+        qint64 totalMs = 0;
+        int jobs = 0;
+        int failed = 0;
+    };
+
+    void begin(const QString &profile);
+    void addJob(const Job &job);
+    void addTimeTrace(const QString &traceFile);
+    void finish(qint64 totalMs);
+
+    QString profile() const;
+    qint64 totalMs() const;
+    QList<Job> jobs() const;
+    QHash<QString, HeaderCost> headers() const;
+
+    bool saveHistory(const QString &metricsDir) const;
+    QList<Summary> loadHistory(const QString &metricsDir) const;
+    bool exportChromeTrace(const QString &path) const;
+
+    static qint64 sampleTreePeakRssKb(qint64 pid);
+
+private:
+    QString historyPath(const QString &metricsDir) const;
+
+    QString profile_;
+    qint64 totalMs_ = 0;
+    QList<Job> jobs_;
+    QHash<QString, HeaderCost> headers_;
+};
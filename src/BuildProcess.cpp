@@ -0,0 +1,66 @@
+#include "BuildProcess.h"
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+BuildProcess::BuildProcess(QObject *parent) : QProcess(parent) {
+#if defined(Q_OS_UNIX) && QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    setChildProcessModifier([this]() { setupChild(); });
+#endif
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+void BuildProcess::setupChildProcess() {
+    setupChild();
+}
+#endif
+
+void BuildProcess::setupChild() {
+#ifdef Q_OS_UNIX
+    // 运行在 fork 之后的子进程里，只做异步信号安全的系统调用
+    ::setpgid(0, 0);
+    if (outputFd_ >= 0) {
+        ::dup2(outputFd_, STDOUT_FILENO);
+        ::dup2(outputFd_, STDERR_FILENO);
+    }
+#endif
+}
+
+void BuildProcess::setOutputDescriptor(int fd) {
+    outputFd_ = fd;
+}
+
+void BuildProcess::terminateGroup() {
+#ifdef Q_OS_UNIX
+    if (signalGroup(SIGTERM)) {
+        return;
+    }
+#endif
+    terminate();
+}
+
+void BuildProcess::killGroup() {
+#ifdef Q_OS_UNIX
+    if (signalGroup(SIGKILL)) {
+        return;
+    }
+#endif
+    kill();
+}
+
+bool BuildProcess::signalGroup(int sig) {
+#ifdef Q_OS_UNIX
+    const qint64 pid = processId();
+    if (pid <= 0 || state() == QProcess::NotRunning) {
+        return false;
+    }
+    // 子进程刚 fork 还没来得及 setpgid 时进程组不存在，调用方会退回到只结束驱动进程本身。
+    return ::kill(-static_cast<pid_t>(pid), sig) == 0;
+#else
+    Q_UNUSED(sig)
+    return false;
+#endif
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QProcess>
+
+// 在独立进程组里启动的 QProcess。g++/clang++、ninja 都只是驱动程序，
+// 取消编译时要连同 cc1plus、ld 等子进程一起结束，否则它们会在后台继续占满 CPU。
+class BuildProcess : public QProcess {
+public:
+    explicit BuildProcess(QObject *parent = nullptr);
+
+    void terminateGroup();
+    void killGroup();
+    // 子进程的 stdout/stderr 直接写入这个描述符（通常是调用方自己的管道写端），
+    // 绕过 QProcess 的读缓冲，读取节奏由调用方控制。需在 start() 之前设置，-1 表示不使用。
+    void setOutputDescriptor(int fd);
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void setupChildProcess() override;
+#endif
+
+private:
+    bool signalGroup(int sig);
+    void setupChild();
+
+    int outputFd_ = -1;
+};
@@ -0,0 +1,127 @@
+#include "BuildReportDialog.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+// 数值列用 DisplayRole 存 qlonglong，QTreeWidget 排序时按数值而不是字符串比较。
+void setNumber(QTreeWidgetItem *item, int column, qint64 value) {
+    item->setData(column, Qt::DisplayRole, static_cast<qlonglong>(value));
+    item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+}
+}
+
+BuildReportDialog::BuildReportDialog(const BuildMetrics &metrics, const QString &metricsDir, QWidget *parent)
+    : QDialog(parent), metrics_(metrics), metricsDir_(metricsDir) {
+    setWindowTitle(tr("编译耗时报告"));
+    resize(820, 520);
+
+    unitsTree_ = new QTreeWidget(this);
+    unitsTree_->setHeaderLabels({tr("编译单元"), tr("类型"), tr("耗时(ms)"), tr("峰值内存(MB)"), tr("开始(ms)"), tr("退出码")});
+    unitsTree_->setRootIsDecorated(false);
+    unitsTree_->setSortingEnabled(true);
+
+    headersTree_ = new QTreeWidget(this);
+    headersTree_->setHeaderLabels({tr("头文件"), tr("累计解析耗时(ms)"), tr("被包含次数")});
+    headersTree_->setRootIsDecorated(false);
+    headersTree_->setSortingEnabled(true);
+
+    historyTree_ = new QTreeWidget(this);
+    historyTree_->setHeaderLabels({tr("时间"), tr("总耗时(ms)"), tr("任务数"), tr("失败")});
+    historyTree_->setRootIsDecorated(false);
+
+    auto *tabs = new QTabWidget(this);
+    tabs->addTab(unitsTree_, tr("最慢的编译单元"));
+    tabs->addTab(headersTree_, tr("最慢的头文件"));
+    tabs->addTab(historyTree_, tr("历史（%1）").arg(metrics_.profile()));
+
+    auto *summary = new QLabel(tr("模式：%1    总耗时：%2 ms    任务数：%3")
+                                   .arg(metrics_.profile())
+                                   .arg(metrics_.totalMs())
+                                   .arg(metrics_.jobs().size()),
+                               this);
+
+    auto *btnExport = new QPushButton(tr("导出 Chrome Trace..."), this);
+    auto *btnClose = new QPushButton(tr("关闭"), this);
+    connect(btnExport, &QPushButton::clicked, this, &BuildReportDialog::exportTrace);
+    connect(btnClose, &QPushButton::clicked, this, &QDialog::accept);
+    btnExport->setEnabled(!metrics_.jobs().isEmpty());
+
+    auto *btnLayout = new QHBoxLayout();
+    btnLayout->addWidget(btnExport);
+    btnLayout->addStretch();
+    btnLayout->addWidget(btnClose);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(summary);
+    layout->addWidget(tabs);
+    layout->addLayout(btnLayout);
+
+    populate();
+}
+
+void BuildReportDialog::populate() {
+    for (const BuildMetrics::Job &job : metrics_.jobs()) {
+        auto *item = new QTreeWidgetItem(unitsTree_);
+        item->setText(0, job.label);
+        item->setToolTip(0, job.source);
+        item->setText(1, job.kind);
+        setNumber(item, 2, job.durationMs);
+        setNumber(item, 3, job.peakRssKb / 1024);
+        setNumber(item, 4, job.startMs);
+        setNumber(item, 5, job.crashed ? -1 : job.exitCode);
+    }
+    unitsTree_->sortByColumn(2, Qt::DescendingOrder);
+    unitsTree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    const auto headers = metrics_.headers();
+    for (auto it = headers.cbegin(); it != headers.cend(); ++it) {
+        auto *item = new QTreeWidgetItem(headersTree_);
+        item->setText(0, it.key());
+        item->setToolTip(0, it.key());
+        setNumber(item, 1, it.value().totalUs / 1000);
+        setNumber(item, 2, it.value().count);
+    }
+    headersTree_->sortByColumn(1, Qt::DescendingOrder);
+    headersTree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    if (headers.isEmpty()) {
+        auto *item = new QTreeWidgetItem(headersTree_);
+        item->setText(0, tr("没有头文件数据：使用 clang 并开启“记录 Clang 时间线”后重新编译。"));
+    }
+
+    const QList<BuildMetrics::Summary> history = metrics_.loadHistory(metricsDir_);
+    for (int i = history.size() - 1; i >= 0; --i) {
+        const BuildMetrics::Summary &s = history.at(i);
+        auto *item = new QTreeWidgetItem(historyTree_);
+        item->setText(0, QDateTime::fromMSecsSinceEpoch(s.timestamp).toString("yyyy-MM-dd HH:mm:ss"));
+        setNumber(item, 1, s.totalMs);
+        setNumber(item, 2, s.jobs);
+        setNumber(item, 3, s.failed);
+    }
+}
+
+void BuildReportDialog::exportTrace() {
+    const QString defaultPath = metricsDir_.isEmpty()
+                                    ? QDir::homePath() + "/build_trace.json"
+                                    : QDir(metricsDir_).filePath(metrics_.profile() + "_trace.json");
+    const QString path = QFileDialog::getSaveFileName(this, tr("导出 Chrome Trace"), defaultPath, tr("JSON 文件 (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!metrics_.exportChromeTrace(path)) {
+        QMessageBox::warning(this, tr("导出失败"), tr("无法写入：%1").arg(path));
+        return;
+    }
+    QMessageBox::information(this, tr("导出完成"),
+                             tr("已导出到 %1\n可在 chrome://tracing 或 ui.perfetto.dev 中打开。").arg(path));
+}
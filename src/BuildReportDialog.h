@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QDialog>
+
+#include "BuildMetrics.h"
+
+class QTreeWidget;
+
+class BuildReportDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    BuildReportDialog(const BuildMetrics &metrics, const QString &metricsDir, QWidget *parent = nullptr);
+
+private slots:
+    void exportTrace();
+
+private:
+    void populate();
+
+    BuildMetrics metrics_;
+    QString metricsDir_;
+    QTreeWidget *unitsTree_;
+    QTreeWidget *headersTree_;
+    QTreeWidget *historyTree_;
+};
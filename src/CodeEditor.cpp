@@ -3,6 +3,7 @@
 #include <QAbstractItemView>
 #include <QApplication>
 #include <QCompleter>
+#include <QHelpEvent>
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QPainter>
@@ -11,9 +12,12 @@
 #include <QStandardItemModel>
 #include <QStyle>
 #include <QTextBlock>
+#include <QToolTip>
 
 #include "LspClient.h"
 
+#include <algorithm>
+
 LineNumberArea::LineNumberArea(CodeEditor *editor) : QWidget(editor), editor_(editor) {}
 
 QSize LineNumberArea::sizeHint() const {
@@ -24,6 +28,20 @@ void LineNumberArea::paintEvent(QPaintEvent *event) {
     editor_->lineNumberAreaPaintEvent(event);
 }
 
+bool LineNumberArea::event(QEvent *event) {
+    if (event->type() == QEvent::ToolTip) {
+        auto *helpEvent = static_cast<QHelpEvent *>(event);
+        const QString text = editor_->lineNumberAreaToolTip(helpEvent->pos());
+        if (text.isEmpty()) {
+            QToolTip::hideText();
+        } else {
+            QToolTip::showText(helpEvent->globalPos(), text, this);
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
 void LineNumberArea::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
         QTextCursor tc = editor_->cursorForPosition(QPoint(0, event->pos().y()));
@@ -34,7 +52,17 @@ void LineNumberArea::mousePressEvent(QMouseEvent *event) {
     QWidget::mousePressEvent(event);
 }
 
-CodeEditor::CodeEditor(QWidget *parent) : QPlainTextEdit(parent), lineNumberArea_(new LineNumberArea(this)) {
+RemarkOverlay::RemarkOverlay(CodeEditor *editor) : QWidget(editor), editor_(editor) {
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    hide();
+}
+
+void RemarkOverlay::paintEvent(QPaintEvent *event) {
+    editor_->remarkOverlayPaintEvent(event);
+}
+
+CodeEditor::CodeEditor(QWidget *parent)
+    : QPlainTextEdit(parent), lineNumberArea_(new LineNumberArea(this)), remarkOverlay_(new RemarkOverlay(this)) {
     connect(this, &CodeEditor::blockCountChanged, this, &CodeEditor::updateLineNumberAreaWidth);
     connect(this, &CodeEditor::updateRequest, this, &CodeEditor::updateLineNumberArea);
     connect(this, &CodeEditor::cursorPositionChanged, this, &CodeEditor::highlightCurrentLine);
@@ -66,6 +94,12 @@ int CodeEditor::lineNumberAreaWidth() const {
 
 void CodeEditor::updateLineNumberAreaWidth(int) {
     setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+    updateRemarkOverlayGeometry();
+}
+
+void CodeEditor::updateRemarkOverlayGeometry() {
+    // 覆盖层是编辑器的子控件而不是 viewport 的，否则滚动时会被 viewport 一起平移
+    remarkOverlay_->setGeometry(viewport()->geometry());
 }
 
 void CodeEditor::updateLineNumberArea(const QRect &rect, int dy) {
@@ -74,6 +108,9 @@ void CodeEditor::updateLineNumberArea(const QRect &rect, int dy) {
     } else {
         lineNumberArea_->update(0, rect.y(), lineNumberArea_->width(), rect.height());
     }
+    if (!remarksByLine_.isEmpty()) {
+        remarkOverlay_->update();
+    }
 
     if (rect.contains(viewport()->rect())) {
         updateLineNumberAreaWidth(0);
@@ -85,10 +122,13 @@ void CodeEditor::resizeEvent(QResizeEvent *event) {
 
     QRect cr = contentsRect();
     lineNumberArea_->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    updateRemarkOverlayGeometry();
 }
 
 void CodeEditor::highlightCurrentLine() {
     QList<QTextEdit::ExtraSelection> extraSelections = semanticSelections_;
+    extraSelections += asmSelections_;
+    extraSelections += buildDiagnosticSelections_;
     extraSelections += diagnosticSelections_;
     extraSelections += debugSelections_;
 
@@ -113,6 +153,11 @@ void CodeEditor::setDiagnosticSelections(const QList<QTextEdit::ExtraSelection>
     highlightCurrentLine();
 }
 
+void CodeEditor::setBuildDiagnosticSelections(const QList<QTextEdit::ExtraSelection> &selections) {
+    buildDiagnosticSelections_ = selections;
+    highlightCurrentLine();
+}
+
 void CodeEditor::setSemanticSelections(const QList<QTextEdit::ExtraSelection> &selections) {
     semanticSelections_ = selections;
     highlightCurrentLine();
@@ -123,6 +168,11 @@ void CodeEditor::setDebugSelections(const QList<QTextEdit::ExtraSelection> &sele
     highlightCurrentLine();
 }
 
+void CodeEditor::setAsmSelections(const QList<QTextEdit::ExtraSelection> &selections) {
+    asmSelections_ = selections;
+    highlightCurrentLine();
+}
+
 void CodeEditor::addBracketMatchSelections(QList<QTextEdit::ExtraSelection> &selections) {
     const QTextCursor cursor = textCursor();
     const int pos = cursor.position();
@@ -402,10 +452,165 @@ void CodeEditor::toggleBreakpointAtLine(int line) {
     lineNumberArea_->update();
 }
 
+void CodeEditor::setLineHeat(const QHash<int, int> &samplesByLine, int totalSamples) {
+    lineHeat_ = samplesByLine;
+    heatTotal_ = totalSamples;
+    heatMax_ = 0;
+    for (int samples : samplesByLine) {
+        heatMax_ = qMax(heatMax_, samples);
+    }
+    lineNumberArea_->update();
+}
+
+void CodeEditor::setLineCoverage(const QHash<int, qint64> &countsByLine) {
+    lineCoverage_ = countsByLine;
+    lineNumberArea_->update();
+}
+
+QString CodeEditor::lineNumberAreaToolTip(const QPoint &pos) const {
+    if ((lineHeat_.isEmpty() || heatTotal_ <= 0) && lineCoverage_.isEmpty()) {
+        return QString();
+    }
+    const int line = cursorForPosition(QPoint(0, pos.y())).blockNumber();
+    QStringList parts;
+    const int samples = heatTotal_ > 0 ? lineHeat_.value(line) : 0;
+    if (samples > 0) {
+        parts << tr("%1 个样本（%2%）").arg(samples).arg(100.0 * samples / heatTotal_, 0, 'f', 1);
+    }
+    const auto coverage = lineCoverage_.constFind(line);
+    if (coverage != lineCoverage_.constEnd()) {
+        parts << (coverage.value() > 0 ? tr("执行 %1 次").arg(coverage.value()) : tr("未执行"));
+    }
+    return parts.join('\n');
+}
+
+void CodeEditor::setOptRemarks(const QList<OptRemark> &remarks) {
+    remarksByLine_.clear();
+    for (const OptRemark &remark : remarks) {
+        if (remark.line > 0) {
+            remarksByLine_[remark.line - 1].append(remark);
+        }
+    }
+    // 同一行有多条时行尾显示最值得注意的那条：未优化 > 已优化 > 分析
+    auto rank = [](const OptRemark &remark) {
+        return remark.kind == OptRemark::Missed ? 0 : remark.kind == OptRemark::Passed ? 1 : 2;
+    };
+    for (auto it = remarksByLine_.begin(); it != remarksByLine_.end(); ++it) {
+        std::stable_sort(it.value().begin(), it.value().end(),
+                         [&rank](const OptRemark &a, const OptRemark &b) { return rank(a) < rank(b); });
+    }
+    remarkOverlay_->setVisible(!remarksByLine_.isEmpty());
+    remarkOverlay_->raise();
+    remarkOverlay_->update();
+}
+
+void CodeEditor::remarkOverlayPaintEvent(QPaintEvent *event) {
+    if (remarksByLine_.isEmpty()) {
+        return;
+    }
+    QPainter painter(remarkOverlay_);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont remarkFont = font();
+    remarkFont.setItalic(true);
+    remarkFont.setPointSizeF(remarkFont.pointSizeF() * 0.9);
+    painter.setFont(remarkFont);
+    const QFontMetrics metrics(remarkFont);
+    const int gap = metrics.horizontalAdvance(QLatin1Char(' ')) * 3;
+
+    const QPointF offset = contentOffset();
+    for (QTextBlock block = firstVisibleBlock(); block.isValid(); block = block.next()) {
+        const QRectF bounds = blockBoundingGeometry(block).translated(offset);
+        if (bounds.top() > event->rect().bottom()) {
+            break;
+        }
+        const auto it = remarksByLine_.constFind(block.blockNumber());
+        if (it == remarksByLine_.constEnd() || !block.isVisible() || bounds.bottom() < event->rect().top()) {
+            continue;
+        }
+        const OptRemark &remark = it.value().first();
+        QColor color;
+        QString mark;
+        if (remark.kind == OptRemark::Missed) {
+            color = QColor(220, 50, 47);
+            mark = QStringLiteral("✗");
+        } else if (remark.kind == OptRemark::Passed) {
+            color = darkThemeEnabled_ ? QColor(110, 200, 120) : QColor(0, 140, 60);
+            mark = QStringLiteral("✓");
+        } else {
+            color = darkThemeEnabled_ ? QColor(160, 160, 160) : QColor(120, 120, 120);
+            mark = QStringLiteral("·");
+        }
+        QString text = QStringLiteral("%1 %2：%3").arg(mark, OptRemark::categoryName(remark.category), remark.message);
+        if (it.value().size() > 1) {
+            text += tr("  (+%1)").arg(it.value().size() - 1);
+        }
+
+        QTextCursor end(block);
+        end.movePosition(QTextCursor::EndOfBlock);
+        const int x = cursorRect(end).right() + gap;
+        if (x >= remarkOverlay_->width()) {
+            continue;
+        }
+        text = metrics.elidedText(text, Qt::ElideRight, qMax(40, remarkOverlay_->width() - x - 12));
+        const QRect box(x, qRound(bounds.top()) + 1, metrics.horizontalAdvance(text) + 8, qRound(bounds.height()) - 2);
+        QColor background = color;
+        background.setAlpha(darkThemeEnabled_ ? 45 : 28);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(background);
+        painter.drawRoundedRect(box, 3, 3);
+        painter.setPen(color);
+        painter.drawText(box.adjusted(4, 0, -4, 0), Qt::AlignLeft | Qt::AlignVCenter, text);
+    }
+}
+
+QString CodeEditor::remarkToolTip(const QPoint &pos) const {
+    const QTextBlock block = cursorForPosition(pos).block();
+    const auto it = remarksByLine_.constFind(block.blockNumber());
+    if (it == remarksByLine_.constEnd()) {
+        return QString();
+    }
+    const QRectF bounds = blockBoundingGeometry(block).translated(contentOffset());
+    QTextCursor end(block);
+    end.movePosition(QTextCursor::EndOfBlock);
+    if (pos.y() < bounds.top() || pos.y() > bounds.bottom() || pos.x() <= cursorRect(end).right()) {
+        return QString();
+    }
+    QStringList lines;
+    for (const OptRemark &remark : it.value()) {
+        QString pass = remark.pass;
+        if (!remark.name.isEmpty()) {
+            pass += QLatin1Char('/') + remark.name;
+        }
+        QString line = tr("[%1] %2").arg(OptRemark::kindName(remark.kind), OptRemark::categoryName(remark.category));
+        if (pass != OptRemark::categoryName(remark.category)) {
+            line += QStringLiteral(" (%1)").arg(pass);
+        }
+        line += tr("：%1").arg(remark.message);
+        if (!remark.function.isEmpty()) {
+            line += tr("\n    所在函数：%1").arg(remark.function);
+        }
+        lines << line;
+    }
+    return lines.join('\n');
+}
+
+bool CodeEditor::viewportEvent(QEvent *event) {
+    if (event->type() == QEvent::ToolTip && !remarksByLine_.isEmpty()) {
+        auto *helpEvent = static_cast<QHelpEvent *>(event);
+        const QString text = remarkToolTip(helpEvent->pos());
+        if (!text.isEmpty()) {
+            QToolTip::showText(helpEvent->globalPos(), text, viewport());
+            return true;
+        }
+    }
+    return QPlainTextEdit::viewportEvent(event);
+}
+
 void CodeEditor::setDarkThemeEnabled(bool enabled) {
     darkThemeEnabled_ = enabled;
     highlightCurrentLine();
     lineNumberArea_->update();
+    remarkOverlay_->update();
 }
 
 void CodeEditor::keyPressEvent(QKeyEvent *event) {
@@ -532,6 +737,22 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
 
     while (block.isValid() && top <= event->rect().bottom()) {
         if (block.isVisible() && bottom >= event->rect().top()) {
+            const int samples = heatMax_ > 0 ? lineHeat_.value(blockNumber) : 0;
+            if (samples > 0) {
+                // 越热越红、越不透明；右侧细条始终不透明，冷行也看得出被采到过
+                const double heat = static_cast<double>(samples) / heatMax_;
+                QColor color = QColor::fromHsv(static_cast<int>(40 * (1.0 - heat)), 230, 255);
+                const QRect row(0, top, lineNumberArea_->width(), bottom - top);
+                painter.fillRect(row.adjusted(0, 0, -3, 0), QColor(color.red(), color.green(), color.blue(),
+                                                                   50 + static_cast<int>(150 * heat)));
+                painter.fillRect(QRect(row.right() - 2, row.top(), 3, row.height()), color);
+            }
+            const auto coverage = lineCoverage_.constFind(blockNumber);
+            if (coverage != lineCoverage_.constEnd()) {
+                painter.fillRect(QRect(0, top, 3, bottom - top),
+                                 coverage.value() > 0 ? QColor(60, 170, 80) : QColor(210, 60, 60));
+            }
+
             QString number = QString::number(blockNumber + 1);
             painter.setPen(darkThemeEnabled_ ? QColor(180, 180, 180) : Qt::gray);
             painter.drawText(0, top, lineNumberArea_->width() - 5, fontMetrics().height(), Qt::AlignRight, number);
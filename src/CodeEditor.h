@@ -1,11 +1,15 @@
 #pragma once
 
+#include <QHash>
 #include <QPlainTextEdit>
 #include <QSet>
 
+#include "OptRemarks.h"
+
 struct LspCompletionItem;
 
 class LineNumberArea;
+class RemarkOverlay;
 class QCompleter;
 class QStandardItemModel;
 class QKeyEvent;
@@ -19,10 +23,13 @@ public:
 
     int lineNumberAreaWidth() const;
     void lineNumberAreaPaintEvent(QPaintEvent *event);
+    QString lineNumberAreaToolTip(const QPoint &pos) const;
 
     void setDiagnosticSelections(const QList<QTextEdit::ExtraSelection> &selections);
+    void setBuildDiagnosticSelections(const QList<QTextEdit::ExtraSelection> &selections);
     void setSemanticSelections(const QList<QTextEdit::ExtraSelection> &selections);
     void setDebugSelections(const QList<QTextEdit::ExtraSelection> &selections);
+    void setAsmSelections(const QList<QTextEdit::ExtraSelection> &selections);
     void showCompletions(const QList<LspCompletionItem> &items);
 
     void setBreakpoints(const QSet<int> &lines);
@@ -30,6 +37,16 @@ public:
 
     void toggleBreakpointAtLine(int line);
 
+    // 采样分析的行热度（行号从 0 开始），在行号栏画成由橙到红的底色
+    void setLineHeat(const QHash<int, int> &samplesByLine, int totalSamples);
+
+    // 覆盖率（行号从 0 开始，只含可执行行），在行号栏左侧画绿/红细条
+    void setLineCoverage(const QHash<int, qint64> &countsByLine);
+
+    // 优化报告画在独立的覆盖层上，显示在行尾，不占用 ExtraSelection
+    void setOptRemarks(const QList<OptRemark> &remarks);
+    void remarkOverlayPaintEvent(QPaintEvent *event);
+
     void setDarkThemeEnabled(bool enabled);
 
 signals:
@@ -41,6 +58,7 @@ protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
+    bool viewportEvent(QEvent *event) override;
 
 private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
@@ -49,13 +67,21 @@ private slots:
 
 private:
     LineNumberArea *lineNumberArea_;
+    RemarkOverlay *remarkOverlay_;
     QList<QTextEdit::ExtraSelection> diagnosticSelections_;
+    QList<QTextEdit::ExtraSelection> buildDiagnosticSelections_;
     QList<QTextEdit::ExtraSelection> semanticSelections_;
     QList<QTextEdit::ExtraSelection> debugSelections_;
+    QList<QTextEdit::ExtraSelection> asmSelections_;
     QCompleter *completer_ = nullptr;
     QStandardItemModel *completionModel_ = nullptr;
 
     QSet<int> breakpoints_;
+    QHash<int, int> lineHeat_;
+    int heatTotal_ = 0;
+    int heatMax_ = 0;
+    QHash<int, qint64> lineCoverage_;
+    QHash<int, QList<OptRemark>> remarksByLine_; // 行号从 0 开始
     bool darkThemeEnabled_ = false;
 
     void insertCompletion(const QString &completion);
@@ -64,6 +90,8 @@ private:
     void addBracketMatchSelections(QList<QTextEdit::ExtraSelection> &selections);
     void indentSelection(int spaces);
     void unindentSelection(int spaces);
+    void updateRemarkOverlayGeometry();
+    QString remarkToolTip(const QPoint &pos) const;
 };
 
 class LineNumberArea : public QWidget {
@@ -73,9 +101,22 @@ public:
     QSize sizeHint() const override;
 
 protected:
+    bool event(QEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
 
 private:
     CodeEditor *editor_;
 };
+
+// 覆盖在 viewport 上的透明层，只负责画优化报告，鼠标事件穿透给编辑器。
+class RemarkOverlay : public QWidget {
+public:
+    explicit RemarkOverlay(CodeEditor *editor);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    CodeEditor *editor_;
+};
@@ -0,0 +1,222 @@
+#include "CompileCache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+CompileCache::CompileCache() {
+    QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+    const QString defaultDir = QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation))
+                                   .filePath(QStringLiteral("RusticCppIDE/objcache"));
+    directory_ = settings.value("cache/directory", defaultDir).toString();
+    maxBytes_ = settings.value("cache/maxSizeMB", 2048).toLongLong() * 1024 * 1024;
+}
+
+QString CompileCache::directory() const {
+    QMutexLocker lock(&mutex_);
+    return directory_;
+}
+
+void CompileCache::setDirectory(const QString &dir) {
+    QMutexLocker lock(&mutex_);
+    directory_ = dir;
+    indexLoaded_ = false;
+    index_.clear();
+    currentBytes_ = 0;
+}
+
+qint64 CompileCache::maxBytes() const {
+    QMutexLocker lock(&mutex_);
+    return maxBytes_;
+}
+
+void CompileCache::setMaxBytes(qint64 bytes) {
+    QMutexLocker lock(&mutex_);
+    maxBytes_ = bytes;
+}
+
+QString CompileCache::compilerIdentity(const QString &compiler) {
+    auto it = compilerIds_.constFind(compiler);
+    if (it != compilerIds_.cend()) {
+        return it.value();
+    }
+    // 与 ccache 的 compiler_check=mtime 相同：用可执行文件的真实路径、大小和修改时间标识编译器，
+    // 避免每次编译都启动一次 `--version`。
+    QString exe = QStandardPaths::findExecutable(compiler);
+    if (exe.isEmpty()) {
+        exe = compiler;
+    }
+    const QFileInfo info(exe);
+    const QString canonical = info.canonicalFilePath().isEmpty() ? exe : info.canonicalFilePath();
+    const QFileInfo target(canonical);
+    const QString id = QStringLiteral("%1|%2|%3")
+                           .arg(canonical)
+                           .arg(target.size())
+                           .arg(target.lastModified().toMSecsSinceEpoch());
+    compilerIds_.insert(compiler, id);
+    return id;
+}
+
+bool CompileCache::fetch(const QString &key, const QString &destination) {
+    const QString entry = entryPath(key);
+    {
+        QMutexLocker lock(&mutex_);
+        ensureIndexLoaded();
+        if (!index_.contains(entry)) {
+            ++misses_;
+            return false;
+        }
+    }
+    QFile::remove(destination);
+    QDir().mkpath(QFileInfo(destination).absolutePath());
+    if (!QFile::copy(entry, destination)) {
+        // 被别的进程清掉了，或者正在被淘汰
+        QMutexLocker lock(&mutex_);
+        ++misses_;
+        return false;
+    }
+    // 条目的 mtime 即最近使用时间，下次启动重建索引时用
+    QFile entryFile(entry);
+    if (entryFile.open(QFile::ReadWrite)) {
+        entryFile.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    // 复制后的文件沿用缓存条目的时间戳，需要刷新，否则增量链接会误判目标文件未更新。
+    QFile destFile(destination);
+    if (destFile.open(QFile::ReadWrite)) {
+        destFile.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    QMutexLocker lock(&mutex_);
+    auto it = index_.find(entry);
+    if (it != index_.end()) {
+        it.value().lastUsedMs = QDateTime::currentMSecsSinceEpoch();
+    }
+    ++hits_;
+    return true;
+}
+
+bool CompileCache::store(const QString &key, const QString &source) {
+    const QString entry = entryPath(key);
+    const QFileInfo srcInfo(source);
+    {
+        QMutexLocker lock(&mutex_);
+        if (maxBytes_ <= 0) {
+            return false;
+        }
+        ensureIndexLoaded();
+    }
+    if (!srcInfo.exists()) {
+        return false;
+    }
+    QDir().mkpath(QFileInfo(entry).absolutePath());
+
+    // QSaveFile 写到唯一命名的临时文件再改名：内容相同的两个翻译单元在不同线程里同时存入同一条目，
+    // 或者中途崩溃，都不会留下半截条目。
+    QFile input(source);
+    QSaveFile output(entry);
+    if (!input.open(QFile::ReadOnly) || !output.open(QFile::WriteOnly)) {
+        return false;
+    }
+    while (!input.atEnd()) {
+        const QByteArray chunk = input.read(1024 * 1024);
+        if (chunk.isEmpty() || output.write(chunk) != chunk.size()) {
+            output.cancelWriting();
+            break;
+        }
+    }
+    if (!output.commit()) {
+        return false;
+    }
+
+    QStringList evicted;
+    {
+        QMutexLocker lock(&mutex_);
+        const Entry previous = index_.value(entry);
+        currentBytes_ += srcInfo.size() - previous.size;
+        index_.insert(entry, Entry{srcInfo.size(), QDateTime::currentMSecsSinceEpoch()});
+        evicted = takeEvictions();
+    }
+    for (const QString &path : evicted) {
+        QFile::remove(path);
+    }
+    return true;
+}
+
+void CompileCache::clear() {
+    QMutexLocker lock(&mutex_);
+    QDir(directory_).removeRecursively();
+    index_.clear();
+    currentBytes_ = 0;
+    indexLoaded_ = true;
+    hits_ = 0;
+    misses_ = 0;
+}
+
+int CompileCache::hits() const {
+    QMutexLocker lock(&mutex_);
+    return hits_;
+}
+
+int CompileCache::misses() const {
+    QMutexLocker lock(&mutex_);
+    return misses_;
+}
+
+void CompileCache::resetStats() {
+    QMutexLocker lock(&mutex_);
+    hits_ = 0;
+    misses_ = 0;
+}
+
+QString CompileCache::entryPath(const QString &key) const {
+    QMutexLocker lock(&mutex_);
+    return QDir(directory_).filePath(key.left(2) + QLatin1Char('/') + key + QStringLiteral(".o"));
+}
+
+void CompileCache::ensureIndexLoaded() {
+    if (indexLoaded_) {
+        return;
+    }
+    indexLoaded_ = true;
+    index_.clear();
+    currentBytes_ = 0;
+    QDirIterator it(directory_, {"*.o"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        index_.insert(info.absoluteFilePath(), Entry{info.size(), info.lastModified().toMSecsSinceEpoch()});
+        currentBytes_ += info.size();
+    }
+}
+
+QStringList CompileCache::takeEvictions() {
+    QStringList victims;
+    if (maxBytes_ <= 0 || currentBytes_ <= maxBytes_) {
+        return victims;
+    }
+    QList<QPair<qint64, QString>> byAge;
+    byAge.reserve(index_.size());
+    for (auto it = index_.cbegin(); it != index_.cend(); ++it) {
+        byAge.append({it.value().lastUsedMs, it.key()});
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    // 一次淘汰到上限的 90%，避免每存一个条目都要排序一次。
+    const qint64 target = maxBytes_ / 10 * 9;
+    for (const auto &item : byAge) {
+        if (currentBytes_ <= target) {
+            break;
+        }
+        currentBytes_ -= index_.take(item.second).size;
+        victims.append(item.second);
+    }
+    return victims;
+}
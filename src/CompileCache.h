@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// 本地目标文件缓存（类似 ccache）：键由预处理结果、编译器身份和完整编译参数计算，
+// 条目按最近使用时间淘汰，总大小受 maxBytes 限制。
+// fetch/store 会复制文件，由 BuildManager 放在后台线程里调用，可以多个线程同时进行；
+// 条目大小和最近使用时间记在内存索引里，只在第一次用到时遍历一次缓存目录。
+class CompileCache {
+public:
+    CompileCache();
+
+    QString directory() const;
+    void setDirectory(const QString &dir);
+    qint64 maxBytes() const;
+    void setMaxBytes(qint64 bytes); // 下次 store 时按新上限淘汰
+
+    QString compilerIdentity(const QString &compiler);
+
+    bool fetch(const QString &key, const QString &destination);
+    bool store(const QString &key, const QString &source);
+    void clear();
+
+    int hits() const;
+    int misses() const;
+    void resetStats();
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 lastUsedMs = 0;
+    };
+
+    QString entryPath(const QString &key) const;
+    void ensureIndexLoaded(); // 调用方持有 mutex_
+    QStringList takeEvictions(); // 调用方持有 mutex_；返回要删除的条目路径
+
+    mutable QMutex mutex_;
+    QString directory_;
+    qint64 maxBytes_ = 0;
+    bool indexLoaded_ = false;
+    QHash<QString, Entry> index_; // 条目路径 -> 大小和最近使用时间
+    qint64 currentBytes_ = 0;
+    int hits_ = 0;
+    int misses_ = 0;
+    QHash<QString, QString> compilerIds_;
+};
@@ -0,0 +1,164 @@
+#include "CoverageCollector.h"
+
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+namespace {
+// gcov 的版本必须和编译器一致：g++-12 对应 gcov-12，clang++-15 对应 llvm-cov-15 gcov。
+QStringList gcovCommand(const QString &compiler) {
+    const QString name = QFileInfo(compiler).fileName();
+    static const QRegularExpression kVersionSuffix(QStringLiteral("-\\d+(\\.\\d+)*$"));
+    const QRegularExpressionMatch version = kVersionSuffix.match(name);
+    const QString suffix = version.hasMatch() ? version.captured(0) : QString();
+    if (name.contains(QLatin1String("clang"))) {
+        QString tool = QStandardPaths::findExecutable(QStringLiteral("llvm-cov") + suffix);
+        if (tool.isEmpty()) {
+            tool = QStringLiteral("llvm-cov");
+        }
+        return {tool, QStringLiteral("gcov")};
+    }
+    QString gcov = name;
+    gcov.replace(QLatin1String("g++"), QLatin1String("gcov"));
+    gcov.replace(QLatin1String("gcc"), QLatin1String("gcov"));
+    if (!gcov.contains(QLatin1String("gcov")) || QStandardPaths::findExecutable(gcov).isEmpty()) {
+        gcov = QStringLiteral("gcov") + suffix;
+        if (QStandardPaths::findExecutable(gcov).isEmpty()) {
+            gcov = QStringLiteral("gcov");
+        }
+    }
+    return {gcov};
+}
+}
+
+CoverageCollector::CoverageCollector(QObject *parent) : QObject(parent) {
+    connect(&process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            &CoverageCollector::handleFinished);
+    connect(&process_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart && running_) {
+            fail(tr("无法启动：%1").arg(process_.program()));
+        }
+    });
+}
+
+bool CoverageCollector::isRunning() const {
+    return running_;
+}
+
+int CoverageCollector::clearCounters(const QString &objectDirectory) {
+    int removed = 0;
+    QDirIterator it(objectDirectory, {QStringLiteral("*.gcda")}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (QFile::remove(it.next())) {
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+void CoverageCollector::collect(const Request &request) {
+    if (running_) {
+        return;
+    }
+    request_ = request;
+    timer_.start();
+
+    QStringList dataFiles;
+    QDirIterator it(request.objectDirectory, {QStringLiteral("*.gcda")}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        dataFiles << it.next();
+    }
+    dataFiles_ = static_cast<int>(dataFiles.size());
+    if (dataFiles.isEmpty()) {
+        CoverageReport report;
+        report.error = tr("没有找到覆盖率数据（.gcda），请先用 Coverage 模式编译并运行。");
+        emit finished(report);
+        return;
+    }
+
+    QStringList command = gcovCommand(request.compiler);
+    const QString program = command.takeFirst();
+    // 不给 -o：gcov 按 .gcda 的路径找同名 .gcno，目标文件分布在多个子目录时也不会找错
+    command << "-t" << dataFiles;
+    running_ = true;
+    process_.setWorkingDirectory(request.objectDirectory);
+    process_.setProcessChannelMode(QProcess::SeparateChannels);
+    process_.start(program, command);
+}
+
+void CoverageCollector::handleFinished(int exitCode, QProcess::ExitStatus status) {
+    if (!running_) {
+        return;
+    }
+    const QString out = QString::fromLocal8Bit(process_.readAllStandardOutput());
+    const QString err = QString::fromLocal8Bit(process_.readAllStandardError()).trimmed();
+    if (status != QProcess::NormalExit || (exitCode != 0 && out.isEmpty())) {
+        fail(err.isEmpty() ? tr("gcov 失败，退出码 %1").arg(exitCode) : err);
+        return;
+    }
+    running_ = false;
+    CoverageReport report = parseGcovText(out, request_.sourceRoot);
+    report.dataFiles = dataFiles_;
+    report.elapsedMs = timer_.elapsed();
+    emit finished(report);
+}
+
+void CoverageCollector::fail(const QString &error) {
+    running_ = false;
+    CoverageReport report;
+    report.error = error;
+    report.elapsedMs = timer_.elapsed();
+    emit finished(report);
+}
+
+CoverageReport CoverageCollector::parseGcovText(const QString &text, const QString &sourceRoot) {
+    //         -:    0:Source:/work/src/a.cpp
+    //        10:    3:    if (x > 5)
+    //     #####:    4:        return x * 2;
+    //        4*:    5:    return x;          （* 表示这一行有没执行到的基本块）
+    // 模板实例化的分段行以 "|" 开头，总数已经算在上面的行里，这里跳过。
+    static const QRegularExpression kLine(QStringLiteral("^\\s*(-|#####|=====|\\d+\\*?)\\s*:\\s*(\\d+):(.*)$"));
+    CoverageReport report;
+    QString current; // 不在 sourceRoot 下的文件为空
+    const QStringList lines = text.split('\n');
+    for (const QString &line : lines) {
+        const QRegularExpressionMatch match = kLine.match(line);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        const int lineNumber = match.captured(2).toInt();
+        if (lineNumber == 0) {
+            const QString rest = match.captured(3).trimmed();
+            if (rest.startsWith(QLatin1String("Source:"))) {
+                const QString path = QFileInfo(rest.mid(7)).absoluteFilePath();
+                current = sourceRoot.isEmpty() || path.startsWith(sourceRoot) ? path : QString();
+            }
+            continue;
+        }
+        const QString count = match.captured(1);
+        if (current.isEmpty() || count == QLatin1String("-")) {
+            continue;
+        }
+        qint64 value = 0;
+        if (count.at(0).isDigit()) {
+            QString digits = count;
+            if (digits.endsWith('*')) {
+                digits.chop(1);
+            }
+            value = digits.toLongLong();
+        }
+        // 同一个头文件出现在多个翻译单元里，执行次数相加
+        report.lineCounts[current][lineNumber] += value;
+    }
+    for (const auto &file : report.lineCounts) {
+        for (qint64 count : file) {
+            ++report.executableLines;
+            if (count > 0) {
+                ++report.coveredLines;
+            }
+        }
+    }
+    return report;
+}
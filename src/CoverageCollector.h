@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+struct CoverageReport {
+    QHash<QString, QHash<int, qint64>> lineCounts; // 绝对路径 -> 可执行行（从 1 开始）-> 执行次数
+    int executableLines = 0;
+    int coveredLines = 0;
+    int dataFiles = 0;
+    qint64 elapsedMs = 0;
+    QString error;
+};
+
+// 读取 --coverage 插桩产物运行后留下的 .gcda：gcc 用对应版本的 gcov，clang 用 llvm-cov gcov，
+// 都以 -t 把 .gcov 文本输出到标准输出，不在工程里留下文件。只保留 sourceRoot 下的源文件。
+class CoverageCollector : public QObject {
+    Q_OBJECT
+
+public:
+    struct Request {
+        QString compiler;
+        QString objectDirectory; // build/Coverage/obj
+        QString sourceRoot;
+    };
+
+    explicit CoverageCollector(QObject *parent = nullptr);
+
+    void collect(const Request &request);
+    bool isRunning() const;
+    static int clearCounters(const QString &objectDirectory); // 删除 .gcda，返回删除的个数
+
+    static CoverageReport parseGcovText(const QString &text, const QString &sourceRoot);
+
+signals:
+    void finished(const CoverageReport &report);
+
+private:
+    void handleFinished(int exitCode, QProcess::ExitStatus status);
+    void fail(const QString &error);
+
+    QProcess process_;
+    Request request_;
+    QElapsedTimer timer_;
+    int dataFiles_ = 0;
+    bool running_ = false;
+};
@@ -0,0 +1,261 @@
+#include "DiagnosticParser.h"
+
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+
+namespace {
+// 单个 JSON 诊断块过大时放弃，按文本处理，避免异常输出把内存吃光。
+constexpr int kMaxJsonBytes = 64 * 1024 * 1024;
+
+BuildDiagnostic::Severity severityFromText(const QString &text) {
+    if (text.contains("error")) {
+        return BuildDiagnostic::Error;
+    }
+    if (text == "warning") {
+        return BuildDiagnostic::Warning;
+    }
+    return BuildDiagnostic::Note;
+}
+
+QString unescapeFixIt(const QString &text) {
+    QString result;
+    result.reserve(text.size());
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c == '\\' && i + 1 < text.size()) {
+            const QChar n = text.at(++i);
+            if (n == 'n') {
+                result += '\n';
+            } else if (n == 't') {
+                result += '\t';
+            } else {
+                result += n;
+            }
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+}
+
+QString BuildDiagnostic::key() const {
+    return QStringLiteral("%1:%2:%3:%4:%5").arg(file).arg(line).arg(column).arg(int(severity)).arg(message);
+}
+
+DiagnosticParser::DiagnosticParser(const QString &workingDirectory) : workingDir_(workingDirectory) {}
+
+QList<BuildDiagnostic> DiagnosticParser::feed(const QByteArray &data) {
+    QList<BuildDiagnostic> done;
+    pending_ += data;
+    int start = 0;
+    int newline = pending_.indexOf('\n', start);
+    while (newline >= 0) {
+        QByteArray raw = pending_.mid(start, newline - start);
+        if (raw.endsWith('\r')) {
+            raw.chop(1);
+        }
+        start = newline + 1;
+
+        if (!json_.isEmpty() || raw.startsWith("[{") || raw == "[]") {
+            json_ += raw;
+            json_ += '\n';
+            if (!parseJson(&done) && json_.size() > kMaxJsonBytes) {
+                const QStringList lines = QString::fromLocal8Bit(json_).split('\n');
+                json_.clear();
+                for (const QString &line : lines) {
+                    parseLine(line, &done);
+                }
+            }
+        } else {
+            parseLine(QString::fromLocal8Bit(raw), &done);
+        }
+        newline = pending_.indexOf('\n', start);
+    }
+    pending_.remove(0, start);
+    return done;
+}
+
+QList<BuildDiagnostic> DiagnosticParser::finish() {
+    QList<BuildDiagnostic> done;
+    if (!pending_.isEmpty()) {
+        pending_ += '\n';
+        done = feed(QByteArray());
+    }
+    if (!json_.isEmpty()) {
+        if (!parseJson(&done)) {
+            const QStringList lines = QString::fromLocal8Bit(json_).split('\n');
+            json_.clear();
+            for (const QString &line : lines) {
+                parseLine(line, &done);
+            }
+        }
+    }
+    flushCurrent(&done);
+    return done;
+}
+
+bool DiagnosticParser::isFixItLine(const QString &line) {
+    return line.startsWith(QStringLiteral("fix-it:\""));
+}
+
+void DiagnosticParser::parseLine(const QString &rawLine, QList<BuildDiagnostic> *done) {
+    static const QRegularExpression ansi(QStringLiteral("\\x1b\\[[0-9;]*[mK]"));
+    static const QRegularExpression located(
+        QStringLiteral("^(.+?):(\\d+):(?:(\\d+):)?\\s*(fatal error|error|warning|note|remark):\\s*(.*)$"));
+    static const QRegularExpression context(
+        QStringLiteral("^(.+?):(\\d+):(\\d+):\\s+((?:required|recursively required|in (?:constexpr )?expansion) .*)$"));
+    static const QRegularExpression unlocated(QStringLiteral("^([^\\s:][^:]*):\\s*(fatal error|error|warning):\\s*(.*)$"));
+    static const QRegularExpression fixit(QStringLiteral(
+        "^fix-it:\"((?:[^\"\\\\]|\\\\.)*)\":\\{(\\d+):(\\d+)-(\\d+):(\\d+)\\}:\"((?:[^\"\\\\]|\\\\.)*)\"$"));
+    static const QRegularExpression option(QStringLiteral("\\s\\[(-W[^\\]]+)\\]$"));
+
+    QString line = rawLine;
+    if (line.contains(QChar(0x1b))) {
+        line.remove(ansi);
+    }
+    if (line.trimmed().isEmpty()) {
+        return;
+    }
+
+    QRegularExpressionMatch m = fixit.match(line);
+    if (m.hasMatch()) {
+        if (hasCurrent_) {
+            BuildFixIt fix;
+            fix.file = resolvePath(unescapeFixIt(m.captured(1)));
+            fix.line = m.captured(2).toInt();
+            fix.column = m.captured(3).toInt();
+            fix.endLine = m.captured(4).toInt();
+            fix.endColumn = m.captured(5).toInt();
+            fix.replacement = unescapeFixIt(m.captured(6));
+            current_.fixits.append(fix);
+        }
+        return;
+    }
+
+    m = located.match(line);
+    if (m.hasMatch()) {
+        BuildDiagnostic diag;
+        diag.file = resolvePath(m.captured(1));
+        diag.line = m.captured(2).toInt();
+        diag.column = m.captured(3).toInt();
+        diag.severity = severityFromText(m.captured(4));
+        diag.message = m.captured(5);
+        const QRegularExpressionMatch opt = option.match(diag.message);
+        if (opt.hasMatch()) {
+            diag.option = opt.captured(1);
+            diag.message.chop(opt.capturedLength(0));
+        }
+        if (diag.severity == BuildDiagnostic::Note && hasCurrent_) {
+            current_.notes.append(diag);
+            return;
+        }
+        flushCurrent(done);
+        current_ = diag;
+        hasCurrent_ = true;
+        return;
+    }
+
+    // 模板实例化链：“required from here” 之类没有 severity 的行归入当前诊断的 note。
+    m = context.match(line);
+    if (m.hasMatch()) {
+        if (hasCurrent_) {
+            BuildDiagnostic note;
+            note.severity = BuildDiagnostic::Note;
+            note.file = resolvePath(m.captured(1));
+            note.line = m.captured(2).toInt();
+            note.column = m.captured(3).toInt();
+            note.message = m.captured(4);
+            current_.notes.append(note);
+        }
+        return;
+    }
+
+    m = unlocated.match(line);
+    if (m.hasMatch()) {
+        flushCurrent(done);
+        current_ = BuildDiagnostic{};
+        current_.severity = severityFromText(m.captured(2));
+        current_.message = m.captured(1) + QStringLiteral(": ") + m.captured(3);
+        hasCurrent_ = true;
+        return;
+    }
+
+    if (line.contains(QStringLiteral("undefined reference to")) || line.contains(QStringLiteral("multiple definition of"))) {
+        flushCurrent(done);
+        current_ = BuildDiagnostic{};
+        current_.severity = BuildDiagnostic::Error;
+        current_.message = line.trimmed();
+        hasCurrent_ = true;
+    }
+    // 源码回显、插入符号行和 “In function ...” 之类的上下文头不单独成条。
+}
+
+bool DiagnosticParser::parseJson(QList<BuildDiagnostic> *done) {
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(json_, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isArray()) {
+        return false;
+    }
+    json_.clear();
+    flushCurrent(done);
+    for (const auto &value : doc.array()) {
+        done->append(fromJson(value.toObject()));
+    }
+    return true;
+}
+
+BuildDiagnostic DiagnosticParser::fromJson(const QJsonObject &obj) const {
+    BuildDiagnostic diag;
+    diag.severity = severityFromText(obj.value("kind").toString());
+    diag.message = obj.value("message").toString();
+    diag.option = obj.value("option").toString();
+
+    const QJsonArray locations = obj.value("locations").toArray();
+    if (!locations.isEmpty()) {
+        const QJsonObject caret = locations.first().toObject().value("caret").toObject();
+        diag.file = resolvePath(caret.value("file").toString());
+        diag.line = caret.value("line").toInt();
+        diag.column = caret.value("column").toInt();
+    }
+
+    for (const auto &child : obj.value("children").toArray()) {
+        diag.notes.append(fromJson(child.toObject()));
+    }
+
+    // GCC 的 fix-it 区间是 [start, next)，与 parseable-fixits 的半开区间一致。
+    for (const auto &fixVal : obj.value("fixits").toArray()) {
+        const QJsonObject fixObj = fixVal.toObject();
+        const QJsonObject start = fixObj.value("start").toObject();
+        const QJsonObject next = fixObj.value("next").toObject();
+        BuildFixIt fix;
+        fix.file = resolvePath(start.value("file").toString());
+        fix.line = start.value("line").toInt();
+        fix.column = start.value("column").toInt();
+        fix.endLine = next.value("line").toInt(fix.line);
+        fix.endColumn = next.value("column").toInt(fix.column);
+        fix.replacement = fixObj.value("string").toString();
+        diag.fixits.append(fix);
+    }
+    return diag;
+}
+
+QString DiagnosticParser::resolvePath(const QString &file) const {
+    if (file.isEmpty()) {
+        return file;
+    }
+    const QDir base(workingDir_.isEmpty() ? QDir::currentPath() : workingDir_);
+    return QDir::cleanPath(base.absoluteFilePath(file));
+}
+
+void DiagnosticParser::flushCurrent(QList<BuildDiagnostic> *done) {
+    if (!hasCurrent_) {
+        return;
+    }
+    done->append(current_);
+    current_ = BuildDiagnostic{};
+    hasCurrent_ = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QJsonObject;
+
+struct BuildFixIt {
+    QString file;
+    int line = 0;
+    int column = 0;
+    int endLine = 0;
+    int endColumn = 0;
+    QString replacement;
+};
+
+struct BuildDiagnostic {
+    enum Severity { Error, Warning, Note };
+
+    Severity severity = Error;
+    QString file; // 绝对路径；链接器等无位置的诊断为空
+    int line = 0;   // 从 1 开始，0 表示未知
+    int column = 0; // 从 1 开始，0 表示未知
+    QString message;
+    QString option; // 例如 -Wunused-variable
+    QList<BuildDiagnostic> notes;
+    QList<BuildFixIt> fixits;
+
+    QString key() const;
+};
+
+// 增量解析 GCC/Clang 的诊断输出：按字节流喂入，返回已经完整的诊断（主诊断连同其后的 note）。
+// 支持 -fdiagnostics-format=json（整段 JSON 数组）和普通文本格式，
+// 文本格式下识别 -fdiagnostics-parseable-fixits 输出的 fix-it 行。
+class DiagnosticParser {
+public:
+    explicit DiagnosticParser(const QString &workingDirectory = QString());
+
+    QList<BuildDiagnostic> feed(const QByteArray &data);
+    QList<BuildDiagnostic> finish();
+
+    static bool isFixItLine(const QString &line);
+
+private:
+    void parseLine(const QString &line, QList<BuildDiagnostic> *done);
+    bool parseJson(QList<BuildDiagnostic> *done);
+    BuildDiagnostic fromJson(const QJsonObject &obj) const;
+    QString resolvePath(const QString &file) const;
+    void flushCurrent(QList<BuildDiagnostic> *done);
+
+    QString workingDir_;
+    QByteArray pending_;
+    QByteArray json_;
+    BuildDiagnostic current_;
+    bool hasCurrent_ = false;
+};
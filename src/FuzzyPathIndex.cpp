@@ -0,0 +1,310 @@
+#include "FuzzyPathIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr int kNoMatch = std::numeric_limits<int>::min();
+constexpr int kMaxQueryBytes = 128;
+
+// 打分规则接近 fzf：每命中一个字符得分，落在词首（/ _ - . 之后、驼峰的大写字母）或 basename 开头另外加分，
+// 连续命中沿用这一段开头的加分，中间跳过的字符扣分。
+constexpr int kScoreMatch = 16;
+constexpr int kBonusBasenameStart = 40;
+constexpr int kBonusBoundary = 24;
+constexpr int kBonusConsecutive = 8;
+constexpr int kPenaltyGapStart = 3;
+constexpr int kPenaltyGapExtension = 1;
+// basename 里能匹配上的一律排在只能跨目录匹配的前面
+constexpr int kTierBasename = 1 << 20;
+
+quint64 charBit(uchar c) {
+    if (c >= 'a' && c <= 'z') {
+        return quint64(1) << (c - 'a');
+    }
+    if (c >= '0' && c <= '9') {
+        return quint64(1) << (26 + c - '0');
+    }
+    if (c >= 0x80) {
+        return quint64(1) << 63; // 非 ASCII 的字节共用一位
+    }
+    return quint64(1) << (36 + c % 27);
+}
+
+quint64 maskOf(const char *text, int length) {
+    quint64 mask = 0;
+    for (int i = 0; i < length; ++i) {
+        mask |= charBit(static_cast<uchar>(text[i]));
+    }
+    return mask;
+}
+
+bool isBoundary(char c) {
+    return c == '/' || c == '_' || c == '-' || c == '.' || c == ' ';
+}
+
+QByteArray normalizedPath(const QString &path) {
+    QString lower = path.toLower();
+    lower.replace('\\', '/');
+    return lower.toUtf8();
+}
+
+// 大小写信息在小写化之后就没了，先按原文标出词首。转小写改变了 UTF-8 长度时只认分隔符。
+QByteArray wordStarts(const QString &path, const QByteArray &lower) {
+    QByteArray original = path.toUtf8();
+    const bool sameLayout = original.size() == lower.size();
+    QByteArray starts(lower.size(), '\0');
+    for (int i = 0; i < starts.size(); ++i) {
+        if (i == 0 || isBoundary(lower.at(i - 1))) {
+            starts[i] = 1;
+        } else if (sameLayout) {
+            const char c = original.at(i);
+            const char previous = original.at(i - 1);
+            starts[i] = c >= 'A' && c <= 'Z' && !(previous >= 'A' && previous <= 'Z');
+        }
+    }
+    return starts;
+}
+
+QByteArray normalizedQuery(const QString &query) {
+    QByteArray bytes = normalizedPath(query);
+    bytes.replace(' ', QByteArray());
+    return bytes.left(kMaxQueryBytes);
+}
+
+// 在 p[begin, end) 里把 q 当作子序列匹配。先正向找到最早的结束位置，再从那里反向找最晚的起点，
+// 得到最短的窗口，然后在窗口里正向计分。starts 是与 p 对应的词首标记。
+// positions 非空时写入每个查询字符命中的字节偏移。
+int scoreWindow(const char *p, const char *starts, int begin, int end, const char *q, int m, int baseStart,
+                int *positions) {
+    int j = 0;
+    int i = begin;
+    for (; i < end; ++i) {
+        if (p[i] == q[j] && ++j == m) {
+            break;
+        }
+    }
+    if (j < m) {
+        return kNoMatch;
+    }
+    const int last = i;
+    int start = last;
+    for (j = m - 1;; --start) {
+        if (p[start] == q[j] && --j < 0) {
+            break;
+        }
+    }
+
+    int score = 0;
+    int previous = start - 1;
+    int chunkBonus = 0;
+    j = 0;
+    for (i = start; j < m; ++i) {
+        if (p[i] != q[j]) {
+            continue;
+        }
+        int bonus = 0;
+        if (i == baseStart) {
+            bonus = kBonusBasenameStart;
+        } else if (starts[i]) {
+            bonus = kBonusBoundary;
+        }
+        if (j > 0 && previous == i - 1) {
+            bonus = std::max({bonus, chunkBonus, kBonusConsecutive});
+        } else if (j > 0) {
+            score -= kPenaltyGapStart + (i - previous - 2) * kPenaltyGapExtension;
+        }
+        chunkBonus = bonus;
+        score += kScoreMatch + bonus;
+        if (positions) {
+            positions[j] = i;
+        }
+        previous = i;
+        ++j;
+    }
+    return score;
+}
+
+// 同分时路径短的在前
+int finalScore(int raw, int length, bool inBasename) {
+    return (inBasename ? kTierBasename : 0) + raw * 4 - length / 4;
+}
+}
+
+void FuzzyPathIndex::setPaths(const QStringList &paths) {
+    paths_ = paths;
+    text_.clear();
+    boundaries_.clear();
+    entries_.clear();
+    masks_.clear();
+    entries_.reserve(static_cast<int>(paths.size()));
+    masks_.reserve(static_cast<int>(paths.size()));
+    for (const QString &path : paths) {
+        const QByteArray bytes = normalizedPath(path);
+        Entry entry;
+        entry.offset = static_cast<int>(text_.size());
+        entry.length = static_cast<int>(bytes.size());
+        entry.baseStart = static_cast<int>(bytes.lastIndexOf('/')) + 1;
+        entry.baseMask = maskOf(bytes.constData() + entry.baseStart, entry.length - entry.baseStart);
+        entry.baseFirst = entry.baseStart < entry.length ? bytes.at(entry.baseStart) : '\0';
+        text_.append(bytes);
+        boundaries_.append(wordStarts(path, bytes));
+        entries_.append(entry);
+        masks_.append(maskOf(bytes.constData(), entry.length));
+    }
+    lastQuery_.clear();
+    candidates_.clear();
+}
+
+const QStringList &FuzzyPathIndex::paths() const {
+    return paths_;
+}
+
+int FuzzyPathIndex::size() const {
+    return static_cast<int>(entries_.size());
+}
+
+QVector<FuzzyPathIndex::Match> FuzzyPathIndex::match(const QString &query, int limit) {
+    QVector<Match> result;
+    const QByteArray q = normalizedQuery(query);
+    if (q.isEmpty() || limit <= 0) {
+        lastQuery_.clear();
+        candidates_.clear();
+        for (int i = 0; i < std::min(limit, size()); ++i) {
+            result.append(Match{i, 0});
+        }
+        return result;
+    }
+    const int m = static_cast<int>(q.size());
+    const quint64 queryMask = maskOf(q.constData(), m);
+    const quint64 *masks = masks_.constData();
+
+    // 第一步：掩码筛选，写入位置无条件前进，避免在一半命中一半落空时分支预测失败
+    const bool narrowing = !lastQuery_.isEmpty() && q.startsWith(lastQuery_);
+    const int total = narrowing ? static_cast<int>(candidates_.size()) : size();
+    scratch_.resize(total);
+    int *out = scratch_.data();
+    int kept = 0;
+    if (narrowing) {
+        const int *from = candidates_.constData();
+        for (int k = 0; k < total; ++k) {
+            const int i = from[k];
+            out[kept] = i;
+            kept += (masks[i] & queryMask) == queryMask;
+        }
+    } else {
+        for (int i = 0; i < total; ++i) {
+            out[kept] = i;
+            kept += (masks[i] & queryMask) == queryMask;
+        }
+    }
+    scratch_.resize(kept);
+    candidates_.swap(scratch_);
+    lastQuery_ = q;
+
+    // 第二步：打分，用小根堆保留前 limit 名
+    const auto better = [](const Match &a, const Match &b) {
+        return a.score != b.score ? a.score > b.score : a.index < b.index;
+    };
+    result.reserve(limit);
+    const auto offer = [&](int index, int score) {
+        const Match match{index, score};
+        if (result.size() < limit) {
+            result.append(match);
+            std::push_heap(result.begin(), result.end(), better);
+        } else if (better(match, result.front())) {
+            std::pop_heap(result.begin(), result.end(), better);
+            result.back() = match;
+            std::push_heap(result.begin(), result.end(), better);
+        }
+    };
+
+    // 每条路径能拿到的最高分：basename 以查询首字符开头时全部字符都能沿用 basename 开头的加分，
+    // 否则最多拿到词首加分。堆满后上限够不到门槛的不用看文本；候选按下标递增，同分也比不过堆里的
+    const int prefixBound = (kScoreMatch + kBonusBasenameStart) * m;
+    const int nonPrefixBound = (kScoreMatch + kBonusBoundary) * m;
+    const char first = q.at(0);
+    const Entry *entries = entries_.constData();
+    const char *text = text_.constData();
+    const char *starts = boundaries_.constData();
+    const int *candidates = candidates_.constData();
+    scratch_.resize(kept);
+    int *pathOnly = scratch_.data();
+    int pathOnlyCount = 0;
+    for (int k = 0; k < kept; ++k) {
+        const int i = candidates[k];
+        const Entry &entry = entries[i];
+        if ((entry.baseMask & queryMask) == queryMask && entry.baseStart < entry.length) {
+            const int bound = entry.baseFirst == first ? prefixBound : nonPrefixBound;
+            if (result.size() == limit && finalScore(bound, entry.length, true) <= result.front().score) {
+                continue;
+            }
+            const int raw = scoreWindow(text + entry.offset, starts + entry.offset, entry.baseStart, entry.length,
+                                        q.constData(), m, entry.baseStart, nullptr);
+            if (raw != kNoMatch) {
+                offer(i, finalScore(raw, entry.length, true));
+                continue;
+            }
+        }
+        pathOnly[pathOnlyCount++] = i;
+    }
+    // basename 里的匹配不够 limit 条时才需要看跨目录的匹配
+    if (result.size() < limit) {
+        for (int k = 0; k < pathOnlyCount; ++k) {
+            const Entry &entry = entries[pathOnly[k]];
+            const int raw = scoreWindow(text + entry.offset, starts + entry.offset, 0, entry.length, q.constData(), m,
+                                        entry.baseStart, nullptr);
+            if (raw != kNoMatch) {
+                offer(pathOnly[k], finalScore(raw, entry.length, false));
+            }
+        }
+    }
+    std::sort_heap(result.begin(), result.end(), better);
+    return result;
+}
+
+QVector<int> FuzzyPathIndex::matchPositions(int index, const QString &query) const {
+    if (index < 0 || index >= size()) {
+        return {};
+    }
+    const QString &path = paths_.at(index);
+    if (path.toLower().size() != path.size()) {
+        return {}; // 少数字符转小写后长度会变，不好对应回原文，不高亮
+    }
+    const QByteArray q = normalizedQuery(query);
+    const int m = static_cast<int>(q.size());
+    if (m == 0) {
+        return {};
+    }
+    const Entry &entry = entries_.at(index);
+    const char *p = text_.constData() + entry.offset;
+    const char *starts = boundaries_.constData() + entry.offset;
+    QVector<int> bytePositions(m);
+    int raw = kNoMatch;
+    if (entry.baseStart < entry.length) {
+        raw = scoreWindow(p, starts, entry.baseStart, entry.length, q.constData(), m, entry.baseStart,
+                          bytePositions.data());
+    }
+    if (raw == kNoMatch) {
+        raw = scoreWindow(p, starts, 0, entry.length, q.constData(), m, entry.baseStart, bytePositions.data());
+    }
+    if (raw == kNoMatch) {
+        return {};
+    }
+
+    // UTF-8 字节偏移换算成 QString 下标：四字节序列对应一对代理项
+    QVector<int> positions;
+    positions.reserve(m);
+    int charIndex = 0;
+    int byte = 0;
+    for (int target : bytePositions) {
+        for (; byte < target; ++byte) {
+            const uchar c = static_cast<uchar>(p[byte]);
+            if ((c & 0xC0) != 0x80) {
+                charIndex += c >= 0xF0 ? 2 : 1;
+            }
+        }
+        positions.append(charIndex);
+    }
+    return positions;
+}
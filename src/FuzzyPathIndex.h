@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+// “转到文件”用的模糊路径索引。路径一次性转成小写 UTF-8 连续存放，每条路径附带整条路径和 basename
+// 各自的 64 位字符掩码；查询时先用掩码无分支地筛掉不可能匹配的路径（每条一次与运算加比较），
+// 剩下的再按子序列打分，只保留前 limit 名。查询在上一次查询后面追加字符时，只在上一次的候选里继续筛。
+class FuzzyPathIndex {
+public:
+    struct Match {
+        int index = 0; // paths() 里的下标
+        int score = 0;
+    };
+
+    void setPaths(const QStringList &paths);
+    const QStringList &paths() const;
+    int size() const;
+
+    // 按分数从高到低返回至多 limit 条；整段落在 basename 里的匹配总排在只能跨目录匹配的前面。
+    // 查询为空时按原顺序返回前 limit 条。
+    QVector<Match> match(const QString &query, int limit);
+
+    // 命中字符在 paths().at(index) 里的下标，只给显示出来的几十条算，用于高亮
+    QVector<int> matchPositions(int index, const QString &query) const;
+
+private:
+    struct Entry {
+        quint64 baseMask = 0; // basename 出现过的字符
+        int offset = 0;       // 在 text_ 里的起点
+        int length = 0;
+        int baseStart = 0; // basename 相对路径起点的偏移
+        char baseFirst = 0; // basename 的第一个字节，剪枝时不用去读 text_
+    };
+
+    QStringList paths_;
+    QByteArray text_;
+    QByteArray boundaries_; // 与 text_ 一一对应：1 表示词首（路径开头、分隔符之后、驼峰的大写字母）
+    QVector<Entry> entries_;
+    QVector<quint64> masks_; // 整条路径出现过的字符；单独连续存放，筛选时只扫这一个数组
+
+    // 上一次查询的掩码筛选结果（比真正的匹配集合大），下一次查询以它为起点
+    QByteArray lastQuery_;
+    QVector<int> candidates_;
+    QVector<int> scratch_;
+};
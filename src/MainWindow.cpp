@@ -1,20 +1,28 @@
 #include "MainWindow.h"
 
+#include "BenchmarkDialog.h"
+#include "BenchmarkRunner.h"
 #include "BuildManager.h"
+#include "BuildReportDialog.h"
 #include "CodeEditor.h"
+#include "CoverageCollector.h"
 #include "CppRusticHighlighter.h"
 #include "FindReplaceDialog.h"
 #include "GdbMiClient.h"
 #include "LspClient.h"
+#include "ProjectFileIndex.h"
 #include "ProjectManager.h"
 #include "ProjectSettingsDialog.h"
+#include "QuickOpenDialog.h"
 #include "ShortcutSettingsDialog.h"
+#include "ToolPipeline.h"
 
 #include <QAction>
 #include <QActionGroup>
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDockWidget>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
@@ -29,6 +37,7 @@
 #include <QMenu>
 #include <QMenuBar>
 #include <QPlainTextEdit>
+#include <QProgressBar>
 #include <QSettings>
 #include <QStatusBar>
 #include <QTextDocument>
@@ -48,6 +57,7 @@
 #include <QHash>
 #include <QSet>
 #include <QScreen>
+#include <QScrollBar>
 
 #include <functional>
 #include <algorithm>
@@ -60,13 +70,12 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       tabWidget_(new QTabWidget(this)),
-      output_(new QPlainTextEdit(this)) {
+      output_(new OutputPane(this)) {
     std::fprintf(stderr, "[DEBUG_STARTUP] MainWindow ctor begin\n");
     std::fflush(stderr);
     tabWidget_->setTabsClosable(true);
     tabWidget_->setMovable(true);
     setCentralWidget(tabWidget_);
-    output_->setReadOnly(true);
 
     connect(tabWidget_->tabBar(), &QTabBar::tabMoved, this, [this](int from, int to) {
         if (from < 0 || to < 0 || from >= openTabs_.size() || to >= openTabs_.size()) {
@@ -84,6 +93,10 @@ MainWindow::MainWindow(QWidget *parent)
     createToolBar();
     std::fprintf(stderr, "[DEBUG_STARTUP] createToolBar done\n");
     std::fflush(stderr);
+    // 运行控制台在 createDocks 里绑定到 BuildManager 的 RunSession，要先创建
+    buildManager_ = std::make_unique<BuildManager>(this);
+    std::fprintf(stderr, "[DEBUG_STARTUP] buildManager created\n");
+    std::fflush(stderr);
     createDocks();
     std::fprintf(stderr, "[DEBUG_STARTUP] createDocks done\n");
     std::fflush(stderr);
@@ -98,11 +111,34 @@ MainWindow::MainWindow(QWidget *parent)
 
     // 基础高亮器会在每个标签页创建时绑定到对应 document。
 
-    buildManager_ = std::make_unique<BuildManager>(this);
-    std::fprintf(stderr, "[DEBUG_STARTUP] buildManager created\n");
-    std::fflush(stderr);
     connect(buildManager_.get(), &BuildManager::outputReady, this, &MainWindow::appendBuildOutput);
     connect(buildManager_.get(), &BuildManager::buildFinished, this, &MainWindow::buildFinished);
+    connect(buildManager_.get(), &BuildManager::diagnosticReported, this, &MainWindow::addBuildDiagnostic);
+    connect(buildManager_.get(), &BuildManager::buildStarted, this, [this]() {
+        clearBuildDiagnostics();
+        buildProgressBar_->setRange(0, 0);
+        buildProgressBar_->show();
+        cancelBuildAct_->setEnabled(true);
+    });
+    connect(buildManager_.get(), &BuildManager::buildProgress, this, [this](int finished, int total) {
+        buildProgressBar_->setRange(0, total);
+        buildProgressBar_->setValue(finished);
+    });
+
+    buildOnSaveTimer_ = new QTimer(this);
+    buildOnSaveTimer_->setSingleShot(true);
+    buildOnSaveTimer_->setInterval(800);
+    connect(buildOnSaveTimer_, &QTimer::timeout, this, [this]() {
+        if (!currentFile_.isEmpty() || projectManager_->hasProject()) {
+            startBuild();
+        }
+    });
+
+    buildProgressBar_ = new QProgressBar(this);
+    buildProgressBar_->setMaximumWidth(180);
+    buildProgressBar_->setFormat(tr("编译 %v/%m"));
+    buildProgressBar_->hide();
+    statusBar()->addPermanentWidget(buildProgressBar_);
 
     projectManager_ = std::make_unique<ProjectManager>(this);
     std::fprintf(stderr, "[DEBUG_STARTUP] projectManager created\n");
@@ -136,6 +172,41 @@ MainWindow::MainWindow(QWidget *parent)
             }
         }
     });
+    projectIndex_ = projectManager_->fileIndex();
+    connect(projectManager_.get(), &ProjectManager::projectLoaded, this, [this]() { quickOpenDirty_ = true; });
+    connect(projectManager_.get(), &ProjectManager::projectClosed, this, [this]() {
+        quickOpenDirty_ = true;
+        importSourcesBefore_ = -1;
+        if (buildWaitingForSources_) {
+            buildWaitingForSources_ = false;
+            dropPendingBuildActions(tr("工程已关闭，未运行基准测试。"));
+        }
+    });
+    connect(projectIndex_, &ProjectFileIndex::ready, this, [this]() {
+        quickOpenDirty_ = true;
+        if (projectManager_->hasProject()) {
+            rebuildProjectTree();
+        }
+    });
+    connect(projectIndex_, &ProjectFileIndex::filesAdded, this, &MainWindow::addOtherFileItems);
+    connect(projectIndex_, &ProjectFileIndex::filesRemoved, this, &MainWindow::removeOtherFileItems);
+    connect(projectIndex_, &ProjectFileIndex::filesAdded, this, [this]() { quickOpenDirty_ = true; });
+    connect(projectIndex_, &ProjectFileIndex::filesRemoved, this, [this]() { quickOpenDirty_ = true; });
+    connect(projectManager_.get(), &ProjectManager::sourcesChanged, this,
+            [this](const QStringList &added, const QStringList &removed) {
+                quickOpenDirty_ = true;
+                applySourceChanges(added, removed);
+            });
+    connect(projectManager_.get(), &ProjectManager::sourcesReady, this, [this]() {
+        reportImportedSources();
+        if (buildWaitingForSources_) {
+            buildWaitingForSources_ = false;
+            startBuild();
+        }
+    });
+    connect(projectManager_.get(), &ProjectManager::saveFailed, this, [this](const QString &path) {
+        statusBar()->showMessage(tr("工程保存失败：%1").arg(path), 5000);
+    });
     connect(lspClient_.get(), &LspClient::diagnosticsUpdated, this, &MainWindow::handleDiagnostics);
     connect(lspClient_.get(), &LspClient::completionItemsReady, this, &MainWindow::handleCompletionItems);
     connect(lspClient_.get(), &LspClient::documentSymbolsReady, this, &MainWindow::handleDocumentSymbols);
@@ -144,7 +215,9 @@ MainWindow::MainWindow(QWidget *parent)
     connect(lspClient_.get(), &LspClient::definitionLocationsReady, this, &MainWindow::handleDefinitionLocations);
     connect(lspClient_.get(), &LspClient::referencesLocationsReady, this, &MainWindow::handleReferencesLocations);
     connect(lspClient_.get(), &LspClient::renameEditsReady, this, &MainWindow::handleRenameEdits);
-    connect(lspClient_.get(), &LspClient::serverLog, this, &MainWindow::appendBuildOutput);
+    connect(lspClient_.get(), &LspClient::serverLog, this, [this](const QString &message) {
+        appendBuildOutput(message.endsWith('\n') ? message : message + '\n');
+    });
 
     connect(gdbClient_.get(), &GdbMiClient::consoleOutput, this, [this](const QString &text) {
         if (debugOutput_) {
@@ -266,6 +339,7 @@ MainWindow::MainWindow(QWidget *parent)
                 lspClient_->setCurrentDocument(tab->editor->document(), currentFile_);
                 lspClient_->openDocument(currentFile_, tab->editor->toPlainText());
             }
+            requestAssembly();
         }
     });
 
@@ -471,8 +545,14 @@ void MainWindow::loadUiSettings() {
     loadShortcut(compileAct_);
     loadShortcut(rebuildAct_);
     loadShortcut(cleanAct_);
+    loadShortcut(cancelBuildAct_);
     loadShortcut(runAct_);
+    loadShortcut(benchmarkAct_);
+    loadShortcut(profileAct_);
+    loadShortcut(optRemarksAct_);
+    loadShortcut(clearCoverageAct_);
     loadShortcut(makefileAct_);
+    loadShortcut(ninjaFileAct_);
     loadShortcut(externalToolAct_);
     loadShortcut(debugStartAct_);
     loadShortcut(debugBuildAndStartAct_);
@@ -485,6 +565,7 @@ void MainWindow::loadUiSettings() {
     loadShortcut(debugAddWatchAct_);
     loadShortcut(debugRemoveWatchAct_);
     loadShortcut(debugStopAct_);
+    loadShortcut(quickOpenAct_);
     loadShortcut(navBackAct_);
     loadShortcut(navForwardAct_);
     loadShortcut(findReferencesAct_);
@@ -494,10 +575,12 @@ void MainWindow::loadUiSettings() {
     loadShortcut(saveProjectAct_);
     loadShortcut(closeProjectAct_);
     loadShortcut(addSourceAct_);
+    loadShortcut(importSourcesAct_);
     loadShortcut(addIncludeAct_);
     loadShortcut(fetchRusticAct_);
     loadShortcut(projectSettingsAct_);
     loadShortcut(terminalAct_);
+    loadShortcut(asmViewAct_);
 }
 
 void MainWindow::saveUiSettings() {
@@ -521,7 +604,18 @@ void MainWindow::createActions() {
     saveAct_ = new QAction(tr("保存"), this);
     saveAct_->setObjectName("file.save");
     saveAct_->setShortcuts(QKeySequence::Save);
-    connect(saveAct_, &QAction::triggered, this, &MainWindow::saveFile);
+    connect(saveAct_, &QAction::triggered, this, [this]() {
+        if (saveFile()) {
+            scheduleBuildOnSave();
+            // 保存的可能是头文件，缓存里的汇编都可能过期
+            asmGenerator_->invalidate();
+            requestAssembly();
+            // 行号已经变了，已有标注的文件重新收集
+            if (optRemarksDock_->isVisible() && optRemarks_.contains(QFileInfo(currentFile_).absoluteFilePath())) {
+                collectOptRemarks();
+            }
+        }
+    });
 
     saveAsAct_ = new QAction(tr("另存为..."), this);
     saveAsAct_->setObjectName("file.saveAs");
@@ -543,6 +637,11 @@ void MainWindow::createActions() {
     findInFilesAct_->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F));
     connect(findInFilesAct_, &QAction::triggered, this, &MainWindow::findInFiles);
 
+    quickOpenAct_ = new QAction(tr("转到文件..."), this);
+    quickOpenAct_->setObjectName("nav.quickOpen");
+    quickOpenAct_->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_P));
+    connect(quickOpenAct_, &QAction::triggered, this, &MainWindow::showQuickOpen);
+
     navBackAct_ = new QAction(tr("后退"), this);
     navBackAct_->setObjectName("nav.back");
     navBackAct_->setShortcut(QKeySequence(Qt::ALT | Qt::Key_Left));
@@ -582,15 +681,119 @@ void MainWindow::createActions() {
     cleanAct_->setObjectName("build.clean");
     connect(cleanAct_, &QAction::triggered, this, &MainWindow::cleanProject);
 
+    compileCacheAct_ = new QAction(tr("使用编译缓存"), this);
+    compileCacheAct_->setObjectName("build.compileCache");
+    compileCacheAct_->setCheckable(true);
+    {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        compileCacheAct_->setChecked(settings.value("cache/enabled", true).toBool());
+    }
+    connect(compileCacheAct_, &QAction::toggled, this, [](bool enabled) {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("cache/enabled", enabled);
+    });
+
+    buildOnSaveAct_ = new QAction(tr("保存后自动编译"), this);
+    buildOnSaveAct_->setObjectName("build.buildOnSave");
+    buildOnSaveAct_->setCheckable(true);
+    {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        buildOnSaveAct_->setChecked(settings.value("build/buildOnSave", false).toBool());
+    }
+    connect(buildOnSaveAct_, &QAction::toggled, this, [this](bool enabled) {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("build/buildOnSave", enabled);
+        if (!enabled) {
+            buildOnSaveTimer_->stop();
+        }
+    });
+
+    timeTraceAct_ = new QAction(tr("记录 Clang 时间线 (-ftime-trace)"), this);
+    timeTraceAct_->setObjectName("build.timeTrace");
+    timeTraceAct_->setCheckable(true);
+    {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        timeTraceAct_->setChecked(settings.value("build/timeTrace", false).toBool());
+    }
+    connect(timeTraceAct_, &QAction::toggled, this, [](bool enabled) {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("build/timeTrace", enabled);
+    });
+
+    buildReportAct_ = new QAction(tr("编译耗时报告..."), this);
+    buildReportAct_->setObjectName("build.report");
+    connect(buildReportAct_, &QAction::triggered, this, [this]() {
+        BuildReportDialog dialog(buildManager_->lastMetrics(), buildManager_->metricsDirectory(), this);
+        dialog.exec();
+    });
+
+    clearCacheAct_ = new QAction(tr("清空编译缓存"), this);
+    clearCacheAct_->setObjectName("build.clearCache");
+    connect(clearCacheAct_, &QAction::triggered, this, [this]() {
+        buildManager_->clearCompileCache();
+    });
+
+    cancelBuildAct_ = new QAction(tr("取消编译"), this);
+    cancelBuildAct_->setObjectName("build.cancel");
+    cancelBuildAct_->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_Pause));
+    cancelBuildAct_->setEnabled(false);
+    connect(cancelBuildAct_, &QAction::triggered, this, [this]() {
+        buildManager_->cancelBuild();
+    });
+
     runAct_ = new QAction(tr("运行"), this);
     runAct_->setObjectName("build.run");
     runAct_->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_F10));
     connect(runAct_, &QAction::triggered, this, &MainWindow::runFile);
 
+    benchmarkAct_ = new QAction(tr("以基准测试运行..."), this);
+    benchmarkAct_->setObjectName("build.benchmark");
+    connect(benchmarkAct_, &QAction::triggered, this, &MainWindow::showBenchmarkDialog);
+
+    profileAct_ = new QAction(tr("性能分析（采样）"), this);
+    profileAct_->setObjectName("build.profile");
+    connect(profileAct_, &QAction::triggered, this, &MainWindow::profileFile);
+
+    optRemarksAct_ = new QAction(tr("收集优化报告"), this);
+    optRemarksAct_->setObjectName("build.optRemarks");
+    optRemarksAct_->setStatusTip(tr("单独编译当前文件，把编译器的向量化、内联等优化报告标注到行尾"));
+    connect(optRemarksAct_, &QAction::triggered, this, &MainWindow::collectOptRemarks);
+
+    clearCoverageAct_ = new QAction(tr("清除覆盖率数据"), this);
+    clearCoverageAct_->setObjectName("build.clearCoverage");
+    clearCoverageAct_->setStatusTip(tr("删除 Coverage 模式累计的 .gcda 计数，并清除行号栏的覆盖率标记"));
+    connect(clearCoverageAct_, &QAction::triggered, this, [this]() {
+        int removed = 0;
+        if (projectManager_->hasProject()) {
+            removed = CoverageCollector::clearCounters(QDir(projectManager_->rootDir()).filePath(QStringLiteral("build/Coverage/obj")));
+        }
+        coverage_.clear();
+        for (OpenTab &tab : openTabs_) {
+            applyCoverage(tab);
+        }
+        statusBar()->showMessage(tr("已清除覆盖率数据（%1 个 .gcda）").arg(removed), 2000);
+    });
+
     makefileAct_ = new QAction(tr("生成 Makefile"), this);
     makefileAct_->setObjectName("build.makefile");
     connect(makefileAct_, &QAction::triggered, this, &MainWindow::generateMakefile);
 
+    ninjaFileAct_ = new QAction(tr("生成 build.ninja"), this);
+    ninjaFileAct_->setObjectName("build.ninjaFile");
+    connect(ninjaFileAct_, &QAction::triggered, this, &MainWindow::generateNinjaFile);
+
+    useNinjaAct_ = new QAction(tr("使用 Ninja 构建（若已安装）"), this);
+    useNinjaAct_->setObjectName("build.useNinja");
+    useNinjaAct_->setCheckable(true);
+    {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        useNinjaAct_->setChecked(settings.value("build/useNinja", false).toBool());
+    }
+    connect(useNinjaAct_, &QAction::toggled, this, [](bool enabled) {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("build/useNinja", enabled);
+    });
+
     externalToolAct_ = new QAction(tr("运行外部工具..."), this);
     externalToolAct_->setObjectName("build.externalTool");
     connect(externalToolAct_, &QAction::triggered, this, &MainWindow::runExternalTool);
@@ -688,14 +891,25 @@ void MainWindow::createActions() {
         if (terminalDock_) {
             terminalDock_->setVisible(terminalAct_->isChecked());
             if (terminalAct_->isChecked()) {
-                if (!terminalProcess_ || terminalProcess_->state() == QProcess::NotRunning) {
+                if (!terminal_->isRunning()) {
                     startTerminalShell();
                 }
                 terminalDock_->raise();
+                terminal_->setFocus();
             }
         }
     });
 
+    asmViewAct_ = new QAction(tr("汇编视图"), this);
+    asmViewAct_->setObjectName("view.assembly");
+    asmViewAct_->setCheckable(true);
+    connect(asmViewAct_, &QAction::triggered, this, [this](bool checked) {
+        asmDock_->setVisible(checked);
+        if (checked) {
+            asmDock_->raise();
+        }
+    });
+
     foldAllAct_ = new QAction(tr("折叠全部"), this);
     foldAllAct_->setObjectName("view.foldAll");
     foldAllAct_->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_K));
@@ -726,6 +940,11 @@ void MainWindow::createActions() {
     addSourceAct_->setObjectName("project.addSource");
     connect(addSourceAct_, &QAction::triggered, this, &MainWindow::addSourceFileToProject);
 
+    importSourcesAct_ = new QAction(tr("导入源码目录..."), this);
+    importSourcesAct_->setObjectName("project.importSources");
+    importSourcesAct_->setStatusTip(tr("按 glob 规则把目录下的全部 C++ 源文件加入工程，之后新增或删除的文件自动同步"));
+    connect(importSourcesAct_, &QAction::triggered, this, &MainWindow::importSourceTree);
+
     addIncludeAct_ = new QAction(tr("添加 Include 目录..."), this);
     addIncludeAct_->setObjectName("project.addInclude");
     connect(addIncludeAct_, &QAction::triggered, this, &MainWindow::addIncludeDirToProject);
@@ -761,6 +980,7 @@ void MainWindow::createMenus() {
     projectMenu->addAction(closeProjectAct_);
     projectMenu->addSeparator();
     projectMenu->addAction(addSourceAct_);
+    projectMenu->addAction(importSourcesAct_);
     projectMenu->addAction(addIncludeAct_);
     projectMenu->addSeparator();
     projectMenu->addAction(fetchRusticAct_);
@@ -771,9 +991,41 @@ void MainWindow::createMenus() {
     buildMenu->addAction(compileAct_);
     buildMenu->addAction(rebuildAct_);
     buildMenu->addAction(cleanAct_);
+    buildMenu->addAction(cancelBuildAct_);
+    buildMenu->addAction(buildOnSaveAct_);
     buildMenu->addAction(runAct_);
+    buildMenu->addAction(benchmarkAct_);
+    buildMenu->addAction(profileAct_);
+    buildMenu->addAction(optRemarksAct_);
+    buildMenu->addSeparator();
+    // 编译模式随工程变化（没有工程时不可用），每次展开菜单时重建
+    auto *profileMenu = buildMenu->addMenu(tr("编译模式"));
+    connect(profileMenu, &QMenu::aboutToShow, this, [this, profileMenu]() {
+        profileMenu->clear();
+        auto *group = new QActionGroup(profileMenu);
+        for (const QString &profile : projectManager_->profileNames()) {
+            QAction *act = profileMenu->addAction(profile);
+            act->setCheckable(true);
+            act->setChecked(projectManager_->hasProject() && profile == projectManager_->activeBuildProfile());
+            act->setEnabled(projectManager_->hasProject());
+            group->addAction(act);
+            connect(act, &QAction::triggered, this, [this, profile]() {
+                projectManager_->setActiveBuildProfile(profile);
+                statusBar()->showMessage(tr("编译模式：%1").arg(profile), 2000);
+            });
+        }
+    });
+    buildMenu->addAction(clearCoverageAct_);
+    buildMenu->addSeparator();
+    buildMenu->addAction(compileCacheAct_);
+    buildMenu->addAction(clearCacheAct_);
+    buildMenu->addSeparator();
+    buildMenu->addAction(timeTraceAct_);
+    buildMenu->addAction(buildReportAct_);
     buildMenu->addSeparator();
     buildMenu->addAction(makefileAct_);
+    buildMenu->addAction(ninjaFileAct_);
+    buildMenu->addAction(useNinjaAct_);
     buildMenu->addSeparator();
     buildMenu->addAction(externalToolAct_);
 
@@ -803,11 +1055,14 @@ void MainWindow::createMenus() {
     themeMenu->addAction(themeExportAct_);
     viewMenu->addSeparator();
     viewMenu->addAction(terminalAct_);
+    viewMenu->addAction(asmViewAct_);
     viewMenu->addSeparator();
     viewMenu->addAction(foldAllAct_);
     viewMenu->addAction(unfoldAllAct_);
 
     auto navMenu = menuBar()->addMenu(tr("导航"));
+    navMenu->addAction(quickOpenAct_);
+    navMenu->addSeparator();
     navMenu->addAction(navBackAct_);
     navMenu->addAction(navForwardAct_);
     navMenu->addSeparator();
@@ -829,6 +1084,7 @@ void MainWindow::createToolBar() {
     bar->addAction(openProjectAct_);
     bar->addSeparator();
     bar->addAction(compileAct_);
+    bar->addAction(cancelBuildAct_);
     bar->addAction(runAct_);
     bar->addSeparator();
     bar->addAction(debugStartAct_);
@@ -845,6 +1101,163 @@ void MainWindow::createDocks() {
     outputDock->setWidget(output_);
     addDockWidget(Qt::BottomDockWidgetArea, outputDock);
 
+    runConsole_ = new RunConsole(buildManager_->runSession(), this);
+    runDock_ = new QDockWidget(tr("运行"), this);
+    runDock_->setObjectName(QStringLiteral("dock.run"));
+    runDock_->setWidget(runConsole_);
+    addDockWidget(Qt::BottomDockWidgetArea, runDock_);
+    tabifyDockWidget(outputDock, runDock_);
+
+    profiler_ = new SamplingProfiler(this);
+    profilePanel_ = new ProfilePanel(profiler_, this);
+    profileDock_ = new QDockWidget(tr("性能分析"), this);
+    profileDock_->setObjectName(QStringLiteral("dock.profile"));
+    profileDock_->setWidget(profilePanel_);
+    addDockWidget(Qt::BottomDockWidgetArea, profileDock_);
+    tabifyDockWidget(outputDock, profileDock_);
+    profileDock_->hide();
+    connect(profilePanel_, &ProfilePanel::locationActivated, this, [this](const QString &file, int line) {
+        jumpToFileLocation(file, line - 1, 0, true);
+    });
+    connect(profilePanel_, &ProfilePanel::clearRequested, this, [this]() {
+        profileHeat_.clear();
+        profileTotalSamples_ = 0;
+        for (OpenTab &tab : openTabs_) {
+            applyProfileHeat(tab);
+        }
+    });
+    connect(profiler_, &SamplingProfiler::finished, this, [this](const SamplingProfiler::Result &result) {
+        profileHeat_.clear();
+        for (auto file = result.lineSamples.cbegin(); file != result.lineSamples.cend(); ++file) {
+            QHash<int, int> &lines = profileHeat_[QFileInfo(file.key()).absoluteFilePath()];
+            for (auto line = file.value().cbegin(); line != file.value().cend(); ++line) {
+                lines.insert(line.key() - 1, line.value());
+            }
+        }
+        profileTotalSamples_ = result.totalSamples;
+        for (OpenTab &tab : openTabs_) {
+            applyProfileHeat(tab);
+        }
+    });
+
+    optRemarkCollector_ = new OptRemarkCollector(this);
+    optRemarksPanel_ = new OptRemarksPanel(optRemarkCollector_, this);
+    optRemarksDock_ = new QDockWidget(tr("优化报告"), this);
+    optRemarksDock_->setObjectName(QStringLiteral("dock.optRemarks"));
+    optRemarksDock_->setWidget(optRemarksPanel_);
+    addDockWidget(Qt::BottomDockWidgetArea, optRemarksDock_);
+    tabifyDockWidget(outputDock, optRemarksDock_);
+    optRemarksDock_->hide();
+    connect(optRemarksPanel_, &OptRemarksPanel::collectRequested, this, &MainWindow::collectOptRemarks);
+    connect(optRemarksPanel_, &OptRemarksPanel::locationActivated, this, [this](const QString &file, int line) {
+        jumpToFileLocation(file, line - 1, 0, true);
+    });
+    auto applyAllOptRemarks = [this]() {
+        for (OpenTab &tab : openTabs_) {
+            applyOptRemarks(tab);
+        }
+    };
+    connect(optRemarksPanel_, &OptRemarksPanel::filtersChanged, this, applyAllOptRemarks);
+    connect(optRemarksPanel_, &OptRemarksPanel::clearRequested, this, [this, applyAllOptRemarks]() {
+        optRemarks_.clear();
+        applyAllOptRemarks();
+    });
+    connect(optRemarkCollector_, &OptRemarkCollector::finished, this, [this](const OptRemarkReport &report) {
+        if (!report.error.isEmpty()) {
+            return;
+        }
+        const QString abs = QFileInfo(report.sourcePath).absoluteFilePath();
+        optRemarks_.insert(abs, report.remarks);
+        if (OpenTab *tab = tabAt(indexOfFile(abs))) {
+            applyOptRemarks(*tab);
+        }
+    });
+
+    sanitizerPanel_ = new SanitizerPanel(this);
+    sanitizerDock_ = new QDockWidget(tr("Sanitizer"), this);
+    sanitizerDock_->setObjectName(QStringLiteral("dock.sanitizer"));
+    sanitizerDock_->setWidget(sanitizerPanel_);
+    addDockWidget(Qt::BottomDockWidgetArea, sanitizerDock_);
+    tabifyDockWidget(outputDock, sanitizerDock_);
+    sanitizerDock_->hide();
+    connect(sanitizerPanel_, &SanitizerPanel::locationActivated, this, [this](const QString &file, int line) {
+        jumpToFileLocation(file, line - 1, 0, true);
+    });
+
+    coverageCollector_ = new CoverageCollector(this);
+    connect(coverageCollector_, &CoverageCollector::finished, this, [this](const CoverageReport &report) {
+        if (!report.error.isEmpty()) {
+            appendBuildOutput(tr("覆盖率收集失败：%1\n").arg(report.error));
+            return;
+        }
+        coverage_.clear();
+        for (auto file = report.lineCounts.cbegin(); file != report.lineCounts.cend(); ++file) {
+            QHash<int, qint64> &lines = coverage_[file.key()];
+            for (auto line = file.value().cbegin(); line != file.value().cend(); ++line) {
+                lines.insert(line.key() - 1, line.value());
+            }
+        }
+        for (OpenTab &tab : openTabs_) {
+            applyCoverage(tab);
+        }
+        const double percent = report.executableLines > 0 ? 100.0 * report.coveredLines / report.executableLines : 0.0;
+        appendBuildOutput(tr("行覆盖率：%1/%2（%3%），%4 个源文件，用时 %5 ms\n")
+                              .arg(report.coveredLines)
+                              .arg(report.executableLines)
+                              .arg(percent, 0, 'f', 1)
+                              .arg(report.lineCounts.size())
+                              .arg(report.elapsedMs));
+    });
+
+    RunSession *session = buildManager_->runSession();
+    connect(session, &RunSession::started, this, [this]() {
+        runProfile_ = projectManager_->hasProject() ? projectManager_->activeBuildProfile() : QString();
+        runDirectory_ = projectManager_->hasProject() ? projectManager_->rootDir() : QString();
+        const QString cwd = projectManager_->hasProject() ? projectManager_->runWorkingDir() : QString();
+        if (!cwd.isEmpty()) {
+            runDirectory_ = QDir(projectManager_->rootDir()).absoluteFilePath(cwd);
+        }
+        // 报告写在 stderr 上，和程序输出混在一起；输出到达时就逐行过一遍，普通输出会被忽略
+        const QStringList flags = runProfile_.isEmpty() ? QStringList() : projectManager_->extraFlagsFor(runProfile_);
+        sanitizedRun_ = std::any_of(flags.cbegin(), flags.cend(), [](const QString &flag) {
+            return flag.startsWith(QLatin1String("-fsanitize="));
+        });
+        sanitizerParser_ = SanitizerParser(runDirectory_);
+        sanitizerReports_.clear();
+    });
+    connect(session, &RunSession::linesReceived, this, [this](const QStringList &lines) {
+        if (!sanitizedRun_) {
+            return;
+        }
+        for (const QString &line : lines) {
+            sanitizerReports_ += sanitizerParser_.feedLine(line);
+        }
+    });
+    connect(session, &RunSession::finished, this, &MainWindow::handleRunFinished);
+
+    problemsTree_ = new QTreeWidget(this);
+    problemsTree_->setHeaderLabels({tr("类型"), tr("位置"), tr("信息")});
+    problemsTree_->setRootIsDecorated(true);
+    problemsDock_ = new QDockWidget(tr("问题"), this);
+    problemsDock_->setObjectName(QStringLiteral("dock.problems"));
+    problemsDock_->setWidget(problemsTree_);
+    addDockWidget(Qt::BottomDockWidgetArea, problemsDock_);
+    tabifyDockWidget(outputDock, problemsDock_);
+    outputDock->raise();
+
+    connect(problemsTree_, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item, int) {
+        if (!item) {
+            return;
+        }
+        const QString file = item->data(0, Qt::UserRole).toString();
+        const int line = item->data(0, Qt::UserRole + 1).toInt();
+        const int column = item->data(0, Qt::UserRole + 2).toInt();
+        if (file.isEmpty() || line <= 0 || !QFileInfo::exists(file)) {
+            return;
+        }
+        jumpToFileLocation(file, line - 1, qMax(0, column - 1), true);
+    });
+
     auto *debugWidget = new QWidget(this);
     debugOutput_ = new QPlainTextEdit(debugWidget);
     debugOutput_->setReadOnly(true);
@@ -864,23 +1277,17 @@ void MainWindow::createDocks() {
     tabifyDockWidget(outputDock, debugDock);
     debugDock->hide();
 
-    auto *terminalWidget = new QWidget(this);
-    terminalOutput_ = new QPlainTextEdit(terminalWidget);
-    terminalOutput_->setReadOnly(true);
-    terminalInput_ = new QLineEdit(terminalWidget);
-    terminalInput_->setPlaceholderText(tr("输入终端命令并回车"));
-    connect(terminalInput_, &QLineEdit::returnPressed, this, &MainWindow::sendTerminalCommand);
-    auto *termLayout = new QVBoxLayout(terminalWidget);
-    termLayout->setContentsMargins(0, 0, 0, 0);
-    termLayout->addWidget(terminalOutput_);
-    termLayout->addWidget(terminalInput_);
+    terminal_ = new TerminalWidget(this);
 
     terminalDock_ = new QDockWidget(tr("终端"), this);
     terminalDock_->setObjectName(QStringLiteral("dock.terminal"));
-    terminalDock_->setWidget(terminalWidget);
+    terminalDock_->setWidget(terminal_);
     addDockWidget(Qt::BottomDockWidgetArea, terminalDock_);
     tabifyDockWidget(outputDock, terminalDock_);
     terminalDock_->hide();
+    connect(terminal_, &TerminalWidget::titleChanged, this, [this](const QString &title) {
+        terminalDock_->setWindowTitle(title.isEmpty() ? tr("终端") : tr("终端 - %1").arg(title));
+    });
 
     debugInfoTabs_ = new QTabWidget(this);
     breakpointsTree_ = new QTreeWidget(debugInfoTabs_);
@@ -940,6 +1347,44 @@ void MainWindow::createDocks() {
     symbolDock->setWidget(symbolTree_);
     addDockWidget(Qt::RightDockWidgetArea, symbolDock);
 
+    asmGenerator_ = new AsmGenerator(this);
+    asmView_ = new AsmView(asmGenerator_, this);
+    asmDock_ = new QDockWidget(tr("汇编"), this);
+    asmDock_->setObjectName(QStringLiteral("dock.assembly"));
+    asmDock_->setWidget(asmView_);
+    addDockWidget(Qt::RightDockWidgetArea, asmDock_);
+    tabifyDockWidget(symbolDock, asmDock_);
+    asmDock_->hide();
+    symbolDock->raise();
+    connect(asmDock_, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        asmViewAct_->setChecked(asmDock_->isVisible());
+        if (visible) {
+            requestAssembly();
+        }
+    });
+    connect(asmView_, &AsmView::refreshRequested, this, &MainWindow::requestAssembly);
+    connect(asmView_, &AsmView::sourceLineSelected, this, [this](int line) {
+        CodeEditor *editor = currentEditor();
+        if (!editor || QFileInfo(currentFile_).absoluteFilePath() != asmView_->sourcePath()) {
+            return;
+        }
+        const QTextBlock block = editor->document()->findBlockByNumber(line - 1);
+        if (!block.isValid()) {
+            return;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.format.setBackground(QColor(255, 200, 0, 90));
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        editor->setAsmSelections({selection});
+        // 只滚动不移动光标，否则又会反过来驱动汇编视图
+        const int first = editor->cursorForPosition(QPoint(0, 0)).blockNumber();
+        const int last = editor->cursorForPosition(QPoint(0, editor->viewport()->height() - 1)).blockNumber();
+        if (line - 1 < first || line - 1 > last) {
+            editor->verticalScrollBar()->setValue(qMax(0, line - 1 - (last - first) / 2));
+        }
+    });
+
     searchResultsTree_ = new QTreeWidget(this);
     searchResultsTree_->setHeaderHidden(true);
     auto searchDock = new QDockWidget(tr("搜索结果"), this);
@@ -1237,6 +1682,8 @@ void MainWindow::newProject() {
         QMessageBox::warning(this, tr("创建失败"), tr("无法创建工程"));
         return;
     }
+    // 模板的源文件、分组和模式设置合并成一次保存
+    projectManager_->beginTransaction();
 
     const QString root = projectManager_->rootDir();
     QString mainPath;
@@ -1319,6 +1766,9 @@ void MainWindow::newProject() {
         g.name = tr("Sources");
         g.files = {"main.cpp"};
         projectManager_->setGroups({g});
+    }
+    projectManager_->commitTransaction();
+    if (!mainPath.isEmpty()) {
         createNewTab(mainPath);
     }
 
@@ -1397,18 +1847,18 @@ void MainWindow::rebuildProjectTree() {
         return;
     }
     projectTree_->clear();
+    otherFilesItem_ = nullptr;
+    otherFileItems_.clear();
+    treeListedFiles_.clear();
+    sourcesItem_ = nullptr;
+    sourceFileItems_.clear();
     if (!projectManager_->hasProject()) {
         return;
     }
 
     const QString root = projectManager_->rootDir();
-    QVector<ProjectGroup> groups = projectManager_->groups();
-    if (groups.isEmpty()) {
-        ProjectGroup defaultGroup;
-        defaultGroup.name = tr("Sources");
-        defaultGroup.files = projectManager_->sources();
-        groups.append(defaultGroup);
-    }
+    const QVector<ProjectGroup> groups = projectManager_->groups();
+    const QStringList sources = projectManager_->sources();
 
     QSet<QString> groupedFiles;
     for (const auto &g : groups) {
@@ -1422,47 +1872,127 @@ void MainWindow::rebuildProjectTree() {
         }
     }
 
-    QStringList ungroupedSources;
-    for (const QString &src : projectManager_->sources()) {
-        if (!groupedFiles.contains(src)) {
-            ungroupedSources.append(src);
+    // 没有分组时全部源文件放进默认的 Sources 分组，否则不在分组里的放进“未分组源文件”；
+    // 之后 glob 规则匹配到的增减由 applySourceChanges 差量更新
+    if (groups.isEmpty()) {
+        sourcesItem_ = new QTreeWidgetItem(projectTree_, QStringList{tr("Sources")});
+    }
+    for (const QString &src : sources) {
+        if (groupedFiles.contains(src) || sourceFileItems_.contains(src)) {
+            continue;
+        }
+        if (!sourcesItem_) {
+            sourcesItem_ = new QTreeWidgetItem(projectTree_, QStringList{tr("未分组源文件")});
         }
+        auto *fileItem = new QTreeWidgetItem(sourcesItem_, QStringList{QFileInfo(src).fileName()});
+        fileItem->setData(0, Qt::UserRole, QDir(root).absoluteFilePath(src));
+        fileItem->setToolTip(0, src);
+        sourceFileItems_.insert(src, fileItem);
     }
-    if (!ungroupedSources.isEmpty()) {
-        auto *ungroupItem = new QTreeWidgetItem(projectTree_, QStringList{tr("未分组源文件")});
-        for (const QString &fileRel : ungroupedSources) {
-            const QString abs = QDir(root).absoluteFilePath(fileRel);
-            auto *fileItem = new QTreeWidgetItem(ungroupItem, QStringList{QFileInfo(fileRel).fileName()});
-            fileItem->setData(0, Qt::UserRole, abs);
-            fileItem->setToolTip(0, fileRel);
+
+    // 其他文件来自内存里的文件索引，不再遍历磁盘；之后的增删由 addOtherFileItems/removeOtherFileItems 差量更新
+    treeListedFiles_ = groupedFiles;
+    for (auto it = sourceFileItems_.cbegin(); it != sourceFileItems_.cend(); ++it) {
+        treeListedFiles_.insert(it.key());
+    }
+    addOtherFileItems(projectIndex_->files());
+
+    projectTree_->expandAll();
+}
+
+void MainWindow::applySourceChanges(const QStringList &added, const QStringList &removed) {
+    if (!projectTree_ || !projectManager_->hasProject()) {
+        return;
+    }
+    const QDir root(projectManager_->rootDir());
+    QStringList becameOther;
+    for (const QString &rel : removed) {
+        QTreeWidgetItem *item = sourceFileItems_.take(rel);
+        if (!item) {
+            continue; // 在用户分组里，分组照常列出
+        }
+        delete item;
+        treeListedFiles_.remove(rel);
+        if (projectIndex_->contains(rel)) {
+            becameOther.append(rel); // 文件还在，只是不再匹配规则
         }
     }
+    if (sourcesItem_ && sourcesItem_->childCount() == 0 && !projectManager_->groups().isEmpty()) {
+        delete sourcesItem_;
+        sourcesItem_ = nullptr;
+    }
 
-    QStringList otherFiles;
-    QDirIterator it(root, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        const QString abs = it.next();
-        const QString rel = QDir(root).relativeFilePath(abs);
-        if (rel.startsWith("build/") || rel.startsWith(".git/") || rel.startsWith("third_party/") || rel.endsWith(".rcppide.json") || rel == "compile_commands.json") {
-            continue;
+    QStringList nowSources;
+    for (const QString &rel : added) {
+        if (!treeListedFiles_.contains(rel)) {
+            nowSources.append(rel);
         }
-        if (groupedFiles.contains(rel) || projectManager_->sources().contains(rel)) {
-            continue;
+    }
+    removeOtherFileItems(nowSources);
+    for (const QString &rel : nowSources) {
+        if (!sourcesItem_) {
+            // 放在“其他文件”之前
+            sourcesItem_ = new QTreeWidgetItem(QStringList{tr("未分组源文件")});
+            const int index = otherFilesItem_ ? projectTree_->indexOfTopLevelItem(otherFilesItem_) : projectTree_->topLevelItemCount();
+            projectTree_->insertTopLevelItem(index, sourcesItem_);
+            sourcesItem_->setExpanded(true);
         }
-        otherFiles.append(rel);
+        auto *fileItem = new QTreeWidgetItem(sourcesItem_, QStringList{QFileInfo(rel).fileName()});
+        fileItem->setData(0, Qt::UserRole, root.absoluteFilePath(rel));
+        fileItem->setToolTip(0, rel);
+        sourceFileItems_.insert(rel, fileItem);
+        treeListedFiles_.insert(rel);
     }
-    otherFiles.sort();
-    if (!otherFiles.isEmpty()) {
-        auto *otherItem = new QTreeWidgetItem(projectTree_, QStringList{tr("其他文件")});
-        for (const QString &fileRel : otherFiles) {
-            const QString abs = QDir(root).absoluteFilePath(fileRel);
-            auto *fileItem = new QTreeWidgetItem(otherItem, QStringList{QFileInfo(fileRel).fileName()});
-            fileItem->setData(0, Qt::UserRole, abs);
-            fileItem->setToolTip(0, fileRel);
+    addOtherFileItems(becameOther);
+}
+
+void MainWindow::addOtherFileItems(const QStringList &relativePaths) {
+    if (!projectTree_ || !projectManager_->hasProject() || projectIndex_->rootDir() != QDir(projectManager_->rootDir()).absolutePath()) {
+        return;
+    }
+    const QDir root(projectManager_->rootDir());
+    // 先排序：初次填充时每个条目都追加在末尾，不会反复在中间插入
+    QStringList sorted = relativePaths;
+    std::sort(sorted.begin(), sorted.end());
+    for (const QString &rel : sorted) {
+        // third_party/ 在索引里（源文件规则可能用到），但不在工程树里铺开
+        if (treeListedFiles_.contains(rel) || otherFileItems_.contains(rel) || rel.startsWith(QLatin1String("third_party/"))) {
+            continue;
+        }
+        if (!otherFilesItem_) {
+            otherFilesItem_ = new QTreeWidgetItem(projectTree_, QStringList{tr("其他文件")});
+            otherFilesItem_->setExpanded(true);
         }
+        // 按相对路径有序插入（条目 tooltip 即相对路径）
+        int lo = 0;
+        int hi = otherFilesItem_->childCount();
+        if (hi > 0 && otherFilesItem_->child(hi - 1)->toolTip(0) < rel) {
+            lo = hi;
+        }
+        while (lo < hi) {
+            const int mid = (lo + hi) / 2;
+            if (otherFilesItem_->child(mid)->toolTip(0) < rel) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        auto *fileItem = new QTreeWidgetItem(QStringList{QFileInfo(rel).fileName()});
+        fileItem->setData(0, Qt::UserRole, root.absoluteFilePath(rel));
+        fileItem->setToolTip(0, rel);
+        otherFilesItem_->insertChild(lo, fileItem);
+        otherFileItems_.insert(rel, fileItem);
     }
+}
 
-    projectTree_->expandAll();
+void MainWindow::removeOtherFileItems(const QStringList &relativePaths) {
+    for (const QString &rel : relativePaths) {
+        delete otherFileItems_.take(rel);
+    }
+    if (otherFilesItem_ && otherFilesItem_->childCount() == 0) {
+        delete otherFilesItem_;
+        otherFilesItem_ = nullptr;
+    }
 }
 
 void MainWindow::addSourceFileToProject() {
@@ -1473,11 +2003,59 @@ void MainWindow::addSourceFileToProject() {
 
     const QStringList files = QFileDialog::getOpenFileNames(this, tr("添加源文件"), projectManager_->rootDir(),
                                                            tr("C++ 文件 (*.cpp *.cc *.cxx);;所有文件 (*.*)"));
-    for (const QString &file : files) {
-        projectManager_->addSourceFile(file);
+    if (projectManager_->addSourceFiles(files) > 0) {
+        rebuildProjectTree();
     }
 }
 
+void MainWindow::importSourceTree() {
+    if (!projectManager_->hasProject()) {
+        QMessageBox::information(this, tr("未打开工程"), tr("请先创建或打开工程。"));
+        return;
+    }
+
+    const QString root = projectManager_->rootDir();
+    const QString dir = QFileDialog::getExistingDirectory(this, tr("导入源码目录"), root);
+    if (dir.isEmpty()) {
+        return;
+    }
+    const QString rel = QDir(root).relativeFilePath(dir);
+    if (rel.startsWith(QLatin1String("..")) || QDir::isAbsolutePath(rel)) {
+        QMessageBox::information(this, tr("导入源码目录"), tr("只能导入工程目录下的子目录。"));
+        return;
+    }
+
+    // 一条规则覆盖整棵目录树，而不是逐个文件写进工程
+    const QString prefix = rel == QLatin1String(".") ? QString() : rel + QLatin1Char('/');
+    QStringList globs = projectManager_->sourceGlobs();
+    for (const QString &ext : {QStringLiteral("cpp"), QStringLiteral("cc"), QStringLiteral("cxx")}) {
+        globs << prefix + QStringLiteral("**/*.") + ext;
+    }
+    const QStringList excludes = projectManager_->sourceExcludes();
+
+    // 扫描在后台进行，结果到了（sourcesReady）再报告匹配数
+    importTimer_.start();
+    importSourcesBefore_ = projectManager_->globSourceCount();
+    projectManager_->setSourceRules(globs, excludes);
+    if (projectManager_->sourcesPending()) {
+        statusBar()->showMessage(tr("正在扫描源文件..."));
+    } else {
+        reportImportedSources();
+    }
+}
+
+void MainWindow::reportImportedSources() {
+    if (importSourcesBefore_ < 0) {
+        return;
+    }
+    statusBar()->showMessage(tr("规则匹配到 %1 个源文件（新增 %2 个），用时 %3 ms")
+                                 .arg(projectManager_->globSourceCount())
+                                 .arg(projectManager_->globSourceCount() - importSourcesBefore_)
+                                 .arg(importTimer_.elapsed()),
+                             4000);
+    importSourcesBefore_ = -1;
+}
+
 void MainWindow::addIncludeDirToProject() {
     if (!projectManager_->hasProject()) {
         QMessageBox::information(this, tr("未打开工程"), tr("请先创建或打开工程。"));
@@ -1531,8 +2109,14 @@ void MainWindow::showShortcutSettings() {
     add(compileAct_);
     add(rebuildAct_);
     add(cleanAct_);
+    add(cancelBuildAct_);
     add(runAct_);
+    add(benchmarkAct_);
+    add(profileAct_);
+    add(optRemarksAct_);
+    add(clearCoverageAct_);
     add(makefileAct_);
+    add(ninjaFileAct_);
     add(externalToolAct_);
     add(debugStartAct_);
     add(debugBuildAndStartAct_);
@@ -1545,6 +2129,7 @@ void MainWindow::showShortcutSettings() {
     add(debugAddWatchAct_);
     add(debugRemoveWatchAct_);
     add(debugStopAct_);
+    add(quickOpenAct_);
     add(navBackAct_);
     add(navForwardAct_);
     add(findReferencesAct_);
@@ -1554,10 +2139,12 @@ void MainWindow::showShortcutSettings() {
     add(saveProjectAct_);
     add(closeProjectAct_);
     add(addSourceAct_);
+    add(importSourcesAct_);
     add(addIncludeAct_);
     add(fetchRusticAct_);
     add(projectSettingsAct_);
     add(terminalAct_);
+    add(asmViewAct_);
 
     ShortcutSettingsDialog dialog(acts, this);
     dialog.exec();
@@ -1678,6 +2265,9 @@ void MainWindow::createNewTab(const QString &filePath, const QString &content) {
         }
     });
     connect(editor->document(), &QTextDocument::contentsChanged, this, &MainWindow::scheduleLspChange);
+    connect(editor, &QPlainTextEdit::cursorPositionChanged, this, [this, editor]() {
+        syncAssemblyToEditor(editor);
+    });
 
     std::fprintf(stderr, "[DEBUG_STARTUP] editor signals connected\n");
     std::fflush(stderr);
@@ -1688,6 +2278,18 @@ void MainWindow::createNewTab(const QString &filePath, const QString &content) {
         if (breakpointsByFile_.contains(abs)) {
             editor->setBreakpoints(breakpointsByFile_.value(abs));
         }
+        if (buildDiagnostics_.contains(abs)) {
+            applyBuildDiagnostics(openTabs_[index]);
+        }
+        if (profileHeat_.contains(abs)) {
+            applyProfileHeat(openTabs_[index]);
+        }
+        if (optRemarks_.contains(abs)) {
+            applyOptRemarks(openTabs_[index]);
+        }
+        if (coverage_.contains(abs)) {
+            applyCoverage(openTabs_[index]);
+        }
     } else if (!content.isEmpty()) {
         editor->setPlainText(content);
         editor->document()->setModified(false);
@@ -1928,10 +2530,25 @@ void MainWindow::jumpToFileLocation(const QString &filePath, int line, int chara
 
 void MainWindow::compileFile() {
     if (!saveFile()) {
+        dropPendingBuildActions(tr("文件未保存，未运行基准测试。"));
         return;
     }
-    output_->clear();
+    // 编译进行中时这次请求只会排队，保留当前编译的输出。
+    if (!buildManager_->isBuilding()) {
+        output_->clear();
+    }
+    startBuild();
+}
 
+void MainWindow::startBuild() {
+    if (projectManager_->hasProject() && projectManager_->sourcesPending()) {
+        // 刚打开工程或改了源文件规则，拿到完整的源文件列表再编译
+        if (!buildWaitingForSources_) {
+            buildWaitingForSources_ = true;
+            appendBuildOutput(tr("正在扫描源文件，完成后开始编译...\n"));
+        }
+        return;
+    }
     BuildManager::BuildConfig config;
 
     if (projectManager_->hasProject()) {
@@ -1945,40 +2562,88 @@ void MainWindow::compileFile() {
         config.extraFlags = projectManager_->activeExtraFlags();
         config.outputPath = QDir(projectManager_->rootDir()).filePath(projectManager_->activeOutputName());
         config.workingDirectory = projectManager_->rootDir();
+        config.perUnitBuild = true;
+        config.jobs = projectManager_->buildJobs();
+        config.incremental = true;
+        config.useCompileCache = compileCacheAct_->isChecked();
+        config.buildDirectory = QDir(projectManager_->rootDir()).filePath("build");
+        config.profileName = projectManager_->activeBuildProfile();
+        config.pchHeader = projectManager_->pchHeaderAbsolute();
+        config.unityBuild = projectManager_->activeUnityBuild();
+        config.unityBatchSize = projectManager_->unityBatchSize();
+        config.timeTrace = timeTraceAct_->isChecked();
+        config.delegateToNinja = useNinjaAct_->isChecked();
+        config.linker = projectManager_->linker();
+        config.splitDwarf = projectManager_->profileFor(config.profileName).splitDwarf;
+        config.thinLto = projectManager_->profileFor(config.profileName).thinLto;
+        for (const QString &profile : projectManager_->profileNames()) {
+            const QString output = QDir(projectManager_->rootDir()).filePath(projectManager_->outputNameFor(profile));
+            const BuildProfile options = projectManager_->profileFor(profile);
+            config.profiles.append(BuildManager::GeneratorProfile{profile, projectManager_->extraFlagsFor(profile), output,
+                                                                 options.splitDwarf, options.thinLto});
+        }
         appendBuildOutput(tr("开始编译工程：%1\n").arg(projectManager_->projectName()));
     } else {
         config.sources = {currentFile_};
         config.outputPath = QFileInfo(currentFile_).absolutePath() + QDir::separator() + QFileInfo(currentFile_).completeBaseName();
         config.workingDirectory = QFileInfo(currentFile_).absolutePath();
+        if (pendingBenchmarkAfterBuild_) {
+            // 单文件没有构建模式，基准测试时按 Release 的默认优化编译
+            config.extraFlags = QStringList{"-O2", "-DNDEBUG"};
+        }
         appendBuildOutput(tr("开始编译：%1\n").arg(currentFile_));
     }
 
     buildManager_->compile(config);
 }
 
+void MainWindow::scheduleBuildOnSave() {
+    if (buildOnSaveAct_->isChecked()) {
+        // 连续保存只触发一次；增量编译只会重编改动过的翻译单元。
+        buildOnSaveTimer_->start();
+    }
+}
+
 void MainWindow::rebuildProject() {
+    if (buildManager_->isBuilding()) {
+        // 与清理一样拒绝：否则清理被跳过，重新编译就退化成排队的增量编译
+        statusBar()->showMessage(tr("正在编译，请先取消编译再重新编译"), 3000);
+        return;
+    }
     cleanProject();
     compileFile();
 }
 
 void MainWindow::cleanProject() {
+    if (buildManager_->isBuilding()) {
+        // 正在运行的编译任务还在往 build/ 里写，先取消再清理
+        statusBar()->showMessage(tr("正在编译，请先取消编译再清理"), 3000);
+        return;
+    }
     output_->clear();
 
     if (projectManager_->hasProject()) {
         const QString root = projectManager_->rootDir();
-        const QString binaryDebug = QDir(root).filePath(projectManager_->debugProfile().outputName);
-        const QString binaryRelease = QDir(root).filePath(projectManager_->releaseProfile().outputName);
-        QFile::remove(binaryDebug);
-        if (binaryRelease != binaryDebug) {
-            QFile::remove(binaryRelease);
-        }
-
-        for (const QString &src : projectManager_->sourceFilesAbsolute()) {
-            QFileInfo info(src);
-            const QString obj = info.absolutePath() + QDir::separator() + info.completeBaseName() + ".o";
-            QFile::remove(obj);
+        // 中间产物（各编译模式、生成的 ninja/Makefile、性能分析和优化报告）都在 build/ 下，整个删掉；
+        // build/metrics 里是构建耗时和基准测试的历史，回归对比要用，保留。
+        // 最终产物可能放在 build/ 之外，逐个删除。
+        for (const QString &profile : projectManager_->profileNames()) {
+            QFile::remove(QDir(root).filePath(projectManager_->outputNameFor(profile)));
+        }
+        const QDir buildDir(QDir(root).filePath(QStringLiteral("build")));
+        const QFileInfoList entries =
+            buildDir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+        for (const QFileInfo &entry : entries) {
+            if (entry.fileName() == QLatin1String("metrics")) {
+                continue;
+            }
+            if (entry.isDir() && !entry.isSymLink()) {
+                QDir(entry.absoluteFilePath()).removeRecursively();
+            } else {
+                QFile::remove(entry.absoluteFilePath());
+            }
         }
-        appendBuildOutput(tr("已清理 Debug/Release 输出：%1\n").arg(root));
+        appendBuildOutput(tr("已清理所有编译模式的输出：%1\n").arg(root));
     } else if (!currentFile_.isEmpty()) {
         const QString binary = QFileInfo(currentFile_).absolutePath() + QDir::separator() + QFileInfo(currentFile_).completeBaseName();
         QFile::remove(binary);
@@ -2132,8 +2797,8 @@ void MainWindow::removeSelectedWatchExpression() {
 }
 
 void MainWindow::runFile() {
-    output_->clear();
-    appendBuildOutput(tr("运行程序...\n"));
+    runDock_->show();
+    runDock_->raise();
     if (projectManager_->hasProject()) {
         QString cwd = projectManager_->runWorkingDir();
         if (!cwd.isEmpty() && !QDir::isAbsolutePath(cwd)) {
@@ -2148,33 +2813,238 @@ void MainWindow::runFile() {
     }
 }
 
-void MainWindow::generateMakefile() {
-    if (!saveFile()) {
-        return;
+void MainWindow::showBenchmarkDialog() {
+    if (!benchmarkRunner_) {
+        benchmarkRunner_ = new BenchmarkRunner(this);
+    }
+    if (!benchmarkDialog_) {
+        benchmarkDialog_ = new BenchmarkDialog(benchmarkRunner_, this);
+        connect(benchmarkDialog_, &BenchmarkDialog::runRequested, this, &MainWindow::buildAndBenchmark);
     }
+    benchmarkDialog_->setMetricsDirectory(projectManager_->hasProject()
+                                              ? QDir(projectManager_->rootDir()).filePath("build/metrics")
+                                              : QString());
+    benchmarkDialog_->show();
+    benchmarkDialog_->raise();
+    benchmarkDialog_->activateWindow();
+}
 
-    BuildManager::BuildConfig config;
-    QString makefilePath;
+void MainWindow::buildAndBenchmark() {
+    if (benchmarkRunner_->isRunning()) {
+        return;
+    }
+    // 计时只对优化后的产物有意义，和“编译并调试”切到 Debug 一样，这里切到 Release。
+    if (projectManager_->hasProject() && projectManager_->activeBuildProfile() != "Release"
+        && projectManager_->profileNames().contains("Release")) {
+        projectManager_->setActiveBuildProfile("Release");
+    }
+    pendingBenchmarkAfterBuild_ = true;
+    benchmarkDialog_->setStatus(tr("正在编译 Release..."));
+    compileFile();
+}
 
+void MainWindow::startBenchmark() {
+    if (!benchmarkRunner_ || !benchmarkDialog_) {
+        return;
+    }
+    BenchmarkRunner::Options options;
+    options.program = buildManager_->lastBinaryPath();
+    options.iterations = benchmarkDialog_->iterations();
+    options.warmup = benchmarkDialog_->warmup();
+    options.usePerf = benchmarkDialog_->usePerf();
     if (projectManager_->hasProject()) {
-        config.sources = projectManager_->sourceFilesAbsolute();
-        if (config.sources.isEmpty() && !currentFile_.isEmpty()) {
-            config.sources.append(currentFile_);
+        QString cwd = projectManager_->runWorkingDir();
+        if (!cwd.isEmpty() && !QDir::isAbsolutePath(cwd)) {
+            cwd = QDir(projectManager_->rootDir()).absoluteFilePath(cwd);
         }
+        options.workingDirectory = cwd.isEmpty() ? projectManager_->rootDir() : cwd;
+        options.args = projectManager_->runArgs();
+        options.profile = projectManager_->activeBuildProfile();
+    } else {
+        options.workingDirectory = QFileInfo(options.program).absolutePath();
+        options.profile = QStringLiteral("Release");
+    }
+    if (options.program.isEmpty() || !QFileInfo::exists(options.program)) {
+        benchmarkDialog_->setStatus(tr("没有可运行的可执行文件。"));
+        return;
+    }
+    benchmarkDialog_->setMetricsDirectory(buildManager_->metricsDirectory());
+    benchmarkDialog_->show();
+    benchmarkDialog_->raise();
+    if (!benchmarkRunner_->start(options)) {
+        benchmarkDialog_->setStatus(tr("基准测试启动失败。"));
+    }
+}
+
+BuildManager::BuildConfig MainWindow::assemblyConfig() const {
+    BuildManager::BuildConfig config;
+    if (projectManager_->hasProject()) {
         config.includeDirs = projectManager_->includeDirsAbsolute();
         config.compiler = projectManager_->compiler();
         config.cxxStandard = projectManager_->cxxStandard();
         config.extraFlags = projectManager_->activeExtraFlags();
-        config.outputPath = QDir(projectManager_->rootDir()).filePath(projectManager_->activeOutputName());
         config.workingDirectory = projectManager_->rootDir();
-        makefilePath = QDir(projectManager_->rootDir()).filePath("Makefile");
+        config.incremental = true;
+        config.buildDirectory = QDir(projectManager_->rootDir()).filePath("build");
+        config.profileName = projectManager_->activeBuildProfile();
+        config.pchHeader = projectManager_->pchHeaderAbsolute();
+        config.unityBuild = projectManager_->activeUnityBuild();
+        config.splitDwarf = projectManager_->profileFor(config.profileName).splitDwarf;
+        config.thinLto = projectManager_->profileFor(config.profileName).thinLto;
     } else {
-        config.sources = {currentFile_};
-        config.outputPath = QFileInfo(currentFile_).absolutePath() + QDir::separator() + QFileInfo(currentFile_).completeBaseName();
         config.workingDirectory = QFileInfo(currentFile_).absolutePath();
-        makefilePath = QFileInfo(currentFile_).absolutePath() + QDir::separator() + "Makefile";
+    }
+    return config;
+}
+
+void MainWindow::requestAssembly() {
+    if (!asmDock_ || !asmDock_->isVisible()) {
+        return;
+    }
+    if (!ToolPipeline::isCompilableSource(currentFile_)) {
+        asmView_->setStatus(tr("当前文件不是可单独编译的源文件。"));
+        return;
+    }
+    const BuildManager::BuildConfig config = assemblyConfig();
+    AsmGenerator::Request request;
+    request.source = QFileInfo(currentFile_).absoluteFilePath();
+    request.compiler = config.compiler;
+    request.flags = buildManager_->assemblyFlags(config);
+    request.workingDirectory = config.workingDirectory;
+    request.object = buildManager_->upToDateObject(config, request.source);
+    request.verbose = asmView_->verboseAsm();
+    request.intelSyntax = asmView_->intelSyntax();
+    if (request.verbose) {
+        request.object.clear(); // 目标文件里没有 -fverbose-asm 的注释
+    }
+    asmView_->setStatus(request.object.isEmpty() ? tr("正在编译 %1 ...").arg(QFileInfo(currentFile_).fileName())
+                                                 : tr("正在反汇编 %1 ...").arg(QFileInfo(request.object).fileName()));
+    asmGenerator_->generate(request);
+}
+
+void MainWindow::syncAssemblyToEditor(CodeEditor *editor) {
+    if (!asmDock_ || !asmDock_->isVisible() || editor != currentEditor()) {
+        return;
+    }
+    editor->setAsmSelections({});
+    if (QFileInfo(currentFile_).absoluteFilePath() == asmView_->sourcePath()) {
+        asmView_->setCurrentSourceLine(editor->textCursor().blockNumber() + 1);
+    }
+}
+
+void MainWindow::profileFile() {
+    if (profiler_->isRunning()) {
+        profileDock_->show();
+        profileDock_->raise();
+        return;
+    }
+    const QString binaryPath = buildManager_->lastBinaryPath();
+    if (binaryPath.isEmpty() || !QFileInfo::exists(binaryPath)) {
+        appendBuildOutput(tr("没有可分析的可执行文件，请先编译。\n"));
+        return;
+    }
+
+    SamplingProfiler::Options options;
+    options.program = binaryPath;
+    if (projectManager_->hasProject()) {
+        QString cwd = projectManager_->runWorkingDir();
+        if (!cwd.isEmpty() && !QDir::isAbsolutePath(cwd)) {
+            cwd = QDir(projectManager_->rootDir()).absoluteFilePath(cwd);
+        }
+        options.workingDirectory = cwd.isEmpty() ? projectManager_->rootDir() : cwd;
+        options.args = projectManager_->runArgs();
+        options.sourceRoot = projectManager_->rootDir();
+        options.outputDirectory = QDir(projectManager_->rootDir()).filePath("build/profile");
+    } else {
+        options.workingDirectory = QFileInfo(binaryPath).absolutePath();
+        options.sourceRoot = options.workingDirectory;
+        options.outputDirectory = QDir(QDir::tempPath()).filePath("rcppide-profile");
+    }
+    profileDock_->show();
+    profileDock_->raise();
+    profiler_->start(options);
+}
+
+void MainWindow::collectOptRemarks() {
+    optRemarksDock_->show();
+    optRemarksDock_->raise();
+    if (!ToolPipeline::isCompilableSource(currentFile_)) {
+        optRemarksPanel_->setStatus(tr("当前文件不是可单独编译的源文件。"));
+        return;
+    }
+    CodeEditor *editor = currentEditor();
+    if (editor && editor->document()->isModified() && !saveFile()) {
+        return;
+    }
+
+    // 沿用汇编视图的参数：当前编译模式、包含目录和预编译头
+    const BuildManager::BuildConfig config = assemblyConfig();
+    const QString source = QFileInfo(currentFile_).absoluteFilePath();
+    const QString dir = projectManager_->hasProject() ? QDir(projectManager_->rootDir()).filePath("build/remarks")
+                                                      : QDir(QDir::tempPath()).filePath("rcppide-remarks");
+    // 不同目录下的同名文件各用各的记录
+    const QString base = QStringLiteral("%1-%2").arg(QFileInfo(source).fileName()).arg(qHash(source), 0, 16);
+
+    OptRemarkCollector::Request request;
+    request.source = source;
+    request.compiler = config.compiler;
+    request.recordPath = QDir(dir).filePath(base + ".opt-record");
+    request.objectPath = QDir(dir).filePath(base + ".o");
+    request.flags = buildManager_->optimizationRecordFlags(config, request.recordPath);
+    request.workingDirectory = config.workingDirectory;
+    optRemarksPanel_->setStatus(tr("正在编译 %1 ...").arg(QFileInfo(source).fileName()));
+    optRemarkCollector_->collect(request);
+}
+
+bool MainWindow::generatorConfig(BuildManager::BuildConfig *config, QString *outputDir) {
+    if (!saveFile()) {
+        return false;
+    }
+    if (projectManager_->hasProject() && projectManager_->sourcesPending()) {
+        statusBar()->showMessage(tr("正在扫描源文件，请稍后再生成"), 3000);
+        return false;
     }
 
+    if (projectManager_->hasProject()) {
+        config->sources = projectManager_->sourceFilesAbsolute();
+        if (config->sources.isEmpty() && !currentFile_.isEmpty()) {
+            config->sources.append(currentFile_);
+        }
+        config->includeDirs = projectManager_->includeDirsAbsolute();
+        config->compiler = projectManager_->compiler();
+        config->cxxStandard = projectManager_->cxxStandard();
+        config->extraFlags = projectManager_->activeExtraFlags();
+        config->outputPath = QDir(projectManager_->rootDir()).filePath(projectManager_->activeOutputName());
+        config->workingDirectory = projectManager_->rootDir();
+        config->buildDirectory = QDir(projectManager_->rootDir()).filePath("build");
+        config->profileName = projectManager_->activeBuildProfile();
+        config->pchHeader = projectManager_->pchHeaderAbsolute();
+        config->linker = projectManager_->linker();
+        config->splitDwarf = projectManager_->profileFor(config->profileName).splitDwarf;
+        config->thinLto = projectManager_->profileFor(config->profileName).thinLto;
+        for (const QString &profile : projectManager_->profileNames()) {
+            const QString output = QDir(projectManager_->rootDir()).filePath(projectManager_->outputNameFor(profile));
+            const BuildProfile options = projectManager_->profileFor(profile);
+            config->profiles.append(BuildManager::GeneratorProfile{profile, projectManager_->extraFlagsFor(profile), output,
+                                                                 options.splitDwarf, options.thinLto});
+        }
+        *outputDir = projectManager_->rootDir();
+    } else {
+        config->sources = {currentFile_};
+        config->outputPath = QFileInfo(currentFile_).absolutePath() + QDir::separator() + QFileInfo(currentFile_).completeBaseName();
+        config->workingDirectory = QFileInfo(currentFile_).absolutePath();
+        *outputDir = QFileInfo(currentFile_).absolutePath();
+    }
+    return true;
+}
+
+void MainWindow::generateMakefile() {
+    BuildManager::BuildConfig config;
+    QString dir;
+    if (!generatorConfig(&config, &dir)) {
+        return;
+    }
+    const QString makefilePath = QDir(dir).filePath("Makefile");
     if (buildManager_->generateMakefile(config, makefilePath)) {
         appendBuildOutput(tr("Makefile 已生成：%1\n").arg(makefilePath));
     } else {
@@ -2182,6 +3052,20 @@ void MainWindow::generateMakefile() {
     }
 }
 
+void MainWindow::generateNinjaFile() {
+    BuildManager::BuildConfig config;
+    QString dir;
+    if (!generatorConfig(&config, &dir)) {
+        return;
+    }
+    const QString ninjaPath = QDir(dir).filePath("build.ninja");
+    if (buildManager_->generateNinjaFile(config, ninjaPath)) {
+        appendBuildOutput(tr("build.ninja 已生成：%1\n").arg(ninjaPath));
+    } else {
+        appendBuildOutput(tr("生成 build.ninja 失败。\n"));
+    }
+}
+
 void MainWindow::toggleAdvancedParsing(bool enabled) {
     advancedParsingEnabled_ = enabled;
     for (OpenTab &tab : openTabs_) {
@@ -2524,7 +3408,7 @@ void MainWindow::handleDiagnostics(const QString &filePath,
     if (!messages.isEmpty()) {
         appendBuildOutput(tr("clangd 诊断：\n"));
         for (const QString &msg : messages) {
-            appendBuildOutput("- " + msg);
+            appendBuildOutput("- " + msg + '\n');
         }
     }
 }
@@ -2806,6 +3690,52 @@ void MainWindow::findInFiles() {
     statusBar()->showMessage(tr("搜索完成，共找到 %1 处匹配").arg(totalMatches), 3000);
 }
 
+void MainWindow::showQuickOpen() {
+    if (!quickOpenDialog_) {
+        quickOpenDialog_ = new QuickOpenDialog(this);
+        connect(quickOpenDialog_, &QuickOpenDialog::fileChosen, this, [this](const QString &path) {
+            const int existing = indexOfFile(path);
+            if (existing < 0) {
+                jumpToFileLocation(path, 0, 0, true);
+                return;
+            }
+            // 已经打开的文件只切换标签页，保留原来的光标位置
+            tabWidget_->setCurrentIndex(existing);
+            OpenTab *tab = currentTab();
+            if (tab && tab->editor) {
+                tab->editor->setFocus();
+            }
+        });
+    }
+    if (projectManager_->hasProject()) {
+        if (quickOpenDirty_) {
+            // 文件索引里的全部文件，加上索引不收录的源文件（工程目录外等）
+            QStringList paths = projectIndex_->files();
+            QSet<QString> listed(paths.cbegin(), paths.cend());
+            for (const QString &source : projectManager_->sources()) {
+                if (!listed.contains(source)) {
+                    listed.insert(source);
+                    paths.append(source);
+                }
+            }
+            std::sort(paths.begin(), paths.end());
+            quickOpenDialog_->setFiles(projectManager_->rootDir(), paths);
+            quickOpenDirty_ = false;
+        }
+    } else {
+        // 没有工程时只在已打开的文件之间切换
+        QStringList paths;
+        for (const auto &tab : openTabs_) {
+            if (!tab.filePath.isEmpty()) {
+                paths.append(tab.filePath);
+            }
+        }
+        quickOpenDialog_->setFiles(QString(), paths);
+        quickOpenDirty_ = true;
+    }
+    quickOpenDialog_->popup();
+}
+
 void MainWindow::scheduleLspChange() {
     OpenTab *tab = currentTab();
     if (!tab || tab->filePath.isEmpty()) {
@@ -2834,19 +3764,218 @@ void MainWindow::sendLspChange() {
 }
 
 void MainWindow::appendBuildOutput(const QString &text) {
-    output_->appendPlainText(text);
+    output_->append(text);
+}
+
+void MainWindow::addBuildDiagnostic(const BuildDiagnostic &diagnostic) {
+    const auto severityText = [this](BuildDiagnostic::Severity severity) {
+        switch (severity) {
+        case BuildDiagnostic::Error:
+            return tr("错误");
+        case BuildDiagnostic::Warning:
+            return tr("警告");
+        default:
+            return tr("提示");
+        }
+    };
+    const auto makeItem = [&](const BuildDiagnostic &diag) {
+        QString location;
+        if (!diag.file.isEmpty()) {
+            location = QFileInfo(diag.file).fileName();
+            if (diag.line > 0) {
+                location += QStringLiteral(":%1").arg(diag.line);
+                if (diag.column > 0) {
+                    location += QStringLiteral(":%1").arg(diag.column);
+                }
+            }
+        }
+        QString message = diag.message;
+        if (!diag.option.isEmpty()) {
+            message += QStringLiteral(" [%1]").arg(diag.option);
+        }
+        auto *item = new QTreeWidgetItem(QStringList{severityText(diag.severity), location, message});
+        item->setData(0, Qt::UserRole, diag.file);
+        item->setData(0, Qt::UserRole + 1, diag.line);
+        item->setData(0, Qt::UserRole + 2, diag.column);
+        item->setToolTip(1, diag.file);
+        item->setToolTip(2, message);
+        if (diag.severity == BuildDiagnostic::Error) {
+            item->setForeground(0, QColor(220, 50, 47));
+        } else if (diag.severity == BuildDiagnostic::Warning) {
+            item->setForeground(0, QColor(203, 139, 0));
+        }
+        return item;
+    };
+
+    QTreeWidgetItem *top = makeItem(diagnostic);
+    for (const BuildDiagnostic &note : diagnostic.notes) {
+        top->addChild(makeItem(note));
+    }
+    for (const BuildFixIt &fix : diagnostic.fixits) {
+        auto *fixItem = new QTreeWidgetItem(
+            QStringList{tr("修复"),
+                        QStringLiteral("%1:%2:%3").arg(QFileInfo(fix.file).fileName()).arg(fix.line).arg(fix.column),
+                        fix.replacement.isEmpty() ? tr("删除此处代码") : tr("替换为：%1").arg(fix.replacement)});
+        fixItem->setData(0, Qt::UserRole, fix.file);
+        fixItem->setData(0, Qt::UserRole + 1, fix.line);
+        fixItem->setData(0, Qt::UserRole + 2, fix.column);
+        top->addChild(fixItem);
+    }
+    problemsTree_->addTopLevelItem(top);
+
+    if (diagnostic.severity == BuildDiagnostic::Error) {
+        ++buildErrorCount_;
+    } else if (diagnostic.severity == BuildDiagnostic::Warning) {
+        ++buildWarningCount_;
+    }
+    problemsDock_->setWindowTitle(tr("问题 (%1)").arg(problemsTree_->topLevelItemCount()));
+
+    if (diagnostic.file.isEmpty() || diagnostic.line <= 0) {
+        return;
+    }
+    // 只刷新这一条诊断所在的文件，不重扫整个日志。
+    buildDiagnostics_[diagnostic.file].append(diagnostic);
+    const int index = indexOfFile(diagnostic.file);
+    if (OpenTab *tab = tabAt(index)) {
+        applyBuildDiagnostics(*tab);
+    }
+}
+
+void MainWindow::applyBuildDiagnostics(OpenTab &tab) {
+    if (!tab.editor) {
+        return;
+    }
+    QList<QTextEdit::ExtraSelection> selections;
+    const QString abs = QFileInfo(tab.filePath).absoluteFilePath();
+    QTextDocument *doc = tab.editor->document();
+    for (const BuildDiagnostic &diag : buildDiagnostics_.value(abs)) {
+        const QTextBlock block = doc->findBlockByNumber(diag.line - 1);
+        if (!block.isValid()) {
+            continue;
+        }
+        QTextCursor cursor(block);
+        const int column = qBound(0, diag.column - 1, qMax(0, block.length() - 1));
+        cursor.setPosition(block.position() + column);
+        cursor.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+        if (!cursor.hasSelection()) {
+            cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        }
+
+        QTextEdit::ExtraSelection sel;
+        sel.cursor = cursor;
+        sel.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        sel.format.setUnderlineColor(diag.severity == BuildDiagnostic::Error ? QColor(220, 50, 47)
+                                                                             : QColor(203, 139, 0));
+        sel.format.setToolTip(diag.message);
+        selections.append(sel);
+    }
+    tab.editor->setBuildDiagnosticSelections(selections);
+}
+
+void MainWindow::applyProfileHeat(OpenTab &tab) {
+    if (!tab.editor || tab.filePath.isEmpty()) {
+        return;
+    }
+    tab.editor->setLineHeat(profileHeat_.value(QFileInfo(tab.filePath).absoluteFilePath()), profileTotalSamples_);
+}
+
+void MainWindow::applyOptRemarks(OpenTab &tab) {
+    if (!tab.editor || tab.filePath.isEmpty()) {
+        return;
+    }
+    const auto it = optRemarks_.constFind(QFileInfo(tab.filePath).absoluteFilePath());
+    tab.editor->setOptRemarks(it == optRemarks_.constEnd() ? QList<OptRemark>() : optRemarksPanel_->filtered(it.value()));
+}
+
+void MainWindow::applyCoverage(OpenTab &tab) {
+    if (!tab.editor || tab.filePath.isEmpty()) {
+        return;
+    }
+    tab.editor->setLineCoverage(coverage_.value(QFileInfo(tab.filePath).absoluteFilePath()));
+}
+
+void MainWindow::handleRunFinished() {
+    if (runProfile_.isEmpty() || !projectManager_->hasProject()) {
+        return;
+    }
+    if (sanitizedRun_) {
+        // 输出已在运行过程中逐行解析过，这里只收尾未结束的报告
+        sanitizedRun_ = false;
+        QList<SanitizerReport> reports = sanitizerReports_;
+        sanitizerReports_.clear();
+        reports += sanitizerParser_.finish();
+        sanitizerPanel_->setReports(reports, QDir(projectManager_->rootDir()).absolutePath());
+        if (!reports.isEmpty()) {
+            sanitizerDock_->show();
+            sanitizerDock_->raise();
+        }
+    }
+
+    if (projectManager_->profileFor(runProfile_).instrumentation == BuildProfile::Coverage && !coverageCollector_->isRunning()) {
+        CoverageCollector::Request request;
+        request.compiler = projectManager_->compiler();
+        request.objectDirectory = QDir(projectManager_->rootDir()).filePath(QStringLiteral("build/") + runProfile_ + QStringLiteral("/obj"));
+        request.sourceRoot = QDir(projectManager_->rootDir()).absolutePath();
+        coverageCollector_->collect(request);
+    }
+}
+
+void MainWindow::clearBuildDiagnostics() {
+    problemsTree_->clear();
+    problemsDock_->setWindowTitle(tr("问题"));
+    buildErrorCount_ = 0;
+    buildWarningCount_ = 0;
+    if (buildDiagnostics_.isEmpty()) {
+        return;
+    }
+    const QList<QString> files = buildDiagnostics_.keys();
+    buildDiagnostics_.clear();
+    for (const QString &file : files) {
+        if (OpenTab *tab = tabAt(indexOfFile(file))) {
+            tab->editor->setBuildDiagnosticSelections({});
+        }
+    }
 }
 
 void MainWindow::buildFinished(int exitCode, QProcess::ExitStatus status) {
-    if (status == QProcess::NormalExit && exitCode == 0) {
+    buildProgressBar_->hide();
+    cancelBuildAct_->setEnabled(false);
+    if (buildErrorCount_ > 0 || buildWarningCount_ > 0) {
+        appendBuildOutput(tr("共 %1 个错误，%2 个警告，详见“问题”面板。\n").arg(buildErrorCount_).arg(buildWarningCount_));
+        if (buildErrorCount_ > 0) {
+            problemsDock_->show();
+            problemsDock_->raise();
+        }
+    }
+    const bool succeeded = status == QProcess::NormalExit && exitCode == 0;
+    if (buildManager_->hasQueuedBuild()) {
+        // “编译并调试/基准测试”切换了编译模式后排队的那次编译还没开始，这次的产物不是它要的
+        appendBuildOutput(succeeded ? tr("编译成功。\n") : tr("编译失败，退出码：%1\n").arg(exitCode));
+        return;
+    }
+    if (succeeded) {
         appendBuildOutput(tr("编译成功。\n"));
         if (pendingDebugAfterBuild_) {
             pendingDebugAfterBuild_ = false;
             startDebug();
         }
+        if (pendingBenchmarkAfterBuild_) {
+            pendingBenchmarkAfterBuild_ = false;
+            startBenchmark();
+        }
     } else {
         appendBuildOutput(tr("编译失败，退出码：%1\n").arg(exitCode));
-        pendingDebugAfterBuild_ = false;
+        dropPendingBuildActions(tr("编译失败，未运行基准测试。"));
+    }
+}
+
+void MainWindow::dropPendingBuildActions(const QString &reason) {
+    pendingDebugAfterBuild_ = false;
+    if (pendingBenchmarkAfterBuild_) {
+        pendingBenchmarkAfterBuild_ = false;
+        if (benchmarkDialog_) {
+            benchmarkDialog_->setStatus(reason);
+        }
     }
 }
 
@@ -2910,22 +4039,13 @@ QString MainWindow::detectTerminalProgram() const {
 }
 
 void MainWindow::startTerminalShell() {
-    if (!terminalOutput_ || !terminalInput_) {
+    if (!terminal_) {
         return;
     }
-    if (terminalProcess_) {
-        terminalProcess_->kill();
-        terminalProcess_->deleteLater();
-        terminalProcess_ = nullptr;
-    }
-
-    terminalProcess_ = new QProcess(this);
-    terminalProcess_->setProcessChannelMode(QProcess::MergedChannels);
     QString root = QDir::currentPath();
     if (projectManager_ && projectManager_->hasProject()) {
         root = projectManager_->rootDir();
     }
-    terminalProcess_->setWorkingDirectory(root);
 
     const QString program = detectTerminalProgram();
     QStringList args;
@@ -2934,33 +4054,5 @@ void MainWindow::startTerminalShell() {
 #else
     args << "-i";
 #endif
-    terminalProcess_->start(program, args);
-
-    connect(terminalProcess_, &QProcess::readyReadStandardOutput, this, [this]() {
-        terminalOutput_->appendPlainText(QString::fromLocal8Bit(terminalProcess_->readAllStandardOutput()));
-    });
-    connect(terminalProcess_, &QProcess::readyReadStandardError, this, [this]() {
-        terminalOutput_->appendPlainText(QString::fromLocal8Bit(terminalProcess_->readAllStandardError()));
-    });
-    connect(terminalProcess_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int code, QProcess::ExitStatus) {
-        terminalOutput_->appendPlainText(tr("终端已退出，退出码：%1").arg(code));
-    });
-
-    terminalOutput_->appendPlainText(tr("终端已启动：%1").arg(program));
-}
-
-void MainWindow::sendTerminalCommand() {
-    if (!terminalProcess_ || terminalProcess_->state() == QProcess::NotRunning) {
-        startTerminalShell();
-    }
-    if (!terminalProcess_) {
-        return;
-    }
-    const QString cmd = terminalInput_->text();
-    if (cmd.trimmed().isEmpty()) {
-        return;
-    }
-    terminalOutput_->appendPlainText(QStringLiteral("> %1").arg(cmd));
-    terminalProcess_->write((cmd + "\n").toLocal8Bit());
-    terminalInput_->clear();
+    terminal_->start(program, args, root);
 }
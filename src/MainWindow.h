@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QProcess>
 #include <QTimer>
@@ -10,14 +11,26 @@
 #include <QHash>
 #include <QSet>
 
+#include "AsmView.h"
 #include "BuildManager.h"
+#include "OptRemarksPanel.h"
+#include "OutputPane.h"
+#include "ProfilePanel.h"
+#include "RunConsole.h"
+#include "SanitizerPanel.h"
 #include "CppRusticHighlighter.h"
 #include "GdbMiClient.h"
 #include "LspClient.h"
 #include "ProjectManager.h"
+#include "TerminalWidget.h"
 
+class BenchmarkDialog;
+class BenchmarkRunner;
 class CodeEditor;
+class CoverageCollector;
+class ProjectFileIndex;
 class QPlainTextEdit;
+class QProgressBar;
 class QLineEdit;
 class QFileSystemModel;
 class QTreeView;
@@ -25,6 +38,7 @@ class QTabWidget;
 class QTreeWidget;
 class QStackedWidget;
 class FindReplaceDialog;
+class QuickOpenDialog;
 class ProjectSettingsDialog;
 class GdbMiClient;
 
@@ -50,6 +64,7 @@ private slots:
     void saveProject();
     void closeProject();
     void addSourceFileToProject();
+    void importSourceTree();
     void addIncludeDirToProject();
     void fetchRusticLibrary();
     void showProjectSettings();
@@ -58,7 +73,13 @@ private slots:
     void rebuildProject();
     void cleanProject();
     void runFile();
+    void showBenchmarkDialog();
+    void buildAndBenchmark();
+    void profileFile();
+    void collectOptRemarks();
+    void requestAssembly();
     void generateMakefile();
+    void generateNinjaFile();
     void toggleAdvancedParsing(bool enabled);
     void runExternalTool();
 
@@ -70,7 +91,6 @@ private slots:
 
     void showShortcutSettings();
 
-    void sendTerminalCommand();
 
     void startDebug();
     void stopDebug();
@@ -107,13 +127,17 @@ private slots:
     void showFindDialog();
     void showReplaceDialog();
     void findInFiles();
+    void showQuickOpen();
     void scheduleLspChange();
     void sendLspChange();
 
     void appendBuildOutput(const QString &text);
+    void addBuildDiagnostic(const BuildDiagnostic &diagnostic);
     void buildFinished(int exitCode, QProcess::ExitStatus status);
 
 private:
+    void dropPendingBuildActions(const QString &reason);
+    void reportImportedSources();
     void createActions();
     void createMenus();
     void createToolBar();
@@ -123,6 +147,9 @@ private:
     void loadUiSettings();
     void saveUiSettings();
     void highlightDebugLine(const QString &filePath, int line);
+    void startBenchmark();
+    BuildManager::BuildConfig assemblyConfig() const;
+    void syncAssemblyToEditor(CodeEditor *editor);
     void refreshWatchExpressions();
     void startTerminalShell();
     QString detectTerminalProgram() const;
@@ -155,10 +182,28 @@ private:
     void updateWindowTitle();
     void jumpToFileLocation(const QString &filePath, int line, int character, bool recordHistory);
     void rebuildProjectTree();
+    void addOtherFileItems(const QStringList &relativePaths);
+    void removeOtherFileItems(const QStringList &relativePaths);
+    void applySourceChanges(const QStringList &added, const QStringList &removed);
     void showProjectGroupsView(bool enabled);
+    void applyBuildDiagnostics(OpenTab &tab);
+    void applyProfileHeat(OpenTab &tab);
+    void applyOptRemarks(OpenTab &tab);
+    void applyCoverage(OpenTab &tab);
+    void handleRunFinished();
+    void clearBuildDiagnostics();
+    bool generatorConfig(BuildManager::BuildConfig *config, QString *outputDir);
+    void startBuild();
+    void scheduleBuildOnSave();
 
     QTabWidget *tabWidget_;
-    QPlainTextEdit *output_;
+    OutputPane *output_;
+    QProgressBar *buildProgressBar_ = nullptr;
+    QTreeWidget *problemsTree_ = nullptr;
+    QDockWidget *problemsDock_ = nullptr;
+    QHash<QString, QList<BuildDiagnostic>> buildDiagnostics_;
+    int buildErrorCount_ = 0;
+    int buildWarningCount_ = 0;
     QPlainTextEdit *debugOutput_ = nullptr;
     QLineEdit *debugInput_ = nullptr;
     QDockWidget *debugInfoDock_ = nullptr;
@@ -169,10 +214,24 @@ private:
     QTreeWidget *threadsTree_ = nullptr;
     QTreeWidget *watchTree_ = nullptr;
 
-    QPlainTextEdit *terminalOutput_ = nullptr;
-    QLineEdit *terminalInput_ = nullptr;
+    RunConsole *runConsole_ = nullptr;
+    QDockWidget *runDock_ = nullptr;
+    BenchmarkRunner *benchmarkRunner_ = nullptr;
+    BenchmarkDialog *benchmarkDialog_ = nullptr;
+    SamplingProfiler *profiler_ = nullptr;
+    ProfilePanel *profilePanel_ = nullptr;
+    QDockWidget *profileDock_ = nullptr;
+    OptRemarkCollector *optRemarkCollector_ = nullptr;
+    OptRemarksPanel *optRemarksPanel_ = nullptr;
+    QDockWidget *optRemarksDock_ = nullptr;
+    SanitizerPanel *sanitizerPanel_ = nullptr;
+    QDockWidget *sanitizerDock_ = nullptr;
+    CoverageCollector *coverageCollector_ = nullptr;
+    AsmGenerator *asmGenerator_ = nullptr;
+    AsmView *asmView_ = nullptr;
+    QDockWidget *asmDock_ = nullptr;
+    TerminalWidget *terminal_ = nullptr;
     QDockWidget *terminalDock_ = nullptr;
-    QProcess *terminalProcess_ = nullptr;
 
     std::unique_ptr<BuildManager> buildManager_;
     std::unique_ptr<ProjectManager> projectManager_;
@@ -180,6 +239,7 @@ private:
     std::unique_ptr<GdbMiClient> gdbClient_;
 
     QTimer *lspChangeTimer_ = nullptr;
+    QTimer *buildOnSaveTimer_ = nullptr;
 
     QString currentFile_;
     bool advancedParsingEnabled_ = false;
@@ -187,7 +247,12 @@ private:
 
     QString debugExecFile_;
     int debugExecLine_ = -1;
+    // 编译成功后要接着做的事，只在它们要求的那次编译结束时消费（排队中的编译会顶替当前这次）
     bool pendingDebugAfterBuild_ = false;
+    bool pendingBenchmarkAfterBuild_ = false;
+    bool buildWaitingForSources_ = false; // 源文件规则还在扫描，扫完后再开始编译
+    QElapsedTimer importTimer_;
+    int importSourcesBefore_ = -1; // 导入源码目录前的匹配数，-1 表示没有等待报告的导入
 
     bool firstShow_ = true;
 
@@ -206,8 +271,20 @@ private:
     QAction *compileAct_ = nullptr;
     QAction *rebuildAct_ = nullptr;
     QAction *cleanAct_ = nullptr;
+    QAction *cancelBuildAct_ = nullptr;
+    QAction *buildOnSaveAct_ = nullptr;
+    QAction *compileCacheAct_ = nullptr;
+    QAction *clearCacheAct_ = nullptr;
+    QAction *timeTraceAct_ = nullptr;
+    QAction *buildReportAct_ = nullptr;
     QAction *runAct_ = nullptr;
+    QAction *benchmarkAct_ = nullptr;
+    QAction *profileAct_ = nullptr;
+    QAction *optRemarksAct_ = nullptr;
+    QAction *clearCoverageAct_ = nullptr;
     QAction *makefileAct_ = nullptr;
+    QAction *ninjaFileAct_ = nullptr;
+    QAction *useNinjaAct_ = nullptr;
     QAction *externalToolAct_ = nullptr;
     QAction *advancedParseAct_ = nullptr;
     QAction *themeLightAct_ = nullptr;
@@ -215,6 +292,7 @@ private:
     QAction *themeImportAct_ = nullptr;
     QAction *themeExportAct_ = nullptr;
     QAction *terminalAct_ = nullptr;
+    QAction *asmViewAct_ = nullptr;
     QAction *shortcutSettingsAct_ = nullptr;
     QAction *debugStartAct_ = nullptr;
     QAction *debugStopAct_ = nullptr;
@@ -234,6 +312,7 @@ private:
     QAction *replaceAct_ = nullptr;
     QAction *findInFilesAct_ = nullptr;
 
+    QAction *quickOpenAct_ = nullptr;
     QAction *navBackAct_ = nullptr;
     QAction *navForwardAct_ = nullptr;
     QAction *findReferencesAct_ = nullptr;
@@ -244,6 +323,7 @@ private:
     QAction *saveProjectAct_ = nullptr;
     QAction *closeProjectAct_ = nullptr;
     QAction *addSourceAct_ = nullptr;
+    QAction *importSourcesAct_ = nullptr;
     QAction *addIncludeAct_ = nullptr;
     QAction *fetchRusticAct_ = nullptr;
     QAction *projectSettingsAct_ = nullptr;
@@ -251,12 +331,21 @@ private:
     QTreeView *projectView_ = nullptr;
     QFileSystemModel *projectModel_ = nullptr;
     QTreeWidget *projectTree_ = nullptr;
+    ProjectFileIndex *projectIndex_ = nullptr;
+    // 工程树“其他文件”分组按文件索引的增删差量更新，不整棵重建
+    QTreeWidgetItem *otherFilesItem_ = nullptr;
+    QHash<QString, QTreeWidgetItem *> otherFileItems_; // 相对路径 -> 条目
+    QSet<QString> treeListedFiles_;                    // 已出现在分组/源文件里的相对路径
+    QTreeWidgetItem *sourcesItem_ = nullptr;           // 不属于任何分组的源文件挂在这里（默认分组或“未分组源文件”）
+    QHash<QString, QTreeWidgetItem *> sourceFileItems_; // sourcesItem_ 下的条目
     QStackedWidget *projectStack_ = nullptr;
 
     QTreeWidget *symbolTree_ = nullptr;
     QTreeWidget *searchResultsTree_ = nullptr;
 
     FindReplaceDialog *findDialog_ = nullptr;
+    QuickOpenDialog *quickOpenDialog_ = nullptr;
+    bool quickOpenDirty_ = true; // 文件索引或源文件变了，下次打开“转到文件”时重建候选
 
     struct NavLocation {
         QString filePath;
@@ -267,4 +356,13 @@ private:
     QVector<NavLocation> forwardStack_;
 
     QHash<QString, QSet<int>> breakpointsByFile_;
+    QHash<QString, QHash<int, int>> profileHeat_; // 绝对路径 -> 行号（从 0 开始）-> 样本数
+    int profileTotalSamples_ = 0;
+    QHash<QString, QList<OptRemark>> optRemarks_; // 绝对路径 -> 该文件的全部优化报告（未过滤）
+    QHash<QString, QHash<int, qint64>> coverage_; // 绝对路径 -> 可执行行（从 0 开始）-> 执行次数
+    QString runProfile_;   // 本次运行开始时的构建模式
+    QString runDirectory_; // 本次运行的工作目录，sanitizer 报告里的相对路径按它解析
+    bool sanitizedRun_ = false; // 本次运行的构建模式带 -fsanitize=，输出边到达边解析
+    SanitizerParser sanitizerParser_;
+    QList<SanitizerReport> sanitizerReports_;
 };
@@ -0,0 +1,297 @@
+#include "OptRemarks.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+// clang 的 Pass 名称：loop-vectorize、slp-vectorizer、inline、always-inline、licm ...
+OptRemark::Category categoryForPass(const QString &pass) {
+    if (pass.contains(QLatin1String("vectoriz"))) {
+        return OptRemark::Vectorize;
+    }
+    if (pass.contains(QLatin1String("inline"))) {
+        return OptRemark::Inline;
+    }
+    if (pass == QLatin1String("licm")) {
+        return OptRemark::Licm;
+    }
+    return OptRemark::Other;
+}
+
+// gcc 的 -fopt-info 文本不带 pass 名称，只能按措辞归类。
+// 向量化分析的后续说明（"statement clobbers memory" 之类）没有关键字，沿用上一条的分类。
+bool categoryForMessage(const QString &message, OptRemark::Category *category) {
+    const QString lower = message.toLower();
+    if (lower.contains(QLatin1String("vectoriz")) || lower.contains(QLatin1String("vectype"))
+        || lower.contains(QLatin1String("slp"))) {
+        *category = OptRemark::Vectorize;
+        return true;
+    }
+    if (lower.contains(QLatin1String("inlin"))) {
+        *category = OptRemark::Inline;
+        return true;
+    }
+    if (lower.contains(QLatin1String("invariant")) || lower.contains(QLatin1String("hoist"))) {
+        *category = OptRemark::Licm;
+        return true;
+    }
+    static const QStringList kOther{"unroll", "peel", "loop turned into", "distribut", "split", "tail call",
+                                    "jump thread", "versioned"};
+    for (const QString &word : kOther) {
+        if (lower.contains(word)) {
+            *category = OptRemark::Other;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString unquote(const QString &value) {
+    if (value.size() >= 2 && value.startsWith('\'') && value.endsWith('\'')) {
+        QString text = value.mid(1, value.size() - 2);
+        text.replace(QLatin1String("''"), QLatin1String("'"));
+        return text;
+    }
+    if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"')) {
+        QString text = value.mid(1, value.size() - 2);
+        text.replace(QLatin1String("\\\""), QLatin1String("\""));
+        text.replace(QLatin1String("\\\\"), QLatin1String("\\"));
+        return text;
+    }
+    return value;
+}
+}
+
+QString OptRemark::categoryName(Category category) {
+    switch (category) {
+    case Vectorize:
+        return QObject::tr("向量化");
+    case Inline:
+        return QObject::tr("内联");
+    case Licm:
+        return QObject::tr("LICM");
+    case Other:
+        break;
+    }
+    return QObject::tr("其他");
+}
+
+QString OptRemark::kindName(Kind kind) {
+    switch (kind) {
+    case Passed:
+        return QObject::tr("已优化");
+    case Missed:
+        return QObject::tr("未优化");
+    case Analysis:
+        break;
+    }
+    return QObject::tr("分析");
+}
+
+OptRemarkCollector::OptRemarkCollector(QObject *parent) : QObject(parent) {
+    connect(&pipeline_, &ToolPipeline::finished, this, &OptRemarkCollector::finish);
+}
+
+bool OptRemarkCollector::isRunning() const {
+    return pipeline_.isRunning();
+}
+
+void OptRemarkCollector::collect(const Request &request) {
+    pipeline_.cancel(); // 先杀掉旧请求，它可能还在写同一个记录文件
+    request_ = request;
+    timer_.start();
+    QDir().mkpath(QFileInfo(request.recordPath).absolutePath());
+    QFile::remove(request.recordPath); // gcc 以追加方式写 -fopt-info 的文件
+
+    QStringList args = request.flags;
+    args << "-c" << request.source << "-o" << request.objectPath;
+    const QString recordPath = request.recordPath;
+    // 编译成功后读出记录文件交给 c++filt；gcc 没有任何报告时不会创建文件，读到的就是空的
+    pipeline_.start(request.compiler, args, request.workingDirectory, [recordPath](const QByteArray &) {
+        QFile file(recordPath);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    });
+}
+
+void OptRemarkCollector::finish(const QByteArray &record, const QString &error) {
+    OptRemarkReport report;
+    report.sourcePath = request_.source;
+    report.recordPath = request_.recordPath;
+    report.elapsedMs = timer_.elapsed();
+    report.error = error;
+    if (error.isEmpty()) {
+        const QString text = QString::fromUtf8(record);
+        const bool yaml = text.startsWith(QLatin1String("--- !")) || text.contains(QLatin1String("\n--- !"));
+        report.format = yaml ? QStringLiteral("yaml") : QStringLiteral("opt-info");
+        const QList<OptRemark> remarks = yaml ? parseYaml(text) : parseOptInfo(text);
+
+        const QString source = QFileInfo(request_.source).canonicalFilePath();
+        const QDir base(request_.workingDirectory);
+        QHash<QString, bool> isSource;
+        QSet<QString> seen;
+        for (OptRemark remark : remarks) {
+            auto known = isSource.constFind(remark.file);
+            if (known == isSource.constEnd()) {
+                known = isSource.insert(remark.file,
+                                        QFileInfo(base.absoluteFilePath(remark.file)).canonicalFilePath() == source);
+            }
+            if (!known.value()) {
+                ++report.otherFileRemarks;
+                continue;
+            }
+            // gcc 对同一条语句会重复报告
+            const QString key = QStringLiteral("%1:%2:%3:%4").arg(remark.line).arg(remark.column).arg(remark.kind).arg(remark.message);
+            if (seen.contains(key)) {
+                continue;
+            }
+            seen.insert(key);
+            remark.file = request_.source;
+            report.remarks.append(remark);
+        }
+        std::stable_sort(report.remarks.begin(), report.remarks.end(), [](const OptRemark &a, const OptRemark &b) {
+            return a.line != b.line ? a.line < b.line : a.column < b.column;
+        });
+    }
+    emit finished(report);
+}
+
+QList<OptRemark> OptRemarkCollector::parseYaml(const QString &text) {
+    // -fsave-optimization-record 的每条记录是一个 YAML 文档：
+    //   --- !Missed
+    //   Pass:     inline
+    //   Name:     NoDefinition
+    //   DebugLoc: { File: a.cpp, Line: 5, Column: 72 }
+    //   Function: s(std::vector<int>&)
+    //   Args:
+    //     - Callee:  g(int)
+    //     - String:  ' will not be inlined into '
+    //   ...
+    // 这里只按行解析用得到的字段，Args 里的值依次拼起来就是 -Rpass 会打印的那句话。
+    static const QRegularExpression kField(QStringLiteral("^( *)(- )?([A-Za-z][A-Za-z0-9_]*):\\s*(.*)$"));
+    static const QRegularExpression kLocation(
+        QStringLiteral("File:\\s*('(?:[^']|'')*'|[^,]+),\\s*Line:\\s*(\\d+),\\s*Column:\\s*(\\d+)"));
+
+    QList<OptRemark> remarks;
+    OptRemark current;
+    QStringList args;
+    bool inDocument = false;
+    auto flush = [&]() {
+        if (inDocument && current.line > 0) {
+            current.category = categoryForPass(current.pass);
+            current.message = args.join(QString()).simplified();
+            remarks.append(current);
+        }
+        inDocument = false;
+    };
+
+    const QStringList lines = text.split('\n');
+    for (QString line : lines) {
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (line.startsWith(QLatin1String("--- !"))) {
+            flush();
+            inDocument = true;
+            current = OptRemark();
+            args.clear();
+            const QString tag = line.mid(5).trimmed();
+            if (tag.startsWith(QLatin1String("Passed"))) {
+                current.kind = OptRemark::Passed;
+            } else if (tag.startsWith(QLatin1String("Missed")) || tag.startsWith(QLatin1String("Failure"))) {
+                current.kind = OptRemark::Missed;
+            } else {
+                current.kind = OptRemark::Analysis;
+            }
+            continue;
+        }
+        if (line == QLatin1String("...")) {
+            flush();
+            continue;
+        }
+        if (!inDocument) {
+            continue;
+        }
+        const QRegularExpressionMatch match = kField.match(line);
+        if (!match.hasMatch()) {
+            // 折行的长字符串
+            if (!args.isEmpty() && !line.trimmed().isEmpty()) {
+                args.last() += QLatin1Char(' ') + unquote(line.trimmed());
+            }
+            continue;
+        }
+        const int indent = match.capturedLength(1);
+        const bool listItem = match.capturedLength(2) > 0;
+        const QString key = match.captured(3);
+        const QString value = match.captured(4).trimmed();
+        if (listItem) {
+            args.append(unquote(value));
+            continue;
+        }
+        if (indent > 0) {
+            continue; // 参数自带的 DebugLoc 等
+        }
+        if (key == QLatin1String("Pass")) {
+            current.pass = unquote(value);
+        } else if (key == QLatin1String("Name")) {
+            current.name = unquote(value);
+        } else if (key == QLatin1String("Function")) {
+            current.function = unquote(value);
+        } else if (key == QLatin1String("DebugLoc")) {
+            const QRegularExpressionMatch loc = kLocation.match(value);
+            if (loc.hasMatch()) {
+                current.file = unquote(loc.captured(1).trimmed());
+                current.line = loc.captured(2).toInt();
+                current.column = loc.captured(3).toInt();
+            }
+        }
+    }
+    flush();
+    return remarks;
+}
+
+QList<OptRemark> OptRemarkCollector::parseOptInfo(const QString &text) {
+    // a.cpp:4:44: missed: couldn't vectorize loop
+    // a.cpp:5:80: optimized:  Inlining int h(int)/155 into int s(std::vector<int>&)/157.
+    static const QRegularExpression kLine(QStringLiteral("^(.+?):(\\d+):(\\d+): (optimized|missed|note): ?(.*)$"));
+    // 调用图节点编号（"h(int)/155"）对阅读没有帮助
+    static const QRegularExpression kNodeId(QStringLiteral("(?<=[\\w)>\\]])/\\d+(?=[ .,]|$)"));
+
+    QList<OptRemark> remarks;
+    OptRemark::Category previous = OptRemark::Other;
+    const QStringList lines = text.split('\n');
+    for (QString line : lines) {
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        const QRegularExpressionMatch match = kLine.match(line);
+        if (!match.hasMatch()) {
+            if (!remarks.isEmpty() && !line.trimmed().isEmpty()) {
+                remarks.last().message += QLatin1Char(' ') + line.trimmed();
+            }
+            continue;
+        }
+        OptRemark remark;
+        remark.file = match.captured(1);
+        remark.line = match.captured(2).toInt();
+        remark.column = match.captured(3).toInt();
+        const QString kind = match.captured(4);
+        remark.kind = kind == QLatin1String("optimized") ? OptRemark::Passed
+                      : kind == QLatin1String("missed")  ? OptRemark::Missed
+                                                         : OptRemark::Analysis;
+        remark.message = match.captured(5).trimmed();
+        remark.message.remove(kNodeId);
+        if (!categoryForMessage(remark.message, &remark.category)) {
+            remark.category = previous;
+        }
+        previous = remark.category;
+        remark.pass = OptRemark::categoryName(remark.category);
+        remarks.append(remark);
+    }
+    return remarks;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ToolPipeline.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// 编译器的一条优化报告：哪一行的循环没有向量化、哪个调用没有内联等。
+struct OptRemark {
+    enum Kind { Passed, Missed, Analysis };
+    enum Category { Vectorize, Inline, Licm, Other };
+
+    QString file;
+    int line = 0;   // 从 1 开始
+    int column = 0;
+    Kind kind = Missed;
+    Category category = Other;
+    QString pass;     // clang 的 Pass 名称（loop-vectorize、inline、licm...），gcc 下为推断出的分类
+    QString name;     // clang 的 Name，gcc 为空
+    QString function;
+    QString message;
+
+    static QString categoryName(Category category);
+    static QString kindName(Kind kind);
+};
+
+struct OptRemarkReport {
+    QString sourcePath;
+    QList<OptRemark> remarks; // 只保留当前源文件里的，头文件里的只计数
+    int otherFileRemarks = 0;
+    QString format;           // "yaml"（clang）或 "opt-info"（gcc）
+    QString recordPath;
+    qint64 elapsedMs = 0;
+    QString error;
+};
+
+// 单独编译一个翻译单元并收集优化报告：clang 用 -fsave-optimization-record 输出 YAML，
+// gcc 用 -fopt-info-missed-optimized 输出文本，参数由 BuildManager::optimizationRecordFlags 给出。
+// 记录文件按内容判断格式，之后经 c++filt 还原名字再解析；新请求会取消还没完成的旧请求。
+class OptRemarkCollector : public QObject {
+    Q_OBJECT
+
+public:
+    struct Request {
+        QString source;
+        QString compiler;
+        QStringList flags;      // 已包含输出记录文件的参数
+        QString recordPath;
+        QString objectPath;     // 产物只是副产品，放在记录文件旁边
+        QString workingDirectory;
+    };
+
+    explicit OptRemarkCollector(QObject *parent = nullptr);
+
+    void collect(const Request &request);
+    bool isRunning() const;
+
+    static QList<OptRemark> parseYaml(const QString &text);
+    static QList<OptRemark> parseOptInfo(const QString &text);
+
+signals:
+    void finished(const OptRemarkReport &report);
+
+private:
+    void finish(const QByteArray &record, const QString &error);
+
+    ToolPipeline pipeline_;
+    Request request_;
+    QElapsedTimer timer_;
+};
@@ -0,0 +1,163 @@
+#include "OptRemarksPanel.h"
+
+#include <QCheckBox>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSettings>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+constexpr int kLineRole = Qt::UserRole;
+}
+
+OptRemarksPanel::OptRemarksPanel(OptRemarkCollector *collector, QWidget *parent)
+    : QWidget(parent), collector_(collector) {
+    QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+    vectorizeCheck_ = new QCheckBox(tr("向量化"), this);
+    vectorizeCheck_->setChecked(settings.value("optRemarks/vectorize", true).toBool());
+    inlineCheck_ = new QCheckBox(tr("内联"), this);
+    inlineCheck_->setChecked(settings.value("optRemarks/inline", true).toBool());
+    licmCheck_ = new QCheckBox(tr("LICM"), this);
+    licmCheck_->setToolTip(tr("循环不变量外提"));
+    licmCheck_->setChecked(settings.value("optRemarks/licm", true).toBool());
+    otherCheck_ = new QCheckBox(tr("其他"), this);
+    otherCheck_->setChecked(settings.value("optRemarks/other", false).toBool());
+    missedOnlyCheck_ = new QCheckBox(tr("只看未优化"), this);
+    missedOnlyCheck_->setChecked(settings.value("optRemarks/missedOnly", true).toBool());
+    collectButton_ = new QPushButton(tr("收集当前文件"), this);
+    clearButton_ = new QPushButton(tr("清除标注"), this);
+    statusLabel_ = new QLabel(tr("用当前编译模式单独编译当前文件，收集编译器的优化报告。"), this);
+    statusLabel_->setWordWrap(true);
+
+    tree_ = new QTreeWidget(this);
+    tree_->setHeaderLabels({tr("行"), tr("结果"), tr("分类"), tr("Pass"), tr("信息")});
+    tree_->setRootIsDecorated(false);
+    tree_->header()->setSectionResizeMode(4, QHeaderView::Stretch);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(vectorizeCheck_);
+    bar->addWidget(inlineCheck_);
+    bar->addWidget(licmCheck_);
+    bar->addWidget(otherCheck_);
+    bar->addWidget(missedOnlyCheck_);
+    bar->addStretch(1);
+    bar->addWidget(clearButton_);
+    bar->addWidget(collectButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(statusLabel_);
+    layout->addWidget(tree_);
+
+    auto optionsChanged = [this]() {
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("optRemarks/vectorize", vectorizeCheck_->isChecked());
+        settings.setValue("optRemarks/inline", inlineCheck_->isChecked());
+        settings.setValue("optRemarks/licm", licmCheck_->isChecked());
+        settings.setValue("optRemarks/other", otherCheck_->isChecked());
+        settings.setValue("optRemarks/missedOnly", missedOnlyCheck_->isChecked());
+        rebuildTree();
+        emit filtersChanged();
+    };
+    for (QCheckBox *check : {vectorizeCheck_, inlineCheck_, licmCheck_, otherCheck_, missedOnlyCheck_}) {
+        connect(check, &QCheckBox::toggled, this, optionsChanged);
+    }
+    connect(collectButton_, &QPushButton::clicked, this, &OptRemarksPanel::collectRequested);
+    connect(clearButton_, &QPushButton::clicked, this, [this]() {
+        report_ = OptRemarkReport();
+        tree_->clear();
+        statusLabel_->setText(tr("已清除。"));
+        emit clearRequested();
+    });
+    connect(collector_, &OptRemarkCollector::finished, this, &OptRemarksPanel::showReport);
+    connect(tree_, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item, int) {
+        if (item && !report_.sourcePath.isEmpty()) {
+            emit locationActivated(report_.sourcePath, item->data(0, kLineRole).toInt());
+        }
+    });
+}
+
+bool OptRemarksPanel::accepts(const OptRemark &remark) const {
+    if (missedOnlyCheck_->isChecked() && remark.kind != OptRemark::Missed) {
+        return false;
+    }
+    switch (remark.category) {
+    case OptRemark::Vectorize:
+        return vectorizeCheck_->isChecked();
+    case OptRemark::Inline:
+        return inlineCheck_->isChecked();
+    case OptRemark::Licm:
+        return licmCheck_->isChecked();
+    case OptRemark::Other:
+        break;
+    }
+    return otherCheck_->isChecked();
+}
+
+QList<OptRemark> OptRemarksPanel::filtered(const QList<OptRemark> &remarks) const {
+    QList<OptRemark> result;
+    for (const OptRemark &remark : remarks) {
+        if (accepts(remark)) {
+            result.append(remark);
+        }
+    }
+    return result;
+}
+
+void OptRemarksPanel::setStatus(const QString &text) {
+    statusLabel_->setText(text);
+}
+
+void OptRemarksPanel::showReport(const OptRemarkReport &report) {
+    report_ = report;
+    const QString fileName = QFileInfo(report.sourcePath).fileName();
+    if (!report.error.isEmpty()) {
+        tree_->clear();
+        statusLabel_->setText(tr("%1：收集优化报告失败\n%2").arg(fileName, report.error));
+        return;
+    }
+    rebuildTree();
+    QString status = tr("%1：%2 条报告（%3），用时 %4 ms")
+                         .arg(fileName)
+                         .arg(report.remarks.size())
+                         .arg(report.format == QLatin1String("yaml") ? tr("clang 优化记录") : tr("gcc -fopt-info"))
+                         .arg(report.elapsedMs);
+    if (report.otherFileRemarks > 0) {
+        status += tr("；另有 %1 条位于头文件，未显示").arg(report.otherFileRemarks);
+    }
+    if (report.remarks.isEmpty() && report.otherFileRemarks == 0) {
+        status += tr("。当前编译模式可能没有开启优化，可以切到 Release 再试。");
+    }
+    statusLabel_->setText(status);
+    statusLabel_->setToolTip(report.recordPath);
+}
+
+void OptRemarksPanel::rebuildTree() {
+    tree_->clear();
+    for (const OptRemark &remark : report_.remarks) {
+        if (!accepts(remark)) {
+            continue;
+        }
+        auto *item = new QTreeWidgetItem(tree_);
+        item->setData(0, Qt::DisplayRole, remark.line);
+        item->setData(0, kLineRole, remark.line);
+        item->setText(1, OptRemark::kindName(remark.kind));
+        item->setText(2, OptRemark::categoryName(remark.category));
+        item->setText(3, remark.name.isEmpty() ? remark.pass : remark.pass + QLatin1Char('/') + remark.name);
+        item->setText(4, remark.message);
+        item->setToolTip(4, remark.function.isEmpty() ? remark.message
+                                                      : tr("%1\n所在函数：%2").arg(remark.message, remark.function));
+        if (remark.kind == OptRemark::Missed) {
+            item->setForeground(1, QColor(220, 50, 47));
+        } else if (remark.kind == OptRemark::Passed) {
+            item->setForeground(1, QColor(0, 140, 60));
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QWidget>
+
+#include "OptRemarks.h"
+
+class QCheckBox;
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+// 优化报告面板：按 pass（向量化、内联、LICM、其他）和是否已优化过滤，
+// 过滤结果同时决定编辑器覆盖层显示哪些；双击一条跳到对应源码行。
+class OptRemarksPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit OptRemarksPanel(OptRemarkCollector *collector, QWidget *parent = nullptr);
+
+    bool accepts(const OptRemark &remark) const;
+    QList<OptRemark> filtered(const QList<OptRemark> &remarks) const;
+    void setStatus(const QString &text);
+
+signals:
+    void filtersChanged();
+    void collectRequested();
+    void clearRequested();
+    void locationActivated(const QString &filePath, int line);
+
+private:
+    void showReport(const OptRemarkReport &report);
+    void rebuildTree();
+
+    OptRemarkCollector *collector_;
+    OptRemarkReport report_;
+    QLabel *statusLabel_;
+    QCheckBox *vectorizeCheck_;
+    QCheckBox *inlineCheck_;
+    QCheckBox *licmCheck_;
+    QCheckBox *otherCheck_;
+    QCheckBox *missedOnlyCheck_;
+    QPushButton *collectButton_;
+    QPushButton *clearButton_;
+    QTreeWidget *tree_;
+};
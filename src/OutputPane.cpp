@@ -0,0 +1,144 @@
+#include "OutputPane.h"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSettings>
+#include <QSpinBox>
+#include <QTextCursor>
+#include <QVBoxLayout>
+
+namespace {
+// 约 30 帧/秒刷新一次；两帧之间最多积压 512K 字符，再多就整块丢弃最早的部分。
+constexpr int kFlushIntervalMs = 33;
+constexpr int kMaxPendingChars = 512 * 1024;
+constexpr int kDefaultMaxLines = 20000;
+}
+
+OutputPane::OutputPane(QWidget *parent) : QWidget(parent) {
+    view_ = new QPlainTextEdit(this);
+    view_->setReadOnly(true);
+    view_->setUndoRedoEnabled(false);
+    view_->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+    pauseCheck_ = new QCheckBox(tr("暂停自动滚动"), this);
+    maxLinesSpin_ = new QSpinBox(this);
+    maxLinesSpin_->setRange(1000, 1000000);
+    maxLinesSpin_->setSingleStep(10000);
+    maxLinesSpin_->setToolTip(tr("输出面板最多保留的行数，超出后丢弃最早的输出"));
+    auto *btnClear = new QPushButton(tr("清空"), this);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(pauseCheck_);
+    bar->addStretch();
+    bar->addWidget(new QLabel(tr("最大行数："), this));
+    bar->addWidget(maxLinesSpin_);
+    bar->addWidget(btnClear);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(view_);
+
+    QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+    setMaximumLines(settings.value("output/maxLines", kDefaultMaxLines).toInt());
+    connect(maxLinesSpin_, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int lines) {
+        view_->setMaximumBlockCount(lines);
+        QSettings settings(QStringLiteral("RusticCppIDE"), QStringLiteral("RusticCppIDE"));
+        settings.setValue("output/maxLines", lines);
+    });
+    connect(btnClear, &QPushButton::clicked, this, &OutputPane::clear);
+
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(kFlushIntervalMs);
+    connect(&flushTimer_, &QTimer::timeout, this, &OutputPane::flushPending);
+}
+
+void OutputPane::append(const QString &text) {
+    if (text.isEmpty()) {
+        return;
+    }
+    if (text.size() >= kMaxPendingChars) {
+        // 单块就超过上限：之前积压的全部作废，这一块只留最新的部分
+        droppedChars_ += pendingChars_ + (text.size() - kMaxPendingChars);
+        pendingChunks_.clear();
+        pendingChunks_.append(text.right(kMaxPendingChars));
+        pendingChars_ = kMaxPendingChars;
+    } else {
+        pendingChunks_.append(text);
+        pendingChars_ += text.size();
+        while (pendingChars_ > kMaxPendingChars) {
+            const qint64 size = pendingChunks_.first().size();
+            droppedChars_ += size;
+            pendingChars_ -= size;
+            pendingChunks_.removeFirst();
+        }
+    }
+    if (!flushTimer_.isActive()) {
+        flushTimer_.start();
+    }
+}
+
+void OutputPane::clear() {
+    flushTimer_.stop();
+    pendingChunks_.clear();
+    pendingChars_ = 0;
+    droppedChars_ = 0;
+    view_->clear();
+}
+
+int OutputPane::maximumLines() const {
+    return maxLinesSpin_->value();
+}
+
+void OutputPane::setMaximumLines(int lines) {
+    maxLinesSpin_->setValue(lines);
+    view_->setMaximumBlockCount(maxLinesSpin_->value());
+}
+
+QPlainTextEdit *OutputPane::view() const {
+    return view_;
+}
+
+void OutputPane::flushPending() {
+    if (pendingChunks_.isEmpty()) {
+        return;
+    }
+    QString batch;
+    batch.reserve(static_cast<int>(pendingChars_));
+    for (const QString &chunk : pendingChunks_) {
+        batch += chunk;
+    }
+    pendingChunks_.clear();
+    pendingChars_ = 0;
+    if (droppedChars_ > 0) {
+        // 丢弃后剩下的开头可能是半行，跳到下一个行首
+        const int newline = batch.indexOf('\n');
+        if (newline >= 0 && newline < 4096) {
+            droppedChars_ += newline + 1;
+            batch.remove(0, newline + 1);
+        }
+        batch.prepend(tr("…… 输出过快，已丢弃 %1 个字符 ……\n").arg(droppedChars_));
+        droppedChars_ = 0;
+    }
+
+    // 用户往上翻看时（或手动暂停时）保持视图不动，只有停在底部时才跟随新输出。
+    QScrollBar *bar = view_->verticalScrollBar();
+    const bool follow = !pauseCheck_->isChecked() && bar->value() == bar->maximum();
+    const int previous = bar->value();
+
+    QTextCursor cursor(view_->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(batch);
+
+    if (follow) {
+        bar->setValue(bar->maximum());
+    } else {
+        bar->setValue(qMin(previous, bar->maximum()));
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include <QWidget>
+
+class QCheckBox;
+class QPlainTextEdit;
+class QSpinBox;
+
+// 编译/运行输出面板。输出先进入有上限的缓冲区，由定时器按帧率批量写入文本框：
+// 程序每秒输出几百 MB 时界面线程也只做有限次的排版，超出缓冲区的旧输出直接丢弃并标注。
+class OutputPane : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit OutputPane(QWidget *parent = nullptr);
+
+    void append(const QString &text);
+    void clear();
+
+    int maximumLines() const;
+    void setMaximumLines(int lines);
+    QPlainTextEdit *view() const;
+
+private slots:
+    void flushPending();
+
+private:
+    QPlainTextEdit *view_;
+    QCheckBox *pauseCheck_;
+    QSpinBox *maxLinesSpin_;
+    // 两帧之间积压的输出按到达的块存放，超限时整块从前面丢弃，不在大字符串里来回搬移
+    QList<QString> pendingChunks_;
+    qint64 pendingChars_ = 0;
+    qint64 droppedChars_ = 0;
+    QTimer flushTimer_;
+};
@@ -0,0 +1,107 @@
+#include "ProfilePanel.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+constexpr int kMaxRows = 2000;
+constexpr int kFileRole = Qt::UserRole;
+constexpr int kLineRole = Qt::UserRole + 1;
+}
+
+ProfilePanel::ProfilePanel(SamplingProfiler *profiler, QWidget *parent) : QWidget(parent), profiler_(profiler) {
+    statusLabel_ = new QLabel(tr("尚未分析。Release 模式加上 -g 编译才能对应到源码行。"), this);
+    stopButton_ = new QPushButton(tr("停止"), this);
+    stopButton_->setEnabled(false);
+    clearButton_ = new QPushButton(tr("清除热点标记"), this);
+
+    functionsTree_ = new QTreeWidget(this);
+    functionsTree_->setHeaderLabels({tr("函数"), tr("自身样本"), tr("占比(%)"), tr("最热位置"), tr("模块")});
+    functionsTree_->setRootIsDecorated(false);
+    functionsTree_->setSortingEnabled(true);
+    functionsTree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(statusLabel_, 1);
+    bar->addWidget(clearButton_);
+    bar->addWidget(stopButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(functionsTree_);
+
+    connect(stopButton_, &QPushButton::clicked, profiler_, &SamplingProfiler::stop);
+    connect(clearButton_, &QPushButton::clicked, this, [this]() {
+        functionsTree_->clear();
+        statusLabel_->setText(tr("已清除。"));
+        emit clearRequested();
+    });
+    connect(profiler_, &SamplingProfiler::statusChanged, this, [this](const QString &text) {
+        stopButton_->setEnabled(true);
+        statusLabel_->setText(text);
+    });
+    connect(profiler_, &SamplingProfiler::finished, this, &ProfilePanel::showResult);
+    connect(functionsTree_, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item, int) {
+        if (!item) {
+            return;
+        }
+        const QString file = item->data(0, kFileRole).toString();
+        if (!file.isEmpty()) {
+            emit locationActivated(file, item->data(0, kLineRole).toInt());
+        }
+    });
+}
+
+void ProfilePanel::showResult(const SamplingProfiler::Result &result) {
+    stopButton_->setEnabled(false);
+    functionsTree_->setSortingEnabled(false);
+    functionsTree_->clear();
+
+    const int total = qMax(1, result.totalSamples);
+    const int rows = qMin(kMaxRows, static_cast<int>(result.functions.size()));
+    for (int i = 0; i < rows; ++i) {
+        const SamplingProfiler::Function &function = result.functions.at(i);
+        auto *item = new QTreeWidgetItem(functionsTree_);
+        item->setText(0, function.name);
+        item->setToolTip(0, function.name);
+        item->setData(1, Qt::DisplayRole, function.samples);
+        item->setData(2, Qt::DisplayRole, qRound(1000.0 * function.samples / total) / 10.0);
+        if (!function.file.isEmpty()) {
+            item->setText(3, QStringLiteral("%1:%2").arg(QFileInfo(function.file).fileName()).arg(function.line));
+            item->setToolTip(3, function.file);
+            item->setData(0, kFileRole, function.file);
+            item->setData(0, kLineRole, function.line);
+        }
+        item->setText(4, function.module);
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        item->setTextAlignment(2, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    functionsTree_->setSortingEnabled(true);
+    functionsTree_->sortByColumn(1, Qt::DescendingOrder);
+
+    QString status;
+    if (!result.error.isEmpty()) {
+        status = result.error;
+    } else {
+        status = tr("%1：%2 个样本，%3 个函数，%4 个源文件有热度；程序%5，退出码 %6。")
+                     .arg(result.backend)
+                     .arg(result.totalSamples)
+                     .arg(result.functions.size())
+                     .arg(result.lineSamples.size())
+                     .arg(result.stopped ? tr("被停止") : tr("正常结束"))
+                     .arg(result.exitCode);
+        if (result.totalSamples > 0 && result.lineSamples.isEmpty()) {
+            status += tr(" 没有源码行信息，请用 -g 编译。");
+        }
+    }
+    statusLabel_->setText(status);
+    statusLabel_->setToolTip(result.programOutputPath.isEmpty() ? QString() : tr("程序输出：%1").arg(result.programOutputPath));
+}
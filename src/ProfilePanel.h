@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QWidget>
+
+#include "SamplingProfiler.h"
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+// 性能分析面板：显示采样进度和按自身样本排序的热点函数表，双击跳到函数最热的一行。
+class ProfilePanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ProfilePanel(SamplingProfiler *profiler, QWidget *parent = nullptr);
+
+signals:
+    void locationActivated(const QString &filePath, int line);
+    void clearRequested();
+
+private:
+    void showResult(const SamplingProfiler::Result &result);
+
+    SamplingProfiler *profiler_;
+    QLabel *statusLabel_;
+    QPushButton *stopButton_;
+    QPushButton *clearButton_;
+    QTreeWidget *functionsTree_;
+};
@@ -0,0 +1,260 @@
+#include "ProjectFileIndex.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QThread>
+
+#include "SourceScanner.h"
+
+#include <algorithm>
+
+namespace {
+// 规则相对工程根目录；隐藏目录和符号链接在遍历时就跳过了。third_party/ 也要收录，源文件规则可能指向那里
+const QStringList kIgnoreRules = SourceScanner::builtinExcludes();
+}
+
+ProjectFileIndex::ProjectFileIndex(QObject *parent)
+    : QObject(parent),
+      scanner_(new SourceScanner(this)),
+      watcher_(new QFileSystemWatcher(this)),
+      ignoreRules_(SourceScanner::globToRegex(kIgnoreRules)) {
+    // 一次 git checkout 会让同一个目录连续报告很多次变化，攒一下再处理
+    changeTimer_.setSingleShot(true);
+    changeTimer_.setInterval(100);
+    connect(&changeTimer_, &QTimer::timeout, this, &ProjectFileIndex::flushChangedDirectories);
+    connect(watcher_, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+        if (ready_) {
+            changedDirs_.insert(dirRelFor(path));
+            changeTimer_.start();
+        }
+    });
+    connect(scanner_, &SourceScanner::finished, this, [this](const SourceScanner::Result &result) {
+        if (result.rootDir != root_ || ready_) {
+            return;
+        }
+        QStringList added;
+        addScanned(result.files, result.directories, &added);
+        ready_ = true;
+        emit ready();
+    });
+}
+
+ProjectFileIndex::~ProjectFileIndex() {
+    if (subtreeThread_) {
+        subtreeCancelled_ = true;
+        subtreeThread_->wait();
+        delete subtreeThread_;
+    }
+}
+
+void ProjectFileIndex::setRootDir(const QString &rootDir) {
+    const QString root = rootDir.isEmpty() ? QString() : QDir(rootDir).absolutePath();
+    if (root == root_) {
+        return;
+    }
+    root_ = root;
+    ready_ = false;
+    filesByDir_.clear();
+    files_.clear();
+    changedDirs_.clear();
+    changeTimer_.stop();
+    ++generation_;
+    subtreeCancelled_ = true;
+    pendingSubtrees_.clear();
+    scanningSubtrees_.clear();
+    if (!watcher_->directories().isEmpty()) {
+        watcher_->removePaths(watcher_->directories());
+    }
+    if (!root_.isEmpty()) {
+        scanner_->scan(root_, {QStringLiteral("**")}, kIgnoreRules);
+    }
+}
+
+QString ProjectFileIndex::rootDir() const {
+    return root_;
+}
+
+bool ProjectFileIndex::isReady() const {
+    return ready_;
+}
+
+QStringList ProjectFileIndex::files() const {
+    return files_.values();
+}
+
+bool ProjectFileIndex::contains(const QString &relativePath) const {
+    return files_.contains(relativePath);
+}
+
+int ProjectFileIndex::fileCount() const {
+    return static_cast<int>(files_.size());
+}
+
+QString ProjectFileIndex::dirRelFor(const QString &absolutePath) const {
+    const QString rel = QDir(root_).relativeFilePath(absolutePath);
+    return rel == QLatin1String(".") || rel.isEmpty() ? QString() : rel + QLatin1Char('/');
+}
+
+bool ProjectFileIndex::ignored(const QString &relativePath) const {
+    return ignoreRules_.match(relativePath).hasMatch();
+}
+
+void ProjectFileIndex::addScanned(const QStringList &files, const QStringList &directories, QStringList *added) {
+    QStringList watch;
+    for (const QString &dir : directories) {
+        const QString dirRel = dirRelFor(dir);
+        if (!filesByDir_.contains(dirRel) && !ignored(dirRel)) {
+            filesByDir_.insert(dirRel, {});
+            watch << dir;
+        }
+    }
+    for (const QString &rel : files) {
+        if (ignored(rel) || files_.contains(rel)) {
+            continue;
+        }
+        const int slash = static_cast<int>(rel.lastIndexOf(QLatin1Char('/')));
+        filesByDir_[rel.left(slash + 1)].insert(rel.mid(slash + 1));
+        files_.insert(rel);
+        added->append(rel);
+    }
+    if (!watch.isEmpty()) {
+        watcher_->addPaths(watch);
+    }
+}
+
+void ProjectFileIndex::removeTree(const QString &dirRel, QStringList *removed) {
+    QStringList unwatch;
+    for (auto it = filesByDir_.begin(); it != filesByDir_.end();) {
+        if (!it.key().startsWith(dirRel)) {
+            ++it;
+            continue;
+        }
+        for (const QString &name : it.value()) {
+            files_.remove(it.key() + name);
+            removed->append(it.key() + name);
+        }
+        unwatch << QDir(root_).filePath(it.key());
+        it = filesByDir_.erase(it);
+    }
+    // 已删除的目录 inotify 会自动移除监视，这里的失败可以忽略
+    if (!unwatch.isEmpty()) {
+        watcher_->removePaths(unwatch);
+    }
+}
+
+void ProjectFileIndex::refreshDirectory(const QString &dirRel, QStringList *added, QStringList *removed) {
+    if (!filesByDir_.contains(dirRel)) {
+        return; // 父目录先处理时已经整棵移除
+    }
+    const QString dirAbs = dirRel.isEmpty() ? root_ : QDir(root_).filePath(dirRel.left(dirRel.size() - 1));
+    if (!QFileInfo(dirAbs).isDir()) {
+        removeTree(dirRel, removed);
+        return;
+    }
+
+    QSet<QString> names;
+    QSet<QString> subdirs;
+    QDirIterator it(dirAbs, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    while (it.hasNext()) {
+        it.next();
+        const QString rel = dirRel + it.fileName();
+        if (it.fileInfo().isDir()) {
+            if (!ignored(rel + QLatin1Char('/'))) {
+                subdirs.insert(rel + QLatin1Char('/'));
+            }
+        } else if (!ignored(rel)) {
+            names.insert(it.fileName());
+        }
+    }
+
+    QSet<QString> &known = filesByDir_[dirRel];
+    for (const QString &name : names) {
+        if (!known.contains(name)) {
+            files_.insert(dirRel + name);
+            added->append(dirRel + name);
+        }
+    }
+    for (const QString &name : known) {
+        if (!names.contains(name)) {
+            files_.remove(dirRel + name);
+            removed->append(dirRel + name);
+        }
+    }
+    known = names;
+
+    // 直接子目录：新出现的单独扫描整棵，消失的整棵移除
+    QStringList vanished;
+    for (auto dir = filesByDir_.cbegin(); dir != filesByDir_.cend(); ++dir) {
+        const QString &key = dir.key();
+        if (key.size() > dirRel.size() && key.startsWith(dirRel) && key.indexOf(QLatin1Char('/'), dirRel.size()) == key.size() - 1
+            && !subdirs.contains(key)) {
+            vanished << key;
+        }
+    }
+    for (const QString &dir : vanished) {
+        removeTree(dir, removed);
+    }
+    for (const QString &dir : subdirs) {
+        if (!filesByDir_.contains(dir) && !scanningSubtrees_.contains(dir)) {
+            scanningSubtrees_.insert(dir);
+            pendingSubtrees_.append(dir);
+        }
+    }
+}
+
+void ProjectFileIndex::startSubtreeScan() {
+    if (subtreeThread_ || pendingSubtrees_.isEmpty()) {
+        return;
+    }
+    const QString root = root_;
+    const int generation = generation_;
+    const QStringList dirs = pendingSubtrees_;
+    pendingSubtrees_.clear();
+    subtreeCancelled_ = false;
+    subtreeThread_ = QThread::create([this, root, generation, dirs]() {
+        QList<SourceScanner::Result> results;
+        for (const QString &dir : dirs) {
+            results << SourceScanner::scanNow(root, {QStringLiteral("**")}, kIgnoreRules, &subtreeCancelled_, dir);
+        }
+        QMetaObject::invokeMethod(this, [this, generation, dirs, results]() {
+            subtreeThread_->wait();
+            subtreeThread_->deleteLater();
+            subtreeThread_ = nullptr;
+            if (generation == generation_) {
+                QStringList added;
+                for (int i = 0; i < dirs.size(); ++i) {
+                    scanningSubtrees_.remove(dirs.at(i));
+                    // 扫描期间又被删掉的目录不收录
+                    if (QFileInfo(QDir(root_).filePath(dirs.at(i))).isDir()) {
+                        addScanned(results.at(i).files, results.at(i).directories, &added);
+                    }
+                }
+                if (!added.isEmpty()) {
+                    emit filesAdded(added);
+                }
+            }
+            startSubtreeScan();
+        }, Qt::QueuedConnection);
+    });
+    subtreeThread_->start();
+}
+
+void ProjectFileIndex::flushChangedDirectories() {
+    QStringList dirs = changedDirs_.values();
+    changedDirs_.clear();
+    std::sort(dirs.begin(), dirs.end()); // 父目录在前
+    QStringList added;
+    QStringList removed;
+    for (const QString &dir : dirs) {
+        refreshDirectory(dir, &added, &removed);
+    }
+    if (!removed.isEmpty()) {
+        emit filesRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        emit filesAdded(added);
+    }
+    startSubtreeScan();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+
+class QFileSystemWatcher;
+class QThread;
+class SourceScanner;
+
+// 工程目录下全部文件的内存索引（相对路径），由 ProjectManager 持有：glob 源文件规则、工程树的“其他文件”
+// 和 Ctrl+P 都用它，整个工程只扫描一次、只有一套目录监视。
+// 打开工程时在后台扫描一次，之后由 QFileSystemWatcher 报告变化的目录，只重新列出这些目录并做差量更新；
+// 新出现的子目录在后台线程单独扫描，消失的子目录整棵移除。build/、工程文件、隐藏目录不进索引。
+class ProjectFileIndex : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProjectFileIndex(QObject *parent = nullptr);
+    ~ProjectFileIndex() override;
+
+    void setRootDir(const QString &rootDir); // 空串表示关闭工程，清空索引
+    QString rootDir() const;
+    bool isReady() const;
+
+    QStringList files() const; // 未排序
+    bool contains(const QString &relativePath) const;
+    int fileCount() const;
+
+signals:
+    void ready(); // 初次扫描完成，之前的 files() 不完整
+    void filesAdded(const QStringList &relativePaths);
+    void filesRemoved(const QStringList &relativePaths);
+
+private:
+    void addScanned(const QStringList &files, const QStringList &directories, QStringList *added);
+    void removeTree(const QString &dirRel, QStringList *removed);
+    void refreshDirectory(const QString &dirRel, QStringList *added, QStringList *removed);
+    void flushChangedDirectories();
+    void startSubtreeScan();
+    QString dirRelFor(const QString &absolutePath) const;
+    bool ignored(const QString &relativePath) const;
+
+    SourceScanner *scanner_;
+    QFileSystemWatcher *watcher_;
+    QTimer changeTimer_;
+    QRegularExpression ignoreRules_;
+    QString root_;
+    bool ready_ = false;
+    QHash<QString, QSet<QString>> filesByDir_; // 目录相对路径（根目录为空串，其余以 "/" 结尾）-> 文件名
+    QSet<QString> files_;
+    QSet<QString> changedDirs_;
+    // 新出现的子目录在后台线程里扫描，一次只跑一批，其余的排队
+    QThread *subtreeThread_ = nullptr;
+    std::atomic<bool> subtreeCancelled_{false};
+    int generation_ = 0; // setRootDir 时递增，丢弃切换前发出的子目录扫描结果
+    QStringList pendingSubtrees_;
+    QSet<QString> scanningSubtrees_; // 排队中和扫描中的子目录，避免重复扫描
+};
@@ -1,5 +1,6 @@
 #include "ProjectManager.h"
 
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -7,9 +8,87 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QProcess>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QThread>
+
+#include "ProjectFileIndex.h"
+#include "SourceScanner.h"
+
+#include <algorithm>
+
+namespace {
+// 插桩模式的默认参数。sanitizer 和 --coverage 都要同时用于编译和链接，
+// 模式参数本来就会带到链接命令上，这里不需要额外处理。
+BuildProfile defaultInstrumentedProfile(const QString &name) {
+    BuildProfile profile;
+    if (name == QLatin1String("ASan")) {
+        profile.instrumentation = BuildProfile::AddressSanitizer;
+        profile.flags = {"-g", "-O1", "-fno-omit-frame-pointer", "-fsanitize=address"};
+    } else if (name == QLatin1String("UBSan")) {
+        profile.instrumentation = BuildProfile::UndefinedSanitizer;
+        profile.flags = {"-g", "-O1", "-fno-omit-frame-pointer", "-fsanitize=undefined"};
+    } else if (name == QLatin1String("TSan")) {
+        // TSan 不能和 ASan 同时使用，所以各自是独立的模式
+        profile.instrumentation = BuildProfile::ThreadSanitizer;
+        profile.flags = {"-g", "-O1", "-fsanitize=thread"};
+    } else if (name == QLatin1String("Coverage")) {
+        // gcc 和 clang 都支持 --coverage 生成 gcov 格式的数据，clang 下用 llvm-cov gcov 读取
+        profile.instrumentation = BuildProfile::Coverage;
+        profile.flags = {"-g", "-O0", "--coverage"};
+    }
+    return profile;
+}
+
+BuildProfile profileFromJson(const QJsonObject &obj) {
+    BuildProfile profile;
+    profile.outputName = obj.value("output").toString();
+    for (const auto &f : obj.value("flags").toArray()) {
+        profile.flags.append(f.toString());
+    }
+    profile.unityBuild = obj.value("unity").toBool(false);
+    profile.splitDwarf = obj.value("splitDwarf").toBool(false);
+    profile.thinLto = obj.value("thinLto").toBool(false);
+    return profile;
+}
+
+QByteArray contentHash(const QByteArray &data) {
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+QJsonObject profileToJson(const BuildProfile &profile) {
+    QJsonObject obj;
+    obj.insert("output", profile.outputName);
+    QJsonArray flags;
+    for (const QString &f : profile.flags) {
+        flags.append(f);
+    }
+    obj.insert("flags", flags);
+    obj.insert("unity", profile.unityBuild);
+    obj.insert("splitDwarf", profile.splitDwarf);
+    obj.insert("thinLto", profile.thinLto);
+    return obj;
+}
+}
 
-ProjectManager::ProjectManager(QObject *parent) : QObject(parent) {}
+ProjectManager::ProjectManager(QObject *parent) : QObject(parent), fileIndex_(new ProjectFileIndex(this)) {
+    // 连续的修改（逐个添加文件、设置对话框里一串 setter）合并成一次写盘
+    saveTimer_.setSingleShot(true);
+    saveTimer_.setInterval(300);
+    connect(&saveTimer_, &QTimer::timeout, this, &ProjectManager::startAsyncSave);
+
+    // 索引自己会把一阵连续的目录变化攒成一批再报告
+    connect(fileIndex_, &ProjectFileIndex::ready, this, &ProjectManager::resolveGlobSources);
+    connect(fileIndex_, &ProjectFileIndex::filesAdded, this,
+            [this](const QStringList &files) { updateGlobSources(files, {}); });
+    connect(fileIndex_, &ProjectFileIndex::filesRemoved, this,
+            [this](const QStringList &files) { updateGlobSources({}, files); });
+}
+
+ProjectManager::~ProjectManager() {
+    flushPendingSave();
+    delete writer_;
+}
 
 bool ProjectManager::hasProject() const {
     return !projectFilePath_.isEmpty();
@@ -48,20 +127,49 @@ QString ProjectManager::activeBuildProfile() const {
 }
 
 QString ProjectManager::activeOutputName() const {
-    if (activeProfile_.compare("Release", Qt::CaseInsensitive) == 0) {
+    return outputNameFor(activeProfile_);
+}
+
+QStringList ProjectManager::activeExtraFlags() const {
+    return extraFlagsFor(activeProfile_);
+}
+
+QStringList ProjectManager::profileNames() const {
+    return QStringList{QStringLiteral("Debug"), QStringLiteral("Release")} + instrumentedProfileNames();
+}
+
+QStringList ProjectManager::instrumentedProfileNames() {
+    return {QStringLiteral("ASan"), QStringLiteral("UBSan"), QStringLiteral("TSan"), QStringLiteral("Coverage")};
+}
+
+QString ProjectManager::instrumentedProfileName(const QString &profile) const {
+    for (const QString &name : instrumentedProfileNames()) {
+        if (profile.compare(name, Qt::CaseInsensitive) == 0) {
+            return name;
+        }
+    }
+    return QString();
+}
+
+QString ProjectManager::outputNameFor(const QString &profile) const {
+    if (profile.compare("Release", Qt::CaseInsensitive) == 0) {
         return releaseProfile_.outputName.isEmpty() ? outputName_ : releaseProfile_.outputName;
     }
+    const QString instrumented = instrumentedProfileName(profile);
+    if (!instrumented.isEmpty()) {
+        // 插桩产物放在 build/<模式>/ 下，和 Debug/Release 的产物互不覆盖
+        const QString output = instrumentedProfiles_.value(instrumented).outputName;
+        return output.isEmpty() ? QStringLiteral("build/%1/%2").arg(instrumented, outputNameFor("Release")) : output;
+    }
     return debugProfile_.outputName.isEmpty() ? (outputName_ + "_debug") : debugProfile_.outputName;
 }
 
-QStringList ProjectManager::activeExtraFlags() const {
-    QStringList flags = extraFlags_;
-    if (activeProfile_.compare("Release", Qt::CaseInsensitive) == 0) {
-        flags += releaseProfile_.flags;
-    } else {
-        flags += debugProfile_.flags;
-    }
-    return flags;
+QStringList ProjectManager::extraFlagsFor(const QString &profile) const {
+    return extraFlags_ + profileFor(profile).flags;
+}
+
+bool ProjectManager::activeUnityBuild() const {
+    return profileFor(activeProfile_).unityBuild;
 }
 
 BuildProfile ProjectManager::debugProfile() const {
@@ -72,15 +180,46 @@ BuildProfile ProjectManager::releaseProfile() const {
     return releaseProfile_;
 }
 
+BuildProfile ProjectManager::profileFor(const QString &profile) const {
+    if (profile.compare("Release", Qt::CaseInsensitive) == 0) {
+        return releaseProfile_;
+    }
+    const QString instrumented = instrumentedProfileName(profile);
+    if (!instrumented.isEmpty()) {
+        return instrumentedProfiles_.contains(instrumented) ? instrumentedProfiles_.value(instrumented)
+                                                            : defaultInstrumentedProfile(instrumented);
+    }
+    return debugProfile_;
+}
+
 void ProjectManager::setDebugProfile(const BuildProfile &profile) {
     debugProfile_ = profile;
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setReleaseProfile(const BuildProfile &profile) {
     releaseProfile_ = profile;
     outputName_ = profile.outputName;
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
+}
+
+void ProjectManager::setProfile(const QString &name, const BuildProfile &profile) {
+    if (name.compare("Release", Qt::CaseInsensitive) == 0) {
+        setReleaseProfile(profile);
+        return;
+    }
+    const QString instrumented = instrumentedProfileName(name);
+    if (instrumented.isEmpty()) {
+        setDebugProfile(profile);
+        return;
+    }
+    BuildProfile stored = profile;
+    stored.instrumentation = defaultInstrumentedProfile(instrumented).instrumentation;
+    instrumentedProfiles_.insert(instrumented, stored);
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setActiveBuildProfile(const QString &profile) {
@@ -88,7 +227,7 @@ void ProjectManager::setActiveBuildProfile(const QString &profile) {
         return;
     }
     activeProfile_ = profile;
-    saveProject();
+    markModified();
 }
 
 QStringList ProjectManager::runArgs() const {
@@ -99,19 +238,194 @@ QString ProjectManager::runWorkingDir() const {
     return runWorkingDir_;
 }
 
+int ProjectManager::buildJobs() const {
+    return buildJobs_;
+}
+
+QString ProjectManager::pchHeader() const {
+    return pchHeader_;
+}
+
+QString ProjectManager::pchHeaderAbsolute() const {
+    return pchHeader_.isEmpty() ? QString() : resolveToAbsolute(pchHeader_);
+}
+
+int ProjectManager::unityBatchSize() const {
+    return unityBatchSize_;
+}
+
+QString ProjectManager::linker() const {
+    return linker_;
+}
+
 QStringList ProjectManager::sources() const {
-    return sources_;
+    if (globSources_.isEmpty()) {
+        return sources_;
+    }
+    QStringList all = sources_;
+    all.reserve(sources_.size() + globSources_.size());
+    for (const QString &src : globSources_) {
+        if (!sourceSet_.contains(src)) {
+            all.append(src);
+        }
+    }
+    return all;
 }
 
 QStringList ProjectManager::sourceFilesAbsolute() const {
+    const QStringList all = sources();
     QStringList abs;
-    abs.reserve(sources_.size());
-    for (const QString &src : sources_) {
+    abs.reserve(all.size());
+    for (const QString &src : all) {
         abs.append(resolveToAbsolute(src));
     }
     return abs;
 }
 
+QStringList ProjectManager::sourceGlobs() const {
+    return sourceGlobs_;
+}
+
+QStringList ProjectManager::sourceExcludes() const {
+    return sourceExcludes_;
+}
+
+int ProjectManager::globSourceCount() const {
+    return static_cast<int>(globSources_.size());
+}
+
+bool ProjectManager::sourcesPending() const {
+    return sourcesPending_;
+}
+
+ProjectFileIndex *ProjectManager::fileIndex() const {
+    return fileIndex_;
+}
+
+void ProjectManager::setSourceRules(const QStringList &globs, const QStringList &excludes) {
+    QStringList cleanGlobs;
+    for (const QString &glob : globs) {
+        if (!glob.trimmed().isEmpty() && !cleanGlobs.contains(glob.trimmed())) {
+            cleanGlobs.append(glob.trimmed());
+        }
+    }
+    QStringList cleanExcludes;
+    for (const QString &glob : excludes) {
+        if (!glob.trimmed().isEmpty() && !cleanExcludes.contains(glob.trimmed())) {
+            cleanExcludes.append(glob.trimmed());
+        }
+    }
+    if (cleanGlobs == sourceGlobs_ && cleanExcludes == sourceExcludes_) {
+        return;
+    }
+    sourceGlobs_ = cleanGlobs;
+    sourceExcludes_ = cleanExcludes;
+    markModified();
+    resolveGlobSources();
+}
+
+void ProjectManager::resolveGlobSources() {
+    if (!hasProject() || sourceGlobs_.isEmpty()) {
+        setGlobSources({});
+        finishPendingSources();
+        return;
+    }
+    sourceIncludeRx_ = SourceScanner::globToRegex(sourceGlobs_);
+    sourceExcludeRx_ = SourceScanner::globToRegex(sourceExcludes_);
+    if (!fileIndex_->isReady()) {
+        sourcesPending_ = true; // 索引扫完（ready）时再匹配
+        return;
+    }
+    QStringList files;
+    for (const QString &file : fileIndex_->files()) {
+        if (matchesSourceRules(file)) {
+            files.append(file);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    setGlobSources(files);
+    finishPendingSources();
+}
+
+void ProjectManager::updateGlobSources(const QStringList &added, const QStringList &removed) {
+    if (sourceGlobs_.isEmpty() || sourcesPending_) {
+        return;
+    }
+    QStringList addedSources;
+    QStringList removedSources;
+    for (const QString &file : removed) {
+        const auto it = std::lower_bound(globSources_.begin(), globSources_.end(), file);
+        if (it != globSources_.end() && *it == file) {
+            globSources_.erase(it);
+            if (!sourceSet_.contains(file)) {
+                removedSources.append(file);
+            }
+        }
+    }
+    for (const QString &file : added) {
+        if (!matchesSourceRules(file)) {
+            continue;
+        }
+        const auto it = std::lower_bound(globSources_.begin(), globSources_.end(), file);
+        if (it == globSources_.end() || *it != file) {
+            globSources_.insert(it, file);
+            if (!sourceSet_.contains(file)) {
+                addedSources.append(file);
+            }
+        }
+    }
+    if (!addedSources.isEmpty() || !removedSources.isEmpty()) {
+        markModified();
+        emit sourcesChanged(addedSources, removedSources);
+    }
+}
+
+bool ProjectManager::matchesSourceRules(const QString &relativePath) const {
+    // 空的排除规则编译成只匹配空串的表达式，不会误排除
+    return sourceIncludeRx_.match(relativePath).hasMatch() && !sourceExcludeRx_.match(relativePath).hasMatch();
+}
+
+void ProjectManager::setGlobSources(const QStringList &files) {
+    if (files == globSources_) {
+        return;
+    }
+    // 两个列表都已排序，归并一遍得出增减
+    QStringList added;
+    QStringList removed;
+    auto oldIt = globSources_.cbegin();
+    auto newIt = files.cbegin();
+    while (oldIt != globSources_.cend() || newIt != files.cend()) {
+        if (newIt == files.cend() || (oldIt != globSources_.cend() && *oldIt < *newIt)) {
+            if (!sourceSet_.contains(*oldIt)) {
+                removed.append(*oldIt);
+            }
+            ++oldIt;
+        } else if (oldIt == globSources_.cend() || *newIt < *oldIt) {
+            if (!sourceSet_.contains(*newIt)) {
+                added.append(*newIt);
+            }
+            ++newIt;
+        } else {
+            ++oldIt;
+            ++newIt;
+        }
+    }
+    globSources_ = files;
+    // 工程文件里只有规则，不会重写；compile_commands.json 会随源文件列表更新
+    markModified();
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        emit sourcesChanged(added, removed);
+    }
+}
+
+void ProjectManager::finishPendingSources() {
+    if (sourcesPending_) {
+        sourcesPending_ = false;
+        markModified(); // 补上等待期间跳过的 compile_commands.json，内容没变就不会写
+        emit sourcesReady();
+    }
+}
+
 QStringList ProjectManager::includeDirs() const {
     return includeDirs_;
 }
@@ -131,7 +445,7 @@ QVector<ProjectGroup> ProjectManager::groups() const {
 
 void ProjectManager::setGroups(const QVector<ProjectGroup> &groups) {
     groups_ = groups;
-    saveProject();
+    markModified();
 }
 
 bool ProjectManager::addGroup(const QString &name) {
@@ -144,7 +458,7 @@ bool ProjectManager::addGroup(const QString &name) {
         }
     }
     groups_.append(ProjectGroup{name.trimmed(), {}});
-    saveProject();
+    markModified();
     return true;
 }
 
@@ -152,7 +466,7 @@ bool ProjectManager::removeGroup(const QString &name) {
     for (int i = 0; i < groups_.size(); ++i) {
         if (groups_[i].name == name) {
             groups_.removeAt(i);
-            saveProject();
+            markModified();
             return true;
         }
     }
@@ -171,9 +485,8 @@ bool ProjectManager::addFileToGroup(const QString &groupName, const QString &fil
             }
             if (rel.endsWith(".cpp") || rel.endsWith(".cc") || rel.endsWith(".cxx")) {
                 addSourceFile(filePath);
-            } else {
-                saveProject();
             }
+            markModified();
             return true;
         }
     }
@@ -181,6 +494,7 @@ bool ProjectManager::addFileToGroup(const QString &groupName, const QString &fil
 }
 
 bool ProjectManager::createNewProject(const QString &rootDir, const QString &name) {
+    flushPendingSave();
     QDir dir(rootDir);
     if (!dir.exists() && !dir.mkpath(".")) {
         return false;
@@ -191,24 +505,38 @@ bool ProjectManager::createNewProject(const QString &rootDir, const QString &nam
     outputName_ = name;
     projectFilePath_ = dir.filePath(name + ".rcppide.json");
     sources_.clear();
+    sourceSet_.clear();
+    sourceGlobs_.clear();
+    sourceExcludes_.clear();
+    globSources_.clear();
+    fileIndex_->setRootDir(rootDir_);
+    finishPendingSources(); // 新工程没有规则，不用等索引
     includeDirs_.clear();
     extraFlags_.clear();
     groups_.clear();
     runArgs_.clear();
     runWorkingDir_.clear();
+    buildJobs_ = 0;
+    pchHeader_.clear();
+    unityBatchSize_ = 8;
+    linker_.clear();
     includeDirs_.append(".");
 
     ensureDefaultProfiles();
+    invalidateCompileCommands();
+    savedProject_.clear();
+    savedCommandsHash_.clear();
 
+    // 新工程第一次保存一定会写 compile_commands.json，projectChanged 由 saveProject 发出
     if (!saveProject()) {
         return false;
     }
     emit projectLoaded();
-    emit projectChanged();
     return true;
 }
 
 bool ProjectManager::openProject(const QString &projectFilePath) {
+    flushPendingSave();
     QFile file(projectFilePath);
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
         return false;
@@ -221,6 +549,17 @@ bool ProjectManager::openProject(const QString &projectFilePath) {
 
     projectFilePath_ = QFileInfo(projectFilePath).absoluteFilePath();
     rootDir_ = QFileInfo(projectFilePath_).absolutePath();
+    globSources_.clear();
+    fileIndex_->setRootDir(rootDir_);
+    resolveGlobSources();
+    // 以磁盘上现有的内容为基准：打开工程本身不写盘，之后内容真的变了才重写
+    savedProject_ = toJson();
+    invalidateCompileCommands();
+    savedCommandsHash_.clear();
+    QFile commands(QDir(rootDir_).filePath("compile_commands.json"));
+    if (commands.open(QFile::ReadOnly)) {
+        savedCommandsHash_ = contentHash(commands.readAll());
+    }
 
     emit projectLoaded();
     emit projectChanged();
@@ -231,33 +570,172 @@ bool ProjectManager::saveProject() {
     if (projectFilePath_.isEmpty()) {
         return false;
     }
+    saveTimer_.stop();
+    // 等后台那次写完，避免它晚于这次同步写入而覆盖成旧内容
+    waitForWriter();
+    const SaveSnapshot snapshot = takeSnapshot();
+    const QString failedPath = writeSnapshot(snapshot);
+    finishSave(snapshot, failedPath);
+    return failedPath.isEmpty();
+}
 
-    QFile file(projectFilePath_);
-    if (!file.open(QFile::WriteOnly | QFile::Text)) {
-        return false;
+void ProjectManager::beginTransaction() {
+    ++transactionDepth_;
+}
+
+void ProjectManager::commitTransaction() {
+    if (transactionDepth_ <= 0) {
+        return;
     }
-    file.write(toJson());
-    file.close();
+    if (--transactionDepth_ == 0 && modified_) {
+        saveTimer_.start();
+    }
+}
 
-    generateCompileCommands();
-    emit projectChanged();
-    return true;
+void ProjectManager::markModified() {
+    if (!hasProject()) {
+        return;
+    }
+    modified_ = true;
+    if (transactionDepth_ == 0) {
+        saveTimer_.start();
+    }
+}
+
+ProjectManager::SaveSnapshot ProjectManager::takeSnapshot() {
+    SaveSnapshot snapshot;
+    modified_ = false;
+    const QByteArray project = toJson();
+    if (project != savedProject_) {
+        snapshot.projectPath = projectFilePath_;
+        snapshot.project = project;
+        savedProject_ = project;
+    }
+    // 只有编译器、标准、include、源文件或当前模式的参数变了，生成的内容才会不同；
+    // 改分组、运行参数等不会重写 compile_commands.json，也就不会让 clangd 重新索引。
+    // 源文件还没扫完时先不写，扫描结果到了会再保存一次
+    if (sourcesPending_) {
+        return snapshot;
+    }
+    const QByteArray commands = compileCommandsJson();
+    const QByteArray commandsHash = contentHash(commands);
+    if (commandsHash != savedCommandsHash_) {
+        snapshot.commandsPath = QDir(rootDir_).filePath("compile_commands.json");
+        snapshot.commands = commands;
+        savedCommandsHash_ = commandsHash;
+    }
+    return snapshot;
+}
+
+QString ProjectManager::writeSnapshot(const SaveSnapshot &snapshot) {
+    // QSaveFile 先写临时文件再改名，写到一半崩溃也不会留下半个 JSON
+    const auto write = [](const QString &path, const QByteArray &data) {
+        QSaveFile file(path);
+        if (!file.open(QFile::WriteOnly)) {
+            return false;
+        }
+        file.write(data);
+        return file.commit();
+    };
+    if (!snapshot.projectPath.isEmpty() && !write(snapshot.projectPath, snapshot.project)) {
+        return snapshot.projectPath;
+    }
+    if (!snapshot.commandsPath.isEmpty() && !write(snapshot.commandsPath, snapshot.commands)) {
+        return snapshot.commandsPath;
+    }
+    return QString();
+}
+
+void ProjectManager::finishSave(const SaveSnapshot &snapshot, const QString &failedPath) {
+    if (!failedPath.isEmpty()) {
+        // 下次保存时重新写这两个文件
+        if (snapshot.projectPath == projectFilePath_) {
+            savedProject_.clear();
+        }
+        savedCommandsHash_.clear();
+        emit saveFailed(failedPath);
+        return;
+    }
+    if (!snapshot.commandsPath.isEmpty() && snapshot.commandsPath == QDir(rootDir_).filePath("compile_commands.json")) {
+        emit projectChanged();
+    }
+}
+
+void ProjectManager::startAsyncSave() {
+    if (!hasProject()) {
+        return;
+    }
+    if (writer_) {
+        saveAgain_ = true;
+        return;
+    }
+    const SaveSnapshot snapshot = takeSnapshot();
+    if (snapshot.projectPath.isEmpty() && snapshot.commandsPath.isEmpty()) {
+        return;
+    }
+    writer_ = QThread::create([this, snapshot]() {
+        const QString failedPath = writeSnapshot(snapshot);
+        QMetaObject::invokeMethod(this, [this, snapshot, failedPath]() {
+            writer_->wait();
+            writer_->deleteLater();
+            writer_ = nullptr;
+            finishSave(snapshot, failedPath);
+            if (saveAgain_) {
+                saveAgain_ = false;
+                startAsyncSave();
+            }
+        }, Qt::QueuedConnection);
+    });
+    writer_->start();
+}
+
+void ProjectManager::flushPendingSave() {
+    if (hasProject() && (modified_ || saveTimer_.isActive())) {
+        saveProject();
+    }
+    saveTimer_.stop();
+    modified_ = false;
+    waitForWriter();
+}
+
+void ProjectManager::waitForWriter() {
+    // 只等线程结束，清理仍由排队的回调完成
+    if (writer_) {
+        writer_->wait();
+    }
 }
 
 void ProjectManager::closeProject() {
+    flushPendingSave();
+    saveAgain_ = false;
+    transactionDepth_ = 0;
+    savedProject_.clear();
+    savedCommandsHash_.clear();
+    invalidateCompileCommands();
     rootDir_.clear();
     projectFilePath_.clear();
     projectName_.clear();
     outputName_.clear();
     sources_.clear();
+    sourceSet_.clear();
+    sourceGlobs_.clear();
+    sourceExcludes_.clear();
+    globSources_.clear();
+    sourcesPending_ = false;
+    fileIndex_->setRootDir(QString());
     includeDirs_.clear();
     extraFlags_.clear();
     groups_.clear();
     activeProfile_ = QStringLiteral("Debug");
     debugProfile_ = BuildProfile{};
     releaseProfile_ = BuildProfile{};
+    instrumentedProfiles_.clear();
     runArgs_.clear();
     runWorkingDir_.clear();
+    buildJobs_ = 0;
+    pchHeader_.clear();
+    unityBatchSize_ = 8;
+    linker_.clear();
     compiler_ = QStringLiteral("g++");
     cxxStandard_ = QStringLiteral("c++20");
 
@@ -270,11 +748,32 @@ bool ProjectManager::addSourceFile(const QString &filePath) {
         return false;
     }
     const QString normalized = normalizeToProjectRelative(filePath);
-    if (sources_.contains(normalized)) {
+    if (sourceSet_.contains(normalized)) {
         return true;
     }
     sources_.append(normalized);
-    return saveProject();
+    sourceSet_.insert(normalized);
+    markModified();
+    return true;
+}
+
+int ProjectManager::addSourceFiles(const QStringList &filePaths) {
+    if (!hasProject()) {
+        return 0;
+    }
+    int added = 0;
+    for (const QString &filePath : filePaths) {
+        const QString normalized = normalizeToProjectRelative(filePath);
+        if (!sourceSet_.contains(normalized)) {
+            sources_.append(normalized);
+            sourceSet_.insert(normalized);
+            ++added;
+        }
+    }
+    if (added > 0) {
+        markModified();
+    }
+    return added;
 }
 
 bool ProjectManager::addIncludeDir(const QString &dirPath) {
@@ -286,7 +785,9 @@ bool ProjectManager::addIncludeDir(const QString &dirPath) {
         return true;
     }
     includeDirs_.append(normalized);
-    return saveProject();
+    invalidateCompileCommands();
+    markModified();
+    return true;
 }
 
 void ProjectManager::setIncludeDirs(const QStringList &dirs) {
@@ -300,17 +801,20 @@ void ProjectManager::setIncludeDirs(const QStringList &dirs) {
     if (includeDirs_.isEmpty()) {
         includeDirs_.append(".");
     }
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setCompiler(const QString &compiler) {
     compiler_ = compiler.trimmed().isEmpty() ? QStringLiteral("g++") : compiler.trimmed();
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setCxxStandard(const QString &standard) {
     cxxStandard_ = standard.trimmed().isEmpty() ? QStringLiteral("c++20") : standard.trimmed();
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setOutputName(const QString &outputName) {
@@ -319,25 +823,46 @@ void ProjectManager::setOutputName(const QString &outputName) {
     if (debugProfile_.outputName.isEmpty()) {
         debugProfile_.outputName = outputName_ + "_debug";
     }
-    saveProject();
+    markModified();
 }
 
 void ProjectManager::setExtraFlags(const QStringList &flags) {
     extraFlags_ = flags;
-    saveProject();
+    invalidateCompileCommands();
+    markModified();
 }
 
 void ProjectManager::setRunArgs(const QStringList &args) {
     runArgs_ = args;
-    saveProject();
+    markModified();
 }
 
 void ProjectManager::setRunWorkingDir(const QString &dir) {
     runWorkingDir_ = normalizeToProjectRelative(dir);
-    saveProject();
+    markModified();
+}
+
+void ProjectManager::setBuildJobs(int jobs) {
+    buildJobs_ = qMax(0, jobs);
+    markModified();
+}
+
+void ProjectManager::setPchHeader(const QString &header) {
+    pchHeader_ = header.trimmed().isEmpty() ? QString() : normalizeToProjectRelative(header.trimmed());
+    markModified();
+}
+
+void ProjectManager::setUnityBatchSize(int size) {
+    unityBatchSize_ = qMax(2, size);
+    markModified();
 }
 
-bool ProjectManager::generateCompileCommands(QString *errorMessage) const {
+void ProjectManager::setLinker(const QString &linker) {
+    linker_ = linker.trimmed();
+    markModified();
+}
+
+bool ProjectManager::generateCompileCommands(QString *errorMessage) {
     if (!hasProject()) {
         if (errorMessage) {
             *errorMessage = tr("没有打开工程");
@@ -345,41 +870,83 @@ bool ProjectManager::generateCompileCommands(QString *errorMessage) const {
         return false;
     }
 
-    const QString outputPath = QDir(rootDir_).filePath("compile_commands.json");
-    QFile file(outputPath);
-    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+    const QString path = QDir(rootDir_).filePath("compile_commands.json");
+    const QByteArray commands = compileCommandsJson();
+    const QByteArray hash = contentHash(commands);
+    // 内容没变就不碰文件，clangd 看不到修改时间变化也就不会重新扫描
+    if (hash == savedCommandsHash_ && QFileInfo::exists(path)) {
+        return true;
+    }
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly) || file.write(commands) < 0 || !file.commit()) {
         if (errorMessage) {
             *errorMessage = tr("无法写入 compile_commands.json");
         }
         return false;
     }
+    savedCommandsHash_ = hash;
+    return true;
+}
 
-    QJsonArray commands;
-    const QStringList absIncludes = includeDirsAbsolute();
+void ProjectManager::invalidateCompileCommands() {
+    commandTemplates_.clear();
+    commandEntries_.clear();
+}
 
-    for (const QString &src : sources_) {
+QStringList ProjectManager::commandTemplate(const QString &profile) const {
+    const auto cached = commandTemplates_.constFind(profile);
+    if (cached != commandTemplates_.constEnd()) {
+        return cached.value();
+    }
+    QStringList args{compiler_, "-std=" + cxxStandard_, QStringLiteral("-Wall")};
+    for (const QString &inc : includeDirsAbsolute()) {
+        args << "-I" + inc;
+    }
+    args << extraFlagsFor(profile);
+    commandTemplates_.insert(profile, args);
+    return args;
+}
+
+QByteArray ProjectManager::compileCommandsJson() const {
+    // 每个源文件一行紧凑的 JSON 对象。条目文本按模式缓存，模板不变时只为新增的源文件生成条目；
+    // 用 arguments 数组而不是 command 字符串，clangd 不需要再按 shell 规则切分
+    const QString profile = activeBuildProfile();
+    const QStringList prefix = commandTemplate(profile);
+    const QHash<QString, QByteArray> previous = commandEntries_.value(profile);
+    const QStringList all = sources();
+    QHash<QString, QByteArray> entries;
+    entries.reserve(all.size());
+
+    QByteArray out("[\n");
+    bool first = true;
+    for (const QString &src : all) {
         const QString absSrc = resolveToAbsolute(src);
-        QString cmd = quoteIfNeeded(compiler_);
-        cmd += " -std=" + cxxStandard_ + " -Wall";
-        for (const QString &inc : absIncludes) {
-            cmd += " -I" + quoteIfNeeded(inc);
+        QByteArray entry = previous.value(absSrc);
+        if (entry.isEmpty()) {
+            QJsonArray arguments;
+            for (const QString &arg : prefix) {
+                arguments.append(arg);
+            }
+            arguments.append(QStringLiteral("-c"));
+            arguments.append(absSrc);
+
+            QJsonObject obj;
+            obj.insert("directory", rootDir_);
+            obj.insert("file", absSrc);
+            obj.insert("arguments", arguments);
+            entry = QJsonDocument(obj).toJson(QJsonDocument::Compact);
         }
-        const QStringList flags = activeExtraFlags();
-        for (const QString &flag : flags) {
-            cmd += " " + flag;
+        entries.insert(absSrc, entry);
+        if (!first) {
+            out += ",\n";
         }
-        cmd += " -c " + quoteIfNeeded(absSrc);
-
-        QJsonObject entry;
-        entry.insert("directory", rootDir_);
-        entry.insert("file", absSrc);
-        entry.insert("command", cmd);
-        commands.append(entry);
+        first = false;
+        out += "  " + entry;
     }
-
-    QJsonDocument doc(commands);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    return true;
+    out += "\n]\n";
+    // 已移出工程的源文件不再保留
+    commandEntries_.insert(profile, entries);
+    return out;
 }
 
 bool ProjectManager::downloadRusticLibrary(QString *errorMessage) {
@@ -458,8 +1025,21 @@ bool ProjectManager::loadFromJson(const QByteArray &data, QString *errorMessage)
     cxxStandard_ = obj.value("cxxStandard").toString("c++20");
 
     sources_.clear();
+    sourceSet_.clear();
     for (const auto &value : obj.value("sources").toArray()) {
-        sources_.append(value.toString());
+        const QString src = value.toString();
+        if (!sourceSet_.contains(src)) {
+            sources_.append(src);
+            sourceSet_.insert(src);
+        }
+    }
+    sourceGlobs_.clear();
+    for (const auto &value : obj.value("sourceGlobs").toArray()) {
+        sourceGlobs_.append(value.toString());
+    }
+    sourceExcludes_.clear();
+    for (const auto &value : obj.value("sourceExcludes").toArray()) {
+        sourceExcludes_.append(value.toString());
     }
 
     includeDirs_.clear();
@@ -475,18 +1055,16 @@ bool ProjectManager::loadFromJson(const QByteArray &data, QString *errorMessage)
     activeProfile_ = obj.value("activeProfile").toString(QStringLiteral("Debug"));
     debugProfile_ = BuildProfile{};
     releaseProfile_ = BuildProfile{};
+    instrumentedProfiles_.clear();
     const QJsonObject profilesObj = obj.value("profiles").toObject();
     if (!profilesObj.isEmpty()) {
-        const QJsonObject dbgObj = profilesObj.value("Debug").toObject();
-        debugProfile_.outputName = dbgObj.value("output").toString();
-        for (const auto &f : dbgObj.value("flags").toArray()) {
-            debugProfile_.flags.append(f.toString());
-        }
-
-        const QJsonObject relObj = profilesObj.value("Release").toObject();
-        releaseProfile_.outputName = relObj.value("output").toString();
-        for (const auto &f : relObj.value("flags").toArray()) {
-            releaseProfile_.flags.append(f.toString());
+        debugProfile_ = profileFromJson(profilesObj.value("Debug").toObject());
+        releaseProfile_ = profileFromJson(profilesObj.value("Release").toObject());
+        // 旧工程文件里没有插桩模式，缺的由 ensureDefaultProfiles 补上默认值
+        for (const QString &name : instrumentedProfileNames()) {
+            if (profilesObj.contains(name)) {
+                instrumentedProfiles_.insert(name, profileFromJson(profilesObj.value(name).toObject()));
+            }
         }
     }
 
@@ -508,6 +1086,10 @@ bool ProjectManager::loadFromJson(const QByteArray &data, QString *errorMessage)
         runArgs_.append(value.toString());
     }
     runWorkingDir_ = obj.value("runWorkingDir").toString();
+    buildJobs_ = qMax(0, obj.value("buildJobs").toInt(0));
+    pchHeader_ = obj.value("pchHeader").toString();
+    unityBatchSize_ = qMax(2, obj.value("unityBatchSize").toInt(8));
+    linker_ = obj.value("linker").toString();
     if (includeDirs_.isEmpty()) {
         includeDirs_.append(".");
     }
@@ -532,23 +1114,11 @@ QByteArray ProjectManager::toJson() const {
 
     obj.insert("activeProfile", activeProfile_);
     QJsonObject profilesObj;
-    QJsonObject dbgObj;
-    dbgObj.insert("output", debugProfile_.outputName);
-    QJsonArray dbgFlags;
-    for (const QString &f : debugProfile_.flags) {
-        dbgFlags.append(f);
-    }
-    dbgObj.insert("flags", dbgFlags);
-    profilesObj.insert("Debug", dbgObj);
-
-    QJsonObject relObj;
-    relObj.insert("output", releaseProfile_.outputName);
-    QJsonArray relFlags;
-    for (const QString &f : releaseProfile_.flags) {
-        relFlags.append(f);
-    }
-    relObj.insert("flags", relFlags);
-    profilesObj.insert("Release", relObj);
+    profilesObj.insert("Debug", profileToJson(debugProfile_));
+    profilesObj.insert("Release", profileToJson(releaseProfile_));
+    for (auto it = instrumentedProfiles_.cbegin(); it != instrumentedProfiles_.cend(); ++it) {
+        profilesObj.insert(it.key(), profileToJson(it.value()));
+    }
     obj.insert("profiles", profilesObj);
 
     QJsonArray runArgs;
@@ -557,6 +1127,10 @@ QByteArray ProjectManager::toJson() const {
     }
     obj.insert("runArgs", runArgs);
     obj.insert("runWorkingDir", runWorkingDir_);
+    obj.insert("buildJobs", buildJobs_);
+    obj.insert("pchHeader", pchHeader_);
+    obj.insert("unityBatchSize", unityBatchSize_);
+    obj.insert("linker", linker_);
 
     QJsonArray sources;
     for (const QString &src : sources_) {
@@ -564,6 +1138,17 @@ QByteArray ProjectManager::toJson() const {
     }
     obj.insert("sources", sources);
 
+    QJsonArray globs;
+    for (const QString &glob : sourceGlobs_) {
+        globs.append(glob);
+    }
+    obj.insert("sourceGlobs", globs);
+    QJsonArray excludes;
+    for (const QString &glob : sourceExcludes_) {
+        excludes.append(glob);
+    }
+    obj.insert("sourceExcludes", excludes);
+
     QJsonArray includes;
     for (const QString &inc : includeDirs_) {
         includes.append(inc);
@@ -587,13 +1172,6 @@ QByteArray ProjectManager::toJson() const {
     return doc.toJson(QJsonDocument::Indented);
 }
 
-QString ProjectManager::quoteIfNeeded(const QString &value) const {
-    if (value.contains(' ')) {
-        return QStringLiteral("\"") + value + QStringLiteral("\"");
-    }
-    return value;
-}
-
 void ProjectManager::ensureDefaultProfiles() {
     if (releaseProfile_.outputName.isEmpty()) {
         releaseProfile_.outputName = outputName_.isEmpty() ? projectName_ : outputName_;
@@ -604,6 +1182,14 @@ void ProjectManager::ensureDefaultProfiles() {
     if (debugProfile_.flags.isEmpty()) {
         debugProfile_.flags = {QStringLiteral("-g"), QStringLiteral("-O0")};
     }
+    for (const QString &name : instrumentedProfileNames()) {
+        const BuildProfile defaults = defaultInstrumentedProfile(name);
+        BuildProfile &profile = instrumentedProfiles_[name];
+        profile.instrumentation = defaults.instrumentation;
+        if (profile.flags.isEmpty()) {
+            profile.flags = defaults.flags;
+        }
+    }
     if (activeProfile_.isEmpty()) {
         activeProfile_ = QStringLiteral("Debug");
     }
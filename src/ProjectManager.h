@@ -1,18 +1,32 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTimer>
 
 #include <QStringList>
 #include <QVector>
 
+class ProjectFileIndex;
+class QThread;
+
 struct ProjectGroup {
     QString name;
     QStringList files;
 };
 
 struct BuildProfile {
+    // 插桩模式：名称固定（ASan/UBSan/TSan/Coverage），运行结束后 IDE 据此解析报告或收集覆盖率
+    enum Instrumentation { None, AddressSanitizer, UndefinedSanitizer, ThreadSanitizer, Coverage };
+
     QString outputName;
     QStringList flags;
+    bool unityBuild = false;
+    bool splitDwarf = false; // -gsplit-dwarf：调试信息拆到 .dwo，链接时不再搬运
+    bool thinLto = false;    // clang 用 -flto=thin，gcc 用并行的 -flto=auto
+    Instrumentation instrumentation = None; // 由模式名决定，不写入工程文件
 };
 
 class ProjectManager : public QObject {
@@ -20,12 +34,17 @@ class ProjectManager : public QObject {
 
 public:
     explicit ProjectManager(QObject *parent = nullptr);
+    ~ProjectManager() override;
 
     bool createNewProject(const QString &rootDir, const QString &name);
     bool openProject(const QString &projectFilePath);
-    bool saveProject();
+    bool saveProject(); // 立即同步写盘；平时的修改由延迟保存合并后在后台线程写入
     void closeProject();
 
+    // 批量修改：begin/commit 之间的 setter 只改内存，commit 时合并成一次保存。可以嵌套。
+    void beginTransaction();
+    void commitTransaction();
+
     bool hasProject() const;
     QString rootDir() const;
     QString projectName() const;
@@ -38,17 +57,36 @@ public:
     QString activeBuildProfile() const;
     QString activeOutputName() const;
     QStringList activeExtraFlags() const;
+    bool activeUnityBuild() const;
+    QStringList profileNames() const;
+    QString outputNameFor(const QString &profile) const;
+    QStringList extraFlagsFor(const QString &profile) const;
 
     BuildProfile debugProfile() const;
     BuildProfile releaseProfile() const;
+    BuildProfile profileFor(const QString &profile) const;
     void setDebugProfile(const BuildProfile &profile);
     void setReleaseProfile(const BuildProfile &profile);
+    void setProfile(const QString &name, const BuildProfile &profile);
+    static QStringList instrumentedProfileNames();
     void setActiveBuildProfile(const QString &profile);
     QStringList runArgs() const;
     QString runWorkingDir() const;
+    int buildJobs() const;
+    QString pchHeader() const;
+    QString pchHeaderAbsolute() const;
+    int unityBatchSize() const;
+    QString linker() const;
 
-    QStringList sources() const;
+    QStringList sources() const; // 显式添加的源文件加上 glob 规则匹配到的
     QStringList sourceFilesAbsolute() const;
+    QStringList sourceGlobs() const;
+    QStringList sourceExcludes() const;
+    int globSourceCount() const;
+    // 打开工程后文件索引第一次扫描完成之前 sources() 还不完整，编译应等 sourcesReady()
+    bool sourcesPending() const;
+    // 工程目录下全部文件的索引，glob 规则和工程树共用它的一次扫描和目录监视
+    ProjectFileIndex *fileIndex() const;
 
     QStringList includeDirs() const;
     QStringList includeDirsAbsolute() const;
@@ -60,6 +98,9 @@ public:
     bool addFileToGroup(const QString &groupName, const QString &filePath);
 
     bool addSourceFile(const QString &filePath);
+    int addSourceFiles(const QStringList &filePaths); // 返回新加入的个数，只保存一次
+    // glob 规则相对工程根目录，如 src/**/*.cpp；在 fileIndex() 上匹配，随索引的增删自动更新
+    void setSourceRules(const QStringList &globs, const QStringList &excludes);
     bool addIncludeDir(const QString &dirPath);
     void setIncludeDirs(const QStringList &dirs);
 
@@ -69,23 +110,54 @@ public:
     void setExtraFlags(const QStringList &flags);
     void setRunArgs(const QStringList &args);
     void setRunWorkingDir(const QString &dir);
+    void setBuildJobs(int jobs);
+    void setPchHeader(const QString &header);
+    void setUnityBatchSize(int size);
+    void setLinker(const QString &linker);
 
-    bool generateCompileCommands(QString *errorMessage = nullptr) const;
+    bool generateCompileCommands(QString *errorMessage = nullptr); // 内容未变时不写文件
     bool downloadRusticLibrary(QString *errorMessage = nullptr);
 
 signals:
     void projectLoaded();
     void projectClosed();
-    void projectChanged();
+    void projectChanged(); // 打开/关闭工程，或 compile_commands.json 内容变化之后
+    // glob 规则匹配到的源文件有增减；参数是 sources() 里新增/消失的相对路径（显式添加的不在其中）
+    void sourcesChanged(const QStringList &added, const QStringList &removed);
+    void sourcesReady();   // sourcesPending() 变回 false
+    void saveFailed(const QString &path);
 
 private:
     QString normalizeToProjectRelative(const QString &path) const;
     QString resolveToAbsolute(const QString &path) const;
     bool loadFromJson(const QByteArray &data, QString *errorMessage);
     QByteArray toJson() const;
-    QString quoteIfNeeded(const QString &value) const;
+    QByteArray compileCommandsJson() const;
+    QStringList commandTemplate(const QString &profile) const;
+    void invalidateCompileCommands(); // 编译器、标准、include 或模式参数变化时调用
 
     void ensureDefaultProfiles();
+    void resolveGlobSources(); // 打开工程或规则变化后在整个索引上重新匹配
+    void updateGlobSources(const QStringList &added, const QStringList &removed);
+    bool matchesSourceRules(const QString &relativePath) const;
+    void setGlobSources(const QStringList &files);
+    void finishPendingSources();
+    QString instrumentedProfileName(const QString &profile) const;
+
+    // 一次保存要写的内容，在 GUI 线程生成；内容没变的文件留空，不写
+    struct SaveSnapshot {
+        QString projectPath;
+        QByteArray project;
+        QString commandsPath;
+        QByteArray commands;
+    };
+    void markModified();
+    SaveSnapshot takeSnapshot();
+    static QString writeSnapshot(const SaveSnapshot &snapshot); // 返回写失败的文件，成功时为空
+    void finishSave(const SaveSnapshot &snapshot, const QString &failedPath);
+    void startAsyncSave();
+    void flushPendingSave(); // 切换/关闭工程前把待保存的修改写完
+    void waitForWriter();
 
     QString rootDir_;
     QString projectFilePath_;
@@ -94,14 +166,39 @@ private:
     QString compiler_ = QStringLiteral("g++");
     QString cxxStandard_ = QStringLiteral("c++20");
     QStringList sources_;
+    QSet<QString> sourceSet_; // sources_ 的查重集合
+    QStringList sourceGlobs_;
+    QStringList sourceExcludes_;
+    QStringList globSources_; // 规则匹配结果，相对路径，已排序
+    QRegularExpression sourceIncludeRx_;
+    QRegularExpression sourceExcludeRx_;
+    bool sourcesPending_ = false;
     QStringList includeDirs_;
     QStringList extraFlags_;
 
     QString activeProfile_ = QStringLiteral("Debug");
     BuildProfile debugProfile_;
     BuildProfile releaseProfile_;
+    QHash<QString, BuildProfile> instrumentedProfiles_; // ASan/UBSan/TSan/Coverage
 
     QVector<ProjectGroup> groups_;
     QStringList runArgs_;
     QString runWorkingDir_;
+    int buildJobs_ = 0;
+    QString pchHeader_;
+    int unityBatchSize_ = 8;
+    QString linker_; // mold / lld / gold，为空表示编译器默认的链接器
+
+    ProjectFileIndex *fileIndex_;
+    QTimer saveTimer_;
+    QThread *writer_ = nullptr;
+    int transactionDepth_ = 0;
+    bool modified_ = false;  // 有还没交给写盘的修改
+    bool saveAgain_ = false; // 写盘线程忙时又到了保存时间
+    QByteArray savedProject_;  // 最近一次写入（或读入）的工程文件内容
+    QByteArray savedCommandsHash_; // 最近一次写入（或读入）的 compile_commands.json 的哈希
+
+    // compile_commands.json 的增量生成：模式 -> 源文件之前的公共参数；模式 -> 绝对路径 -> 条目 JSON 文本
+    mutable QHash<QString, QStringList> commandTemplates_;
+    mutable QHash<QString, QHash<QString, QByteArray>> commandEntries_;
 };
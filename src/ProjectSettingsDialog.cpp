@@ -2,6 +2,7 @@
 
 #include "ProjectManager.h"
 
+#include <QCheckBox>
 #include <QComboBox>
 #include <QFileDialog>
 #include <QFormLayout>
@@ -10,6 +11,7 @@
 #include <QLineEdit>
 #include <QListWidget>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QTabWidget>
 #include <QTextEdit>
 #include <QVBoxLayout>
@@ -23,9 +25,27 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     standardCombo_ = new QComboBox(this);
     standardCombo_->addItems({"c++17", "c++20", "c++23"});
     activeProfileCombo_ = new QComboBox(this);
-    activeProfileCombo_->addItems({"Debug", "Release"});
+    activeProfileCombo_->addItems(manager_ ? manager_->profileNames() : QStringList{"Debug", "Release"});
     runArgsEdit_ = new QLineEdit(this);
     runDirEdit_ = new QLineEdit(this);
+    jobsSpin_ = new QSpinBox(this);
+    jobsSpin_->setRange(0, 256);
+    jobsSpin_->setSpecialValueText(tr("自动(CPU 核心数)"));
+    pchEdit_ = new QLineEdit(this);
+    pchEdit_->setPlaceholderText(tr("留空表示不使用预编译头，例如：include/rustic.hpp"));
+    auto *btnPch = new QPushButton(tr("浏览..."), this);
+    connect(btnPch, &QPushButton::clicked, this, &ProjectSettingsDialog::browsePchHeader);
+    auto *pchLayout = new QHBoxLayout();
+    pchLayout->addWidget(pchEdit_);
+    pchLayout->addWidget(btnPch);
+    unityBatchSpin_ = new QSpinBox(this);
+    unityBatchSpin_->setRange(2, 256);
+    linkerCombo_ = new QComboBox(this);
+    linkerCombo_->addItem(tr("编译器默认"), QString());
+    linkerCombo_->addItem(QStringLiteral("mold"), QStringLiteral("mold"));
+    linkerCombo_->addItem(QStringLiteral("lld"), QStringLiteral("lld"));
+    linkerCombo_->addItem(QStringLiteral("gold"), QStringLiteral("gold"));
+    linkerCombo_->setToolTip(tr("编译前会先试链接一次，所选链接器不可用时自动退回默认链接器"));
 
     auto *form = new QFormLayout();
     form->addRow(tr("编译器："), compilerEdit_);
@@ -33,6 +53,10 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     form->addRow(tr("当前编译模式："), activeProfileCombo_);
     form->addRow(tr("运行参数："), runArgsEdit_);
     form->addRow(tr("运行工作目录："), runDirEdit_);
+    form->addRow(tr("并行编译任务数："), jobsSpin_);
+    form->addRow(tr("预编译头："), pchLayout);
+    form->addRow(tr("Unity 每批文件数："), unityBatchSpin_);
+    form->addRow(tr("链接器："), linkerCombo_);
 
     includeList_ = new QListWidget(this);
     auto *btnAddInc = new QPushButton(tr("添加目录..."), this);
@@ -56,6 +80,13 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     auto *flagsLayout = new QVBoxLayout(flagsGroup);
     flagsLayout->addWidget(flagsEdit_);
 
+    sourceRulesEdit_ = new QTextEdit(this);
+    sourceRulesEdit_->setPlaceholderText(tr("每行一条 glob 规则，相对工程目录；以 ! 开头表示排除\n例如：\nsrc/**/*.cpp\n!build/**"));
+    sourceRulesEdit_->setToolTip(tr("* 不跨目录，** 匹配任意层目录。匹配到的源文件自动加入工程，目录变化时自动更新"));
+    auto *rulesGroup = new QGroupBox(tr("源文件规则"), this);
+    auto *rulesLayout = new QVBoxLayout(rulesGroup);
+    rulesLayout->addWidget(sourceRulesEdit_);
+
     profileTabs_ = new QTabWidget(this);
     auto *debugTab = new QWidget(profileTabs_);
     auto *releaseTab = new QWidget(profileTabs_);
@@ -66,6 +97,12 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     auto *debugForm = new QFormLayout(debugTab);
     debugForm->addRow(tr("Debug 输出名："), debugOutputEdit_);
     debugForm->addRow(tr("Debug 额外参数："), debugFlagsEdit_);
+    debugUnityCheck_ = new QCheckBox(tr("使用 Unity 构建（合并源文件批量编译）"), debugTab);
+    debugForm->addRow(QString(), debugUnityCheck_);
+    debugSplitDwarfCheck_ = new QCheckBox(tr("拆分调试信息 (-gsplit-dwarf)，加快链接"), debugTab);
+    debugForm->addRow(QString(), debugSplitDwarfCheck_);
+    debugThinLtoCheck_ = new QCheckBox(tr("启用 Thin LTO（clang 为 -flto=thin，gcc 为 -flto=auto）"), debugTab);
+    debugForm->addRow(QString(), debugThinLtoCheck_);
 
     releaseOutputEdit_ = new QLineEdit(releaseTab);
     releaseFlagsEdit_ = new QTextEdit(releaseTab);
@@ -73,9 +110,27 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     auto *releaseForm = new QFormLayout(releaseTab);
     releaseForm->addRow(tr("Release 输出名："), releaseOutputEdit_);
     releaseForm->addRow(tr("Release 额外参数："), releaseFlagsEdit_);
+    releaseUnityCheck_ = new QCheckBox(tr("使用 Unity 构建（合并源文件批量编译）"), releaseTab);
+    releaseForm->addRow(QString(), releaseUnityCheck_);
+    releaseSplitDwarfCheck_ = new QCheckBox(tr("拆分调试信息 (-gsplit-dwarf)，加快链接"), releaseTab);
+    releaseForm->addRow(QString(), releaseSplitDwarfCheck_);
+    releaseThinLtoCheck_ = new QCheckBox(tr("启用 Thin LTO（clang 为 -flto=thin，gcc 为 -flto=auto）"), releaseTab);
+    releaseForm->addRow(QString(), releaseThinLtoCheck_);
 
     profileTabs_->addTab(debugTab, tr("Debug"));
     profileTabs_->addTab(releaseTab, tr("Release"));
+    for (const QString &name : ProjectManager::instrumentedProfileNames()) {
+        auto *tab = new QWidget(profileTabs_);
+        ProfileEditors editors;
+        editors.output = new QLineEdit(tab);
+        editors.output->setPlaceholderText(tr("留空表示 build/%1/ 下与 Release 同名").arg(name));
+        editors.flags = new QTextEdit(tab);
+        auto *tabForm = new QFormLayout(tab);
+        tabForm->addRow(tr("%1 输出名：").arg(name), editors.output);
+        tabForm->addRow(tr("%1 额外参数：").arg(name), editors.flags);
+        instrumentedEditors_.insert(name, editors);
+        profileTabs_->addTab(tab, name);
+    }
     auto *profilesGroup = new QGroupBox(tr("编译模式配置"), this);
     auto *profilesLayout = new QVBoxLayout(profilesGroup);
     profilesLayout->addWidget(profileTabs_);
@@ -94,6 +149,7 @@ ProjectSettingsDialog::ProjectSettingsDialog(ProjectManager *manager, QWidget *p
     mainLayout->addLayout(form);
     mainLayout->addWidget(incGroup);
     mainLayout->addWidget(flagsGroup);
+    mainLayout->addWidget(rulesGroup);
     mainLayout->addWidget(profilesGroup);
     mainLayout->addLayout(btnLayout);
 
@@ -109,24 +165,43 @@ void ProjectSettingsDialog::loadFromProject() {
     activeProfileCombo_->setCurrentText(manager_->activeBuildProfile());
     runArgsEdit_->setText(manager_->runArgs().join(' '));
     runDirEdit_->setText(manager_->runWorkingDir());
+    jobsSpin_->setValue(manager_->buildJobs());
+    pchEdit_->setText(manager_->pchHeader());
+    unityBatchSpin_->setValue(manager_->unityBatchSize());
+    linkerCombo_->setCurrentIndex(qMax(0, linkerCombo_->findData(manager_->linker())));
 
     includeList_->clear();
     includeList_->addItems(manager_->includeDirs());
 
     flagsEdit_->setPlainText(manager_->extraFlags().join("\n"));
 
+    QStringList rules = manager_->sourceGlobs();
+    for (const QString &exclude : manager_->sourceExcludes()) {
+        rules << "!" + exclude;
+    }
+    sourceRulesEdit_->setPlainText(rules.join("\n"));
+
     const BuildProfile dbg = manager_->debugProfile();
     const BuildProfile rel = manager_->releaseProfile();
     debugOutputEdit_->setText(dbg.outputName);
     debugFlagsEdit_->setPlainText(dbg.flags.join("\n"));
+    debugUnityCheck_->setChecked(dbg.unityBuild);
+    debugSplitDwarfCheck_->setChecked(dbg.splitDwarf);
+    debugThinLtoCheck_->setChecked(dbg.thinLto);
     releaseOutputEdit_->setText(rel.outputName);
     releaseFlagsEdit_->setPlainText(rel.flags.join("\n"));
-
-    if (manager_->activeBuildProfile().compare("Release", Qt::CaseInsensitive) == 0) {
-        profileTabs_->setCurrentIndex(1);
-    } else {
-        profileTabs_->setCurrentIndex(0);
+    releaseUnityCheck_->setChecked(rel.unityBuild);
+    releaseSplitDwarfCheck_->setChecked(rel.splitDwarf);
+    releaseThinLtoCheck_->setChecked(rel.thinLto);
+
+    for (auto it = instrumentedEditors_.cbegin(); it != instrumentedEditors_.cend(); ++it) {
+        const BuildProfile profile = manager_->profileFor(it.key());
+        it.value().output->setText(profile.outputName);
+        it.value().flags->setPlainText(profile.flags.join("\n"));
     }
+
+    const int activeIndex = manager_->profileNames().indexOf(activeProfileCombo_->currentText());
+    profileTabs_->setCurrentIndex(qMax(0, activeIndex));
 }
 
 void ProjectSettingsDialog::addIncludeDir() {
@@ -144,18 +219,36 @@ void ProjectSettingsDialog::removeIncludeDir() {
     delete includeList_->takeItem(includeList_->currentRow());
 }
 
+void ProjectSettingsDialog::browsePchHeader() {
+    if (!manager_) {
+        return;
+    }
+    const QString file = QFileDialog::getOpenFileName(this, tr("选择预编译头"), manager_->rootDir(),
+                                                      tr("头文件 (*.h *.hh *.hpp *.hxx);;所有文件 (*)"));
+    if (file.isEmpty()) {
+        return;
+    }
+    pchEdit_->setText(file);
+}
+
 void ProjectSettingsDialog::applyAndClose() {
     if (!manager_) {
         reject();
         return;
     }
 
+    // 所有设置合并成一次保存，compile_commands.json 最多重写一次
+    manager_->beginTransaction();
     manager_->setCompiler(compilerEdit_->text());
     manager_->setCxxStandard(standardCombo_->currentText());
     manager_->setActiveBuildProfile(activeProfileCombo_->currentText());
 
     manager_->setRunArgs(runArgsEdit_->text().split(' ', Qt::SkipEmptyParts));
     manager_->setRunWorkingDir(runDirEdit_->text());
+    manager_->setBuildJobs(jobsSpin_->value());
+    manager_->setPchHeader(pchEdit_->text());
+    manager_->setUnityBatchSize(unityBatchSpin_->value());
+    manager_->setLinker(linkerCombo_->currentData().toString());
 
     QStringList dirs;
     for (int i = 0; i < includeList_->count(); ++i) {
@@ -166,15 +259,41 @@ void ProjectSettingsDialog::applyAndClose() {
     const QStringList flags = flagsEdit_->toPlainText().split('\n', Qt::SkipEmptyParts);
     manager_->setExtraFlags(flags);
 
+    QStringList globs;
+    QStringList excludes;
+    for (const QString &line : sourceRulesEdit_->toPlainText().split('\n', Qt::SkipEmptyParts)) {
+        const QString rule = line.trimmed();
+        if (rule.startsWith('!')) {
+            excludes << rule.mid(1).trimmed();
+        } else if (!rule.isEmpty()) {
+            globs << rule;
+        }
+    }
+    manager_->setSourceRules(globs, excludes);
+
     BuildProfile dbg = manager_->debugProfile();
     dbg.outputName = debugOutputEdit_->text().trimmed();
     dbg.flags = debugFlagsEdit_->toPlainText().split('\n', Qt::SkipEmptyParts);
+    dbg.unityBuild = debugUnityCheck_->isChecked();
+    dbg.splitDwarf = debugSplitDwarfCheck_->isChecked();
+    dbg.thinLto = debugThinLtoCheck_->isChecked();
     manager_->setDebugProfile(dbg);
 
     BuildProfile rel = manager_->releaseProfile();
     rel.outputName = releaseOutputEdit_->text().trimmed();
     rel.flags = releaseFlagsEdit_->toPlainText().split('\n', Qt::SkipEmptyParts);
+    rel.unityBuild = releaseUnityCheck_->isChecked();
+    rel.splitDwarf = releaseSplitDwarfCheck_->isChecked();
+    rel.thinLto = releaseThinLtoCheck_->isChecked();
     manager_->setReleaseProfile(rel);
 
+    for (auto it = instrumentedEditors_.cbegin(); it != instrumentedEditors_.cend(); ++it) {
+        BuildProfile profile = manager_->profileFor(it.key());
+        profile.outputName = it.value().output->text().trimmed();
+        profile.flags = it.value().flags->toPlainText().split('\n', Qt::SkipEmptyParts);
+        manager_->setProfile(it.key(), profile);
+    }
+    manager_->commitTransaction();
+
     accept();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QDialog>
+#include <QHash>
 
 class ProjectManager;
 class QListWidget;
@@ -9,6 +10,8 @@ class QComboBox;
 class QTextEdit;
 class QPushButton;
 class QTabWidget;
+class QSpinBox;
+class QCheckBox;
 
 class ProjectSettingsDialog : public QDialog {
     Q_OBJECT
@@ -19,6 +22,7 @@ public:
 private slots:
     void addIncludeDir();
     void removeIncludeDir();
+    void browsePchHeader();
     void applyAndClose();
 
 private:
@@ -32,9 +36,27 @@ private:
     QLineEdit *releaseOutputEdit_;
     QLineEdit *runArgsEdit_;
     QLineEdit *runDirEdit_;
+    QSpinBox *jobsSpin_;
+    QLineEdit *pchEdit_;
+    QSpinBox *unityBatchSpin_;
+    QCheckBox *debugUnityCheck_;
+    QCheckBox *releaseUnityCheck_;
+    QComboBox *linkerCombo_;
+    QCheckBox *debugSplitDwarfCheck_;
+    QCheckBox *debugThinLtoCheck_;
+    QCheckBox *releaseSplitDwarfCheck_;
+    QCheckBox *releaseThinLtoCheck_;
     QListWidget *includeList_;
     QTextEdit *flagsEdit_;
+    QTextEdit *sourceRulesEdit_;
     QTextEdit *debugFlagsEdit_;
     QTextEdit *releaseFlagsEdit_;
     QTabWidget *profileTabs_;
+
+    // ASan/UBSan/TSan/Coverage 等插桩模式只需要输出名和参数
+    struct ProfileEditors {
+        QLineEdit *output = nullptr;
+        QTextEdit *flags = nullptr;
+    };
+    QHash<QString, ProfileEditors> instrumentedEditors_;
 };
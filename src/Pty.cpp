@@ -0,0 +1,302 @@
+#include "Pty.h"
+
+#include <QFile>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace {
+// 每次可读通知最多读这么多就回到事件循环，输出洪水时界面仍能响应输入和重绘。
+constexpr int kReadChunk = 64 * 1024;
+constexpr int kMaxReadPerWake = 1024 * 1024;
+}
+
+Pty::Pty(QObject *parent) : QObject(parent) {}
+
+Pty::~Pty() {
+#ifdef Q_OS_UNIX
+    if (pid_ > 0) {
+        ::kill(static_cast<pid_t>(pid_), SIGKILL);
+        ::waitpid(static_cast<pid_t>(pid_), nullptr, 0);
+        pid_ = -1;
+    }
+    closeMaster();
+#endif
+    if (fallback_) {
+        fallback_->kill();
+        fallback_->waitForFinished(1000);
+    }
+}
+
+bool Pty::start(const QString &program, const QStringList &args, const QString &workingDirectory, int columns, int rows) {
+    if (isRunning()) {
+        return false;
+    }
+    errorString_.clear();
+#ifdef Q_OS_UNIX
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0) {
+        errorString_ = tr("无法创建伪终端：%1").arg(QString::fromLocal8Bit(strerror(errno)));
+        if (master >= 0) {
+            ::close(master);
+        }
+        return false;
+    }
+    const char *slaveName = ::ptsname(master);
+    if (!slaveName) {
+        errorString_ = tr("无法获取伪终端从设备名。");
+        ::close(master);
+        return false;
+    }
+    const QByteArray slavePath(slaveName);
+
+    struct winsize size {};
+    size.ws_col = static_cast<unsigned short>(columns);
+    size.ws_row = static_cast<unsigned short>(rows);
+    ::ioctl(master, TIOCSWINSZ, &size);
+
+    // fork 之后子进程里只能调用异步信号安全的函数，参数和环境变量都提前准备好。
+    QList<QByteArray> argStorage;
+    argStorage << QFile::encodeName(program);
+    for (const QString &arg : args) {
+        argStorage << arg.toLocal8Bit();
+    }
+    QVector<char *> argv;
+    for (QByteArray &arg : argStorage) {
+        argv << arg.data();
+    }
+    argv << nullptr;
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("TERM"), QStringLiteral("xterm-256color"));
+    env.insert(QStringLiteral("COLORTERM"), QStringLiteral("truecolor"));
+    env.insert(QStringLiteral("COLUMNS"), QString::number(columns));
+    env.insert(QStringLiteral("LINES"), QString::number(rows));
+    QList<QByteArray> envStorage;
+    for (const QString &entry : env.toStringList()) {
+        envStorage << entry.toLocal8Bit();
+    }
+    QVector<char *> envp;
+    for (QByteArray &entry : envStorage) {
+        envp << entry.data();
+    }
+    envp << nullptr;
+    const QByteArray workDir = QFile::encodeName(workingDirectory);
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        errorString_ = tr("无法启动终端进程：%1").arg(QString::fromLocal8Bit(strerror(errno)));
+        ::close(master);
+        return false;
+    }
+    if (pid == 0) {
+        ::setsid();
+        const int slave = ::open(slavePath.constData(), O_RDWR);
+        if (slave < 0) {
+            ::_exit(127);
+        }
+        ::ioctl(slave, TIOCSCTTY, 0);
+        ::dup2(slave, STDIN_FILENO);
+        ::dup2(slave, STDOUT_FILENO);
+        ::dup2(slave, STDERR_FILENO);
+        if (slave > STDERR_FILENO) {
+            ::close(slave);
+        }
+        ::close(master);
+        if (!workDir.isEmpty()) {
+            ::chdir(workDir.constData());
+        }
+        ::signal(SIGPIPE, SIG_DFL);
+        environ = envp.data();
+        ::execvp(argv.at(0), argv.data());
+        ::_exit(127);
+    }
+
+    pid_ = pid;
+    masterFd_ = master;
+    ::fcntl(masterFd_, F_SETFL, ::fcntl(masterFd_, F_GETFL) | O_NONBLOCK);
+    ::fcntl(masterFd_, F_SETFD, FD_CLOEXEC);
+    readNotifier_ = new QSocketNotifier(masterFd_, QSocketNotifier::Read, this);
+    connect(readNotifier_, &QSocketNotifier::activated, this, &Pty::readMaster);
+    writeNotifier_ = new QSocketNotifier(masterFd_, QSocketNotifier::Write, this);
+    writeNotifier_->setEnabled(false);
+    connect(writeNotifier_, &QSocketNotifier::activated, this, &Pty::flushWrites);
+    return true;
+#else
+    Q_UNUSED(columns)
+    Q_UNUSED(rows)
+    fallback_ = new QProcess(this);
+    fallback_->setProcessChannelMode(QProcess::MergedChannels);
+    fallback_->setWorkingDirectory(workingDirectory);
+    connect(fallback_, &QProcess::readyReadStandardOutput, this, [this]() {
+        emit dataReceived(fallback_->readAllStandardOutput());
+    });
+    connect(fallback_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this](int code, QProcess::ExitStatus) {
+                fallback_->deleteLater();
+                fallback_ = nullptr;
+                emit finished(code);
+            });
+    fallback_->start(program, args);
+    if (!fallback_->waitForStarted(3000)) {
+        errorString_ = fallback_->errorString();
+        fallback_->deleteLater();
+        fallback_ = nullptr;
+        return false;
+    }
+    return true;
+#endif
+}
+
+void Pty::write(const QByteArray &data) {
+    if (fallback_) {
+        fallback_->write(data);
+        return;
+    }
+    if (masterFd_ < 0 || data.isEmpty()) {
+        return;
+    }
+    writeBuffer_.append(data);
+    flushWrites();
+}
+
+void Pty::flushWrites() {
+#ifdef Q_OS_UNIX
+    while (!writeBuffer_.isEmpty() && masterFd_ >= 0) {
+        const ssize_t written = ::write(masterFd_, writeBuffer_.constData(), static_cast<size_t>(writeBuffer_.size()));
+        if (written > 0) {
+            writeBuffer_.remove(0, static_cast<int>(written));
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        break; // EAGAIN：tty 输入队列满了（例如粘贴大段文本），等可写通知再继续
+    }
+    if (writeNotifier_) {
+        writeNotifier_->setEnabled(!writeBuffer_.isEmpty());
+    }
+#endif
+}
+
+void Pty::readMaster() {
+#ifdef Q_OS_UNIX
+    QByteArray data;
+    bool closed = false;
+    while (data.size() < kMaxReadPerWake) {
+        const int offset = data.size();
+        data.resize(offset + kReadChunk);
+        const ssize_t n = ::read(masterFd_, data.data() + offset, kReadChunk);
+        const int error = errno;
+        if (n > 0) {
+            data.resize(offset + static_cast<int>(n));
+            continue;
+        }
+        data.resize(offset);
+        if (n < 0 && error == EINTR) {
+            continue;
+        }
+        // Linux 上从设备全部关闭后 read 返回 EIO 而不是 0
+        closed = n == 0 || (error != EAGAIN && error != EWOULDBLOCK);
+        break;
+    }
+    if (!data.isEmpty()) {
+        emit dataReceived(data);
+    }
+    if (closed) {
+        closeMaster();
+        reap();
+    }
+#endif
+}
+
+void Pty::closeMaster() {
+#ifdef Q_OS_UNIX
+    // 可能正处在通知器自己的 activated 信号里，不能直接 delete
+    for (QSocketNotifier *notifier : {readNotifier_, writeNotifier_}) {
+        if (notifier) {
+            notifier->setEnabled(false);
+            notifier->deleteLater();
+        }
+    }
+    readNotifier_ = nullptr;
+    writeNotifier_ = nullptr;
+    writeBuffer_.clear();
+    if (masterFd_ >= 0) {
+        ::close(masterFd_);
+        masterFd_ = -1;
+    }
+#endif
+}
+
+void Pty::reap() {
+#ifdef Q_OS_UNIX
+    if (pid_ <= 0) {
+        return;
+    }
+    int status = 0;
+    const pid_t result = ::waitpid(static_cast<pid_t>(pid_), &status, WNOHANG);
+    if (result == 0) {
+        // 终端已关闭但进程还没退出（比如忽略了 SIGHUP），稍后再收
+        QTimer::singleShot(100, this, &Pty::reap);
+        return;
+    }
+    pid_ = -1;
+    int exitCode = -1;
+    if (result > 0) {
+        exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    }
+    emit finished(exitCode);
+#endif
+}
+
+void Pty::resize(int columns, int rows) {
+#ifdef Q_OS_UNIX
+    if (masterFd_ < 0) {
+        return;
+    }
+    // 内核收到新的窗口大小后会给前台进程组发 SIGWINCH
+    struct winsize size {};
+    size.ws_col = static_cast<unsigned short>(columns);
+    size.ws_row = static_cast<unsigned short>(rows);
+    ::ioctl(masterFd_, TIOCSWINSZ, &size);
+#else
+    Q_UNUSED(columns)
+    Q_UNUSED(rows)
+#endif
+}
+
+void Pty::terminate() {
+    if (fallback_) {
+        fallback_->kill();
+        return;
+    }
+#ifdef Q_OS_UNIX
+    if (pid_ > 0) {
+        ::kill(-static_cast<pid_t>(pid_), SIGHUP);
+    }
+#endif
+}
+
+bool Pty::isRunning() const {
+    return pid_ > 0 || fallback_ != nullptr;
+}
+
+QString Pty::errorString() const {
+    return errorString_;
+}
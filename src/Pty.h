@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QStringList>
+
+class QProcess;
+class QSocketNotifier;
+
+// 伪终端上的子进程。shell 看到的是真正的 tty（isatty 为真、有窗口大小、行编辑和作业控制可用），
+// 而不是管道。没有 pty 的平台退回到 QProcess 管道，交互程序的表现会差一些。
+class Pty : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Pty(QObject *parent = nullptr);
+    ~Pty() override;
+
+    bool start(const QString &program, const QStringList &args, const QString &workingDirectory, int columns, int rows);
+    void write(const QByteArray &data);
+    void resize(int columns, int rows);
+    void terminate();
+    bool isRunning() const;
+    QString errorString() const;
+
+signals:
+    void dataReceived(const QByteArray &data);
+    void finished(int exitCode);
+
+private:
+    void readMaster();
+    void flushWrites();
+    void closeMaster();
+    void reap();
+
+    int masterFd_ = -1;
+    qint64 pid_ = -1;
+    QSocketNotifier *readNotifier_ = nullptr;
+    QSocketNotifier *writeNotifier_ = nullptr;
+    QByteArray writeBuffer_;
+    QProcess *fallback_ = nullptr;
+    QString errorString_;
+};
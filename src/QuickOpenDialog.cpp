@@ -0,0 +1,188 @@
+#include "QuickOpenDialog.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPainter>
+#include <QStyledItemDelegate>
+#include <QVBoxLayout>
+
+namespace {
+constexpr int kMaxResults = 100;
+constexpr int kPathRole = Qt::UserRole;          // 绝对路径
+constexpr int kPositionsRole = Qt::UserRole + 1; // 命中字符在显示文本里的下标
+
+// 先画 basename 再画所在目录（淡色），命中的字符加粗
+class MatchDelegate : public QStyledItemDelegate {
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override {
+        QStyleOptionViewItem opt = option;
+        initStyleOption(&opt, index);
+        const QString path = opt.text;
+        opt.text.clear();
+        const QWidget *widget = opt.widget;
+        QStyle *style = widget ? widget->style() : QApplication::style();
+        style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+        QVector<bool> matched(static_cast<int>(path.size()), false);
+        const QVariantList positions = index.data(kPositionsRole).toList();
+        for (const QVariant &position : positions) {
+            const int i = position.toInt();
+            if (i >= 0 && i < matched.size()) {
+                matched[i] = true;
+            }
+        }
+
+        const bool selected = opt.state.testFlag(QStyle::State_Selected);
+        const QColor textColor = opt.palette.color(selected ? QPalette::HighlightedText : QPalette::Text);
+        QColor dimColor = textColor;
+        dimColor.setAlphaF(0.6);
+        QFont boldFont = opt.font;
+        boldFont.setBold(true);
+
+        painter->save();
+        painter->setClipRect(opt.rect);
+        const QRect textRect = opt.rect.adjusted(6, 0, -6, 0);
+        int x = textRect.left();
+        const auto drawRange = [&](int from, int to, const QColor &color) {
+            painter->setPen(color);
+            while (from < to) {
+                int end = from + 1;
+                while (end < to && matched[end] == matched[from]) {
+                    ++end;
+                }
+                const QFont &font = matched[from] ? boldFont : opt.font;
+                const QString run = path.mid(from, end - from);
+                painter->setFont(font);
+                painter->drawText(QRect(x, textRect.top(), textRect.right() - x, textRect.height()),
+                                  Qt::AlignLeft | Qt::AlignVCenter, run);
+                x += QFontMetrics(font).horizontalAdvance(run);
+                from = end;
+            }
+        };
+        const int slash = static_cast<int>(path.lastIndexOf('/'));
+        drawRange(slash + 1, static_cast<int>(path.size()), textColor);
+        if (slash > 0) {
+            x += QFontMetrics(opt.font).horizontalAdvance(QStringLiteral("   "));
+            drawRange(0, slash, dimColor);
+        }
+        painter->restore();
+    }
+};
+}
+
+QuickOpenDialog::QuickOpenDialog(QWidget *parent) : QDialog(parent) {
+    setWindowTitle(tr("转到文件"));
+    setModal(false);
+
+    queryEdit_ = new QLineEdit(this);
+    queryEdit_->setPlaceholderText(tr("输入文件名或路径片段，例如 mwcpp"));
+    queryEdit_->installEventFilter(this);
+    resultList_ = new QListWidget(this);
+    resultList_->setItemDelegate(new MatchDelegate(resultList_));
+    resultList_->setUniformItemSizes(true);
+    resultList_->setFocusPolicy(Qt::NoFocus);
+    statusLabel_ = new QLabel(this);
+
+    connect(queryEdit_, &QLineEdit::textChanged, this, &QuickOpenDialog::refresh);
+    connect(resultList_, &QListWidget::itemActivated, this, &QuickOpenDialog::choose);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(queryEdit_);
+    layout->addWidget(resultList_);
+    layout->addWidget(statusLabel_);
+    resize(640, 420);
+}
+
+void QuickOpenDialog::setFiles(const QString &rootDir, const QStringList &paths) {
+    rootDir_ = rootDir;
+    index_.setPaths(paths);
+    if (isVisible()) {
+        refresh();
+    }
+}
+
+void QuickOpenDialog::popup() {
+    if (QWidget *owner = parentWidget()) {
+        const QRect area = owner->geometry();
+        move(area.left() + (area.width() - width()) / 2, area.top() + 80);
+    }
+    refresh();
+    show();
+    raise();
+    activateWindow();
+    queryEdit_->setFocus();
+    queryEdit_->selectAll();
+}
+
+bool QuickOpenDialog::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == queryEdit_ && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent *>(event);
+        switch (keyEvent->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QApplication::sendEvent(resultList_, event);
+            return true;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            choose();
+            return true;
+        default:
+            break;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+void QuickOpenDialog::refresh() {
+    const QString query = queryEdit_->text();
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<FuzzyPathIndex::Match> matches = index_.match(query, kMaxResults);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    const QDir root(rootDir_);
+    resultList_->setUpdatesEnabled(false);
+    resultList_->clear();
+    for (const FuzzyPathIndex::Match &match : matches) {
+        const QString &path = index_.paths().at(match.index);
+        QVariantList positions;
+        for (int position : index_.matchPositions(match.index, query)) {
+            positions.append(position);
+        }
+        auto *item = new QListWidgetItem(path, resultList_);
+        item->setData(kPathRole, root.absoluteFilePath(path));
+        item->setData(kPositionsRole, positions);
+        item->setToolTip(path);
+    }
+    if (resultList_->count() > 0) {
+        resultList_->setCurrentRow(0);
+    }
+    resultList_->setUpdatesEnabled(true);
+
+    if (index_.size() == 0) {
+        statusLabel_->setText(tr("没有可打开的文件（打开工程后可按路径查找工程里的全部文件）"));
+    } else if (matches.isEmpty()) {
+        statusLabel_->setText(tr("共 %1 个文件，没有匹配项").arg(index_.size()));
+    } else {
+        statusLabel_->setText(tr("共 %1 个文件，匹配用时 %2 ms").arg(index_.size()).arg(elapsedMs, 0, 'f', 2));
+    }
+}
+
+void QuickOpenDialog::choose() {
+    QListWidgetItem *item = resultList_->currentItem();
+    if (!item) {
+        return;
+    }
+    const QString path = item->data(kPathRole).toString();
+    hide();
+    emit fileChosen(path);
+}
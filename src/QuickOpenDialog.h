@@ -0,0 +1,38 @@
+#pragma once
+
+#include "FuzzyPathIndex.h"
+
+#include <QDialog>
+
+class QLabel;
+class QLineEdit;
+class QListWidget;
+
+// Ctrl+P “转到文件”：输入框每改一次就在 FuzzyPathIndex 里重新匹配，列出前若干条并高亮命中的字符。
+// 上下键/翻页键在输入框里直接移动结果列表的当前行，回车打开。
+class QuickOpenDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit QuickOpenDialog(QWidget *parent = nullptr);
+
+    // paths 是相对 rootDir 的路径（工程外的文件可以是绝对路径），为空的查询按这个顺序列出
+    void setFiles(const QString &rootDir, const QStringList &paths);
+    void popup();
+
+signals:
+    void fileChosen(const QString &absolutePath);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void refresh();
+    void choose();
+
+    FuzzyPathIndex index_;
+    QString rootDir_;
+    QLineEdit *queryEdit_ = nullptr;
+    QListWidget *resultList_ = nullptr;
+    QLabel *statusLabel_ = nullptr;
+};
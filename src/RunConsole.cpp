@@ -0,0 +1,289 @@
+#include "RunConsole.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QDir>
+#include <QFileDialog>
+#include <QFontMetrics>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QMessageBox>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QVBoxLayout>
+
+#include "RunOutputLog.h"
+#include "RunSession.h"
+
+#include <utility>
+
+namespace {
+constexpr int kStatusIntervalMs = 500;
+constexpr int kMaxCopyLines = 100000;
+constexpr int kTextMargin = 4;
+
+QString formatBytes(double bytes) {
+    if (bytes >= 1024.0 * 1024 * 1024) {
+        return QStringLiteral("%1 GB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+    }
+    if (bytes >= 1024.0 * 1024) {
+        return QStringLiteral("%1 MB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    }
+    if (bytes >= 1024.0) {
+        return QStringLiteral("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QStringLiteral("%1 B").arg(static_cast<qint64>(bytes));
+}
+}
+
+RunConsole::RunConsole(RunSession *session, QWidget *parent) : QWidget(parent), session_(session) {
+    view_ = new RunLogView(&session_->log(), this);
+    statusLabel_ = new QLabel(tr("尚未运行"), this);
+    stopButton_ = new QPushButton(tr("停止"), this);
+    stopButton_->setEnabled(false);
+    saveButton_ = new QPushButton(tr("保存输出..."), this);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(statusLabel_, 1);
+    bar->addWidget(saveButton_);
+    bar->addWidget(stopButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(view_);
+
+    statusTimer_.setInterval(kStatusIntervalMs);
+    connect(&statusTimer_, &QTimer::timeout, this, &RunConsole::updateStatus);
+    connect(stopButton_, &QPushButton::clicked, session_, &RunSession::stop);
+    connect(saveButton_, &QPushButton::clicked, this, &RunConsole::saveOutput);
+    connect(session_, &RunSession::started, this, [this]() {
+        exitText_.clear();
+        lastBytes_ = 0;
+        lastSampleMs_ = 0;
+        bytesPerSecond_ = 0;
+        stopButton_->setEnabled(true);
+        statusTimer_.start();
+        view_->refresh();
+        updateStatus();
+    });
+    connect(session_, &RunSession::outputAppended, view_, &RunLogView::refresh);
+    connect(session_, &RunSession::finished, this, [this](int exitCode, QProcess::ExitStatus status) {
+        exitText_ = status == QProcess::NormalExit ? tr("已退出，退出码 %1").arg(exitCode) : tr("异常终止");
+        stopButton_->setEnabled(false);
+        statusTimer_.stop();
+        updateStatus();
+    });
+}
+
+void RunConsole::updateStatus() {
+    const RunOutputLog &log = session_->log();
+    const qint64 elapsed = session_->elapsedMs();
+    const qint64 bytes = log.byteCount();
+    QString text;
+    if (session_->isRunning()) {
+        // 吞吐率按最近一个采样周期计算，反映的是当前速度而不是平均值
+        const qint64 dt = elapsed - lastSampleMs_;
+        if (dt > 0) {
+            bytesPerSecond_ = (bytes - lastBytes_) * 1000.0 / dt;
+        }
+        lastBytes_ = bytes;
+        lastSampleMs_ = elapsed;
+        text = tr("运行中    用时 %1 s    输出 %2    %3/s")
+                   .arg(elapsed / 1000.0, 0, 'f', 1)
+                   .arg(formatBytes(bytes), formatBytes(bytesPerSecond_));
+    } else if (!exitText_.isEmpty()) {
+        const double average = elapsed > 0 ? bytes * 1000.0 / elapsed : 0;
+        text = tr("%1    用时 %2 s    输出 %3    平均 %4/s")
+                   .arg(exitText_)
+                   .arg(elapsed / 1000.0, 0, 'f', 2)
+                   .arg(formatBytes(bytes), formatBytes(average));
+    } else {
+        text = tr("尚未运行");
+    }
+    if (log.isSpilled()) {
+        text += tr("    （%1 行，较早的输出已转存到磁盘）").arg(log.lineCount());
+    }
+    statusLabel_->setText(text);
+    statusLabel_->setToolTip(session_->commandLine());
+}
+
+void RunConsole::saveOutput() {
+    const QString path = QFileDialog::getSaveFileName(this, tr("保存运行输出"), QDir::homePath() + "/run_output.log",
+                                                      tr("日志文件 (*.log *.txt);;所有文件 (*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!session_->log().saveTo(path)) {
+        QMessageBox::warning(this, tr("保存失败"), tr("无法写入：%1").arg(path));
+    }
+}
+
+RunLogView::RunLogView(const RunOutputLog *log, QWidget *parent) : QAbstractScrollArea(parent), log_(log) {
+    QFont font;
+    font.setFamily("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setPointSize(11);
+    setFont(font);
+    const QFontMetrics metrics(font);
+    lineHeight_ = qMax(1, metrics.height());
+    charWidth_ = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+    ascent_ = metrics.ascent();
+
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    verticalScrollBar()->setSingleStep(1);
+    horizontalScrollBar()->setSingleStep(charWidth_ * 4);
+    updateScrollBars();
+}
+
+void RunLogView::refresh() {
+    if (log_->lineCount() == 0) {
+        selectionAnchor_ = selectionEnd_ = -1;
+        widestLine_ = 0;
+        followOutput_ = true;
+    }
+    updateScrollBars();
+    viewport()->update();
+}
+
+int RunLogView::visibleRows() const {
+    return qMax(1, viewport()->height() / lineHeight_);
+}
+
+void RunLogView::updateScrollBars() {
+    const bool follow = followOutput_;
+    QScrollBar *vbar = verticalScrollBar();
+    vbar->setPageStep(visibleRows());
+    vbar->setRange(0, qMax(0, log_->lineCount() - visibleRows()));
+    if (follow) {
+        vbar->setValue(vbar->maximum());
+    }
+    followOutput_ = follow || vbar->value() == vbar->maximum();
+
+    QScrollBar *hbar = horizontalScrollBar();
+    hbar->setPageStep(viewport()->width());
+    hbar->setRange(0, qMax(0, widestLine_ * charWidth_ + 2 * kTextMargin - viewport()->width()));
+}
+
+void RunLogView::scrollContentsBy(int dx, int dy) {
+    Q_UNUSED(dx)
+    Q_UNUSED(dy)
+    followOutput_ = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+    viewport()->update();
+}
+
+void RunLogView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void RunLogView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    QPainter painter(viewport());
+    painter.setFont(font());
+    painter.fillRect(viewport()->rect(), palette().color(QPalette::Base));
+
+    const int first = verticalScrollBar()->value();
+    const int count = log_->lineCount();
+    const int rows = visibleRows() + 1;
+    const int x = kTextMargin - horizontalScrollBar()->value();
+    const int selFirst = qMin(selectionAnchor_, selectionEnd_);
+    const int selLast = qMax(selectionAnchor_, selectionEnd_);
+    int widest = widestLine_;
+    for (int i = 0; i < rows && first + i < count; ++i) {
+        const int index = first + i;
+        QString text = log_->line(index);
+        text.replace(QLatin1Char('\t'), QStringLiteral("    "));
+        widest = qMax(widest, static_cast<int>(text.size()));
+        const int y = i * lineHeight_;
+        if (selFirst >= 0 && index >= selFirst && index <= selLast) {
+            painter.fillRect(0, y, viewport()->width(), lineHeight_, palette().color(QPalette::Highlight));
+            painter.setPen(palette().color(QPalette::HighlightedText));
+        } else {
+            painter.setPen(palette().color(QPalette::Text));
+        }
+        painter.drawText(x, y + ascent_, text);
+    }
+    if (widest != widestLine_) {
+        // 不能在绘制过程中改滚动条范围，留到事件循环下一轮
+        widestLine_ = widest;
+        QTimer::singleShot(0, this, &RunLogView::updateScrollBars);
+    }
+}
+
+int RunLogView::lineAt(const QPoint &pos) const {
+    const int index = verticalScrollBar()->value() + pos.y() / lineHeight_;
+    return qBound(0, index, qMax(0, log_->lineCount() - 1));
+}
+
+void RunLogView::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || log_->lineCount() == 0) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    selectionAnchor_ = lineAt(event->pos());
+    if (!(event->modifiers() & Qt::ShiftModifier) || selectionEnd_ < 0) {
+        selectionEnd_ = selectionAnchor_;
+    } else {
+        std::swap(selectionAnchor_, selectionEnd_);
+        selectionEnd_ = lineAt(event->pos());
+    }
+    viewport()->update();
+}
+
+void RunLogView::mouseMoveEvent(QMouseEvent *event) {
+    if (!(event->buttons() & Qt::LeftButton) || selectionAnchor_ < 0) {
+        return;
+    }
+    selectionEnd_ = lineAt(event->pos());
+    if (event->pos().y() < 0) {
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - 1);
+    } else if (event->pos().y() > viewport()->height()) {
+        verticalScrollBar()->setValue(verticalScrollBar()->value() + 1);
+    }
+    viewport()->update();
+}
+
+QString RunLogView::selectedText() const {
+    if (selectionAnchor_ < 0) {
+        return {};
+    }
+    const int first = qMin(selectionAnchor_, selectionEnd_);
+    const int last = qMin(qMax(selectionAnchor_, selectionEnd_), first + kMaxCopyLines - 1);
+    QStringList lines;
+    for (int i = first; i <= last; ++i) {
+        lines << log_->line(i);
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+void RunLogView::keyPressEvent(QKeyEvent *event) {
+    if (event->matches(QKeySequence::Copy)) {
+        const QString text = selectedText();
+        if (!text.isEmpty()) {
+            QApplication::clipboard()->setText(text);
+        }
+        return;
+    }
+    if (event->matches(QKeySequence::SelectAll) && log_->lineCount() > 0) {
+        selectionAnchor_ = 0;
+        selectionEnd_ = log_->lineCount() - 1;
+        viewport()->update();
+        return;
+    }
+    if (event->key() == Qt::Key_Home && (event->modifiers() & Qt::ControlModifier)) {
+        verticalScrollBar()->setValue(0);
+        return;
+    }
+    if (event->key() == Qt::Key_End && (event->modifiers() & Qt::ControlModifier)) {
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        return;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
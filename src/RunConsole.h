@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QTimer>
+#include <QWidget>
+
+class QLabel;
+class QPushButton;
+class RunOutputLog;
+class RunSession;
+class RunLogView;
+
+// 运行控制台：显示 RunSession 收集的输出以及运行时长、输出量和吞吐率。
+class RunConsole : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit RunConsole(RunSession *session, QWidget *parent = nullptr);
+
+private:
+    void updateStatus();
+    void saveOutput();
+
+    RunSession *session_;
+    RunLogView *view_;
+    QLabel *statusLabel_;
+    QPushButton *stopButton_;
+    QPushButton *saveButton_;
+    QTimer statusTimer_;
+    QString exitText_;
+    qint64 lastBytes_ = 0;
+    qint64 lastSampleMs_ = 0;
+    double bytesPerSecond_ = 0;
+};
+
+// 按行号直接从 RunOutputLog 取数据绘制的只读视图：只有可见的几十行会被解码和排版，
+// 滚动到已转存到磁盘的位置时由 RunOutputLog 按页读回。
+class RunLogView : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    explicit RunLogView(const RunOutputLog *log, QWidget *parent = nullptr);
+
+    void refresh(); // 日志有新增后调用
+    QString selectedText() const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    int visibleRows() const;
+    int lineAt(const QPoint &pos) const;
+    void updateScrollBars();
+
+    const RunOutputLog *log_;
+    int lineHeight_ = 16;
+    int charWidth_ = 8;
+    int ascent_ = 12;
+    int widestLine_ = 0; // 画过的最长行的字符数，决定水平滚动范围
+    bool followOutput_ = true;
+    int selectionAnchor_ = -1; // 按整行选择
+    int selectionEnd_ = -1;
+};
@@ -0,0 +1,227 @@
+#include "RunOutputLog.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+#include <limits>
+
+namespace {
+constexpr int kPageLines = 256;
+constexpr int kCachedPages = 32;
+constexpr int kTrimBatch = 1024;          // 内存窗口超出后一次丢弃的行数，避免逐行移动
+constexpr int kMaxLineBytes = 64 * 1024;  // 没有换行的超长输出按这个长度强制折行
+
+QString decodeLine(const QByteArray &bytes) {
+    return QString::fromLocal8Bit(bytes);
+}
+}
+
+RunOutputLog::RunOutputLog(qint64 spillThreshold, int memoryLines)
+    : spillThreshold_(spillThreshold), memoryLines_(qMax(kPageLines, memoryLines)) {}
+
+RunOutputLog::~RunOutputLog() = default;
+
+void RunOutputLog::clear() {
+    window_.clear();
+    newLines_.clear();
+    windowFirst_ = 0;
+    completeLines_ = 0;
+    partial_.clear();
+    bytes_ = 0;
+    memoryBytes_ = 0;
+    file_.reset();
+    fileSize_ = 0;
+    checkpoints_.clear();
+    pageCache_.clear();
+    pageOrder_.clear();
+}
+
+void RunOutputLog::append(const QByteArray &data) {
+    bytes_ += data.size();
+    int start = 0;
+    while (start < data.size()) {
+        const int newline = data.indexOf('\n', start);
+        if (newline < 0) {
+            partial_.append(data.constData() + start, data.size() - start);
+            while (partial_.size() >= kMaxLineBytes) {
+                addLine(partial_.left(kMaxLineBytes));
+                partial_.remove(0, kMaxLineBytes);
+            }
+            break;
+        }
+        if (partial_.isEmpty()) {
+            addLine(data.mid(start, newline - start));
+        } else {
+            partial_.append(data.constData() + start, newline - start);
+            addLine(partial_);
+            partial_.clear();
+        }
+        start = newline + 1;
+    }
+}
+
+void RunOutputLog::finish() {
+    if (!partial_.isEmpty()) {
+        addLine(partial_);
+        partial_.clear();
+    }
+    if (file_) {
+        file_->flush();
+    }
+}
+
+QStringList RunOutputLog::takeNewLines() {
+    QStringList lines;
+    lines.swap(newLines_);
+    return lines;
+}
+
+void RunOutputLog::addLine(const QByteArray &bytes) {
+    QByteArray text = bytes;
+    if (text.endsWith('\r')) {
+        text.chop(1);
+    }
+    if (file_) {
+        writeLine(text);
+    }
+    const QString line = decodeLine(text);
+    window_.append(line);
+    newLines_.append(line);
+    memoryBytes_ += text.size();
+    ++completeLines_;
+
+    if (!file_ && (memoryBytes_ > spillThreshold_ || window_.size() > memoryLines_)) {
+        spill();
+    }
+    if (window_.size() > memoryLines_ + kTrimBatch) {
+        // 已经转存到文件的行可以放心丢弃；转存失败时只能真的丢掉，line() 对它们返回空串
+        window_.erase(window_.begin(), window_.begin() + kTrimBatch);
+        windowFirst_ += kTrimBatch;
+    }
+}
+
+void RunOutputLog::writeLine(const QByteArray &bytes) {
+    // 调用时 completeLines_ 还是这一行的行号
+    if (completeLines_ % kPageLines == 0) {
+        checkpoints_.append(fileSize_);
+    }
+    file_->write(bytes);
+    file_->write("\n", 1);
+    fileSize_ += bytes.size() + 1;
+}
+
+void RunOutputLog::spill() {
+    auto file = std::make_unique<QTemporaryFile>(QDir(QDir::tempPath()).filePath("rcppide_run_XXXXXX.log"));
+    if (!file->open()) {
+        spillThreshold_ = std::numeric_limits<qint64>::max();
+        return;
+    }
+    file_ = std::move(file);
+    // 转存之前所有行都还在内存里（windowFirst_ 为 0），按行号依次写出并记录页偏移
+    const int total = completeLines_;
+    completeLines_ = 0;
+    for (const QString &text : window_) {
+        writeLine(text.toLocal8Bit());
+        ++completeLines_;
+    }
+    completeLines_ = total;
+}
+
+const QStringList &RunOutputLog::page(int pageIndex) const {
+    auto it = pageCache_.find(pageIndex);
+    if (it != pageCache_.end()) {
+        return it.value();
+    }
+    QStringList lines;
+    if (file_ && pageIndex < checkpoints_.size()) {
+        file_->flush();
+        if (file_->seek(checkpoints_.at(pageIndex))) {
+            while (lines.size() < kPageLines && !file_->atEnd()) {
+                QByteArray bytes = file_->readLine();
+                if (bytes.endsWith('\n')) {
+                    bytes.chop(1);
+                }
+                lines.append(decodeLine(bytes));
+            }
+        }
+        file_->seek(fileSize_);
+    }
+    if (pageOrder_.size() >= kCachedPages) {
+        pageCache_.remove(pageOrder_.takeFirst());
+    }
+    pageOrder_.append(pageIndex);
+    return pageCache_.insert(pageIndex, lines).value();
+}
+
+int RunOutputLog::lineCount() const {
+    return completeLines_ + (partial_.isEmpty() ? 0 : 1);
+}
+
+QString RunOutputLog::line(int index) const {
+    if (index < 0) {
+        return {};
+    }
+    if (index >= completeLines_) {
+        if (index == completeLines_ && !partial_.isEmpty()) {
+            QByteArray text = partial_;
+            if (text.endsWith('\r')) {
+                text.chop(1);
+            }
+            return decodeLine(text);
+        }
+        return {};
+    }
+    if (index >= windowFirst_) {
+        return window_.at(index - windowFirst_);
+    }
+    if (!file_) {
+        return {};
+    }
+    const int pageIndex = index / kPageLines;
+    const int offset = index % kPageLines;
+    if (offset >= page(pageIndex).size()) {
+        // 缓存时这一页还没写满，重新读一次
+        pageCache_.remove(pageIndex);
+        pageOrder_.removeAll(pageIndex);
+    }
+    const QStringList &lines = page(pageIndex);
+    return offset < lines.size() ? lines.at(offset) : QString();
+}
+
+qint64 RunOutputLog::byteCount() const {
+    return bytes_;
+}
+
+bool RunOutputLog::isSpilled() const {
+    return file_ != nullptr;
+}
+
+QString RunOutputLog::spillPath() const {
+    return file_ ? file_->fileName() : QString();
+}
+
+bool RunOutputLog::saveTo(const QString &path) const {
+    QFile::remove(path);
+    if (file_) {
+        file_->flush();
+        if (!QFile::copy(file_->fileName(), path)) {
+            return false;
+        }
+        if (partial_.isEmpty()) {
+            return true;
+        }
+        QFile out(path);
+        return out.open(QIODevice::Append) && out.write(partial_) == partial_.size();
+    }
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    for (const QString &text : window_) {
+        out.write(text.toLocal8Bit());
+        out.write("\n", 1);
+    }
+    out.write(partial_);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+class QTemporaryFile;
+
+// 运行输出的按行存储。输出量不大时全部放在内存里；超过阈值后把全部内容转存到临时文件，
+// 内存中只保留最新的一段行，更早的行在界面滚动到时再按页从文件读回（带少量页缓存）。
+class RunOutputLog {
+public:
+    explicit RunOutputLog(qint64 spillThreshold = 8 * 1024 * 1024, int memoryLines = 20000);
+    ~RunOutputLog();
+
+    void clear();
+    void append(const QByteArray &data);
+    void finish(); // 进程结束：末尾不完整的行也算作一行
+    // 上次取走之后新完成的行。边运行边解析输出的一方按周期取走，不必回头按行号重读日志
+    QStringList takeNewLines();
+
+    int lineCount() const; // 包括末尾尚未换行的部分
+    QString line(int index) const;
+    qint64 byteCount() const;
+    bool isSpilled() const;
+    QString spillPath() const;
+    bool saveTo(const QString &path) const;
+
+private:
+    void addLine(const QByteArray &bytes);
+    void spill();
+    void writeLine(const QByteArray &bytes);
+    const QStringList &page(int pageIndex) const;
+
+    qint64 spillThreshold_;
+    int memoryLines_;
+    QStringList window_;     // 最新的若干完整行
+    QStringList newLines_;   // 与 window_ 共享字符串数据，takeNewLines 时清空
+    int windowFirst_ = 0;    // window_[0] 的行号
+    int completeLines_ = 0;
+    QByteArray partial_;
+    qint64 bytes_ = 0;
+    qint64 memoryBytes_ = 0;
+
+    std::unique_ptr<QTemporaryFile> file_;
+    qint64 fileSize_ = 0;
+    QVector<qint64> checkpoints_; // 第 i 项是第 i*kPageLines 行在文件中的偏移
+
+    mutable QHash<int, QStringList> pageCache_;
+    mutable QList<int> pageOrder_;
+};
@@ -0,0 +1,215 @@
+#include "RunSession.h"
+
+#include <QSocketNotifier>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 每 50ms 最多接收 4MB（约 80MB/s）。上限之外的输出留在管道里，由内核阻塞子进程。
+constexpr int kTickMs = 50;
+constexpr qint64 kBytesPerTick = 4 * 1024 * 1024;
+constexpr qint64 kReadChunk = 64 * 1024;
+constexpr qint64 kMaxDrainBytes = 16 * 1024 * 1024;
+}
+
+RunSession::RunSession(QObject *parent) : QObject(parent) {
+    tickTimer_.setInterval(kTickMs);
+    connect(&tickTimer_, &QTimer::timeout, this, &RunSession::tick);
+    connect(&process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            &RunSession::handleFinished);
+    connect(&process_, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+        log_.append(tr("无法启动：%1\n").arg(process_.errorString()).toLocal8Bit());
+        handleFinished(-1, QProcess::CrashExit);
+    });
+#ifndef Q_OS_UNIX
+    connect(&process_, &QProcess::readyReadStandardOutput, this, [this]() { readOutput(false); });
+#endif
+}
+
+RunSession::~RunSession() {
+    if (isRunning()) {
+        process_.killGroup();
+        process_.waitForFinished(1000);
+    }
+    closePipe();
+}
+
+bool RunSession::start(const QString &program, const QStringList &args, const QString &workingDirectory) {
+    if (isRunning()) {
+        return false;
+    }
+    log_.clear();
+    commandLine_ = QStringList(QStringList{program} + args).join(' ');
+    process_.setProgram(program);
+    process_.setArguments(args);
+    process_.setWorkingDirectory(workingDirectory);
+
+#ifdef Q_OS_UNIX
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        log_.append(tr("无法创建输出管道。\n").toLocal8Bit());
+        return false;
+    }
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC); // dup2 到 1/2 之后的副本不带 CLOEXEC
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    readFd_ = fds[0];
+    process_.setStandardOutputFile(QProcess::nullDevice());
+    process_.setStandardErrorFile(QProcess::nullDevice());
+    process_.setOutputDescriptor(fds[1]);
+    process_.start();
+    ::close(fds[1]); // 父进程不持有写端，子进程全部退出后读端才能读到 EOF
+    process_.setOutputDescriptor(-1);
+#else
+    // 没有可控的管道，退回到 QProcess 自己的缓冲；仍然按周期限量取出，界面线程不会被淹没
+    process_.setProcessChannelMode(QProcess::MergedChannels);
+    process_.start();
+#endif
+    if (process_.state() == QProcess::NotRunning) {
+        closePipe(); // 启动失败已经由 errorOccurred 报告
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    notifier_ = new QSocketNotifier(readFd_, QSocketNotifier::Read, this);
+    connect(notifier_, &QSocketNotifier::activated, this, [this]() { readOutput(false); });
+#endif
+
+    budget_ = kBytesPerTick;
+    appended_ = false;
+    elapsedMs_ = 0;
+    clock_.start();
+    tickTimer_.start();
+    emit started();
+    return true;
+}
+
+void RunSession::readOutput(bool drain) {
+#ifdef Q_OS_UNIX
+    if (readFd_ < 0) {
+        return;
+    }
+    qint64 drained = 0;
+    QByteArray buffer;
+    while (true) {
+        const qint64 want = drain ? qMin(kReadChunk, kMaxDrainBytes - drained) : qMin(kReadChunk, budget_);
+        if (want <= 0) {
+            if (!drain && notifier_) {
+                notifier_->setEnabled(false); // 本周期额度用完，下个周期再读
+            }
+            return;
+        }
+        buffer.resize(static_cast<int>(want));
+        const ssize_t n = ::read(readFd_, buffer.data(), static_cast<size_t>(want));
+        const int error = errno;
+        if (n > 0) {
+            buffer.resize(static_cast<int>(n));
+            log_.append(buffer);
+            appended_ = true;
+            budget_ -= n;
+            drained += n;
+            continue;
+        }
+        if (n < 0 && error == EINTR) {
+            continue;
+        }
+        if (n == 0 || (error != EAGAIN && error != EWOULDBLOCK)) {
+            closePipe();
+        }
+        return;
+    }
+#else
+    const qint64 want = drain ? kMaxDrainBytes : budget_;
+    if (want <= 0) {
+        return;
+    }
+    const QByteArray data = process_.read(want);
+    if (!data.isEmpty()) {
+        log_.append(data);
+        appended_ = true;
+        budget_ -= data.size();
+    }
+#endif
+}
+
+void RunSession::tick() {
+    budget_ = kBytesPerTick;
+    if (notifier_) {
+        notifier_->setEnabled(true);
+    }
+#ifndef Q_OS_UNIX
+    readOutput(false);
+#endif
+    if (appended_) {
+        appended_ = false;
+        emitNewLines();
+        emit outputAppended();
+    }
+}
+
+void RunSession::emitNewLines() {
+    const QStringList lines = log_.takeNewLines();
+    if (!lines.isEmpty()) {
+        emit linesReceived(lines);
+    }
+}
+
+void RunSession::closePipe() {
+    if (notifier_) {
+        notifier_->setEnabled(false);
+        notifier_->deleteLater();
+        notifier_ = nullptr;
+    }
+#ifdef Q_OS_UNIX
+    if (readFd_ >= 0) {
+        ::close(readFd_);
+        readFd_ = -1;
+    }
+#endif
+}
+
+void RunSession::handleFinished(int exitCode, QProcess::ExitStatus status) {
+    // 进程退出后把管道里剩下的内容一次读完；后台子进程如果还拿着写端，就不再等它
+    readOutput(true);
+    closePipe();
+    log_.finish();
+    tickTimer_.stop();
+    elapsedMs_ = clock_.isValid() ? clock_.elapsed() : 0;
+    emitNewLines();
+    emit outputAppended();
+    emit finished(exitCode, status);
+}
+
+void RunSession::stop() {
+    if (!isRunning()) {
+        return;
+    }
+    process_.terminateGroup();
+    QTimer::singleShot(3000, this, [this]() {
+        if (isRunning()) {
+            process_.killGroup();
+        }
+    });
+}
+
+bool RunSession::isRunning() const {
+    return process_.state() != QProcess::NotRunning;
+}
+
+const RunOutputLog &RunSession::log() const {
+    return log_;
+}
+
+qint64 RunSession::elapsedMs() const {
+    return isRunning() ? clock_.elapsed() : elapsedMs_;
+}
+
+QString RunSession::commandLine() const {
+    return commandLine_;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+
+#include "BuildProcess.h"
+#include "RunOutputLog.h"
+
+class QSocketNotifier;
+
+// 运行编译产物并收集输出。stdout/stderr 接到自己的管道上，每个周期最多读固定字节数：
+// 读不过来时停止读取，管道写满后子进程在 write() 上阻塞，而不是在 IDE 里无限堆积。
+class RunSession : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RunSession(QObject *parent = nullptr);
+    ~RunSession() override;
+
+    bool start(const QString &program, const QStringList &args, const QString &workingDirectory);
+    void stop();
+    bool isRunning() const;
+
+    const RunOutputLog &log() const;
+    qint64 elapsedMs() const;
+    QString commandLine() const;
+
+signals:
+    void started();
+    void outputAppended();
+    // 新完成的输出行，每个周期一批；进程结束时先发出最后一批再发 finished
+    void linesReceived(const QStringList &lines);
+    void finished(int exitCode, QProcess::ExitStatus status);
+
+private:
+    void readOutput(bool drain);
+    void tick();
+    void closePipe();
+    void emitNewLines();
+    void handleFinished(int exitCode, QProcess::ExitStatus status);
+
+    BuildProcess process_;
+    RunOutputLog log_;
+    QTimer tickTimer_;
+    QElapsedTimer clock_;
+    qint64 elapsedMs_ = 0;
+    QString commandLine_;
+    int readFd_ = -1;
+    QSocketNotifier *notifier_ = nullptr;
+    qint64 budget_ = 0;
+    bool appended_ = false;
+};
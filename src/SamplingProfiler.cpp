@@ -0,0 +1,507 @@
+#include "SamplingProfiler.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#endif
+
+namespace {
+// 回退模式用的采样库。只在程序计数器落在主程序里时记录相对加载基址的偏移，
+// 其他模块（libc、libstdc++ 等）记为 0；输出用 write() 手写十六进制，信号处理里也能安全调用。
+const char *const kSamplerSource = R"SAMPLER(#define _GNU_SOURCE
+#include <fcntl.h>
+#include <link.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define CAPACITY (1 << 22)
+
+static uintptr_t samples[CAPACITY];
+static size_t sample_count;
+static uintptr_t exe_base, exe_lo, exe_hi;
+static int dumped;
+static char out_path[4096];
+
+static uintptr_t pc_from(void *context) {
+    ucontext_t *uc = (ucontext_t *)context;
+#if defined(__x86_64__)
+    return (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    return (uintptr_t)uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+    return (uintptr_t)uc->uc_mcontext.pc;
+#else
+    (void)uc;
+    return 0;
+#endif
+}
+
+static void on_prof(int sig, siginfo_t *info, void *context) {
+    (void)sig;
+    (void)info;
+    uintptr_t pc = pc_from(context);
+    size_t i = __atomic_fetch_add(&sample_count, 1, __ATOMIC_RELAXED);
+    if (i < CAPACITY) {
+        samples[i] = (pc >= exe_lo && pc < exe_hi) ? pc - exe_base : 0;
+    }
+}
+
+static int find_main(struct dl_phdr_info *info, size_t size, void *data) {
+    (void)size;
+    (void)data;
+    exe_base = info->dlpi_addr;
+    exe_lo = UINTPTR_MAX;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+        if (ph->p_type == PT_LOAD && (ph->p_flags & PF_X)) {
+            uintptr_t lo = exe_base + ph->p_vaddr;
+            uintptr_t hi = lo + ph->p_memsz;
+            if (lo < exe_lo) exe_lo = lo;
+            if (hi > exe_hi) exe_hi = hi;
+        }
+    }
+    return 1; /* 第一个就是主程序 */
+}
+
+static char buffer[65536];
+static size_t buffered;
+
+static void flush_to(int fd) {
+    size_t done = 0;
+    while (done < buffered) {
+        ssize_t n = write(fd, buffer + done, buffered - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    buffered = 0;
+}
+
+static void put_hex(int fd, uintptr_t value) {
+    char digits[2 * sizeof(uintptr_t) + 1];
+    int n = sizeof digits;
+    digits[--n] = '\n';
+    do {
+        digits[--n] = "0123456789abcdef"[value & 15];
+        value >>= 4;
+    } while (value);
+    if (buffered + sizeof digits > sizeof buffer) flush_to(fd);
+    memcpy(buffer + buffered, digits + n, sizeof digits - n);
+    buffered += sizeof digits - n;
+}
+
+static void dump(void) {
+    if (__atomic_exchange_n(&dumped, 1, __ATOMIC_SEQ_CST) || !out_path[0]) return;
+    struct itimerval off;
+    memset(&off, 0, sizeof off);
+    setitimer(ITIMER_PROF, &off, 0);
+    int fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return;
+    size_t count = __atomic_load_n(&sample_count, __ATOMIC_RELAXED);
+    if (count > CAPACITY) count = CAPACITY;
+    for (size_t i = 0; i < count; ++i) put_hex(fd, samples[i]);
+    flush_to(fd);
+    close(fd);
+}
+
+static void on_stop(int sig) {
+    dump();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+__attribute__((constructor)) static void rcpp_profile_start(void) {
+    const char *out = getenv("RCPP_PROFILE_OUT");
+    if (!out) return;
+    strncpy(out_path, out, sizeof out_path - 1);
+    const char *hz_text = getenv("RCPP_PROFILE_HZ");
+    int hz = hz_text ? atoi(hz_text) : 999;
+    if (hz <= 0 || hz > 10000) hz = 999;
+    /* 子进程不再被采样，也不会覆盖结果文件 */
+    unsetenv("LD_PRELOAD");
+    unsetenv("RCPP_PROFILE_OUT");
+    dl_iterate_phdr(find_main, 0);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_sigaction = on_prof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, 0);
+    /* IDE 点“停止”时发 SIGINT：先写出样本再按默认方式退出 */
+    int stop_signals[] = {SIGINT, SIGTERM};
+    for (int i = 0; i < 2; ++i) {
+        struct sigaction old;
+        if (sigaction(stop_signals[i], 0, &old) == 0 && old.sa_handler == SIG_DFL) signal(stop_signals[i], on_stop);
+    }
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, 0);
+}
+
+__attribute__((destructor)) static void rcpp_profile_stop(void) {
+    dump();
+}
+)SAMPLER";
+
+QString resolveSourcePath(const QString &file, const QString &sourceRoot) {
+    if (file.isEmpty() || file.startsWith(QLatin1String("??"))) {
+        return QString();
+    }
+    if (QDir::isAbsolutePath(file)) {
+        return QDir::cleanPath(file);
+    }
+    return QDir::cleanPath(QDir(sourceRoot).absoluteFilePath(file));
+}
+
+// 把一条条样本累加成函数表和行热度
+class Aggregator {
+public:
+    explicit Aggregator(const QString &sourceRoot) : sourceRoot_(sourceRoot) {}
+
+    void add(const QString &function, const QString &module, const QString &fileLine, int count) {
+        QString file;
+        int line = 0;
+        const int colon = fileLine.lastIndexOf(':');
+        if (colon > 0) {
+            line = fileLine.mid(colon + 1).section(' ', 0, 0).toInt(); // "a.cpp:12 (discriminator 3)"
+            file = resolveSourcePath(fileLine.left(colon), sourceRoot_);
+        }
+        const QString key = function + QLatin1Char('\n') + module;
+        SamplingProfiler::Function &entry = functions_[key];
+        entry.name = function;
+        entry.module = module;
+        entry.samples += count;
+        if (!file.isEmpty() && line > 0) {
+            lineSamples_[file][line] += count;
+            functionLines_[key][file + QLatin1Char('\n') + QString::number(line)] += count;
+        }
+        total_ += count;
+    }
+
+    void finish(SamplingProfiler::Result *result) {
+        for (auto it = functions_.begin(); it != functions_.end(); ++it) {
+            const QHash<QString, int> lines = functionLines_.value(it.key());
+            int best = 0;
+            for (auto line = lines.cbegin(); line != lines.cend(); ++line) {
+                if (line.value() > best) {
+                    best = line.value();
+                    it.value().file = line.key().section('\n', 0, 0);
+                    it.value().line = line.key().section('\n', 1, 1).toInt();
+                }
+            }
+            result->functions.append(it.value());
+        }
+        std::sort(result->functions.begin(), result->functions.end(),
+                  [](const SamplingProfiler::Function &a, const SamplingProfiler::Function &b) {
+                      return a.samples > b.samples;
+                  });
+        result->lineSamples = lineSamples_;
+        result->totalSamples = total_;
+    }
+
+private:
+    QString sourceRoot_;
+    QHash<QString, SamplingProfiler::Function> functions_;
+    QHash<QString, QHash<QString, int>> functionLines_;
+    QHash<QString, QHash<int, int>> lineSamples_;
+    int total_ = 0;
+};
+}
+
+SamplingProfiler::SamplingProfiler(QObject *parent) : QObject(parent) {}
+
+SamplingProfiler::~SamplingProfiler() {
+    if (thread_) {
+        stop();
+        thread_->wait();
+        delete thread_;
+    }
+}
+
+bool SamplingProfiler::start(const Options &options) {
+    if (thread_ || options.program.isEmpty()) {
+        return false;
+    }
+    stopped_ = false;
+    thread_ = QThread::create([this, options]() {
+        const Result result = execute(options);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            thread_->wait();
+            thread_->deleteLater();
+            thread_ = nullptr;
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    thread_->start();
+    return true;
+}
+
+void SamplingProfiler::stop() {
+    stopped_ = true;
+#ifdef Q_OS_UNIX
+    // perf record 收到 SIGINT 会结束被测程序并写完 perf.data；采样库也会先写出样本。
+    const qint64 pid = childPid_.load();
+    if (pid > 0) {
+        ::kill(static_cast<pid_t>(pid), SIGINT);
+    }
+#endif
+}
+
+bool SamplingProfiler::isRunning() const {
+    return thread_ != nullptr;
+}
+
+void SamplingProfiler::report(const QString &text) {
+    QMetaObject::invokeMethod(this, [this, text]() { emit statusChanged(text); }, Qt::QueuedConnection);
+}
+
+SamplingProfiler::Result SamplingProfiler::execute(const Options &options) {
+    Result result;
+#ifdef Q_OS_LINUX
+    QDir().mkpath(options.outputDirectory);
+    result.programOutputPath = QDir(options.outputDirectory).filePath("program-output.txt");
+
+    const QString perf = QStandardPaths::findExecutable("perf");
+    if (!perf.isEmpty() && perfUsable(perf, options.outputDirectory)) {
+        result.backend = QStringLiteral("perf");
+        recordWithPerf(perf, options, &result);
+    } else {
+        result.backend = QStringLiteral("SIGPROF");
+        recordWithSampler(options, &result);
+    }
+    result.stopped = stopped_;
+#else
+    Q_UNUSED(options);
+    result.error = tr("采样分析目前只支持 Linux（perf 或 LD_PRELOAD 采样库）。");
+#endif
+    return result;
+}
+
+bool SamplingProfiler::perfUsable(const QString &perf, const QString &outputDirectory) {
+    // perf_event_paranoid 过高或容器里没有权限时 perf record 会直接失败，先用 true 试一下
+    const QString probe = QDir(outputDirectory).filePath("probe.data");
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(perf, {"record", "-q", "-o", probe, "--", "true"});
+    const bool ok = process.waitForFinished(10000) && process.exitStatus() == QProcess::NormalExit
+                    && process.exitCode() == 0;
+    QFile::remove(probe);
+    return ok;
+}
+
+int SamplingProfiler::runProfiled(const QString &program, const QStringList &args, const Options &options,
+                                  const QStringList &extraEnvironment) {
+    QProcess process;
+    process.setWorkingDirectory(options.workingDirectory);
+    process.setStandardInputFile(QProcess::nullDevice());
+    process.setStandardOutputFile(QDir(options.outputDirectory).filePath("program-output.txt"));
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (const QString &entry : extraEnvironment) {
+        env.insert(entry.section('=', 0, 0), entry.section('=', 1));
+    }
+    process.setProcessEnvironment(env);
+    process.start(program, args);
+    if (!process.waitForStarted()) {
+        return -1;
+    }
+    childPid_ = process.processId();
+    if (stopped_) {
+        stop();
+    }
+    process.waitForFinished(-1);
+    childPid_ = 0;
+    // 被信号结束时 QProcess 拿不到信号编号，按 shell 的习惯报 128 以上
+    return process.exitStatus() == QProcess::NormalExit ? process.exitCode() : 128;
+}
+
+bool SamplingProfiler::recordWithPerf(const QString &perf, const Options &options, Result *result) {
+    const QString data = QDir(options.outputDirectory).filePath("perf.data");
+    report(tr("正在用 perf record 运行 %1 ...").arg(QFileInfo(options.program).fileName()));
+    const QStringList recordArgs = QStringList{"record", "-q", "-F", QString::number(options.frequency), "-o", data, "--",
+                                               options.program} + options.args;
+    result->exitCode = runProfiled(perf, recordArgs, options, {});
+    if (result->exitCode < 0 || !QFileInfo::exists(data)) {
+        result->error = tr("perf record 没有生成数据。");
+        return false;
+    }
+
+    report(tr("正在解析符号和源码行..."));
+    const QString scriptOutput = QDir(options.outputDirectory).filePath("perf-script.txt");
+    QProcess script;
+    script.setStandardOutputFile(scriptOutput);
+    script.setStandardErrorFile(QProcess::nullDevice());
+    script.start(perf, {"script", "-i", data, "-F", "ip,sym,dso,srcline"});
+    if (!script.waitForStarted() || !script.waitForFinished(-1)) {
+        result->error = tr("perf script 运行失败。");
+        return false;
+    }
+
+    // 每个样本一行 "  <ip> <符号> (<模块>)"，紧跟一行 "  文件:行"
+    static const QRegularExpression sampleRe(QStringLiteral("^\\s*[0-9a-f]+\\s+(.+?)\\s+\\((.*)\\)\\s*$"));
+    QFile file(scriptOutput);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        result->error = tr("无法读取 perf script 输出。");
+        return false;
+    }
+    Aggregator aggregator(options.sourceRoot);
+    QString function;
+    QString module;
+    QString srcline;
+    bool pending = false;
+    auto flush = [&]() {
+        if (pending) {
+            aggregator.add(function, module, srcline, 1);
+        }
+        pending = false;
+        srcline.clear();
+    };
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QRegularExpressionMatch match = sampleRe.match(line);
+        if (match.hasMatch()) {
+            flush();
+            function = match.captured(1);
+            module = QFileInfo(match.captured(2)).fileName();
+            pending = true;
+        } else if (pending && srcline.isEmpty()) {
+            srcline = line;
+        }
+    }
+    flush();
+    aggregator.finish(result);
+    QFile::remove(scriptOutput);
+    return true;
+}
+
+bool SamplingProfiler::recordWithSampler(const Options &options, Result *result) {
+    const QDir dir(options.outputDirectory);
+    const QString sourcePath = dir.filePath("rcpp_sampler.c");
+    const QString libraryPath = dir.filePath("librcpp_sampler.so");
+    const QByteArray source(kSamplerSource);
+
+    // 源码没变就复用上次编好的采样库
+    QFile existing(sourcePath);
+    const bool upToDate = QFileInfo::exists(libraryPath) && existing.open(QFile::ReadOnly) && existing.readAll() == source;
+    existing.close();
+    if (!upToDate) {
+        report(tr("没有可用的 perf，正在编译 SIGPROF 采样库..."));
+        QFile out(sourcePath);
+        if (!out.open(QFile::WriteOnly | QFile::Truncate)) {
+            result->error = tr("无法写入采样库源码：%1").arg(sourcePath);
+            return false;
+        }
+        out.write(source);
+        out.close();
+        QString cc;
+        for (const QString &candidate : {QStringLiteral("cc"), QStringLiteral("gcc"), QStringLiteral("clang")}) {
+            cc = QStandardPaths::findExecutable(candidate);
+            if (!cc.isEmpty()) {
+                break;
+            }
+        }
+        QProcess compile;
+        compile.setProcessChannelMode(QProcess::MergedChannels);
+        compile.start(cc.isEmpty() ? QStringLiteral("cc") : cc,
+                      {"-shared", "-fPIC", "-O2", "-o", libraryPath, sourcePath});
+        if (!compile.waitForFinished(60000) || compile.exitCode() != 0) {
+            result->error = tr("编译采样库失败：%1").arg(QString::fromLocal8Bit(compile.readAll()).trimmed());
+            return false;
+        }
+    }
+
+    const QString samplesPath = dir.filePath("samples.txt");
+    QFile::remove(samplesPath);
+    QString preload = libraryPath;
+    const QString inherited = qEnvironmentVariable("LD_PRELOAD");
+    if (!inherited.isEmpty()) {
+        preload += QLatin1Char(':') + inherited;
+    }
+    report(tr("正在用 SIGPROF 采样运行 %1 ...").arg(QFileInfo(options.program).fileName()));
+    result->exitCode = runProfiled(options.program, options.args, options,
+                                   {"LD_PRELOAD=" + preload, "RCPP_PROFILE_OUT=" + samplesPath,
+                                    "RCPP_PROFILE_HZ=" + QString::number(options.frequency)});
+    if (result->exitCode < 0) {
+        result->error = tr("无法启动：%1").arg(options.program);
+        return false;
+    }
+
+    QFile samplesFile(samplesPath);
+    if (!samplesFile.open(QFile::ReadOnly | QFile::Text)) {
+        result->error = tr("程序没有写出采样结果（可能被强制结束或调用了 _exit）。");
+        return false;
+    }
+    QHash<quint64, int> counts;
+    while (!samplesFile.atEnd()) {
+        bool ok = false;
+        const quint64 offset = samplesFile.readLine().trimmed().toULongLong(&ok, 16);
+        if (ok) {
+            counts[offset] += 1;
+        }
+    }
+
+    report(tr("正在用 addr2line 解析 %1 个地址...").arg(counts.size()));
+    QList<quint64> addresses;
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        if (it.key() != 0) {
+            addresses.append(it.key());
+        }
+    }
+    QStringList symbolLines;
+    QString addr2line = QStandardPaths::findExecutable("addr2line");
+    if (addr2line.isEmpty()) {
+        addr2line = QStandardPaths::findExecutable("llvm-addr2line");
+    }
+    if (!addr2line.isEmpty() && !addresses.isEmpty()) {
+        QProcess resolve;
+        resolve.start(addr2line, {"-e", options.program, "-f", "-C"});
+        if (resolve.waitForStarted()) {
+            QByteArray input;
+            for (quint64 address : addresses) {
+                input += "0x" + QByteArray::number(address, 16) + '\n';
+            }
+            resolve.write(input);
+            resolve.closeWriteChannel();
+            resolve.waitForFinished(-1);
+            symbolLines = QString::fromLocal8Bit(resolve.readAllStandardOutput()).split('\n');
+        }
+    }
+
+    // addr2line -f 每个地址输出两行：函数名、文件:行
+    Aggregator aggregator(options.sourceRoot);
+    const QString module = QFileInfo(options.program).fileName();
+    for (int i = 0; i < addresses.size(); ++i) {
+        const quint64 address = addresses.at(i);
+        QString function = symbolLines.value(2 * i).trimmed();
+        if (function.isEmpty() || function == QLatin1String("??")) {
+            function = QStringLiteral("0x") + QString::number(address, 16);
+        }
+        aggregator.add(function, module, symbolLines.value(2 * i + 1).trimmed(), counts.value(address));
+    }
+    if (counts.value(0) > 0) {
+        aggregator.add(tr("[其他模块]"), QString(), QString(), counts.value(0));
+    }
+    aggregator.finish(result);
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include <atomic>
+
+class QThread;
+
+// 采样分析：优先用 perf record，不可用时（没装 perf 或 perf_event_paranoid 限制）
+// 现场编译一个很小的 LD_PRELOAD 采样库，用 ITIMER_PROF/SIGPROF 记录程序计数器。
+// 样本按函数和源码行汇总（perf 自带 srcline，回退模式用 addr2line 解析 DWARF），
+// 只统计自身样本（栈顶），不展开调用栈。整个过程在后台线程里同步进行。
+class SamplingProfiler : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString program;
+        QStringList args;
+        QString workingDirectory;
+        QString outputDirectory; // 存放 perf.data、采样库和程序输出
+        QString sourceRoot;      // 调试信息里的相对路径按这个目录解析
+        int frequency = 999;
+    };
+
+    struct Function {
+        QString name;
+        QString module;
+        QString file; // 样本最多的那一行
+        int line = 0;
+        int samples = 0;
+    };
+
+    struct Result {
+        QString backend; // "perf" 或 "SIGPROF"
+        int totalSamples = 0;
+        QList<Function> functions;
+        QHash<QString, QHash<int, int>> lineSamples; // 绝对路径 -> 行号（从 1 开始）-> 样本数
+        QString programOutputPath;
+        int exitCode = 0;
+        bool stopped = false;
+        QString error;
+    };
+
+    explicit SamplingProfiler(QObject *parent = nullptr);
+    ~SamplingProfiler() override;
+
+    bool start(const Options &options);
+    void stop();
+    bool isRunning() const;
+
+signals:
+    void statusChanged(const QString &text);
+    void finished(const SamplingProfiler::Result &result);
+
+private:
+    Result execute(const Options &options);
+    bool perfUsable(const QString &perf, const QString &outputDirectory);
+    bool recordWithPerf(const QString &perf, const Options &options, Result *result);
+    bool recordWithSampler(const Options &options, Result *result);
+    int runProfiled(const QString &program, const QStringList &args, const Options &options,
+                    const QStringList &extraEnvironment);
+    void report(const QString &text);
+
+    QThread *thread_ = nullptr;
+    std::atomic<qint64> childPid_{0};
+    std::atomic<bool> stopped_{false};
+};
@@ -0,0 +1,119 @@
+#include "SanitizerPanel.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+constexpr int kFileRole = Qt::UserRole;
+constexpr int kLineRole = Qt::UserRole + 1;
+
+QString shortToolName(const QString &tool) {
+    if (tool == QLatin1String("AddressSanitizer")) {
+        return QStringLiteral("ASan");
+    }
+    if (tool == QLatin1String("LeakSanitizer")) {
+        return QStringLiteral("LSan");
+    }
+    if (tool == QLatin1String("ThreadSanitizer")) {
+        return QStringLiteral("TSan");
+    }
+    if (tool == QLatin1String("UndefinedBehaviorSanitizer")) {
+        return QStringLiteral("UBSan");
+    }
+    return tool;
+}
+}
+
+SanitizerPanel::SanitizerPanel(QWidget *parent) : QWidget(parent) {
+    statusLabel_ = new QLabel(tr("用 ASan/UBSan/TSan 模式编译并运行后，这里列出检测到的问题。"), this);
+    statusLabel_->setWordWrap(true);
+    clearButton_ = new QPushButton(tr("清除"), this);
+
+    tree_ = new QTreeWidget(this);
+    tree_->setHeaderLabels({tr("报告 / 栈帧"), tr("位置"), tr("模块")});
+    tree_->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    auto *bar = new QHBoxLayout();
+    bar->setContentsMargins(0, 0, 0, 0);
+    bar->addWidget(statusLabel_, 1);
+    bar->addWidget(clearButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(bar);
+    layout->addWidget(tree_);
+
+    connect(clearButton_, &QPushButton::clicked, this, [this]() {
+        tree_->clear();
+        statusLabel_->setText(tr("已清除。"));
+    });
+    connect(tree_, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item, int) {
+        if (!item) {
+            return;
+        }
+        const QString file = item->data(0, kFileRole).toString();
+        if (!file.isEmpty()) {
+            emit locationActivated(file, item->data(0, kLineRole).toInt());
+        }
+    });
+}
+
+void SanitizerPanel::setStatus(const QString &text) {
+    statusLabel_->setText(text);
+}
+
+void SanitizerPanel::setReports(const QList<SanitizerReport> &reports, const QString &sourceRoot) {
+    tree_->clear();
+    const QColor foreign = palette().color(QPalette::Disabled, QPalette::Text);
+    for (const SanitizerReport &report : reports) {
+        auto *top = new QTreeWidgetItem(tree_);
+        top->setText(0, QStringLiteral("[%1] %2").arg(shortToolName(report.tool), report.title));
+        QStringList tip{report.title};
+        tip << report.notes;
+        if (!report.summary.isEmpty()) {
+            tip << report.summary;
+        }
+        top->setToolTip(0, tip.join('\n'));
+        if (const SanitizerFrame *primary = report.primaryFrame(sourceRoot)) {
+            top->setText(1, QStringLiteral("%1:%2").arg(QFileInfo(primary->file).fileName()).arg(primary->line));
+            top->setToolTip(1, primary->file);
+            top->setData(0, kFileRole, primary->file);
+            top->setData(0, kLineRole, primary->line);
+        }
+
+        for (const SanitizerReport::Section &section : report.sections) {
+            auto *sectionItem = new QTreeWidgetItem(top);
+            sectionItem->setText(0, section.title.isEmpty() ? tr("调用栈") : section.title);
+            sectionItem->setToolTip(0, section.title);
+            for (const SanitizerFrame &frame : section.frames) {
+                auto *frameItem = new QTreeWidgetItem(sectionItem);
+                frameItem->setText(0, QStringLiteral("#%1 %2").arg(frame.index).arg(frame.function.isEmpty() ? tr("<未知>") : frame.function));
+                frameItem->setToolTip(0, frame.function);
+                frameItem->setText(1, frame.location);
+                frameItem->setText(2, frame.module);
+                if (!frame.file.isEmpty()) {
+                    frameItem->setToolTip(1, frame.file);
+                    frameItem->setData(0, kFileRole, frame.file);
+                    frameItem->setData(0, kLineRole, frame.line);
+                }
+                if (frame.file.isEmpty() || (!sourceRoot.isEmpty() && !frame.file.startsWith(sourceRoot))) {
+                    for (int column = 0; column < 3; ++column) {
+                        frameItem->setForeground(column, foreign);
+                    }
+                }
+            }
+            sectionItem->setExpanded(true);
+        }
+    }
+    if (tree_->topLevelItemCount() > 0) {
+        tree_->topLevelItem(0)->setExpanded(true);
+    }
+    statusLabel_->setText(reports.isEmpty() ? tr("运行结束，没有检测到问题。")
+                                            : tr("检测到 %1 份报告，双击跳到对应源码。").arg(reports.size()));
+}
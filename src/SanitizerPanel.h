@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QWidget>
+
+#include "SanitizerParser.h"
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+// Sanitizer 面板：把运行输出里的 ASan/UBSan/TSan 报告整理成可跳转的调用栈，
+// 每份报告下按段（访问位置、释放位置、上一次访问……）列出栈帧，工程外的帧显示为灰色。
+class SanitizerPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SanitizerPanel(QWidget *parent = nullptr);
+
+    void setReports(const QList<SanitizerReport> &reports, const QString &sourceRoot);
+    void setStatus(const QString &text);
+
+signals:
+    void locationActivated(const QString &filePath, int line);
+
+private:
+    QLabel *statusLabel_;
+    QPushButton *clearButton_;
+    QTreeWidget *tree_;
+};
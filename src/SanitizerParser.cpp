@@ -0,0 +1,183 @@
+#include "SanitizerParser.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+namespace {
+// ==1234==ERROR: AddressSanitizer: heap-use-after-free on address ...
+// ==1234==ERROR: LeakSanitizer: detected memory leaks
+const QRegularExpression kErrorHeader(QStringLiteral("^==\\d+==ERROR: (\\w+Sanitizer): (.*)$"));
+// WARNING: ThreadSanitizer: data race (pid=1234)
+const QRegularExpression kWarningHeader(QStringLiteral("^WARNING: (\\w+Sanitizer): (.*?)(?: \\(pid=\\d+\\))?$"));
+// a.cpp:2:49: runtime error: signed integer overflow: ...
+const QRegularExpression kRuntimeError(QStringLiteral("^(.+?):(\\d+):(\\d+): runtime error: (.*)$"));
+const QRegularExpression kSummary(QStringLiteral("^SUMMARY: (\\w+Sanitizer): (.*)$"));
+//     #0 0x55f1ef26a1c8 in main /tmp/a.cpp:2:5          （ASan / LSan）
+//     #0 w() /tmp/t.cpp:3 (t+0x1248)                     （TSan）
+//     #1 0x7f3afca45249  (/lib/x86_64-linux-gnu/libc.so.6+0x27249)
+const QRegularExpression kFrame(QStringLiteral("^\\s*#(\\d+)\\s+(?:0x[0-9a-fA-F]+\\s*)?(?:in\\s+)?(.*)$"));
+const QRegularExpression kModule(QStringLiteral("\\s*\\(([^()]*)\\+0x[0-9a-fA-F]+\\)\\s*$"));
+const QRegularExpression kLocation(QStringLiteral("^(.*?)\\s*(\\S+?):(\\d+)(?::(\\d+))?$"));
+}
+
+const SanitizerFrame *SanitizerReport::primaryFrame(const QString &sourceRoot) const {
+    const SanitizerFrame *fallback = nullptr;
+    for (const Section &section : sections) {
+        for (const SanitizerFrame &frame : section.frames) {
+            if (frame.file.isEmpty()) {
+                continue;
+            }
+            if (sourceRoot.isEmpty() || frame.file.startsWith(sourceRoot)) {
+                return &frame;
+            }
+            if (!fallback) {
+                fallback = &frame;
+            }
+        }
+    }
+    return fallback;
+}
+
+SanitizerParser::SanitizerParser(const QString &workingDirectory) : workingDir_(workingDirectory) {}
+
+QString SanitizerParser::resolvePath(const QString &file) const {
+    const QString path = QDir::isAbsolutePath(file) || workingDir_.isEmpty() ? file : QDir(workingDir_).filePath(file);
+    const QFileInfo info(path);
+    // 运行时库里的帧带的是编译 gcc 时的相对路径，本机上不存在
+    return info.exists() ? info.absoluteFilePath() : QString();
+}
+
+bool SanitizerParser::parseFrame(const QString &line, SanitizerFrame *frame) const {
+    const QRegularExpressionMatch match = kFrame.match(line);
+    if (!match.hasMatch()) {
+        return false;
+    }
+    frame->index = match.captured(1).toInt();
+    QString rest = match.captured(2).trimmed();
+    const QRegularExpressionMatch module = kModule.match(rest);
+    if (module.hasMatch()) {
+        frame->module = QFileInfo(module.captured(1)).fileName();
+        rest.truncate(module.capturedStart(0));
+    }
+    rest.remove(QStringLiteral("<null>"));
+    rest = rest.trimmed();
+    const QRegularExpressionMatch location = kLocation.match(rest);
+    if (location.hasMatch()) {
+        frame->function = location.captured(1).trimmed();
+        frame->location = QStringLiteral("%1:%2").arg(QFileInfo(location.captured(2)).fileName(), location.captured(3));
+        frame->file = resolvePath(location.captured(2));
+        frame->line = location.captured(3).toInt();
+        frame->column = location.captured(4).toInt();
+    } else {
+        frame->function = rest;
+    }
+    return true;
+}
+
+QList<SanitizerReport> SanitizerParser::feedLine(const QString &rawLine) {
+    QList<SanitizerReport> done;
+    QString line = rawLine;
+    if (line.endsWith('\r')) {
+        line.chop(1);
+    }
+
+    QRegularExpressionMatch match = kErrorHeader.match(line);
+    if (!match.hasMatch()) {
+        match = kWarningHeader.match(line);
+    }
+    if (match.hasMatch()) {
+        flush(&done);
+        current_ = SanitizerReport();
+        current_.tool = match.captured(1);
+        current_.title = match.captured(2).trimmed();
+        inReport_ = true;
+        return done;
+    }
+
+    match = kRuntimeError.match(line);
+    if (match.hasMatch()) {
+        // UBSan 默认不打印调用栈，一行就是一份报告；开了 print_stacktrace 时后面跟着栈帧
+        flush(&done);
+        current_ = SanitizerReport();
+        current_.tool = QStringLiteral("UndefinedBehaviorSanitizer");
+        current_.title = match.captured(4).trimmed();
+        SanitizerFrame frame;
+        frame.file = resolvePath(match.captured(1));
+        frame.line = match.captured(2).toInt();
+        frame.column = match.captured(3).toInt();
+        frame.location = QStringLiteral("%1:%2").arg(QFileInfo(match.captured(1)).fileName(), match.captured(2));
+        current_.sections.append(SanitizerReport::Section{QStringLiteral("runtime error"), {frame}});
+        inReport_ = true;
+        return done;
+    }
+
+    if (!inReport_) {
+        return done;
+    }
+
+    match = kSummary.match(line);
+    if (match.hasMatch()) {
+        current_.summary = match.captured(2).trimmed();
+        flush(&done);
+        return done;
+    }
+    if (skipping_) {
+        return done;
+    }
+    if (line.startsWith(QLatin1String("Shadow bytes around"))) {
+        skipping_ = true;
+        return done;
+    }
+
+    SanitizerFrame frame;
+    if (parseFrame(line, &frame)) {
+        // UBSan 的第一段是出错位置本身，#0 开始的是另一段调用栈
+        if (current_.sections.isEmpty() || (frame.index == 0 && !current_.sections.last().frames.isEmpty())) {
+            current_.sections.append(SanitizerReport::Section{QString(), {}});
+        }
+        current_.sections.last().frames.append(frame);
+        return done;
+    }
+
+    const QString text = line.trimmed();
+    if (text.isEmpty() || text.startsWith(QLatin1String("=========="))) {
+        return done;
+    }
+    if (current_.tool == QLatin1String("UndefinedBehaviorSanitizer")) {
+        // UBSan 报告之后的 "note: pointer points here" 等已经不属于栈
+        flush(&done);
+        return done;
+    }
+    // 后面紧跟栈帧的行是这一段的标题（"freed by thread T0 here:"），否则只是说明
+    if (!current_.sections.isEmpty() && current_.sections.last().frames.isEmpty()) {
+        current_.notes.append(current_.sections.takeLast().title);
+    }
+    QString title = text;
+    if (title.endsWith(':')) {
+        title.chop(1);
+    }
+    current_.sections.append(SanitizerReport::Section{title, {}});
+    return done;
+}
+
+QList<SanitizerReport> SanitizerParser::finish() {
+    QList<SanitizerReport> done;
+    flush(&done);
+    return done;
+}
+
+void SanitizerParser::flush(QList<SanitizerReport> *done) {
+    if (!inReport_) {
+        return;
+    }
+    inReport_ = false;
+    skipping_ = false;
+    for (int i = static_cast<int>(current_.sections.size()) - 1; i >= 0; --i) {
+        if (current_.sections.at(i).frames.isEmpty()) {
+            current_.notes.insert(0, current_.sections.takeAt(i).title);
+        }
+    }
+    done->append(current_);
+    current_ = SanitizerReport();
+}
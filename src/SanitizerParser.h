@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct SanitizerFrame {
+    int index = 0;
+    QString function;
+    QString file; // 绝对路径；只有模块偏移时为空
+    int line = 0; // 从 1 开始
+    int column = 0;
+    QString module;
+    QString location; // 原始的 "文件:行" 文本，库里的帧文件不存在时仍然显示它
+};
+
+// 一份 sanitizer 报告：标题（"heap-use-after-free on address ..."）加若干段调用栈，
+// 例如 ASan 的访问位置 / 释放位置 / 分配位置，TSan 的本次访问 / 上一次访问 / 线程创建位置。
+struct SanitizerReport {
+    struct Section {
+        QString title;
+        QList<SanitizerFrame> frames;
+    };
+
+    QString tool;    // AddressSanitizer、ThreadSanitizer、UndefinedBehaviorSanitizer ...
+    QString title;
+    QString summary;
+    QList<Section> sections;
+    QStringList notes; // 不属于调用栈的说明行
+
+    // 第一个落在工程里的栈帧，双击报告时跳到这里
+    const SanitizerFrame *primaryFrame(const QString &sourceRoot) const;
+};
+
+// 逐行解析程序输出里的 ASan/LSan/UBSan/TSan 报告。报告之外的普通输出直接忽略。
+class SanitizerParser {
+public:
+    explicit SanitizerParser(const QString &workingDirectory = QString());
+
+    QList<SanitizerReport> feedLine(const QString &line);
+    QList<SanitizerReport> finish();
+
+private:
+    bool parseFrame(const QString &line, SanitizerFrame *frame) const;
+    QString resolvePath(const QString &file) const;
+    void flush(QList<SanitizerReport> *done);
+
+    QString workingDir_;
+    SanitizerReport current_;
+    bool inReport_ = false;
+    bool skipping_ = false; // ASan 的 shadow 内存图，直到 SUMMARY 都不需要
+};
@@ -0,0 +1,194 @@
+#include "SourceScanner.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <algorithm>
+
+namespace {
+// 各扫描线程共享的状态：待遍历目录队列（相对路径，根目录为空串，其余以 "/" 结尾）和结果
+struct ScanState {
+    QMutex mutex;
+    QWaitCondition wake;
+    QStringList queue;
+    int busy = 0;
+    QSet<QString> files;
+    QStringList directories;
+};
+
+void scanWorker(const QString &root, const QRegularExpression &include, const QRegularExpression &exclude,
+                ScanState *state, const std::atomic<bool> *cancelled) {
+    const auto excluded = [&](const QString &rel) {
+        return exclude.match(rel).hasMatch();
+    };
+    for (;;) {
+        QString dirRel;
+        {
+            QMutexLocker lock(&state->mutex);
+            while (state->queue.isEmpty() && state->busy > 0 && !(cancelled && cancelled->load())) {
+                state->wake.wait(&state->mutex);
+            }
+            if (state->queue.isEmpty() || (cancelled && cancelled->load())) {
+                state->wake.wakeAll();
+                return;
+            }
+            dirRel = state->queue.takeLast();
+            ++state->busy;
+        }
+
+        // 先在本地收集，一个目录只加一次锁
+        QStringList subdirs;
+        QStringList files;
+        const QString dirAbs = dirRel.isEmpty() ? root : root + QLatin1Char('/') + dirRel.left(dirRel.size() - 1);
+        QDirIterator it(dirAbs, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        while (it.hasNext()) {
+            it.next();
+            const QString rel = dirRel + it.fileName();
+            if (it.fileInfo().isDir()) {
+                if (!excluded(rel) && !excluded(rel + QLatin1Char('/'))) {
+                    subdirs << rel + QLatin1Char('/');
+                }
+            } else if (include.match(rel).hasMatch() && !excluded(rel)) {
+                files << rel;
+            }
+        }
+
+        QMutexLocker lock(&state->mutex);
+        state->queue << subdirs;
+        for (const QString &file : files) {
+            state->files.insert(file);
+        }
+        state->directories << dirAbs;
+        --state->busy;
+        state->wake.wakeAll();
+    }
+}
+}
+
+SourceScanner::SourceScanner(QObject *parent) : QObject(parent) {}
+
+SourceScanner::~SourceScanner() {
+    if (thread_) {
+        cancelled_ = true;
+        thread_->wait();
+        delete thread_;
+    }
+}
+
+bool SourceScanner::isRunning() const {
+    return thread_ != nullptr;
+}
+
+void SourceScanner::scan(const QString &rootDir, const QStringList &includes, const QStringList &excludes) {
+    const Request request{rootDir, includes, excludes};
+    if (thread_) {
+        pending_ = request;
+        hasPending_ = true;
+        cancelled_ = true;
+        return;
+    }
+    start(request);
+}
+
+void SourceScanner::start(const Request &request) {
+    cancelled_ = false;
+    thread_ = QThread::create([this, request]() {
+        const Result result = scanNow(request.rootDir, request.includes, request.excludes, &cancelled_);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            thread_->wait();
+            thread_->deleteLater();
+            thread_ = nullptr;
+            if (hasPending_) {
+                // 中途规则或目录又变了，这次的结果已经过时
+                hasPending_ = false;
+                start(pending_);
+                return;
+            }
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    thread_->start();
+}
+
+QStringList SourceScanner::builtinExcludes() {
+    // build/ 下有 unity 合并文件和生成的源文件，被 **/*.cpp 匹配进来会重复编译
+    return {QStringLiteral("build/**"), QStringLiteral("**/*.rcppide.json"), QStringLiteral("compile_commands.json")};
+}
+
+QRegularExpression SourceScanner::globToRegex(const QStringList &globs) {
+    QStringList alternatives;
+    for (const QString &glob : globs) {
+        QString rx;
+        const QString pattern = QDir::fromNativeSeparators(glob.trimmed());
+        for (int i = 0; i < pattern.size(); ++i) {
+            const QChar c = pattern.at(i);
+            if (c == QLatin1Char('*')) {
+                if (i + 1 < pattern.size() && pattern.at(i + 1) == QLatin1Char('*')) {
+                    ++i;
+                    if (i + 1 < pattern.size() && pattern.at(i + 1) == QLatin1Char('/')) {
+                        ++i;
+                        rx += QStringLiteral("(?:.*/)?"); // "**/" 也匹配零层目录
+                    } else {
+                        rx += QStringLiteral(".*");
+                    }
+                } else {
+                    rx += QStringLiteral("[^/]*");
+                }
+            } else if (c == QLatin1Char('?')) {
+                rx += QStringLiteral("[^/]");
+            } else {
+                rx += QRegularExpression::escape(QString(c));
+            }
+        }
+        if (!rx.isEmpty()) {
+            alternatives << rx;
+        }
+    }
+    return QRegularExpression(QStringLiteral("^(?:%1)$").arg(alternatives.join(QLatin1Char('|'))));
+}
+
+SourceScanner::Result SourceScanner::scanNow(const QString &rootDir, const QStringList &includes,
+                                             const QStringList &excludes, const std::atomic<bool> *cancelled,
+                                             const QString &subdir) {
+    QElapsedTimer timer;
+    timer.start();
+    Result result;
+    result.rootDir = rootDir;
+    result.includes = includes;
+    result.excludes = excludes;
+    if (rootDir.isEmpty() || includes.isEmpty()) {
+        return result;
+    }
+
+    const QRegularExpression include = globToRegex(includes);
+    const QRegularExpression exclude = globToRegex(excludes + builtinExcludes());
+    const QString root = QDir(rootDir).absolutePath();
+
+    ScanState state;
+    state.queue << subdir;
+    const int workers = qBound(1, QThread::idealThreadCount(), 8);
+    QList<QThread *> threads;
+    for (int i = 1; i < workers; ++i) {
+        threads << QThread::create([&root, &include, &exclude, &state, cancelled]() {
+            scanWorker(root, include, exclude, &state, cancelled);
+        });
+        threads.last()->start();
+    }
+    // 当前线程也参与遍历
+    scanWorker(root, include, exclude, &state, cancelled);
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    result.files = state.files.values();
+    std::sort(result.files.begin(), result.files.end());
+    result.directories = state.directories;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
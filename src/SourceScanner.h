@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QObject>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <atomic>
+
+class QThread;
+
+// 按 glob 规则在工程目录下查找源文件。规则相对工程根目录："*" 不跨目录，"**" 匹配任意层目录，
+// "?" 匹配单个字符，例如 src/**/*.cpp。命中排除规则的目录整棵跳过，隐藏目录和符号链接不进入；
+// IDE 自己生成的 build/、工程文件和 compile_commands.json 总是排除（见 builtinExcludes）。
+// 目录树由多个线程从共享队列里取目录并行遍历，结果放进哈希集合去重后排序。
+class SourceScanner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Result {
+        QString rootDir;
+        QStringList includes;    // 这次扫描用的规则，调用方据此丢弃规则已经变过的旧结果
+        QStringList excludes;
+        QStringList files;       // 相对工程根目录，已排序
+        QStringList directories; // 遍历过的目录（绝对路径），用来挂文件系统监视
+        qint64 elapsedMs = 0;
+    };
+
+    explicit SourceScanner(QObject *parent = nullptr);
+    ~SourceScanner() override;
+
+    // 后台扫描；正在扫描时取消那一次并记下这次请求，上一次退出后再扫
+    void scan(const QString &rootDir, const QStringList &includes, const QStringList &excludes);
+    bool isRunning() const;
+
+    // subdir 非空时只遍历这棵子树（相对 rootDir，以 "/" 结尾），结果路径和规则仍相对 rootDir
+    static Result scanNow(const QString &rootDir, const QStringList &includes, const QStringList &excludes,
+                          const std::atomic<bool> *cancelled = nullptr, const QString &subdir = QString());
+    static QRegularExpression globToRegex(const QStringList &globs);
+    static QStringList builtinExcludes();
+
+signals:
+    void finished(const SourceScanner::Result &result);
+
+private:
+    struct Request {
+        QString rootDir;
+        QStringList includes;
+        QStringList excludes;
+    };
+    void start(const Request &request);
+
+    QThread *thread_ = nullptr;
+    Request pending_;
+    bool hasPending_ = false;
+    std::atomic<bool> cancelled_{false};
+};
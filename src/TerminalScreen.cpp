@@ -0,0 +1,763 @@
+#include "TerminalScreen.h"
+
+#include <QtGlobal>
+
+namespace {
+constexpr int kMaxParams = 16;
+constexpr int kMaxStringBytes = 4096;
+
+// 把 24 位真彩色近似到 xterm 256 色的 6x6x6 色立方。
+qint16 nearestPaletteIndex(int r, int g, int b) {
+    const auto level = [](int v) { return v < 48 ? 0 : (v < 115 ? 1 : (v - 35) / 40); };
+    return static_cast<qint16>(16 + 36 * level(r) + 6 * level(g) + level(b));
+}
+}
+
+TerminalScreen::TerminalScreen(int columns, int rows, int scrollbackLimit)
+    : columns_(qMax(1, columns)), rows_(qMax(1, rows)), scrollbackLimit_(qMax(0, scrollbackLimit)) {
+    reset();
+}
+
+void TerminalScreen::reset() {
+    pen_ = Cell();
+    lines_ = QVector<Line>(rows_, blankLine());
+    savedPrimary_.clear();
+    alternate_ = false;
+    cursorRow_ = 0;
+    cursorColumn_ = 0;
+    wrapPending_ = false;
+    savedRow_ = 0;
+    savedColumn_ = 0;
+    savedPen_ = Cell();
+    scrollTop_ = 0;
+    scrollBottom_ = rows_ - 1;
+    autoWrap_ = true;
+    cursorVisible_ = true;
+    appCursorKeys_ = false;
+    bracketedPaste_ = false;
+    state_ = State::Ground;
+    utf8Remaining_ = 0;
+    markDirty(0, rows_ - 1);
+}
+
+void TerminalScreen::feed(const QByteArray &data) {
+    const int size = data.size();
+    const char *bytes = data.constData();
+    for (int i = 0; i < size; ++i) {
+        processByte(static_cast<uchar>(bytes[i]));
+    }
+}
+
+void TerminalScreen::processByte(uchar byte) {
+    // 多字节 UTF-8 只在普通状态下出现；控制序列本身都是 ASCII。
+    if (utf8Remaining_ > 0) {
+        if ((byte & 0xC0) == 0x80) {
+            utf8Char_ = (utf8Char_ << 6) | (byte & 0x3F);
+            if (--utf8Remaining_ == 0) {
+                print(utf8Char_);
+            }
+            return;
+        }
+        utf8Remaining_ = 0;
+        print(U'�');
+    }
+
+    switch (state_) {
+    case State::Ground:
+        if (byte < 0x20 || byte == 0x7F) {
+            execute(byte);
+        } else if (byte < 0x80) {
+            print(byte);
+        } else if ((byte & 0xE0) == 0xC0) {
+            utf8Char_ = byte & 0x1F;
+            utf8Remaining_ = 1;
+        } else if ((byte & 0xF0) == 0xE0) {
+            utf8Char_ = byte & 0x0F;
+            utf8Remaining_ = 2;
+        } else if ((byte & 0xF8) == 0xF0) {
+            utf8Char_ = byte & 0x07;
+            utf8Remaining_ = 3;
+        } else {
+            print(U'�');
+        }
+        return;
+    case State::Escape:
+        if (byte < 0x20) {
+            execute(byte);
+        } else {
+            escDispatch(byte);
+        }
+        return;
+    case State::EscapeSkipOne:
+        state_ = State::Ground;
+        return;
+    case State::Csi:
+        if (byte < 0x20) {
+            execute(byte); // 控制序列中间的 CR/LF 等照常执行，ESC 则重新开始
+        } else if (byte >= '0' && byte <= '9') {
+            currentParam_ = (currentParam_ < 0 ? 0 : currentParam_) * 10 + (byte - '0');
+            currentParam_ = qMin(currentParam_, 99999);
+        } else if (byte == ';' || byte == ':') {
+            if (params_.size() < kMaxParams) {
+                params_.append(currentParam_);
+            }
+            currentParam_ = -1;
+        } else if (byte >= '<' && byte <= '?') {
+            private_ = static_cast<char>(byte);
+        } else if (byte >= 0x20 && byte <= 0x2F) {
+            csiIgnored_ = true; // 带中间字节的序列（DECSCUSR 等）不支持，整体忽略
+        } else if (byte >= 0x40 && byte <= 0x7E) {
+            if (params_.size() < kMaxParams) {
+                params_.append(currentParam_);
+            }
+            state_ = State::Ground;
+            if (!csiIgnored_) {
+                csiDispatch(byte);
+            }
+        }
+        return;
+    case State::String:
+        if (byte == 0x07) {
+            finishString();
+        } else if (byte == 0x1B) {
+            state_ = State::StringEscape;
+        } else if (string_.size() < kMaxStringBytes) {
+            string_.append(static_cast<char>(byte));
+        }
+        return;
+    case State::StringEscape:
+        if (byte == '\\') {
+            finishString();
+        } else {
+            // 字符串被新的转义序列打断
+            state_ = State::Escape;
+            processByte(byte);
+        }
+        return;
+    }
+}
+
+void TerminalScreen::execute(uchar control) {
+    switch (control) {
+    case 0x07: // BEL
+        break;
+    case 0x08: // BS
+        wrapPending_ = false;
+        cursorColumn_ = qMax(0, cursorColumn_ - 1);
+        break;
+    case 0x09: // HT，固定 8 列制表位
+        wrapPending_ = false;
+        cursorColumn_ = qMin(columns_ - 1, (cursorColumn_ / 8 + 1) * 8);
+        break;
+    case 0x0A:
+    case 0x0B:
+    case 0x0C:
+        lineFeed();
+        break;
+    case 0x0D:
+        wrapPending_ = false;
+        cursorColumn_ = 0;
+        break;
+    case 0x18:
+    case 0x1A:
+        state_ = State::Ground;
+        break;
+    case 0x1B:
+        state_ = State::Escape;
+        params_.clear();
+        currentParam_ = -1;
+        private_ = 0;
+        csiIgnored_ = false;
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::escDispatch(uchar final) {
+    state_ = State::Ground;
+    switch (final) {
+    case '[':
+        state_ = State::Csi;
+        break;
+    case ']':
+    case 'P':
+    case '_':
+    case '^':
+        state_ = State::String;
+        stringKind_ = static_cast<char>(final);
+        string_.clear();
+        break;
+    case '(':
+    case ')':
+    case '*':
+    case '+':
+    case '#':
+    case '%':
+        state_ = State::EscapeSkipOne;
+        break;
+    case '7':
+        savedRow_ = cursorRow_;
+        savedColumn_ = cursorColumn_;
+        savedPen_ = pen_;
+        break;
+    case '8':
+        pen_ = savedPen_;
+        moveCursor(savedRow_, savedColumn_);
+        break;
+    case 'D':
+        lineFeed();
+        break;
+    case 'E':
+        cursorColumn_ = 0;
+        lineFeed();
+        break;
+    case 'M':
+        reverseIndex();
+        break;
+    case 'c':
+        reset();
+        break;
+    default:
+        break; // ESC = / ESC > 等键盘模式切换对显示没有影响
+    }
+}
+
+int TerminalScreen::param(int index, int fallback) const {
+    const int value = index < params_.size() ? params_.at(index) : -1;
+    return value <= 0 ? fallback : value;
+}
+
+void TerminalScreen::csiDispatch(uchar final) {
+    if (private_ == '?') {
+        if (final == 'h' || final == 'l') {
+            for (int mode : params_) {
+                setMode(mode, final == 'h');
+            }
+        }
+        return;
+    }
+    if (private_ == '>') {
+        if (final == 'c') {
+            responses_ += "\x1b[>0;0;0c";
+        }
+        return;
+    }
+    if (private_ != 0) {
+        return;
+    }
+
+    const int n = param(0, 1);
+    switch (final) {
+    case '@': { // ICH
+        Line &line = lines_[cursorRow_];
+        const int count = qMin(n, columns_ - cursorColumn_);
+        for (int c = columns_ - 1; c >= cursorColumn_ + count; --c) {
+            line[c] = line[c - count];
+        }
+        for (int c = cursorColumn_; c < cursorColumn_ + count; ++c) {
+            line[c] = blankCell();
+        }
+        markDirty(cursorRow_);
+        break;
+    }
+    case 'A':
+        moveCursor(cursorRow_ - n, cursorColumn_);
+        break;
+    case 'B':
+    case 'e':
+        moveCursor(cursorRow_ + n, cursorColumn_);
+        break;
+    case 'C':
+    case 'a':
+        moveCursor(cursorRow_, cursorColumn_ + n);
+        break;
+    case 'D':
+        moveCursor(cursorRow_, cursorColumn_ - n);
+        break;
+    case 'E':
+        moveCursor(cursorRow_ + n, 0);
+        break;
+    case 'F':
+        moveCursor(cursorRow_ - n, 0);
+        break;
+    case 'G':
+    case '`':
+        moveCursor(cursorRow_, n - 1);
+        break;
+    case 'H':
+    case 'f':
+        moveCursor(param(0, 1) - 1, param(1, 1) - 1);
+        break;
+    case 'd':
+        moveCursor(n - 1, cursorColumn_);
+        break;
+    case 'J':
+        eraseInDisplay(qMax(0, params_.value(0, 0)));
+        break;
+    case 'K': {
+        const int mode = qMax(0, params_.value(0, 0));
+        if (mode == 0) {
+            eraseInLine(cursorRow_, cursorColumn_, columns_ - 1);
+        } else if (mode == 1) {
+            eraseInLine(cursorRow_, 0, cursorColumn_);
+        } else {
+            eraseInLine(cursorRow_, 0, columns_ - 1);
+        }
+        break;
+    }
+    case 'L':
+        if (cursorRow_ >= scrollTop_ && cursorRow_ <= scrollBottom_) {
+            scrollDown(cursorRow_, scrollBottom_, n);
+        }
+        break;
+    case 'M':
+        if (cursorRow_ >= scrollTop_ && cursorRow_ <= scrollBottom_) {
+            scrollUp(cursorRow_, scrollBottom_, n);
+        }
+        break;
+    case 'P': { // DCH
+        Line &line = lines_[cursorRow_];
+        const int count = qMin(n, columns_ - cursorColumn_);
+        for (int c = cursorColumn_; c < columns_ - count; ++c) {
+            line[c] = line[c + count];
+        }
+        for (int c = columns_ - count; c < columns_; ++c) {
+            line[c] = blankCell();
+        }
+        markDirty(cursorRow_);
+        break;
+    }
+    case 'X':
+        eraseInLine(cursorRow_, cursorColumn_, qMin(columns_ - 1, cursorColumn_ + n - 1));
+        break;
+    case 'S':
+        scrollUp(scrollTop_, scrollBottom_, n);
+        break;
+    case 'T':
+        scrollDown(scrollTop_, scrollBottom_, n);
+        break;
+    case 'm':
+        selectGraphicRendition();
+        break;
+    case 'r': {
+        const int top = param(0, 1) - 1;
+        const int bottom = param(1, rows_) - 1;
+        if (top < bottom && bottom < rows_) {
+            scrollTop_ = top;
+            scrollBottom_ = bottom;
+        } else {
+            scrollTop_ = 0;
+            scrollBottom_ = rows_ - 1;
+        }
+        moveCursor(0, 0);
+        break;
+    }
+    case 's':
+        savedRow_ = cursorRow_;
+        savedColumn_ = cursorColumn_;
+        break;
+    case 'u':
+        moveCursor(savedRow_, savedColumn_);
+        break;
+    case 'n':
+        if (params_.value(0) == 5) {
+            responses_ += "\x1b[0n";
+        } else if (params_.value(0) == 6) {
+            responses_ += QStringLiteral("\x1b[%1;%2R").arg(cursorRow_ + 1).arg(cursorColumn_ + 1).toLatin1();
+        }
+        break;
+    case 'c':
+        responses_ += "\x1b[?1;2c";
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::setMode(int mode, bool enabled) {
+    switch (mode) {
+    case 1:
+        appCursorKeys_ = enabled;
+        break;
+    case 7:
+        autoWrap_ = enabled;
+        break;
+    case 25:
+        cursorVisible_ = enabled;
+        markDirty(cursorRow_);
+        break;
+    case 47:
+    case 1047:
+        switchScreen(enabled);
+        break;
+    case 1049:
+        if (enabled) {
+            savedRow_ = cursorRow_;
+            savedColumn_ = cursorColumn_;
+            savedPen_ = pen_;
+            switchScreen(true);
+        } else {
+            switchScreen(false);
+            pen_ = savedPen_;
+            moveCursor(savedRow_, savedColumn_);
+        }
+        break;
+    case 2004:
+        bracketedPaste_ = enabled;
+        break;
+    default:
+        break;
+    }
+}
+
+void TerminalScreen::switchScreen(bool alternate) {
+    if (alternate == alternate_) {
+        return;
+    }
+    // 备用屏（vim、less、top 等全屏程序）不进入回滚缓冲区，退出后恢复原来的内容。
+    if (alternate) {
+        savedPrimary_ = lines_;
+        lines_ = QVector<Line>(rows_, blankLine());
+    } else {
+        lines_ = savedPrimary_;
+        savedPrimary_.clear();
+        if (lines_.size() != rows_) {
+            lines_.resize(rows_);
+            for (Line &line : lines_) {
+                line.resize(columns_);
+            }
+        }
+    }
+    alternate_ = alternate;
+    scrollTop_ = 0;
+    scrollBottom_ = rows_ - 1;
+    markDirty(0, rows_ - 1);
+}
+
+void TerminalScreen::selectGraphicRendition() {
+    for (int i = 0; i < params_.size(); ++i) {
+        const int p = qMax(0, params_.at(i));
+        if (p == 0) {
+            pen_ = Cell();
+        } else if (p == 1) {
+            pen_.attrs |= Bold;
+        } else if (p == 4) {
+            pen_.attrs |= Underline;
+        } else if (p == 7) {
+            pen_.attrs |= Inverse;
+        } else if (p == 22) {
+            pen_.attrs &= ~Bold;
+        } else if (p == 24) {
+            pen_.attrs &= ~Underline;
+        } else if (p == 27) {
+            pen_.attrs &= ~Inverse;
+        } else if (p >= 30 && p <= 37) {
+            pen_.fg = static_cast<qint16>(p - 30);
+        } else if (p == 39) {
+            pen_.fg = DefaultColor;
+        } else if (p >= 40 && p <= 47) {
+            pen_.bg = static_cast<qint16>(p - 40);
+        } else if (p == 49) {
+            pen_.bg = DefaultColor;
+        } else if (p >= 90 && p <= 97) {
+            pen_.fg = static_cast<qint16>(p - 90 + 8);
+        } else if (p >= 100 && p <= 107) {
+            pen_.bg = static_cast<qint16>(p - 100 + 8);
+        } else if (p == 38 || p == 48) {
+            qint16 color = DefaultColor;
+            const int kind = params_.value(i + 1);
+            if (kind == 5) {
+                color = static_cast<qint16>(qBound(0, params_.value(i + 2), 255));
+                i += 2;
+            } else if (kind == 2) {
+                color = nearestPaletteIndex(qBound(0, params_.value(i + 2), 255), qBound(0, params_.value(i + 3), 255),
+                                            qBound(0, params_.value(i + 4), 255));
+                i += 4;
+            } else {
+                break;
+            }
+            (p == 38 ? pen_.fg : pen_.bg) = color;
+        }
+    }
+}
+
+void TerminalScreen::finishString() {
+    state_ = State::Ground;
+    // 只关心 OSC 0/2 设置的窗口标题，其余（超链接、剪贴板等）忽略。
+    if (stringKind_ == ']' && (string_.startsWith("0;") || string_.startsWith("2;"))) {
+        title_ = QString::fromUtf8(string_.mid(2));
+    }
+    string_.clear();
+}
+
+void TerminalScreen::print(char32_t ch) {
+    int width = charWidth(ch);
+    if (width == 0) {
+        return; // 组合字符直接丢弃，不影响列对齐
+    }
+    if (width == 2 && columns_ < 2) {
+        // 只有一列时放不下宽字符，换行后照样越界，退化成一个空白格
+        ch = U' ';
+        width = 1;
+    }
+    if (wrapPending_) {
+        wrapPending_ = false;
+        cursorColumn_ = 0;
+        lineFeed();
+    }
+    if (width == 2 && cursorColumn_ == columns_ - 1) {
+        if (!autoWrap_) {
+            return;
+        }
+        lines_[cursorRow_][cursorColumn_] = blankCell();
+        markDirty(cursorRow_);
+        cursorColumn_ = 0;
+        lineFeed();
+    }
+
+    Line &line = lines_[cursorRow_];
+    Cell cell = pen_;
+    cell.ch = ch;
+    line[cursorColumn_] = cell;
+    if (width == 2) {
+        cell.ch = 0;
+        line[cursorColumn_ + 1] = cell;
+    }
+    markDirty(cursorRow_);
+
+    if (cursorColumn_ + width >= columns_) {
+        cursorColumn_ = columns_ - 1;
+        wrapPending_ = autoWrap_;
+    } else {
+        cursorColumn_ += width;
+    }
+}
+
+void TerminalScreen::lineFeed() {
+    wrapPending_ = false;
+    if (cursorRow_ == scrollBottom_) {
+        scrollUp(scrollTop_, scrollBottom_, 1);
+    } else if (cursorRow_ < rows_ - 1) {
+        ++cursorRow_;
+    }
+}
+
+void TerminalScreen::reverseIndex() {
+    wrapPending_ = false;
+    if (cursorRow_ == scrollTop_) {
+        scrollDown(scrollTop_, scrollBottom_, 1);
+    } else if (cursorRow_ > 0) {
+        --cursorRow_;
+    }
+}
+
+void TerminalScreen::scrollUp(int top, int bottom, int count) {
+    count = qMin(count, bottom - top + 1);
+    // 整屏向上滚动时被挤出去的行进入回滚缓冲区；备用屏和局部滚动区域不保留。
+    const bool keep = top == 0 && !alternate_;
+    for (int i = 0; i < count; ++i) {
+        if (keep) {
+            pushScrollback(lines_.at(top));
+        }
+        lines_.removeAt(top);
+        lines_.insert(bottom, blankLine());
+    }
+    if (keep) {
+        damage_.scrolled += count;
+    }
+    markDirty(top, bottom);
+}
+
+void TerminalScreen::scrollDown(int top, int bottom, int count) {
+    count = qMin(count, bottom - top + 1);
+    for (int i = 0; i < count; ++i) {
+        lines_.removeAt(bottom);
+        lines_.insert(top, blankLine());
+    }
+    markDirty(top, bottom);
+}
+
+void TerminalScreen::pushScrollback(const Line &line) {
+    if (scrollbackLimit_ == 0) {
+        return;
+    }
+    if (ring_.size() < scrollbackLimit_) {
+        ring_.append(line);
+        return;
+    }
+    ring_[ringStart_] = line;
+    ringStart_ = (ringStart_ + 1) % ring_.size();
+}
+
+void TerminalScreen::eraseInLine(int row, int from, int to) {
+    Line &line = lines_[row];
+    const Cell blank = blankCell();
+    for (int c = qMax(0, from); c <= qMin(columns_ - 1, to); ++c) {
+        line[c] = blank;
+    }
+    markDirty(row);
+}
+
+void TerminalScreen::eraseInDisplay(int mode) {
+    if (mode == 0) {
+        eraseInLine(cursorRow_, cursorColumn_, columns_ - 1);
+        for (int r = cursorRow_ + 1; r < rows_; ++r) {
+            lines_[r] = blankLine();
+        }
+        markDirty(cursorRow_, rows_ - 1);
+    } else if (mode == 1) {
+        for (int r = 0; r < cursorRow_; ++r) {
+            lines_[r] = blankLine();
+        }
+        eraseInLine(cursorRow_, 0, cursorColumn_);
+        markDirty(0, cursorRow_);
+    } else {
+        for (Line &line : lines_) {
+            line = blankLine();
+        }
+        if (mode == 3) {
+            ring_.clear();
+            ringStart_ = 0;
+            damage_.scrolled += 1;
+        }
+        markDirty(0, rows_ - 1);
+    }
+}
+
+void TerminalScreen::moveCursor(int row, int column) {
+    wrapPending_ = false;
+    markDirty(cursorRow_);
+    cursorRow_ = qBound(0, row, rows_ - 1);
+    cursorColumn_ = qBound(0, column, columns_ - 1);
+    markDirty(cursorRow_);
+}
+
+void TerminalScreen::resize(int columns, int rows) {
+    columns = qMax(1, columns);
+    rows = qMax(1, rows);
+    if (columns == columns_ && rows == rows_) {
+        return;
+    }
+    const auto fit = [columns](QVector<Line> &lines) {
+        for (Line &line : lines) {
+            line.resize(columns);
+        }
+    };
+    // 行数变少时优先保留光标所在行，挤掉的上方行进入回滚缓冲区。
+    const int overflow = qMax(0, cursorRow_ - (rows - 1));
+    for (int i = 0; i < overflow; ++i) {
+        if (!alternate_) {
+            pushScrollback(lines_.first());
+        }
+        lines_.removeFirst();
+    }
+    cursorRow_ -= overflow;
+    lines_.resize(rows);
+    if (!savedPrimary_.isEmpty()) {
+        savedPrimary_.resize(rows);
+        fit(savedPrimary_);
+    }
+    columns_ = columns;
+    rows_ = rows;
+    fit(lines_);
+    fit(ring_);
+    scrollTop_ = 0;
+    scrollBottom_ = rows_ - 1;
+    cursorRow_ = qBound(0, cursorRow_, rows_ - 1);
+    cursorColumn_ = qBound(0, cursorColumn_, columns_ - 1);
+    wrapPending_ = false;
+    damage_.scrolled += 1;
+    markDirty(0, rows_ - 1);
+}
+
+TerminalScreen::Line TerminalScreen::blankLine() const {
+    return Line(columns_, blankCell());
+}
+
+TerminalScreen::Cell TerminalScreen::blankCell() const {
+    // 擦除使用当前背景色（与 xterm 的 BCE 行为一致）
+    Cell cell;
+    cell.bg = pen_.bg;
+    return cell;
+}
+
+void TerminalScreen::markDirty(int row) {
+    markDirty(row, row);
+}
+
+void TerminalScreen::markDirty(int top, int bottom) {
+    damage_.top = damage_.top < 0 ? top : qMin(damage_.top, top);
+    damage_.bottom = qMax(damage_.bottom, bottom);
+}
+
+TerminalScreen::Damage TerminalScreen::takeDamage() {
+    const Damage result = damage_;
+    damage_ = Damage();
+    return result;
+}
+
+QByteArray TerminalScreen::takeResponses() {
+    QByteArray result;
+    result.swap(responses_);
+    return result;
+}
+
+int TerminalScreen::columns() const {
+    return columns_;
+}
+
+int TerminalScreen::rows() const {
+    return rows_;
+}
+
+int TerminalScreen::scrollbackSize() const {
+    return ring_.size();
+}
+
+const TerminalScreen::Line &TerminalScreen::scrollbackLine(int index) const {
+    return ring_.at((ringStart_ + index) % ring_.size());
+}
+
+const TerminalScreen::Line &TerminalScreen::screenLine(int row) const {
+    return lines_.at(row);
+}
+
+int TerminalScreen::cursorRow() const {
+    return cursorRow_;
+}
+
+int TerminalScreen::cursorColumn() const {
+    return cursorColumn_;
+}
+
+bool TerminalScreen::cursorVisible() const {
+    return cursorVisible_;
+}
+
+bool TerminalScreen::applicationCursorKeys() const {
+    return appCursorKeys_;
+}
+
+bool TerminalScreen::bracketedPaste() const {
+    return bracketedPaste_;
+}
+
+QString TerminalScreen::title() const {
+    return title_;
+}
+
+int TerminalScreen::charWidth(char32_t ch) {
+    if ((ch >= 0x0300 && ch <= 0x036F) || (ch >= 0x200B && ch <= 0x200F) || (ch >= 0xFE00 && ch <= 0xFE0F)) {
+        return 0;
+    }
+    // 东亚宽字符（中日韩文字、全角符号、常见 emoji）占两列。
+    if ((ch >= 0x1100 && ch <= 0x115F) || (ch >= 0x2E80 && ch <= 0x303E) || (ch >= 0x3041 && ch <= 0x33FF)
+        || (ch >= 0x3400 && ch <= 0x4DBF) || (ch >= 0x4E00 && ch <= 0x9FFF) || (ch >= 0xA000 && ch <= 0xA4CF)
+        || (ch >= 0xAC00 && ch <= 0xD7A3) || (ch >= 0xF900 && ch <= 0xFAFF) || (ch >= 0xFE30 && ch <= 0xFE4F)
+        || (ch >= 0xFF00 && ch <= 0xFF60) || (ch >= 0xFFE0 && ch <= 0xFFE6) || (ch >= 0x1F300 && ch <= 0x1F64F)
+        || (ch >= 0x1F900 && ch <= 0x1F9FF) || (ch >= 0x20000 && ch <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
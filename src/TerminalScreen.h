@@ -0,0 +1,128 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// VT100/xterm 常用子集的终端屏幕模型：固定大小的字符网格 + 环形回滚缓冲区。
+// 只负责解析字节流和维护状态，不涉及绘制；记录自上次取走以来变化过的行，供界面只重绘受损区域。
+class TerminalScreen {
+public:
+    enum Attribute : quint8 {
+        Bold = 1,
+        Underline = 2,
+        Inverse = 4,
+    };
+    static constexpr qint16 DefaultColor = -1;
+
+    struct Cell {
+        char32_t ch = U' ';        // 宽字符占两格，第二格为 0
+        qint16 fg = DefaultColor;  // 0-255 调色板索引
+        qint16 bg = DefaultColor;
+        quint8 attrs = 0;
+    };
+    using Line = QVector<Cell>;
+
+    struct Damage {
+        int top = -1;      // 屏幕行范围（含），-1 表示没有变化
+        int bottom = -1;
+        int scrolled = 0;  // 滚入回滚缓冲区的行数，非 0 时整屏重绘
+    };
+
+    explicit TerminalScreen(int columns = 80, int rows = 24, int scrollbackLimit = 10000);
+
+    void feed(const QByteArray &data);
+    void resize(int columns, int rows);
+    void reset();
+
+    int columns() const;
+    int rows() const;
+    int scrollbackSize() const;
+    const Line &scrollbackLine(int index) const; // 0 为最早的一行
+    const Line &screenLine(int row) const;
+
+    int cursorRow() const;
+    int cursorColumn() const;
+    bool cursorVisible() const;
+    bool applicationCursorKeys() const;
+    bool bracketedPaste() const;
+    QString title() const;
+
+    Damage takeDamage();
+    QByteArray takeResponses(); // DSR/DA 等需要回写给程序的应答
+
+    static int charWidth(char32_t ch);
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        EscapeSkipOne, // ESC ( B 之类的字符集指定，吞掉下一个字节
+        Csi,
+        String,        // OSC / DCS / APC，直到 BEL 或 ST
+        StringEscape,
+    };
+
+    void processByte(uchar byte);
+    void execute(uchar control);
+    void escDispatch(uchar final);
+    void csiDispatch(uchar final);
+    void setMode(int mode, bool enabled);
+    void selectGraphicRendition();
+    void finishString();
+
+    void print(char32_t ch);
+    void lineFeed();
+    void reverseIndex();
+    void scrollUp(int top, int bottom, int count);
+    void scrollDown(int top, int bottom, int count);
+    void eraseInLine(int row, int from, int to);
+    void eraseInDisplay(int mode);
+    void moveCursor(int row, int column);
+    void pushScrollback(const Line &line);
+    void switchScreen(bool alternate);
+
+    Line blankLine() const;
+    Cell blankCell() const;
+    void markDirty(int row);
+    void markDirty(int top, int bottom);
+    int param(int index, int fallback) const;
+
+    int columns_;
+    int rows_;
+    int scrollbackLimit_;
+    QVector<Line> lines_;
+    QVector<Line> savedPrimary_;
+    QVector<Line> ring_;
+    int ringStart_ = 0;
+
+    int cursorRow_ = 0;
+    int cursorColumn_ = 0;
+    bool wrapPending_ = false;
+    int savedRow_ = 0;
+    int savedColumn_ = 0;
+    Cell savedPen_;
+    int scrollTop_ = 0;
+    int scrollBottom_ = 0;
+    Cell pen_;
+
+    bool autoWrap_ = true;
+    bool cursorVisible_ = true;
+    bool appCursorKeys_ = false;
+    bool bracketedPaste_ = false;
+    bool alternate_ = false;
+
+    State state_ = State::Ground;
+    QVector<int> params_;
+    int currentParam_ = -1;
+    char private_ = 0;
+    bool csiIgnored_ = false;
+    QByteArray string_;
+    char stringKind_ = 0;
+    char32_t utf8Char_ = 0;
+    int utf8Remaining_ = 0;
+
+    QString title_;
+    QByteArray responses_;
+    Damage damage_;
+};
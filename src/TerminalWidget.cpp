@@ -0,0 +1,544 @@
+#include "TerminalWidget.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFontMetrics>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <utility>
+
+namespace {
+// 约 60 帧/秒；一帧内到达的所有数据只触发一次重绘。
+constexpr int kRenderIntervalMs = 16;
+
+const QColor kDefaultForeground(0xd4, 0xd4, 0xd4);
+const QColor kDefaultBackground(0x1e, 0x1e, 0x1e);
+const QRgb kBasePalette[16] = {
+    0x000000, 0xcd3131, 0x0dbc79, 0xe5e510, 0x2472c8, 0xbc3fbc, 0x11a8cd, 0xe5e5e5,
+    0x666666, 0xf14c4c, 0x23d18b, 0xf5f543, 0x3b8eea, 0xd670d6, 0x29b8db, 0xffffff,
+};
+
+QByteArray csiKey(char final, int modifiers, bool application) {
+    if (modifiers > 1) {
+        return QByteArray("\x1b[1;") + QByteArray::number(modifiers) + final;
+    }
+    return QByteArray(application ? "\x1bO" : "\x1b[") + final;
+}
+
+QByteArray tildeKey(int code, int modifiers) {
+    QByteArray seq = "\x1b[" + QByteArray::number(code);
+    if (modifiers > 1) {
+        seq += ';' + QByteArray::number(modifiers);
+    }
+    return seq + '~';
+}
+}
+
+TerminalWidget::TerminalWidget(QWidget *parent) : QAbstractScrollArea(parent), screen_(80, 24) {
+    QFont font;
+    font.setFamily("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setFixedPitch(true);
+    font.setPointSize(11);
+    setFont(font);
+    const QFontMetrics metrics(font);
+    cellWidth_ = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+    cellHeight_ = qMax(1, metrics.height());
+    ascent_ = metrics.ascent();
+
+    setFocusPolicy(Qt::StrongFocus);
+    setAttribute(Qt::WA_InputMethodEnabled);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    viewport()->setCursor(Qt::IBeamCursor);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+    viewport()->setAutoFillBackground(false);
+    verticalScrollBar()->setSingleStep(1);
+    verticalScrollBar()->setRange(0, 0);
+
+    renderTimer_.setSingleShot(true);
+    renderTimer_.setInterval(kRenderIntervalMs);
+    connect(&renderTimer_, &QTimer::timeout, this, &TerminalWidget::render);
+    connect(&pty_, &Pty::dataReceived, this, &TerminalWidget::handleData);
+    connect(&pty_, &Pty::finished, this, [this](int exitCode) {
+        handleData(tr("\r\n[进程已退出，退出码：%1]\r\n").arg(exitCode).toUtf8());
+        emit finished(exitCode);
+    });
+}
+
+bool TerminalWidget::start(const QString &program, const QStringList &args, const QString &workingDirectory) {
+    if (pty_.isRunning()) {
+        return true;
+    }
+    updateGridSize();
+    if (!pty_.start(program, args, workingDirectory, screen_.columns(), screen_.rows())) {
+        handleData(tr("无法启动终端：%1\r\n").arg(pty_.errorString()).toUtf8());
+        return false;
+    }
+    return true;
+}
+
+void TerminalWidget::terminate() {
+    pty_.terminate();
+}
+
+bool TerminalWidget::isRunning() const {
+    return pty_.isRunning();
+}
+
+void TerminalWidget::handleData(const QByteArray &data) {
+    screen_.feed(data);
+    // 光标位置查询等应答要尽快回写，shell 会等它画提示符
+    const QByteArray responses = screen_.takeResponses();
+    if (!responses.isEmpty()) {
+        pty_.write(responses);
+    }
+    if (!renderTimer_.isActive()) {
+        renderTimer_.start();
+    }
+}
+
+void TerminalWidget::render() {
+    TerminalScreen::Damage damage = screen_.takeDamage();
+    if (screen_.title() != lastTitle_) {
+        lastTitle_ = screen_.title();
+        emit titleChanged(lastTitle_);
+    }
+    // 光标移动不一定伴随内容变化，新旧两个位置所在的行都要重画
+    const QPoint cursor(screen_.cursorColumn(), screen_.cursorRow());
+    if (cursor != lastCursor_) {
+        const int low = qMin(qMin(cursor.y(), lastCursor_.y()), screen_.rows() - 1);
+        const int high = qMin(qMax(cursor.y(), lastCursor_.y()), screen_.rows() - 1);
+        damage.top = damage.top < 0 ? low : qMin(damage.top, low);
+        damage.bottom = qMax(damage.bottom, high);
+        lastCursor_ = cursor;
+    }
+    if (damage.top < 0 && damage.scrolled == 0) {
+        return;
+    }
+
+    const int before = topRow();
+    updateScrollBar();
+    if (damage.scrolled > 0 || topRow() != before) {
+        viewport()->update();
+        return;
+    }
+    // 只重绘变化的行：屏幕行换算成视口行后求交
+    const int offset = screen_.scrollbackSize() - topRow();
+    const int first = damage.top + offset;
+    const int last = damage.bottom + offset;
+    const QRect rect(0, first * cellHeight_, viewport()->width(), (last - first + 1) * cellHeight_);
+    const QRect visible = rect.intersected(viewport()->rect());
+    if (!visible.isEmpty()) {
+        viewport()->update(visible);
+    }
+}
+
+void TerminalWidget::updateScrollBar() {
+    QScrollBar *bar = verticalScrollBar();
+    const bool follow = followOutput_;
+    bar->setPageStep(screen_.rows());
+    bar->setRange(0, screen_.scrollbackSize());
+    if (follow) {
+        bar->setValue(bar->maximum());
+    }
+    followOutput_ = follow || bar->value() == bar->maximum();
+}
+
+void TerminalWidget::scrollContentsBy(int dx, int dy) {
+    Q_UNUSED(dx)
+    Q_UNUSED(dy)
+    followOutput_ = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+    viewport()->update();
+}
+
+int TerminalWidget::topRow() const {
+    return verticalScrollBar()->value();
+}
+
+const TerminalScreen::Line &TerminalWidget::lineAt(int absoluteRow) const {
+    const int scrollback = screen_.scrollbackSize();
+    if (absoluteRow < scrollback) {
+        return screen_.scrollbackLine(absoluteRow);
+    }
+    return screen_.screenLine(qMin(absoluteRow - scrollback, screen_.rows() - 1));
+}
+
+void TerminalWidget::updateGridSize() {
+    const int columns = qMax(2, viewport()->width() / cellWidth_);
+    const int rows = qMax(1, viewport()->height() / cellHeight_);
+    if (columns == screen_.columns() && rows == screen_.rows()) {
+        return;
+    }
+    screen_.resize(columns, rows);
+    pty_.resize(columns, rows);
+    updateScrollBar();
+    viewport()->update();
+}
+
+void TerminalWidget::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateGridSize();
+}
+
+QColor TerminalWidget::color(qint16 index, bool foreground) const {
+    if (index < 0) {
+        return foreground ? kDefaultForeground : kDefaultBackground;
+    }
+    if (index < 16) {
+        return QColor(kBasePalette[index]);
+    }
+    if (index < 232) {
+        static const int levels[6] = {0, 95, 135, 175, 215, 255};
+        const int i = index - 16;
+        return QColor(levels[i / 36], levels[(i / 6) % 6], levels[i % 6]);
+    }
+    const int gray = 8 + (index - 232) * 10;
+    return QColor(gray, gray, gray);
+}
+
+void TerminalWidget::paintEvent(QPaintEvent *event) {
+    QPainter painter(viewport());
+    painter.setFont(font());
+    const QRect area = event->rect();
+    painter.fillRect(area, kDefaultBackground);
+
+    const int top = topRow();
+    const int total = screen_.scrollbackSize() + screen_.rows();
+    const int firstRow = qMax(0, area.top() / cellHeight_);
+    const int lastRow = qMin(screen_.rows() - 1, area.bottom() / cellHeight_);
+    for (int row = firstRow; row <= lastRow && top + row < total; ++row) {
+        paintLine(painter, top + row, row * cellHeight_);
+    }
+}
+
+void TerminalWidget::paintLine(QPainter &painter, int absoluteRow, int y) {
+    const TerminalScreen::Line &line = lineAt(absoluteRow);
+    const int columns = qMin(static_cast<int>(line.size()), screen_.columns());
+    const int cursorRow = screen_.scrollbackSize() + screen_.cursorRow();
+    const bool hasSelection = selectionAnchor_.y() >= 0 && selectionAnchor_ != selectionEnd_;
+
+    // 相同属性的连续 ASCII 字符合并成一次 drawText，宽字符和其他非 ASCII 字符逐个按格子绘制，保证列对齐。
+    int column = 0;
+    while (column < columns) {
+        const TerminalScreen::Cell &head = line.at(column);
+        const bool selected = hasSelection && isSelected(absoluteRow, column);
+        int end = column + 1;
+        while (end < columns) {
+            const TerminalScreen::Cell &cell = line.at(end);
+            if (cell.fg != head.fg || cell.bg != head.bg || cell.attrs != head.attrs
+                || (hasSelection && isSelected(absoluteRow, end) != selected)) {
+                break;
+            }
+            ++end;
+        }
+
+        qint16 fgIndex = head.fg;
+        if ((head.attrs & TerminalScreen::Bold) && fgIndex >= 0 && fgIndex < 8) {
+            fgIndex = static_cast<qint16>(fgIndex + 8);
+        }
+        QColor fg = color(fgIndex, true);
+        QColor bg = color(head.bg, false);
+        if (head.attrs & TerminalScreen::Inverse) {
+            std::swap(fg, bg);
+        }
+        if (selected) {
+            std::swap(fg, bg);
+        }
+
+        const int x = column * cellWidth_;
+        const int width = (end - column) * cellWidth_;
+        if (bg != kDefaultBackground) {
+            painter.fillRect(x, y, width, cellHeight_, bg);
+        }
+        painter.setPen(fg);
+
+        QString ascii;
+        int asciiStart = column;
+        const auto flushAscii = [&]() {
+            if (!ascii.isEmpty()) {
+                painter.drawText(asciiStart * cellWidth_, y + ascent_, ascii);
+                ascii.clear();
+            }
+        };
+        for (int c = column; c < end; ++c) {
+            const char32_t ch = line.at(c).ch;
+            if (ch >= 0x20 && ch < 0x7F) {
+                if (ascii.isEmpty()) {
+                    asciiStart = c;
+                }
+                ascii.append(QLatin1Char(static_cast<char>(ch)));
+                continue;
+            }
+            flushAscii();
+            if (ch != 0 && ch != U' ') {
+                painter.drawText(c * cellWidth_, y + ascent_, QString::fromUcs4(&ch, 1));
+            }
+        }
+        flushAscii();
+        if (head.attrs & TerminalScreen::Underline) {
+            painter.drawLine(x, y + ascent_ + 1, x + width - 1, y + ascent_ + 1);
+        }
+        column = end;
+    }
+
+    if (absoluteRow == cursorRow && screen_.cursorVisible()) {
+        const QRect cursorRect(screen_.cursorColumn() * cellWidth_, y, cellWidth_, cellHeight_);
+        if (hasFocus()) {
+            const TerminalScreen::Cell &cell = line.value(screen_.cursorColumn());
+            painter.fillRect(cursorRect, kDefaultForeground);
+            if (cell.ch != U' ' && cell.ch != 0) {
+                painter.setPen(kDefaultBackground);
+                painter.drawText(cursorRect.left(), y + ascent_, QString::fromUcs4(&cell.ch, 1));
+            }
+        } else {
+            painter.setPen(kDefaultForeground);
+            painter.drawRect(cursorRect.adjusted(0, 0, -1, -1));
+        }
+    }
+}
+
+QPoint TerminalWidget::cellAt(const QPoint &pos) const {
+    const int column = qBound(0, pos.x() / cellWidth_, screen_.columns() - 1);
+    const int row = qBound(0, pos.y() / cellHeight_, screen_.rows() - 1);
+    return QPoint(column, topRow() + row);
+}
+
+bool TerminalWidget::isSelected(int absoluteRow, int column) const {
+    QPoint start = selectionAnchor_;
+    QPoint end = selectionEnd_;
+    if (end.y() < start.y() || (end.y() == start.y() && end.x() < start.x())) {
+        std::swap(start, end);
+    }
+    if (absoluteRow < start.y() || absoluteRow > end.y()) {
+        return false;
+    }
+    if (absoluteRow == start.y() && column < start.x()) {
+        return false;
+    }
+    return absoluteRow != end.y() || column <= end.x();
+}
+
+QString TerminalWidget::selectedText() const {
+    if (selectionAnchor_.y() < 0 || selectionAnchor_ == selectionEnd_) {
+        return {};
+    }
+    QPoint start = selectionAnchor_;
+    QPoint end = selectionEnd_;
+    if (end.y() < start.y() || (end.y() == start.y() && end.x() < start.x())) {
+        std::swap(start, end);
+    }
+    const int total = screen_.scrollbackSize() + screen_.rows();
+    QStringList lines;
+    for (int row = start.y(); row <= end.y() && row < total; ++row) {
+        const TerminalScreen::Line &line = lineAt(row);
+        const int from = row == start.y() ? start.x() : 0;
+        const int to = row == end.y() ? end.x() : line.size() - 1;
+        QString text;
+        for (int c = from; c <= to && c < line.size(); ++c) {
+            const char32_t ch = line.at(c).ch;
+            if (ch != 0) {
+                text += QString::fromUcs4(&ch, 1);
+            }
+        }
+        while (text.endsWith(QLatin1Char(' '))) {
+            text.chop(1);
+        }
+        lines << text;
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+void TerminalWidget::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::MiddleButton) {
+        const QString text = QApplication::clipboard()->text(QClipboard::Selection);
+        if (!text.isEmpty()) {
+            pty_.write(text.toUtf8());
+        }
+        return;
+    }
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    selecting_ = true;
+    selectionAnchor_ = cellAt(event->pos());
+    selectionEnd_ = selectionAnchor_;
+    viewport()->update();
+}
+
+void TerminalWidget::mouseMoveEvent(QMouseEvent *event) {
+    if (!selecting_) {
+        return;
+    }
+    selectionEnd_ = cellAt(event->pos());
+    viewport()->update();
+}
+
+void TerminalWidget::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || !selecting_) {
+        return;
+    }
+    selecting_ = false;
+    selectionEnd_ = cellAt(event->pos());
+    QClipboard *clipboard = QApplication::clipboard();
+    if (clipboard->supportsSelection()) {
+        clipboard->setText(selectedText(), QClipboard::Selection);
+    }
+    viewport()->update();
+}
+
+void TerminalWidget::copySelection() {
+    const QString text = selectedText();
+    if (!text.isEmpty()) {
+        QApplication::clipboard()->setText(text);
+    }
+}
+
+void TerminalWidget::paste() {
+    QString text = QApplication::clipboard()->text();
+    if (text.isEmpty()) {
+        return;
+    }
+    text.replace(QStringLiteral("\r\n"), QStringLiteral("\r"));
+    text.replace(QLatin1Char('\n'), QLatin1Char('\r'));
+    // 括号粘贴模式下 shell 不会把粘贴内容里的换行当作回车执行
+    if (screen_.bracketedPaste()) {
+        pty_.write("\x1b[200~" + text.toUtf8() + "\x1b[201~");
+    } else {
+        pty_.write(text.toUtf8());
+    }
+}
+
+bool TerminalWidget::focusNextPrevChild(bool next) {
+    Q_UNUSED(next)
+    return false; // Tab 交给 shell 做补全
+}
+
+void TerminalWidget::inputMethodEvent(QInputMethodEvent *event) {
+    if (!event->commitString().isEmpty()) {
+        pty_.write(event->commitString().toUtf8());
+    }
+    event->accept();
+}
+
+void TerminalWidget::keyPressEvent(QKeyEvent *event) {
+    const Qt::KeyboardModifiers mods = event->modifiers();
+    const bool ctrlShift = (mods & Qt::ControlModifier) && (mods & Qt::ShiftModifier);
+    if (ctrlShift && event->key() == Qt::Key_C) {
+        copySelection();
+        return;
+    }
+    if (ctrlShift && event->key() == Qt::Key_V) {
+        paste();
+        return;
+    }
+    if ((mods & Qt::ShiftModifier) && (event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown)) {
+        QScrollBar *bar = verticalScrollBar();
+        bar->setValue(bar->value() + (event->key() == Qt::Key_PageUp ? -bar->pageStep() : bar->pageStep()));
+        return;
+    }
+
+    const QByteArray data = encodeKey(event);
+    if (data.isEmpty()) {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+    // 输入时回到底部并清除选区
+    if (!followOutput_) {
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    }
+    if (selectionAnchor_.y() >= 0) {
+        selectionAnchor_ = selectionEnd_ = QPoint(-1, -1);
+        viewport()->update();
+    }
+    pty_.write(data);
+}
+
+QByteArray TerminalWidget::encodeKey(QKeyEvent *event) const {
+    const Qt::KeyboardModifiers mods = event->modifiers();
+    // xterm 的修饰键参数：1 + Shift(1) + Alt(2) + Ctrl(4)
+    const int modifiers = 1 + ((mods & Qt::ShiftModifier) ? 1 : 0) + ((mods & Qt::AltModifier) ? 2 : 0)
+                          + ((mods & Qt::ControlModifier) ? 4 : 0);
+    const bool app = screen_.applicationCursorKeys();
+
+    switch (event->key()) {
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        return "\r";
+    case Qt::Key_Backspace:
+        return (mods & Qt::ControlModifier) ? "\x08" : "\x7f";
+    case Qt::Key_Tab:
+        return "\t";
+    case Qt::Key_Backtab:
+        return "\x1b[Z";
+    case Qt::Key_Escape:
+        return "\x1b";
+    case Qt::Key_Up:
+        return csiKey('A', modifiers, app);
+    case Qt::Key_Down:
+        return csiKey('B', modifiers, app);
+    case Qt::Key_Right:
+        return csiKey('C', modifiers, app);
+    case Qt::Key_Left:
+        return csiKey('D', modifiers, app);
+    case Qt::Key_Home:
+        return csiKey('H', modifiers, app);
+    case Qt::Key_End:
+        return csiKey('F', modifiers, app);
+    case Qt::Key_Insert:
+        return tildeKey(2, modifiers);
+    case Qt::Key_Delete:
+        return tildeKey(3, modifiers);
+    case Qt::Key_PageUp:
+        return tildeKey(5, modifiers);
+    case Qt::Key_PageDown:
+        return tildeKey(6, modifiers);
+    case Qt::Key_F1:
+        return csiKey('P', modifiers, true);
+    case Qt::Key_F2:
+        return csiKey('Q', modifiers, true);
+    case Qt::Key_F3:
+        return csiKey('R', modifiers, true);
+    case Qt::Key_F4:
+        return csiKey('S', modifiers, true);
+    default:
+        break;
+    }
+    if (event->key() >= Qt::Key_F5 && event->key() <= Qt::Key_F12) {
+        static const int codes[] = {15, 17, 18, 19, 20, 21, 23, 24};
+        return tildeKey(codes[event->key() - Qt::Key_F5], modifiers);
+    }
+
+    if (mods & Qt::ControlModifier) {
+        const int key = event->key();
+        if (key >= Qt::Key_A && key <= Qt::Key_Z) {
+            return QByteArray(1, static_cast<char>(key - Qt::Key_A + 1));
+        }
+        switch (key) {
+        case Qt::Key_Space:
+        case Qt::Key_At:
+            return QByteArray(1, '\0');
+        case Qt::Key_BracketLeft:
+            return "\x1b";
+        case Qt::Key_Backslash:
+            return "\x1c";
+        case Qt::Key_BracketRight:
+            return "\x1d";
+        case Qt::Key_Underscore:
+        case Qt::Key_Minus:
+            return "\x1f";
+        default:
+            break;
+        }
+    }
+
+    QByteArray text = event->text().toUtf8();
+    if (!text.isEmpty() && (mods & Qt::AltModifier)) {
+        text.prepend('\x1b');
+    }
+    return text;
+}
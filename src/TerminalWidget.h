@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QPoint>
+#include <QTimer>
+
+#include "Pty.h"
+#include "TerminalScreen.h"
+
+class QPainter;
+
+// 集成终端：Pty 提供真正的 tty，TerminalScreen 维护字符网格，这里只负责按键编码和绘制。
+// 数据到达时只解析不绘制，由定时器按帧合并重绘，并且只重绘有变化的行。
+class TerminalWidget : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    explicit TerminalWidget(QWidget *parent = nullptr);
+
+    bool start(const QString &program, const QStringList &args, const QString &workingDirectory);
+    void terminate();
+    bool isRunning() const;
+    QString selectedText() const;
+
+signals:
+    void titleChanged(const QString &title);
+    void finished(int exitCode);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void inputMethodEvent(QInputMethodEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    bool focusNextPrevChild(bool next) override;
+
+private:
+    void handleData(const QByteArray &data);
+    void render();
+    void updateScrollBar();
+    void updateGridSize();
+    void copySelection();
+    void paste();
+    QByteArray encodeKey(QKeyEvent *event) const;
+    QColor color(qint16 index, bool foreground) const;
+    const TerminalScreen::Line &lineAt(int absoluteRow) const;
+    int topRow() const;
+    QPoint cellAt(const QPoint &pos) const;
+    bool isSelected(int absoluteRow, int column) const;
+    void paintLine(QPainter &painter, int absoluteRow, int y);
+
+    Pty pty_;
+    TerminalScreen screen_;
+    QTimer renderTimer_;
+    QString lastTitle_;
+    QPoint lastCursor_{0, 0}; // 上一帧画光标的位置 (列, 屏幕行)
+    int cellWidth_ = 8;
+    int cellHeight_ = 16;
+    int ascent_ = 12;
+    bool followOutput_ = true;
+    bool selecting_ = false;
+    QPoint selectionAnchor_{-1, -1}; // (列, 绝对行)，绝对行 = 回滚行数 + 屏幕行
+    QPoint selectionEnd_{-1, -1};
+};
@@ -0,0 +1,130 @@
+#include "ToolPipeline.h"
+
+#include <QFileInfo>
+#include <QStandardPaths>
+
+ToolPipeline::ToolPipeline(QObject *parent) : QObject(parent) {}
+
+QString ToolPipeline::findTool(const QStringList &candidates) {
+    for (const QString &name : candidates) {
+        const QString path = QStandardPaths::findExecutable(name);
+        if (!path.isEmpty()) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+bool ToolPipeline::isCompilableSource(const QString &path) {
+    static const QStringList kSourceSuffixes{"cpp", "cc", "cxx", "c++", "c", "C"};
+    return !path.isEmpty() && kSourceSuffixes.contains(QFileInfo(path).suffix());
+}
+
+bool ToolPipeline::isRunning() const {
+    return process_ != nullptr;
+}
+
+void ToolPipeline::start(const QString &program, const QStringList &args, const QString &workingDirectory,
+                         DemangleInput demangleInput) {
+    cancel();
+    demangleInput_ = std::move(demangleInput);
+    launch(program, args, workingDirectory, QByteArray());
+}
+
+void ToolPipeline::cancel() {
+    demangleInput_ = DemangleInput();
+    input_.clear();
+    demangling_ = false;
+    QProcess *process = process_;
+    if (!process) {
+        return;
+    }
+    process_ = nullptr;
+    // 不等待旧进程退出，避免卡住界面；kill 之后由 finished 负责回收
+    process->disconnect(this);
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+        return;
+    }
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, &QObject::deleteLater);
+    connect(process, &QProcess::errorOccurred, process, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            process->deleteLater();
+        }
+    });
+    process->kill();
+}
+
+void ToolPipeline::launch(const QString &program, const QStringList &args, const QString &workingDirectory,
+                          const QByteArray &input) {
+    auto *process = new QProcess(this);
+    process_ = process;
+    process->setWorkingDirectory(workingDirectory);
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int exitCode, QProcess::ExitStatus status) { handleFinished(process, exitCode, status); });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            handleFailedToStart(process);
+        }
+    });
+    process->start(program, args);
+    if (process_ == process && !input.isEmpty()) {
+        process->write(input);
+        process->closeWriteChannel();
+    }
+}
+
+void ToolPipeline::handleFinished(QProcess *process, int exitCode, QProcess::ExitStatus status) {
+    if (process != process_) {
+        return;
+    }
+    process_ = nullptr;
+    process->deleteLater();
+    const QByteArray out = process->readAllStandardOutput();
+    const QString err = QString::fromLocal8Bit(process->readAllStandardError()).trimmed();
+    const bool ok = status == QProcess::NormalExit && exitCode == 0;
+
+    if (demangling_) {
+        finish(ok ? out : input_, QString()); // c++filt 出错就用未还原的名字
+        return;
+    }
+    if (!ok) {
+        const QString name = QFileInfo(process->program()).fileName();
+        finish(QByteArray(), err.isEmpty() ? tr("%1 失败，退出码 %2").arg(name).arg(exitCode) : err);
+        return;
+    }
+    if (!demangleInput_) {
+        finish(out, QString());
+        return;
+    }
+    input_ = demangleInput_(out);
+    const QString filt = findTool({"c++filt", "llvm-cxxfilt"});
+    if (filt.isEmpty() || input_.isEmpty()) {
+        finish(input_, QString());
+        return;
+    }
+    demangling_ = true;
+    launch(filt, QStringList(), process->workingDirectory(), input_);
+}
+
+void ToolPipeline::handleFailedToStart(QProcess *process) {
+    if (process != process_) {
+        return;
+    }
+    process_ = nullptr;
+    process->deleteLater();
+    if (demangling_) {
+        finish(input_, QString());
+        return;
+    }
+    finish(QByteArray(), tr("无法启动：%1").arg(process->program()));
+}
+
+void ToolPipeline::finish(const QByteArray &output, const QString &error) {
+    const QByteArray result = output; // output 可能就是 input_
+    demangleInput_ = DemangleInput();
+    input_.clear();
+    demangling_ = false;
+    emit finished(result, error);
+}
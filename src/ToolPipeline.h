@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+#include <functional>
+
+// 汇编视图、优化报告共用的外部命令流水线：先运行编译器（或 objdump），成功后按需把产出的文本交给
+// c++filt 还原名字。新的 start 会取消还没完成的旧命令：旧进程断开连接后直接 kill，
+// 退出时自行回收，界面线程不等待。
+class ToolPipeline : public QObject {
+    Q_OBJECT
+
+public:
+    // 从第一步的标准输出里取出要还原名字的文本；为空表示第一步的输出原样作为结果
+    using DemangleInput = std::function<QByteArray(const QByteArray &output)>;
+
+    explicit ToolPipeline(QObject *parent = nullptr);
+
+    void start(const QString &program, const QStringList &args, const QString &workingDirectory,
+               DemangleInput demangleInput = DemangleInput());
+    void cancel();
+    bool isRunning() const;
+
+    static QString findTool(const QStringList &candidates);
+    // 能用 -c / -S 单独编译的源文件，头文件不算
+    static bool isCompilableSource(const QString &path);
+
+signals:
+    // error 非空表示第一步失败；c++filt 不可用或出错时 output 是未还原名字的原文
+    void finished(const QByteArray &output, const QString &error);
+
+private:
+    void launch(const QString &program, const QStringList &args, const QString &workingDirectory,
+                const QByteArray &input);
+    void handleFinished(QProcess *process, int exitCode, QProcess::ExitStatus status);
+    void handleFailedToStart(QProcess *process);
+    void finish(const QByteArray &output, const QString &error);
+
+    QProcess *process_ = nullptr;
+    DemangleInput demangleInput_;
+    QByteArray input_; // 交给 c++filt 的原文，c++filt 出错时作为结果
+    bool demangling_ = false;
+};